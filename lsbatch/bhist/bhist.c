@@ -40,6 +40,8 @@ static void prtParameters(struct jobInfoEnt *, struct bhistReq *, char *);
 static char * getUserName(int);
 static int dispChkpnt (struct eventRecord *, struct jobRecord *);
 static void readEventFromHead(char *, struct bhistReq *);
+static void readEventFromIdx(char *, struct bhistReq *);
+static void openEventFile0(char *, struct eventLogHandle *, int *);
 static void printEvent(struct bhistReq *, struct jobRecord *, struct jobInfoEnt *, struct eventRecord *, time_t, char *, int);
 static void printChronicleEventLog(struct eventRec *, struct bhistReq *);
 static char * lowFirstChar(char *);
@@ -61,7 +63,7 @@ extern void countLineNum(FILE *fp, long, int *);
 extern struct eventRec *lsbGetNextJobEvent(struct eventLogHandle *, int *, int, LS_LONG_INT *, struct jobIdIndexS *);
 
 
-struct hTab jobIdHT;
+jidTab jobIdHT;
 struct jobRecord *jobRecordList;
 struct loadIndexLog *loadIndex;
 struct bhistReq      Req;
@@ -170,7 +172,7 @@ main(int argc, char **argv)
         exit(-1);
 
 
-    h_initTab_(&jobIdHT, 50);
+    jidInitTab(&jobIdHT, 50);
 
     initLoadIndexNames();
 
@@ -1209,23 +1211,19 @@ logfile_check(struct bhistReq *Req)
     } else if (Req->searchTime[1] == -1)
     {
 
-        eLogHandle.curOpenFile =  0;
-        eLogHandle.lastOpenFile = 0;
-        sprintf(eLogHandle.openEventFile, "%s/lsb.events", workDir);
+        openEventFile0(workDir, &eLogHandle, &lineNum);
+        eLogPtr = &eLogHandle;
 
-        if ((eLogHandle.fp = fopen(eLogHandle.openEventFile, "r")) == NULL) {
-            perror(eLogHandle.openEventFile);
-            exit(-1);
-        }
+    } else if ((Req->options & OPT_JOBID)
+               && !(Req->options & (OPT_JOBNAME | OPT_CHRONICLE))) {
 
-        if (fscanf(eLogHandle.fp,  "%c%d ", &ch, &pos) != 2 || ch != '#') {
-            pos = 0;
-        } else {
-            lineNum = 1;
-	    countLineNum(eLogHandle.fp, pos, &lineNum);
-        }
-        fseek (eLogHandle.fp, pos, SEEK_SET);
+        /* The switched files are read through their
+         * indexes, then the current lsb.events as usual.
+         */
+        Req->searchTime[1] = -1;
+        readEventFromIdx(workDir, Req);
 
+        openEventFile0(workDir, &eLogHandle, &lineNum);
         eLogPtr = &eLogHandle;
 
     } else {
@@ -1375,6 +1373,162 @@ readEventFromHead(char *eventDir, struct bhistReq *reqPtr)
 }
 
 
+/* openEventFile0()
+ * Open the current lsb.events past the records
+ * it inherited from the switched files.
+ */
+static void
+openEventFile0(char *eventDir, struct eventLogHandle *eLogHandle, int *lineNum)
+{
+    char ch;
+    int pos;
+
+    eLogHandle->curOpenFile =  0;
+    eLogHandle->lastOpenFile = 0;
+    sprintf(eLogHandle->openEventFile, "%s/lsb.events", eventDir);
+
+    if ((eLogHandle->fp = fopen(eLogHandle->openEventFile, "r")) == NULL) {
+        perror(eLogHandle->openEventFile);
+        exit(-1);
+    }
+
+    if (fscanf(eLogHandle->fp,  "%c%d ", &ch, &pos) != 2 || ch != '#') {
+        pos = 0;
+    } else {
+        *lineNum = 1;
+        countLineNum(eLogHandle->fp, pos, lineNum);
+    }
+    fseek (eLogHandle->fp, pos, SEEK_SET);
+}
+
+static int
+cmpRecNum(const void *x, const void *y)
+{
+    return *(const int *)x - *(const int *)y;
+}
+
+/* readEventFromIdx()
+ * Read the records of the requested jobs from the
+ * switched event files, oldest first. A file with an
+ * index is mapped and only the records of the jobs are
+ * parsed, a file without one is scanned.
+ */
+static void
+readEventFromIdx(char *eventDir, struct bhistReq *reqPtr)
+{
+    char eventFile[MAXFILENAMELEN];
+    struct eventLogHandle eLogHandle;
+    struct eventRec *log;
+    struct eventIdx *idx;
+    LS_STAT_T statBuf;
+    int *recNums;
+    int *jobRecs;
+    int numRecs;
+    int maxRecs;
+    int maxEventFile;
+    int lineNum;
+    int cc;
+    int i;
+    int j;
+    int n;
+
+    maxEventFile = 0;
+    do {
+        cc = snprintf(eventFile, MAXFILENAMELEN, "%s/lsb.events.%d",
+                      eventDir, ++maxEventFile);
+    } while (cc < MAXFILENAMELEN && stat(eventFile, &statBuf) == 0);
+
+    if (cc >= MAXFILENAMELEN) {
+        fprintf(stderr, "%s: %s\n", eventDir, strerror(ENAMETOOLONG));
+        exit(-1);
+    }
+
+    recNums = NULL;
+    maxRecs = 0;
+
+    for (n = maxEventFile - 1; n > 0; n--) {
+
+        if (snprintf(eventFile, MAXFILENAMELEN, "%s/lsb.events.%d",
+                     eventDir, n) >= MAXFILENAMELEN)
+            continue;
+
+        if ((idx = lsb_openeventidx(eventFile)) == NULL) {
+
+            if ((eLogHandle.fp = fopen(eventFile, "r")) == NULL) {
+                perror(eventFile);
+                continue;
+            }
+            strcpy(eLogHandle.openEventFile, eventFile);
+            eLogHandle.curOpenFile = n;
+            eLogHandle.lastOpenFile = n;
+            lineNum = 0;
+
+            while (TRUE) {
+                if ((log = lsbGetNextJobEvent(&eLogHandle, &lineNum,
+                                              reqPtr->numJobs,
+                                              reqPtr->jobIds,
+                                              NULL)) != NULL) {
+                    parse_event(log, reqPtr);
+                    continue;
+                }
+                if (lsberrno == LSBE_EOF || lsberrno == LSBE_NO_MEM)
+                    break;
+                ls_syslog(LOG_ERR, I18N(3203,
+                                        "File %s at line %d: %s\n"),   /* catgets 3203 */
+                          eventFile, lineNum, lsb_sysmsg());
+            }
+            fclose(eLogHandle.fp);
+            continue;
+        }
+
+        /* Merge the records of all the jobs
+         * back into file order.
+         */
+        numRecs = 0;
+        for (i = 0; i < reqPtr->numJobs; i++) {
+
+            for (j = 0; j < i; j++)
+                if (LSB_ARRAY_JOBID(reqPtr->jobIds[j])
+                    == LSB_ARRAY_JOBID(reqPtr->jobIds[i]))
+                    break;
+            if (j < i)
+                continue;
+
+            j = lsb_eventidxjob(idx, LSB_ARRAY_JOBID(reqPtr->jobIds[i]),
+                                &jobRecs);
+            if (numRecs + j > maxRecs) {
+                maxRecs = numRecs + j;
+                if ((recNums = realloc(recNums,
+                                       maxRecs * sizeof(int))) == NULL) {
+                    perror("realloc");
+                    exit(-1);
+                }
+            }
+            memcpy(recNums + numRecs, jobRecs, j * sizeof(int));
+            numRecs += j;
+        }
+        qsort(recNums, numRecs, sizeof(int), cmpRecNum);
+
+        for (i = 0; i < numRecs; i++) {
+            if ((log = lsb_geteventidxrec(idx, recNums[i])) != NULL) {
+                parse_event(log, reqPtr);
+                continue;
+            }
+            if (lsberrno == LSBE_NO_MEM) {
+                perror("malloc");
+                exit(-1);
+            }
+            ls_syslog(LOG_ERR, I18N(3203,
+                                    "File %s at line %d: %s\n"),   /* catgets 3203 */
+                      eventFile, recNums[i] + 1, lsb_sysmsg());
+        }
+
+        lsb_closeeventidx(idx);
+    }
+
+    FREEUP(recNums);
+}
+
 static void
 initLoadIndexNames(void)
 {
@@ -37,6 +37,7 @@
 
 #include "../cmd/cmd.h"
 #include "../lsbatch.h"
+#include "../../lsf/intlib/jidtab.h"
 
 #define OPT_ALL             0x1      
 #define OPT_DFTSTATUS       0x2      
@@ -162,7 +163,7 @@ struct jobRecord {
 					
 };
 
-extern struct hTab jobIdHT;
+extern jidTab jobIdHT;
 extern struct loadIndexLog *loadIndex;
 extern char *bhist_malloc(int);
 extern char *bhist_calloc(int, int);
@@ -198,7 +199,6 @@ extern struct jobInfoEnt *initJobInfo (void);
 extern char read_jobrequeue(struct eventRec *);
 extern int  matchJobId(struct bhistReq *, LS_LONG_INT);
 
-extern hEnt *chekMemb(struct hTab *tabPtr, LS_LONG_INT member); 
 extern void parse_event(struct eventRec *, struct bhistReq *);
 extern int bhistReqInit(struct bhistReq *);
 
@@ -22,14 +22,11 @@
 #include "../../lsf/lib/lib.table.h"
 #include "../../lsf/lib/lib.h"
 
-extern void initTab (struct hTab *tabPtr);
-extern hEnt *addMemb (struct hTab *tabPtr, LS_LONG_INT member);
-extern char remvMemb (struct hTab *tabPtr, LS_LONG_INT member);
 extern int  matchName(char *, char *);
 
 static void inJobList (struct jobRecord *pred, struct jobRecord *entry);
 static void offJobList(struct jobRecord *entry);
-static void insertModEvent( struct eventRec *log, hEnt *ent );
+static void insertModEvent( struct eventRec *log, jidEnt *ent );
 static struct jobRecord * createJobRec(int);
 
 #define GET_JOBID(jobId, idx) ((Req.options & OPT_ARRAY_INFO)) ? (jobId): LSB_JOBID((jobId), (idx))
@@ -486,7 +483,7 @@ freeJobRecord(struct jobRecord *jobRecord)
     offJobList(jobRecord);
 
 
-    remvMemb(&jobIdHT, jobRecord->job->jobId);
+    jidRmEnt(&jobIdHT, jobRecord->job->jobId);
 
     freeJobInfoEnt(jobRecord->job);
 
@@ -580,14 +577,14 @@ read_startjob(struct eventRec *log)
     struct jobStartLog *jobStartLog;
     int i;
     LS_LONG_INT jobId;
-    hEnt   *ent;
+    jidEnt   *ent;
 
     if (log->type == EVENT_JOB_EXECUTE)
         jobId = (Req.options & OPT_ARRAY_INFO) ? log->eventLog.jobExecuteLog.jobId : LSB_JOBID(log->eventLog.jobExecuteLog.jobId, log->eventLog.jobExecuteLog.idx);
     else
         jobId = (Req.options & OPT_ARRAY_INFO) ? log->eventLog.jobStartLog.jobId : LSB_JOBID(log->eventLog.jobStartLog.jobId, log->eventLog.jobStartLog.idx);
 
-    if( (ent = chekMemb(&jobIdHT, jobId)) == NULL) {
+    if( (ent = jidGetEnt(&jobIdHT, jobId)) == NULL) {
         return(NULL);
     }
     jobRecord = (struct jobRecord *) ent->hData;
@@ -657,13 +654,13 @@ read_newstat(struct eventRec *log)
     struct eventRecord *event;
     struct jobRecord *jobRecord;
     struct jobStatusLog *jobStatusLog;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.jobStatusLog.jobId,
                        log->eventLog.jobStatusLog.idx);
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL) {
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL) {
         if ((Req.options & OPT_CHRONICLE) &&
             matchJobId(&Req, log->eventLog.jobStatusLog.jobId)) {
             if ((jobRecord = createJobRec(log->eventLog.jobStatusLog.jobId))
@@ -707,14 +704,14 @@ read_sigact(struct eventRec *log)
     struct eventRecord *event;
     struct jobRecord *jobRecord;
     struct sigactLog *sigactLog;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.sigactLog.jobId,
                        log->eventLog.sigactLog.idx);
 
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
 
@@ -751,13 +748,13 @@ read_jobrequeue(struct eventRec *log)
 {
     struct eventRecord *event;
     struct jobRecord *jobRecord;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.jobRequeueLog.jobId,
                        log->eventLog.jobRequeueLog.idx);
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
     jobRecord = (struct jobRecord *)ent->hData;
@@ -781,13 +778,13 @@ read_chkpnt(struct eventRec *log)
     struct eventRecord *event;
     struct jobRecord *jobRecord;
     struct chkpntLog *chkLog;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.chkpntLog.jobId,
                        log->eventLog.chkpntLog.idx);
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
 
@@ -820,14 +817,14 @@ read_mig(struct eventRec *log)
     struct eventRecord *event;
     struct jobRecord *jobRecord;
     struct migLog *migLog;
-    hEnt   *ent;
+    jidEnt   *ent;
     int i;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.sigactLog.jobId,
                        log->eventLog.sigactLog.idx);
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
     jobRecord = (struct jobRecord *) ent->hData;
@@ -867,14 +864,14 @@ read_signal(struct eventRec *log)
 {
     struct eventRecord *event;
     struct jobRecord *jobRecord;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.signalLog.jobId,
                        log->eventLog.signalLog.idx);
 
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
     jobRecord = (struct jobRecord *) ent->hData;
@@ -904,14 +901,14 @@ read_jobstartaccept(struct eventRec *log)
 {
     struct eventRecord *event;
     struct jobRecord *jobRecord;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.jobStartAcceptLog.jobId,
                        log->eventLog.jobStartAcceptLog.idx);
 
 
-    if ((ent = chekMemb(&jobIdHT, jobId))
+    if ((ent = jidGetEnt(&jobIdHT, jobId))
         == NULL)
         return(FALSE);
 
@@ -936,13 +933,13 @@ read_jobmsg(struct eventRec *log)
 {
     struct eventRecord *event;
     struct jobRecord *jobRecord;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.jobMsgLog.jobId,
                        log->eventLog.jobMsgLog.idx);
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
     jobRecord = (struct jobRecord *) ent->hData;
@@ -977,13 +974,13 @@ read_jobmsgack(struct eventRec *log)
 {
     struct eventRecord *event;
     struct jobRecord *jobRecord;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.jobMsgAckLog.jobId,
                        log->eventLog.jobMsgAckLog.idx);
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
     jobRecord = (struct jobRecord *) ent->hData;
@@ -1022,14 +1019,14 @@ read_switch(struct eventRec *log)
 {
     struct eventRecord *event;
     struct jobRecord *jobRecord;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.jobSwitchLog.jobId,
                        log->eventLog.jobSwitchLog.idx);
 
 
-    if( (ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if( (ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
     jobRecord = (struct jobRecord *) ent->hData;
@@ -1060,14 +1057,14 @@ read_jobmove(struct eventRec *log)
 {
     struct eventRecord *event;
     struct jobRecord *jobRecord;
-    hEnt   *ent;
+    jidEnt   *ent;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.jobMoveLog.jobId,
                        log->eventLog.jobMoveLog.idx);
 
 
-    if( (ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if( (ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
     jobRecord = (struct jobRecord *) ent->hData;
@@ -1121,14 +1118,14 @@ char
 read_jobforce(struct eventRec *log)
 {
     struct eventRecord      *event;
-    hEnt                    *ent;
+    jidEnt                    *ent;
     struct jobRecord        *jobRecord;
     LS_LONG_INT jobId;
 
     jobId = GET_JOBID (log->eventLog.jobForceRequestLog.jobId,
                        log->eventLog.jobForceRequestLog.idx);
 
-    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return(FALSE);
 
     jobRecord = (struct jobRecord *) ent->hData;
@@ -1153,8 +1150,9 @@ read_jobforce(struct eventRec *log)
 int
 addJob(struct jobRecord *newjobRecord)
 {
-    hEnt *ent;
+    jidEnt *ent;
     struct jobRecord *jobRecord;
+    int new;
 
     newjobRecord->job->startTime = 0;
     newjobRecord->job->endTime = 0;
@@ -1165,12 +1163,12 @@ addJob(struct jobRecord *newjobRecord)
     newjobRecord->back = NULL;
     newjobRecord->nonNewFromHeadFlag = 0;
 
-    if ((ent = chekMemb(&jobIdHT, newjobRecord->job->jobId)) != NULL) {
+    if ((ent = jidGetEnt(&jobIdHT, newjobRecord->job->jobId)) != NULL) {
         jobRecord = (struct jobRecord *) ent->hData;
 
         if (newjobRecord->job->submitTime == jobRecord->job->submitTime) {
             freeJobRecord(jobRecord);
-            if ((ent = addMemb(&jobIdHT, newjobRecord->job->jobId)) != NULL)
+            if ((ent = jidAddEnt(&jobIdHT, newjobRecord->job->jobId, &new)) != NULL)
                 ent->hData = newjobRecord;
             else
                 return(-1);
@@ -1180,7 +1178,7 @@ addJob(struct jobRecord *newjobRecord)
     }
     else {
 
-        if ((ent = addMemb(&jobIdHT, newjobRecord->job->jobId)) != NULL)
+        if ((ent = jidAddEnt(&jobIdHT, newjobRecord->job->jobId, &new)) != NULL)
             ent->hData = newjobRecord;
     }
 
@@ -1283,7 +1281,7 @@ parse_event(struct eventRec *log, struct bhistReq *Req)
     struct jobRecord *newjobRecord, *jobRecord;
     struct eventRecord *event;
     int    i, found;
-    hEnt   *ent;
+    jidEnt   *ent;
     int oldjobnum = 0;
 
     if (logclass & LC_TRACE)
@@ -1415,7 +1413,7 @@ parse_event(struct eventRec *log, struct bhistReq *Req)
             break;
         case EVENT_JOB_MODIFY:
             job = read_newjob (log);
-            if((ent = chekMemb(&jobIdHT, job->jobId)) == NULL) {
+            if((ent = jidGetEnt(&jobIdHT, job->jobId)) == NULL) {
                 freeJobInfoEnt (job);
                 break;
             }
@@ -1461,29 +1459,25 @@ parse_event(struct eventRec *log, struct bhistReq *Req)
             sscanf(log->eventLog.jobModLog.jobIdStr, "%d[%d]", &array_jobId, &array_ele);
             jobId = LSB_JOBID(array_jobId, array_ele);
 
-            ent = chekMemb(&jobIdHT, jobId);
+            ent = jidGetEnt(&jobIdHT, jobId);
             if (ent  == NULL && numEles == 1) {
 
-                sTab  hashSearchPtr;
-                hEnt *hEntPtr = h_firstEnt_(&jobIdHT, &hashSearchPtr);
+                jidIter iter;
+                jidEnt *jidEntPtr = jidFirstEnt(&jobIdHT, &iter);
 
-                while ( hEntPtr) {
-                    LS_LONG_INT tmpId;
+                while ( jidEntPtr) {
                     int tmpArrId;
-                    tmpId    = atoi64_(hEntPtr->keyname);
-                    tmpArrId = LSB_ARRAY_JOBID(tmpId);
+                    tmpArrId = LSB_ARRAY_JOBID(jidEntPtr->key);
                     if ( tmpArrId == array_jobId )  {
-                        if ((ent = chekMemb(&jobIdHT, tmpId)) == NULL)
-                            break;
-                        insertModEvent(log, ent);
+                        insertModEvent(log, jidEntPtr);
                     }
-                    hEntPtr = h_nextEnt_( &hashSearchPtr);
+                    jidEntPtr = jidNextEnt(&iter);
                 }
             }
             else
                 for (i = 0; i < numEles; i++) {
                     jobId = LSB_JOBID(array_jobId, idxList[i]);
-                    if ((ent = chekMemb(&jobIdHT, jobId)) == NULL) {
+                    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL) {
 
                         break;
                     }
@@ -1677,7 +1671,7 @@ matchJobId(struct bhistReq *Req, LS_LONG_INT jobId)
 }
 
 
-static void insertModEvent( struct eventRec *log, hEnt *ent )
+static void insertModEvent( struct eventRec *log, jidEnt *ent )
 {
     struct jobRecord *jobRecord;
     struct eventRecord *event;
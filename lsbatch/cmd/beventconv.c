@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+
+#include <unistd.h>
+
+#include "cmd.h"
+
+/* Convert an event file, lsb.events or one of its
+ * backups, between the text and the framed binary
+ * record formats. The input can be in either format
+ * or a mix of the two as mbatchd leaves it when
+ * MBD_EVENTS_FORMAT is changed.
+ */
+
+static void
+usage(char *cmd)
+{
+    fprintf(stderr, "\
+usage: %s [-h] [-V] [-b | -t] infile outfile\n", cmd);
+    exit(-1);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct eventRec *logPtr;
+    char line[MAXLINELEN];
+    FILE *in;
+    FILE *out;
+    int binary;
+    int lineNum;
+    int num;
+    int cc;
+
+    binary = TRUE;
+
+    while ((cc = getopt(argc, argv, "Vhbt")) != EOF) {
+        switch (cc) {
+            case 'b':
+                binary = TRUE;
+                break;
+            case 't':
+                binary = FALSE;
+                break;
+            case 'V':
+                fputs(_LS_VERSION_, stderr);
+                exit(0);
+            case 'h':
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if (argc - optind != 2)
+        usage(argv[0]);
+
+    if ((in = fopen(argv[optind], "r")) == NULL) {
+        perror(argv[optind]);
+        exit(-1);
+    }
+
+    if ((out = fopen(argv[optind + 1], "w")) == NULL) {
+        perror(argv[optind + 1]);
+        exit(-1);
+    }
+
+    /* Keep the header line of the file,
+     * mbatchd puts a position there.
+     */
+    if (fgets(line, sizeof(line), in) != NULL && line[0] == '#')
+        fputs(line, out);
+    else
+        rewind(in);
+
+    lineNum = 0;
+    num = 0;
+    lsberrno = LSBE_NO_ERROR;
+
+    while (lsberrno != LSBE_EOF) {
+
+        if ((logPtr = lsb_geteventrec(in, &lineNum)) == NULL) {
+            if (lsberrno == LSBE_EOF)
+                break;
+            fprintf(stderr, "%s: record %d: %s\n",
+                    argv[optind], lineNum, lsb_sysmsg());
+            if (lsberrno == LSBE_NO_MEM)
+                exit(-1);
+            lsberrno = LSBE_NO_ERROR;
+            continue;
+        }
+
+        if (binary)
+            cc = lsb_puteventrec_bin(out, logPtr);
+        else
+            cc = lsb_puteventrec(out, logPtr);
+        if (cc < 0) {
+            fprintf(stderr, "%s: record %d: %s\n",
+                    argv[optind + 1], lineNum, lsb_sysmsg());
+            exit(-1);
+        }
+        ++num;
+    }
+
+    fclose(in);
+    if (fclose(out) != 0) {
+        perror(argv[optind + 1]);
+        exit(-1);
+    }
+
+    printf("%d records converted\n", num);
+
+    return 0;
+}
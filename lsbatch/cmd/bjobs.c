@@ -151,6 +151,12 @@ main (int argc, char **argv)
     if (format != LONG_FORMAT && !(options & (HOST_NAME | PEND_JOB)))
         options |= NO_PEND_REASONS;
 
+    /* Short formats print few fields,
+     * ask mbatchd only for those.
+     */
+    if (format != LONG_FORMAT && Wflag == FALSE)
+        options |= JOB_BRIEF_INFO;
+
     if (ls_readconfenv(securebjobsParams,NULL)){
         ls_perror("ls_readconfenv");
         exit(-1);
@@ -192,7 +198,7 @@ main (int argc, char **argv)
         exit(-1);
     }
 
-    options &= ~NO_PEND_REASONS;
+    options &= ~(NO_PEND_REASONS | JOB_BRIEF_INFO);
     jobDisplayed = 0;
 
     for (i = 0; i < jInfoH->numJobs; i++) {
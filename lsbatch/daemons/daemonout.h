@@ -73,6 +73,7 @@ typedef enum {
     BATCH_UNUSED_39      = 39,
 
     BATCH_STATUS_CHUNK   = 40,
+    BATCH_STATUS_BATCH   = 41,
 
 
     BATCH_SET_JOB_ATTR    = 90,
@@ -291,6 +292,9 @@ typedef enum {
 	CMD_SBD_DEBUG   = 7,
         UNUSED_8        = 8,
 	MBD_MODIFY_JOB  = 9,
+        MBD_OPEN_CHAN   = 10,
+        MBD_NEW_JOB_GO  = 11,
+        MBD_NEW_JOB_ABORT = 12,
 
         SBD_JOB_SETUP   = 100,
         SBD_SYSLOG      = 101,
@@ -327,6 +331,7 @@ extern int handShake_(int , char, int);
 #define CALL_SERVER_USE_SOCKET    0x2
 #define CALL_SERVER_NO_HANDSHAKE  0x4
 #define CALL_SERVER_ENQUEUE_ONLY  0x8
+#define CALL_SERVER_GIVE_BUF      0x10  /* call_server frees the request */
 extern int call_server(char *, ushort, char *, int, char **,
                struct LSFHeader *, int, int, int *, int (*)(),
                int *, int);
@@ -85,6 +85,13 @@ struct config_param daemonParams[] = {
     {"LSB_STDOUT_DIRECT", NULL},
     {"MBD_DONT_FORK", NULL},
     {"LIM_NO_MIGRANT_HOSTS", NULL},
+    {"MBD_QUERY_CHILDREN", NULL},
+    {"MBD_MAX_QUERIES", NULL},
+    {"MBD_EVENTS_COMMIT_DELAY", NULL},
+    {"MBD_EVENTS_FORMAT", NULL},
+    {"MBD_REPLAY_THREADS", NULL},
+    {"MBD_LOAD_POLL", NULL},
+    {"LSB_JOB_CGROUP", NULL},
     {NULL, NULL}
 };
 
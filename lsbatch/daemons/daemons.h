@@ -153,6 +153,13 @@
 #define LSB_STDOUT_DIRECT      53
 #define MBD_DONT_FORK          54
 #define LIM_NO_MIGRANT_HOSTS   55
+#define MBD_QUERY_CHILDREN     56
+#define MBD_MAX_QUERIES        57
+#define MBD_EVENTS_COMMIT_DELAY 58
+#define MBD_EVENTS_FORMAT      59
+#define MBD_REPLAY_THREADS     60
+#define MBD_LOAD_POLL          61
+#define LSB_JOB_CGROUP         62
 #define NOT_LOG  INFINIT_INT
 
 #define JOB_SAVE_OUTPUT   0x10000000
@@ -319,6 +326,22 @@ struct chunkStatusReq {
     struct  statusReq    **statusReqs;
 };
 
+/* BATCH_STATUS_BATCH, the status or the rusage of many
+ * jobs, reqTypes[i] being BATCH_STATUS_JOB or
+ * BATCH_RUSAGE_JOB for statusReqs[i]. The reply has a
+ * code per job in the same order.
+ */
+struct statusBatchReq {
+    int                  numStatusReqs;
+    int                  *reqTypes;
+    struct statusReq     *statusReqs;
+};
+
+struct statusBatchReply {
+    int                  numReplies;
+    int                  *replies;
+};
+
 
 struct sbdPackage {
     int    managerId;
@@ -556,6 +579,8 @@ extern int xdr_sbdPackage1(XDR *xdrs, struct sbdPackage *, struct LSFHeader *);
 extern int xdr_jobReply(XDR *xdrs, struct jobReply *jobReply, struct LSFHeader *);
 extern int xdr_jobSig(XDR *xdrs, struct jobSig *jobSig, struct LSFHeader *);
 extern int xdr_chunkStatusReq(XDR *, struct chunkStatusReq *, struct LSFHeader *);
+extern int xdr_statusBatchReq(XDR *, struct statusBatchReq *, struct LSFHeader *);
+extern int xdr_statusBatchReply(XDR *, struct statusBatchReply *, struct LSFHeader *);
 
 extern float normalizeRq_(float rawql, float cpuFactor, int nprocs);
 
@@ -625,6 +625,103 @@ xdr_chunkStatusReq (XDR *xdrs, struct chunkStatusReq *chunkStatusReq,
     return(TRUE);
 } 
 
+bool_t
+xdr_statusBatchReq(XDR *xdrs, struct statusBatchReq *req,
+                   struct LSFHeader *hdr)
+{
+    int i;
+
+    if (xdrs->x_op == XDR_FREE) {
+        for (i = 0; i < req->numStatusReqs; i++)
+            xdr_lsffree(xdr_statusReq, (char *)&req->statusReqs[i], hdr);
+        FREEUP(req->statusReqs);
+        FREEUP(req->reqTypes);
+        req->numStatusReqs = 0;
+        return TRUE;
+    }
+
+    if (xdrs->x_op == XDR_DECODE) {
+        req->numStatusReqs = 0;
+        req->reqTypes = NULL;
+        req->statusReqs = NULL;
+    }
+
+    if (!xdr_int(xdrs, &req->numStatusReqs))
+        return FALSE;
+
+    if (req->numStatusReqs < 0)
+        return FALSE;
+
+    if (xdrs->x_op == XDR_DECODE && req->numStatusReqs > 0) {
+        req->reqTypes = calloc(req->numStatusReqs, sizeof(int));
+        req->statusReqs = calloc(req->numStatusReqs,
+                                 sizeof(struct statusReq));
+        if (req->reqTypes == NULL || req->statusReqs == NULL) {
+            FREEUP(req->reqTypes);
+            FREEUP(req->statusReqs);
+            req->numStatusReqs = 0;
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < req->numStatusReqs; i++) {
+        if (!xdr_int(xdrs, &req->reqTypes[i])
+            || !xdr_statusReq(xdrs, &req->statusReqs[i], hdr)) {
+            /* Free the requests decoded so far.
+             */
+            if (xdrs->x_op == XDR_DECODE) {
+                req->numStatusReqs = i;
+                xdr_lsffree(xdr_statusBatchReq, (char *)req, hdr);
+            }
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+bool_t
+xdr_statusBatchReply(XDR *xdrs, struct statusBatchReply *reply,
+                     struct LSFHeader *hdr)
+{
+    int i;
+
+    if (xdrs->x_op == XDR_FREE) {
+        FREEUP(reply->replies);
+        reply->numReplies = 0;
+        return TRUE;
+    }
+
+    if (xdrs->x_op == XDR_DECODE) {
+        reply->numReplies = 0;
+        reply->replies = NULL;
+    }
+
+    if (!xdr_int(xdrs, &reply->numReplies)
+        || reply->numReplies < 0)
+        return FALSE;
+
+    if (xdrs->x_op == XDR_DECODE && reply->numReplies > 0) {
+        reply->replies = calloc(reply->numReplies, sizeof(int));
+        if (reply->replies == NULL) {
+            reply->numReplies = 0;
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < reply->numReplies; i++) {
+        if (!xdr_int(xdrs, &reply->replies[i])) {
+            if (xdrs->x_op == XDR_DECODE) {
+                FREEUP(reply->replies);
+                reply->numReplies = 0;
+            }
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 bool_t 
 xdr_sbdPackage (XDR *xdrs, struct sbdPackage *sbdPackage, struct LSFHeader *hdr)
 {
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+
+#include "mbd.h"
+
+/* Memory of the scheduling session.
+ *
+ * The candidate host arrays of the pending jobs and
+ * the scratch arrays of the scheduler live only until
+ * disp_clean() ends the session. They are carved out
+ * of big chunks by moving a pointer and are never freed
+ * one by one, the whole arena is reset at once when the
+ * session is over. The chunks are kept for the next
+ * session so a steady mbatchd does not call malloc()
+ * for them at all, but no more than ARENA_KEEP_MAX is
+ * kept so a single big session does not hold on to its
+ * memory for the life of mbatchd.
+ */
+
+#define ARENA_CHUNK_SIZE  (256 * 1024)
+#define ARENA_KEEP_MAX    (4 * ARENA_CHUNK_SIZE)
+#define ARENA_ALIGN       16
+#define ARENA_ROUND(n)    (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+struct arenaChunk {
+    struct arenaChunk   *next;
+    size_t              size;
+    size_t              used;
+};
+
+#define CHUNK_HDR  ARENA_ROUND(sizeof(struct arenaChunk))
+#define CHUNK_DATA(c)  ((char *)(c) + CHUNK_HDR)
+
+static struct arenaChunk *chunks;
+static struct arenaChunk *curChunk;
+
+static struct arenaStats {
+    int      numAllocs;
+    size_t   numBytes;
+    int      numChunks;
+    size_t   maxBytes;
+} arenaStats;
+
+static struct arenaChunk *newChunk(size_t);
+
+/* sessionAlloc()
+ * size bytes, zeroed, valid until the end of the
+ * scheduling session. Returns NULL if there is no
+ * memory.
+ */
+void *
+sessionAlloc(size_t size)
+{
+    struct arenaChunk *c;
+    void *p;
+
+    size = ARENA_ROUND(size > 0 ? size : 1);
+
+    for (c = curChunk; c; c = c->next) {
+        if (c->size - c->used >= size)
+            break;
+    }
+
+    if (c == NULL) {
+        c = newChunk(size > ARENA_CHUNK_SIZE ? size : ARENA_CHUNK_SIZE);
+        if (c == NULL)
+            return NULL;
+        if (curChunk) {
+            c->next = curChunk->next;
+            curChunk->next = c;
+        } else {
+            c->next = chunks;
+            chunks = c;
+        }
+    }
+
+    curChunk = c;
+    p = CHUNK_DATA(c) + c->used;
+    c->used += size;
+    memset(p, 0, size);
+
+    arenaStats.numAllocs++;
+    arenaStats.numBytes += size;
+    INC_CNT(PROF_CNT_sessionAlloc);
+
+    return p;
+}
+
+/* sessionArenaReset()
+ * Release everything allocated in the session. If the
+ * session did not fit in one chunk, or used less than
+ * half of it, the chunks are replaced by a single one
+ * as big as the session was, within ARENA_CHUNK_SIZE
+ * and ARENA_KEEP_MAX.
+ */
+void
+sessionArenaReset(void)
+{
+    struct arenaChunk *c;
+    struct arenaChunk *next;
+    size_t keep;
+
+    if (chunks == NULL)
+        return;
+
+    if (arenaStats.numBytes > arenaStats.maxBytes)
+        arenaStats.maxBytes = arenaStats.numBytes;
+
+    if (logclass & LC_SCHED) {
+        ls_syslog(LOG_DEBUG, "\
+%s: session allocations %d bytes %lu chunks %d max bytes %lu", __func__,
+                  arenaStats.numAllocs, (unsigned long)arenaStats.numBytes,
+                  arenaStats.numChunks, (unsigned long)arenaStats.maxBytes);
+    }
+
+    keep = arenaStats.numBytes;
+    if (keep < ARENA_CHUNK_SIZE)
+        keep = ARENA_CHUNK_SIZE;
+    if (keep > ARENA_KEEP_MAX)
+        keep = ARENA_KEEP_MAX;
+
+    if (chunks->next != NULL
+        || chunks->size > ARENA_KEEP_MAX
+        || chunks->size / 2 > keep) {
+        for (c = chunks; c; c = next) {
+            next = c->next;
+            free(c);
+        }
+        chunks = NULL;
+        arenaStats.numChunks = 0;
+        /* Failing here is not fatal, the next session
+         * gets its chunks as it goes.
+         */
+        chunks = newChunk(keep);
+    }
+
+    if (chunks)
+        chunks->used = 0;
+    curChunk = chunks;
+
+    arenaStats.numAllocs = 0;
+    arenaStats.numBytes = 0;
+}
+
+static struct arenaChunk *
+newChunk(size_t size)
+{
+    struct arenaChunk *c;
+
+    c = malloc(CHUNK_HDR + size);
+    if (c == NULL) {
+        ls_syslog(LOG_ERR, "%s: malloc(%lu) failed %M", __func__,
+                  (unsigned long)(CHUNK_HDR + size));
+        return NULL;
+    }
+
+    c->next = NULL;
+    c->size = size;
+    c->used = 0;
+    arenaStats.numChunks++;
+
+    return c;
+}
@@ -44,6 +44,46 @@ extern sbdReplyType start_ajob (struct jData *jDataPtr, struct qData *qp, struct
 
 struct sbdNode sbdNodeList = {&sbdNodeList, &sbdNodeList, 0, NULL, NULL, 0};
 
+/* The channel mbatchd keeps open to the sbatchd of a host.
+ * Once sbatchd accepted MBD_OPEN_CHAN the requests that
+ * do not wait for their reply are queued on it tagged,
+ * sbatchd answers them in order with the same tag so
+ * the replies are matched against the pending list of
+ * the channel and many of them can be in flight. Until
+ * then, or with a sbatchd that does not know the channel,
+ * every request has a connection of its own as before.
+ */
+struct sbdChan {
+    char *host;
+    int chanfd;
+    int state;
+#define SBD_CHAN_NONE     0
+#define SBD_CHAN_OPENING  1
+#define SBD_CHAN_OPEN     2
+#define SBD_CHAN_REFUSED  3
+    unsigned int nextTag;
+    int numPend;
+    struct sbdNode *pendHead;
+    struct sbdNode *pendTail;
+    time_t retryTime;
+};
+
+/* How long to wait before asking again
+ * a sbatchd that refused the channel.
+ */
+#define SBD_CHAN_RETRY 600
+
+static hTab sbdChanTab;
+static struct sbdChan **sbdChanMap;
+
+static struct sbdChan *getSbdChan(struct hData *, int);
+static void openSbdChan(struct sbdChan *);
+static void closeSbdChan(struct sbdChan *);
+static int sbdChanSend(struct sbdChan *, char *, int, struct lenData *,
+                       int, struct sbdNode *);
+static int sbdChanSeg(struct Buffer **, char *, int, int);
+static void sbdChanFreeMsg(struct Buffer *, char *, struct lenData *, int);
+
 sbdReplyType
 start_job (struct jData *jDataPtr, struct qData *qp, struct jobReply *jobReply)
 {
@@ -147,16 +187,18 @@ start_ajob (struct jData *jDataPtr,
     sbdNode.hData = hostData;
     sbdNode.reqCode = MBD_NEW_JOB;
 
+    /* The request and the job file are queued on the
+     * sbatchd channel as they are, call_server() frees them.
+     */
     reply = callSBD(toHost, request_buf, XDR_GETPOS(&xdrs), &reply_buf, &hdr,
                     sndJobFile_, (int *) &jf, hostData, lastHost, fname,
                     &errcnt, &cc,
-                    CALL_SERVER_NO_WAIT_REPLY | CALL_SERVER_NO_HANDSHAKE,
+                    CALL_SERVER_NO_WAIT_REPLY | CALL_SERVER_NO_HANDSHAKE
+                    | CALL_SERVER_GIVE_BUF,
                     &sbdNode, &socket);
 
     xdr_destroy(&xdrs);
-    free (request_buf);
     freeJobSpecs (&jobSpecs);
-    free(jf.data);
 
     if (reply == ERR_NULL || reply == ERR_FAIL || reply == ERR_UNREACH_SBD)
         return (reply);
@@ -684,11 +726,30 @@ callSBD(char *toHost,
 {
     static char fname[] = "callSBD";
     struct sbdNode *newSbdNode;
+    struct sbdChan *chan;
 
     if (daemonParams[LSB_MBD_BLOCK_SEND].paramValue == NULL
         && strcmp(caller, "msg_job") != 0)
         callServerFlags |= CALL_SERVER_ENQUEUE_ONLY;
 
+    chan = NULL;
+    if (sbdPtr && (callServerFlags & CALL_SERVER_ENQUEUE_ONLY)
+        && (chan = getSbdChan(hPtr, FALSE)) != NULL) {
+
+        if (sbdChanSend(chan, request_buf, len,
+                        postSndFunc ? (struct lenData *)postSndFuncArg : NULL,
+                        callServerFlags & CALL_SERVER_GIVE_BUF,
+                        sockPtr ? sbdPtr : NULL) == 0) {
+            *reply_buf = NULL;
+            *cc = 0;
+            lastHost[0] = '\0';
+            if (*cnt >= 0)
+                hStatChange (hPtr, HOST_STAT_OK);
+            *cnt = 0;
+            return ERR_NO_ERROR;
+        }
+    }
+
     *cc = call_server(toHost,
                       sbd_port,
                       request_buf,
@@ -753,13 +814,22 @@ callSBD(char *toHost,
                                    fname);
             memcpy(newSbdNode, sbdPtr, sizeof(struct sbdNode));
             newSbdNode->chanfd = *sockPtr;
+            newSbdNode->tag = 0;
+            newSbdNode->reply = NULL;
+            newSbdNode->nextPend = NULL;
             newSbdNode->lastTime = now;
             chanSetMode_(*sockPtr, CHAN_MODE_NONBLOCK);
             inList((struct listEntry *) &sbdNodeList,
                    (struct listEntry *) newSbdNode);
+            sbdMap[newSbdNode->chanfd] = newSbdNode;
                 nSbdConnections++;
 
         }
+        /* sbatchd answers, open the channel for
+         * the next requests to the host.
+         */
+        if (sbdPtr && (callServerFlags & CALL_SERVER_ENQUEUE_ONLY))
+            getSbdChan(hPtr, TRUE);
         return ERR_NO_ERROR;
     }
 
@@ -829,3 +899,491 @@ callSbdDebug(struct debugReq *pdebug)
                   __func__, reply, pdebug->hostName);
     return reply;
 }
+
+/* getSbdChan()
+ * The open channel to the sbatchd of hPtr, NULL if the
+ * request has to use a connection of its own. With open
+ * the channel is opened if there is none yet, this is
+ * done once sbatchd answered on such a connection so
+ * an unreachable host is not called twice.
+ */
+static struct sbdChan *
+getSbdChan(struct hData *hPtr, int open)
+{
+    static int first = TRUE;
+    struct sbdChan *chan;
+    hEnt *ent;
+    int new;
+
+    if (daemonParams[LSB_MBD_BLOCK_SEND].paramValue != NULL)
+        return NULL;
+
+    if (first) {
+        h_initTab_(&sbdChanTab, 64);
+        sbdChanMap = my_calloc(sysconf(_SC_OPEN_MAX),
+                               sizeof(struct sbdChan *), __func__);
+        first = FALSE;
+    }
+
+    ent = h_addEnt_(&sbdChanTab, hPtr->host, &new);
+    if (new) {
+        chan = my_calloc(1, sizeof(struct sbdChan), __func__);
+        chan->host = safeSave(hPtr->host);
+        chan->chanfd = -1;
+        chan->state = SBD_CHAN_NONE;
+        chan->nextTag = 1;
+        ent->hData = (int *)chan;
+    }
+    chan = (struct sbdChan *)ent->hData;
+
+    switch (chan->state) {
+        case SBD_CHAN_OPEN:
+            return chan;
+        case SBD_CHAN_REFUSED:
+            if (now < chan->retryTime)
+                break;
+            chan->state = SBD_CHAN_NONE;
+            /* fall through */
+        case SBD_CHAN_NONE:
+            if (open)
+                openSbdChan(chan);
+            break;
+        default:
+            break;
+    }
+
+    return NULL;
+}
+
+/* openSbdChan()
+ * Connect and queue MBD_OPEN_CHAN, the channel is
+ * used once sbatchd accepted it in sbdChanIO().
+ */
+static void
+openSbdChan(struct sbdChan *chan)
+{
+    struct LSFHeader hdr;
+    struct LSFHeader replyHdr;
+    char request_buf[LSF_HEADER_LEN];
+    char *reply_buf;
+    XDR xdrs;
+    int s;
+
+    initLSFHeader_(&hdr);
+    hdr.opCode = MBD_OPEN_CHAN;
+    xdrmem_create(&xdrs, request_buf, sizeof(request_buf), XDR_ENCODE);
+    if (!xdr_encodeMsg(&xdrs, NULL, &hdr, NULL, 0, NULL)) {
+        ls_syslog(LOG_ERR, "\
+%s: xdr_encodeMsg() failed for host %s", __func__, chan->host);
+        xdr_destroy(&xdrs);
+        return;
+    }
+
+    if (call_server(chan->host,
+                    sbd_port,
+                    request_buf,
+                    XDR_GETPOS(&xdrs),
+                    &reply_buf,
+                    &replyHdr,
+                    connTimeout,
+                    0,
+                    &s,
+                    NULL,
+                    NULL,
+                    CALL_SERVER_NO_WAIT_REPLY | CALL_SERVER_NO_HANDSHAKE
+                    | CALL_SERVER_ENQUEUE_ONLY) < 0) {
+        ls_syslog(LOG_DEBUG, "\
+%s: cannot open channel to host %s: %s", __func__, chan->host, lsb_sysmsg());
+        chan->state = SBD_CHAN_REFUSED;
+        chan->retryTime = now + SBD_CHAN_RETRY;
+        xdr_destroy(&xdrs);
+        return;
+    }
+    xdr_destroy(&xdrs);
+
+    chan->chanfd = s;
+    chan->state = SBD_CHAN_OPENING;
+    sbdChanMap[s] = chan;
+    nSbdConnections++;
+
+    if (logclass & LC_COMM)
+        ls_syslog(LOG_DEBUG, "\
+%s: opening channel %d to host %s", __func__, s, chan->host);
+}
+
+/* closeSbdChan()
+ * Close the channel and fail its pending requests, the
+ * next request to the host has a connection of its
+ * own and opens the channel again.
+ */
+static void
+closeSbdChan(struct sbdChan *chan)
+{
+    struct sbdNode *sbdPtr;
+
+    if (chan->state == SBD_CHAN_OPENING) {
+        ls_syslog(LOG_INFO, "\
+%s: sbatchd on host %s refused the channel, retry in %d seconds",
+                  __func__, chan->host, SBD_CHAN_RETRY);
+        chan->state = SBD_CHAN_REFUSED;
+        chan->retryTime = now + SBD_CHAN_RETRY;
+    } else {
+        ls_syslog(LOG_INFO, "\
+%s: channel to host %s closed with %d pending requests",
+                  __func__, chan->host, chan->numPend);
+        chan->state = SBD_CHAN_NONE;
+    }
+
+    sbdChanMap[chan->chanfd] = NULL;
+    chanClose_(chan->chanfd);
+    chan->chanfd = -1;
+    nSbdConnections--;
+
+    while ((sbdPtr = chan->pendHead) != NULL) {
+        chan->pendHead = sbdPtr->nextPend;
+        chan->numPend--;
+        if (sbdPtr->hData == NULL)
+            sbdDone(sbdPtr);
+        else
+            processSbdNode(sbdPtr, TRUE);
+    }
+    chan->pendTail = NULL;
+}
+
+/* sbdChanIO()
+ * Process the message chanPoll_() found on chfd if
+ * it is the channel of a sbatchd. Returns FALSE if
+ * chfd is not such a channel.
+ */
+int
+sbdChanIO(int chfd, int exception)
+{
+    struct sbdChan *chan;
+    struct sbdNode *sbdPtr;
+    struct LSFHeader hdr;
+    struct Buffer *buf;
+    XDR xdrs;
+
+    if (sbdChanMap == NULL
+        || (chan = sbdChanMap[chfd]) == NULL)
+        return FALSE;
+
+    if (exception) {
+        closeSbdChan(chan);
+        return TRUE;
+    }
+
+    if (chanDequeue_(chfd, &buf) < 0) {
+        ls_syslog(LOG_ERR, "\
+%s: chanDequeue_() failed on channel to host %s cherrno %d", __func__,
+                  chan->host, cherrno);
+        closeSbdChan(chan);
+        return TRUE;
+    }
+
+    xdrmem_create(&xdrs, buf->data, buf->len, XDR_DECODE);
+    if (!xdr_LSFHeader(&xdrs, &hdr)) {
+        ls_syslog(LOG_ERR, "\
+%s: xdr_LSFHeader() failed on channel to host %s", __func__, chan->host);
+        xdr_destroy(&xdrs);
+        chanFreeBuf_(buf);
+        closeSbdChan(chan);
+        return TRUE;
+    }
+    xdr_destroy(&xdrs);
+
+    if (chan->state == SBD_CHAN_OPENING) {
+        chanFreeBuf_(buf);
+        if (hdr.opCode != ERR_NO_ERROR) {
+            closeSbdChan(chan);
+            return TRUE;
+        }
+        chan->state = SBD_CHAN_OPEN;
+        ls_syslog(LOG_INFO, "\
+%s: channel %d to host %s open", __func__, chfd, chan->host);
+        return TRUE;
+    }
+
+    /* A request sent without sbdNode, like the probe
+     * not sending the jobs, has tag 0 and nobody waits
+     * for its reply, it must not fail the pending ones.
+     */
+    if (hdr.reserved0 == 0) {
+        chanFreeBuf_(buf);
+        return TRUE;
+    }
+
+    /* sbatchd answers in the order of the requests,
+     * one it did not answer is failed by the reply
+     * of a later one.
+     */
+    while ((sbdPtr = chan->pendHead) != NULL) {
+
+        chan->pendHead = sbdPtr->nextPend;
+        if (chan->pendHead == NULL)
+            chan->pendTail = NULL;
+        chan->numPend--;
+
+        if (sbdPtr->tag != hdr.reserved0) {
+            ls_syslog(LOG_WARNING, "\
+%s: no reply to request %d tag %u from host %s", __func__,
+                      sbdPtr->reqCode, sbdPtr->tag, chan->host);
+            if (sbdPtr->hData == NULL)
+                sbdDone(sbdPtr);
+            else
+                processSbdNode(sbdPtr, TRUE);
+            continue;
+        }
+
+        if (sbdPtr->hData == NULL) {
+            chanFreeBuf_(buf);
+            sbdDone(sbdPtr);
+            return TRUE;
+        }
+
+        sbdPtr->reply = buf;
+        processSbdNode(sbdPtr, FALSE);
+        return TRUE;
+    }
+
+    ls_syslog(LOG_WARNING, "\
+%s: reply %d tag %u from host %s matches no request", __func__,
+              hdr.opCode, hdr.reserved0, chan->host);
+    chanFreeBuf_(buf);
+
+    return TRUE;
+}
+
+/* sbdChanSend()
+ * Queue the request on the channel, the job file of
+ * MBD_NEW_JOB goes in the message after the job specs.
+ * With sbdPtr the reply is waited for on the pending
+ * list. With give the request and the job file are
+ * freed with the message, on failure they are left
+ * to the caller as they were.
+ */
+static int
+sbdChanSend(struct sbdChan *chan,
+            char *request_buf,
+            int len,
+            struct lenData *jf,
+            int give,
+            struct sbdNode *sbdPtr)
+{
+    static char pad[4];
+    char hdrBuf[LSF_HEADER_LEN];
+    struct sbdNode *newSbdNode;
+    struct LSFHeader hdr;
+    struct Buffer *msg;
+    unsigned int tag;
+    XDR xdrs;
+    int nlen;
+
+    memcpy(hdrBuf, request_buf, LSF_HEADER_LEN);
+
+    xdrmem_create(&xdrs, request_buf, LSF_HEADER_LEN, XDR_DECODE);
+    if (!xdr_LSFHeader(&xdrs, &hdr)) {
+        xdr_destroy(&xdrs);
+        return -1;
+    }
+    xdr_destroy(&xdrs);
+
+    tag = 0;
+    if (sbdPtr) {
+        tag = chan->nextTag++;
+        if (chan->nextTag == 0)
+            chan->nextTag = 1;
+    }
+    hdr.reserved0 = tag;
+    if (jf)
+        hdr.length += NET_INTSIZE_ + (jf->len + 3) / 4 * 4;
+
+    xdrmem_create(&xdrs, request_buf, LSF_HEADER_LEN, XDR_ENCODE);
+    xdr_LSFHeader(&xdrs, &hdr);
+    xdr_destroy(&xdrs);
+
+    msg = NULL;
+    if (sbdChanSeg(&msg, request_buf, len, give) < 0)
+        goto fail;
+
+    if (jf) {
+        nlen = htonl(jf->len);
+        if (sbdChanSeg(&msg, (char *) NET_INTADDR_(&nlen),
+                       NET_INTSIZE_, FALSE) < 0
+            || sbdChanSeg(&msg, jf->data, jf->len, give) < 0)
+            goto fail;
+        if (jf->len % 4
+            && sbdChanSeg(&msg, pad, 4 - jf->len % 4, FALSE) < 0)
+            goto fail;
+    }
+
+    if (chanEnqueue_(chan->chanfd, msg) < 0) {
+        ls_syslog(LOG_ERR, "\
+%s: chanEnqueue_() failed on channel to host %s cherrno %d", __func__,
+                  chan->host, cherrno);
+        goto fail;
+    }
+
+    if (sbdPtr == NULL)
+        return 0;
+
+    newSbdNode = my_malloc(sizeof(struct sbdNode), __func__);
+    memcpy(newSbdNode, sbdPtr, sizeof(struct sbdNode));
+    newSbdNode->chanfd = chan->chanfd;
+    newSbdNode->tag = tag;
+    newSbdNode->reply = NULL;
+    newSbdNode->nextPend = NULL;
+    newSbdNode->lastTime = now;
+    inList((struct listEntry *) &sbdNodeList,
+           (struct listEntry *) newSbdNode);
+
+    if (chan->pendTail)
+        chan->pendTail->nextPend = newSbdNode;
+    else
+        chan->pendHead = newSbdNode;
+    chan->pendTail = newSbdNode;
+    chan->numPend++;
+
+    return 0;
+
+fail:
+    sbdChanFreeMsg(msg, request_buf, jf, give);
+    memcpy(request_buf, hdrBuf, LSF_HEADER_LEN);
+    return -1;
+}
+
+static int
+sbdChanSeg(struct Buffer **msg, char *data, int len, int attach)
+{
+    struct Buffer *seg;
+
+    if (attach) {
+        if (chanAttachBuf_(&seg, data, len) < 0)
+            return -1;
+    } else {
+        if (chanAllocBuf_(&seg, len) < 0)
+            return -1;
+        memcpy(seg->data, data, len);
+    }
+    seg->len = len;
+
+    if (*msg == NULL)
+        *msg = seg;
+    else
+        chanChainBuf_(*msg, seg);
+
+    return 0;
+}
+
+/* sbdChanFreeMsg()
+ * Free a message that could not be queued, the
+ * request and job file it was given are not.
+ */
+static void
+sbdChanFreeMsg(struct Buffer *msg, char *request_buf,
+               struct lenData *jf, int give)
+{
+    struct Buffer *seg;
+
+    if (msg == NULL)
+        return;
+
+    if (give) {
+        for (seg = msg; seg; seg = seg->next) {
+            if (seg->data == request_buf
+                || (jf && seg->data == jf->data))
+                seg->data = NULL;
+        }
+    }
+    chanFreeBuf_(msg);
+}
+
+/* sbdRecv()
+ * The reply to the request of sbdPtr, read from its
+ * connection or already matched on the channel.
+ */
+int
+sbdRecv(struct sbdNode *sbdPtr, struct Buffer **buf)
+{
+    if (sbdPtr->tag == 0)
+        return chanRecv_(sbdPtr->chanfd, buf);
+
+    if (sbdPtr->reply == NULL)
+        return -1;
+
+    *buf = sbdPtr->reply;
+    sbdPtr->reply = NULL;
+
+    return 0;
+}
+
+/* sbdGoAhead()
+ * Tell sbatchd the job of the MBD_NEW_JOB request of
+ * sbdPtr can go, or with MBD_NEW_JOB_ABORT it cannot.
+ */
+int
+sbdGoAhead(struct sbdNode *sbdPtr, sbdReqType reqCode)
+{
+    struct sbdChan *chan;
+    struct LSFHeader hdr;
+    struct Buffer *buf;
+    XDR xdrs;
+
+    chan = sbdChanMap[sbdPtr->chanfd];
+    if (chan == NULL || chan->state != SBD_CHAN_OPEN)
+        return -1;
+
+    if (chanAllocBuf_(&buf, LSF_HEADER_LEN) < 0) {
+        ls_syslog(LOG_ERR, "%s: chanAllocBuf_() failed %m", __func__);
+        return -1;
+    }
+
+    initLSFHeader_(&hdr);
+    hdr.opCode = reqCode;
+    hdr.reserved0 = sbdPtr->tag;
+
+    xdrmem_create(&xdrs, buf->data, LSF_HEADER_LEN, XDR_ENCODE);
+    xdr_LSFHeader(&xdrs, &hdr);
+    buf->len = XDR_GETPOS(&xdrs);
+    xdr_destroy(&xdrs);
+
+    if (chanEnqueue_(sbdPtr->chanfd, buf) < 0) {
+        ls_syslog(LOG_ERR, "\
+%s: chanEnqueue_() failed on channel to host %s cherrno %d", __func__,
+                  chan->host, cherrno);
+        chanFreeBuf_(buf);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* sbdCancel()
+ * The job of a request pending on the channel is gone,
+ * the request stays on the channel pending list with
+ * no job and no host until sbatchd answers it.
+ */
+void
+sbdCancel(struct sbdNode *sbdPtr)
+{
+    offList((struct listEntry *) sbdPtr);
+    sbdPtr->forw = sbdPtr->back = sbdPtr;
+    sbdPtr->jData = NULL;
+    sbdPtr->hData = NULL;
+}
+
+/* sbdDone()
+ * Free a request answered on the channel, a job that
+ * got no go-ahead is aborted by sbatchd.
+ */
+void
+sbdDone(struct sbdNode *sbdPtr)
+{
+    if (sbdPtr->reqCode == MBD_NEW_JOB)
+        sbdGoAhead(sbdPtr, MBD_NEW_JOB_ABORT);
+
+    offList((struct listEntry *) sbdPtr);
+    if (sbdPtr->reply)
+        chanFreeBuf_(sbdPtr->reply);
+    FREEUP(sbdPtr);
+}
@@ -90,6 +90,22 @@ struct exceptNodeData {
 static struct Stack *operatorStack;
 static struct Stack *operandStack;
 
+/* Reverse dependency graph. The value of the condition
+ * of a pending job is kept in the job until one of the
+ * jobs it names changes state. The first evaluation of
+ * a condition files the job under the jobs it names, a
+ * state change of one of those invalidates the jobs
+ * filed under it. Filed jobs stay filed until the named
+ * job is freed, a job whose condition was modified may
+ * be invalidated for nothing. Conditions on time windows,
+ * job group counters or job arrays depend on more than
+ * the named jobs and are evaluated at every pass.
+ */
+static jidTab depGraph;
+static unsigned int depSerial;
+
+static int depCondFile(struct dptNode *, struct jData *);
+
 static char *getToken(char **,  dptType *);
 static struct dptNode *newNode(dptType, void *);
 static int mergeNode(int );
@@ -481,6 +497,9 @@ parseDepCond (char *dependCond, struct lsfAuth *auth, int *replyCode, char **bad
         goto Error;
     }
     rootNode->updFlag = TRUE;
+    if (++depSerial == 0)
+        ++depSerial;
+    rootNode->serial = depSerial;
     freeStackDep(operatorStack, FALSE);
     freeStackDep(operandStack, FALSE);
     *replyCode = LSBE_NO_ERROR;
@@ -790,6 +809,152 @@ resetDepCond(struct dptNode *dptNode)
     }
 }
 
+/* depGraphInit()
+ */
+void
+depGraphInit(void)
+{
+    if (jidInitTab(&depGraph, 1024) < 0) {
+        ls_syslog(LOG_ERR, "%s: jidInitTab() failed %M", __func__);
+        mbdDie(MASTER_MEM);
+    }
+}
+
+/* depCondValue()
+ * The value of the dependency condition of a pending
+ * job, evaluated only if one of the jobs it names
+ * changed state since the last evaluation.
+ */
+int
+depCondValue(struct jData *jp)
+{
+    struct dptNode *root = jp->shared->dptRoot;
+
+    if (jp->depFiled != root->serial) {
+        jp->depVolatile = !depCondFile(root, jp);
+        jp->depFiled = root->serial;
+        jp->depSerial = 0;
+    }
+
+    if (jp->depVolatile)
+        return evalDepCond(root, jp);
+
+    if (jp->depSerial != root->serial) {
+        jp->depValue = evalDepCond(root, jp);
+        jp->depSerial = root->serial;
+    }
+
+    return jp->depValue;
+}
+
+/* depJobChanged()
+ * The job changed state, the value of the conditions
+ * naming it and of its own condition are stale.
+ */
+void
+depJobChanged(struct jData *jp)
+{
+    struct jData *dep;
+    jidEnt *ent;
+    jidIter iter;
+
+    jp->depSerial = 0;
+
+    if (jp->jobId <= 0
+        || (ent = jidGetEnt(&depGraph, jp->jobId)) == NULL)
+        return;
+
+    for (ent = jidFirstEnt(ent->hData, &iter); ent; ent = jidNextEnt(&iter)) {
+        if ((dep = getJobData(ent->key)) != NULL)
+            dep->depSerial = 0;
+    }
+}
+
+/* depJobRemove()
+ * The job is freed, invalidate the jobs filed under
+ * it and drop them.
+ */
+void
+depJobRemove(struct jData *jp)
+{
+    jidTab *deps;
+    jidEnt *ent;
+
+    depJobChanged(jp);
+
+    if (jp->jobId <= 0
+        || (ent = jidGetEnt(&depGraph, jp->jobId)) == NULL)
+        return;
+
+    deps = ent->hData;
+    jidRmEnt(&depGraph, jp->jobId);
+    jidFreeTab(deps, NULL);
+    FREEUP(deps);
+}
+
+/* depCondFile()
+ * File the job under the jobs its condition names.
+ * Returns FALSE if the value of the condition can
+ * change without any of them changing state.
+ */
+static int
+depCondFile(struct dptNode *node, struct jData *jp)
+{
+    struct jData *named;
+    jidEnt *ent;
+    int left;
+    int new;
+
+    switch (node->type) {
+        case DPT_AND:
+        case DPT_OR:
+            left = depCondFile(node->dptLeft, jp);
+            return depCondFile(node->dptRight, jp) && left;
+
+        case DPT_NOT:
+            return depCondFile(node->dptLeft, jp);
+
+        case DPT_DONE:
+        case DPT_POST_DONE:
+        case DPT_POST_ERR:
+        case DPT_ENDED:
+        case DPT_STARTED:
+        case DPT_EXIT:
+            named = node->dptJobRec;
+            if (named == NULL)
+                return TRUE;
+            if (named->nodeType == JGRP_NODE_ARRAY
+                || named->jobId <= 0
+                || jp->jobId <= 0)
+                return FALSE;
+
+            ent = jidAddEnt(&depGraph, named->jobId, &new);
+            if (ent == NULL) {
+                ls_syslog(LOG_ERR, "%s: jidAddEnt() failed for job %s %M",
+                          __func__, lsb_jobid2str(named->jobId));
+                mbdDie(MASTER_MEM);
+            }
+            if (new) {
+                ent->hData = my_malloc(sizeof(jidTab), __func__);
+                if (ent->hData == NULL
+                    || jidInitTab(ent->hData, 4) < 0) {
+                    ls_syslog(LOG_ERR, "%s: jidInitTab() failed %M",
+                              __func__);
+                    mbdDie(MASTER_MEM);
+                }
+            }
+            if (jidAddEnt(ent->hData, jp->jobId, &new) == NULL) {
+                ls_syslog(LOG_ERR, "%s: jidAddEnt() failed for job %s %M",
+                          __func__, lsb_jobid2str(jp->jobId));
+                mbdDie(MASTER_MEM);
+            }
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
 static
 char *getToken(char **sp, dptType *type)
 {
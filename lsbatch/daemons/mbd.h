@@ -21,6 +21,7 @@
 #include "daemonout.h"
 #include "daemons.h"
 #include "../../lsf/intlib/bitset.h"
+#include "../../lsf/intlib/jidtab.h"
 #include "jgrp.h"
 
 #define  DEF_CLEAN_PERIOD     3600
@@ -37,6 +38,7 @@
 #define  DEF_EVENT_WATCH_TIME 60
 #define  DEF_COND_CHECK_TIME  600
 #define DEF_MAX_SBD_CONNS     774
+#define MBD_RESERVED_FDS      250
 #define DEF_SCHED_STAY        3
 #define DEF_FRESH_PERIOD     15
 #define DEF_PEND_EXIT       512
@@ -203,11 +205,34 @@ struct candHost {
     LIST_T *backfilleeList;
 };
 
+/* Sort key of a candidate host for one load index,
+ * see sortHosts().
+ */
+struct hostSortKey {
+    int    tier;
+    float  key;
+    float  value;
+};
+
 struct askedHost {
     struct hData *hData;
     int    priority;
 };
 
+/* Per host pending reasons of a job, the reason in
+ * the low and the host id in the high 16 bits, shared
+ * by the jobs having the same, see mbd.reason.c.
+ */
+struct jReasonTb {
+    struct jReasonTb *next;
+    unsigned int hash;
+    int    refCount;
+    int    numReasons;
+    int    *reasons;
+};
+
+#define NUM_JOB_REASONS(jp) ((jp)->reasonTb ? (jp)->reasonTb->numReasons : 0)
+
 #define CLEAR_REASON(v, reason) if (v == reason) v = 0;
 #define SET_REASON(condition, v, reason) \
         if (condition) v = reason; else CLEAR_REASON(v, reason)
@@ -245,8 +270,7 @@ struct jData {
     int     oldReason;
     int     newReason;
     int     subreasons;
-    int     *reasonTb;
-    int     numReasons;
+    struct  jReasonTb *reasonTb;
     struct  qData *qPtr;
     struct  hData **hPtr;
     int     numHostPtr;
@@ -334,7 +358,18 @@ struct jData {
     int*   inEligibleGroups;
     int numSlotsReserve;
     int numAvailSlotsReserve;
-
+    int listNo;
+    unsigned long long listSeq;
+    /* Last value of the dependency condition,
+     * valid while depSerial is the serial of
+     * the condition, and the serial of the
+     * condition filed in the dependency graph,
+     * see depCondValue().
+     */
+    unsigned int depSerial;
+    int    depValue;
+    unsigned int depFiled;
+    int    depVolatile;
 };
 
 
@@ -634,8 +669,35 @@ struct hData {
     LIST_T    *pxySJL;
     LIST_T    *pxyRsvJL;
     float     leftRusageMem;
+    unsigned int selectEpoch;
 };
 
+/* Everything a select expression can read of a host,
+ * its load, status and the values of its resource
+ * instances, changed. Cached select results computed
+ * for the host before are no longer valid.
+ */
+#define HOST_SELECT_CHANGED(hPtr) ((hPtr)->selectEpoch++)
+
+/* Jobs whose select expression and submission host type
+ * and model are the same belong to the same select class,
+ * the class remembers for which hosts the expression is
+ * true. A host entry is valid as long as hostEpoch[hostId]
+ * matches the host selectEpoch, the whole class as long
+ * as its epoch matches the global selectEpoch.
+ */
+struct selectClass {
+    unsigned int    epoch;
+    int             session;
+    int             numHosts;
+    unsigned int    *hostEpoch;
+    LS_BITSET_T     *eligible;
+    LS_BITSET_T     *overRide;
+};
+
+extern unsigned int selectEpoch;
+#define SELECT_CLASSES_CHANGED() (++selectEpoch)
+
 
 struct sbdNode {
     struct sbdNode *forw;
@@ -647,6 +709,13 @@ struct sbdNode {
     time_t lastTime;
     int sigVal;
     int sigFlags;
+    /* Requests on the channel mbatchd keeps open
+     * to the sbatchd carry a tag, 0 is a request
+     * on a connection of its own.
+     */
+    unsigned int tag;
+    struct Buffer *reply;
+    struct sbdNode *nextPend;
 };
 
 extern struct sbdNode sbdNodeList;
@@ -707,6 +776,7 @@ struct dptNode {
     dptType type;
     int value;
     int updFlag;
+    unsigned int serial;
     union {
         struct {
             struct dptNode *left;
@@ -854,7 +924,9 @@ extern struct hTab            uDataList;
 extern struct hTab            calDataList;
 extern struct jData           *chkJList;
 extern struct clientNode      *clientList;
-extern struct hTab            jobIdHT;
+extern struct clientNode      **clientMap;
+extern struct sbdNode         **sbdMap;
+extern jidTab                 jobIdHT;
 extern struct hTab            jgrpIdHT;
 extern struct gData           *usergroups[];
 extern struct gData           *hostgroups[];
@@ -957,10 +1029,14 @@ extern void                 getTclHostData(struct tclHostData *,
 extern int                  getLsbHostNames (char ***);
 extern void                 getLsbHostInfo(void);
 extern int                  getLsbHostLoad(void);
+extern int                  limLoadChan;
+extern void                 limLoadIO(int);
 extern int                  getHostsByResReq(struct resVal *, int *,
                                              struct hData **,
                                              struct hData ***,
                                              struct hData *,int *);
+extern void                 instanceSelectChanged(struct resourceInstance *);
+extern void                 cleanSelectClasses(int);
 
 extern struct resVal *      checkResReq(char *, int);
 extern void                 adjLsbLoad(struct jData *, int, bool_t);
@@ -1047,6 +1123,13 @@ extern int                  resigJobs (int *resignal);
 extern void                 removeJob(LS_LONG_INT);
 extern bool_t               runJob(struct runJobRequest *, struct lsfAuth *);
 extern void                 addJobIdHT(struct jData *);
+extern int                  sjlNeedReorder;
+extern void                 jobIdxInit(void);
+extern void                 jobIdxEnter(struct jData *, int);
+extern void                 jobIdxUpdate(struct jData *);
+extern void                 jobIdxRemove(struct jData *);
+extern int                  jobIdxSelect(struct jobInfoReq *, int, int,
+                                         struct jData ***);
 extern struct jData      *createjDataRef (struct jData *);
 extern void               destroyjDataRef(struct jData *);
 extern void             setJobPendReason(struct jData *, int);
@@ -1103,6 +1186,8 @@ extern int                  hostSlots (int, struct jData *, struct hData *,
                                        int disp, int *);
 extern void                 disp_clean_job(struct jData *);
 extern bool_t               dispatch_it(struct jData *);
+extern int                  sendQueuedJobs(struct timeval *);
+extern void                 logDispatchStats(void);
 extern int                  findBestHosts (struct jData *, struct resVal *, int, int, struct candHost *, bool_t);
 extern int                  hJobLimitOk (struct hData *, struct hostAcct *, int);
 extern void                 freeReserveSlots (struct jData *);
@@ -1119,7 +1204,18 @@ extern int                  reservePreemptResourcesForHosts(struct jData *jp);
 extern int                  freeReservePreemptResources(struct jData *jp);
 extern int                  deallocReservePreemptResources(struct jData *jp);
 extern int                  orderByStatus (struct candHost *, int , bool_t);
+extern int                  hostStatusTier(int);
+extern int                  passSortHosts(struct candHost *,
+                                          struct hostSortKey *,
+                                          int, int, int);
 extern void                 setLsbPtilePack(const bool_t );
+extern void                 jobReasonFree(struct jData *);
+extern void                 jobReasonCopy(struct jData *, struct jData *);
+extern void                 jobReasonMerge(struct jData *, int *, int);
+extern void                 jobReasonAdd(struct jData *, int, int);
+extern void                 logReasonStats(void);
+extern void                 *sessionAlloc(size_t);
+extern void                 sessionArenaReset(void);
 extern int                  do_submitReq(XDR *, int, struct sockaddr_in *,
                                          char *, struct LSFHeader *,
                                          struct sockaddr_in *,
@@ -1135,6 +1231,9 @@ extern int                  do_jobMsg(struct bucket *, XDR *, int,
 extern int                  do_statusReq(XDR *, int, struct sockaddr_in *,
                                          int *,
                                          struct LSFHeader *);
+extern int                  do_statusBatchReq(XDR *, int,
+                                              struct sockaddr_in *, int *,
+                                              struct LSFHeader *);
 extern int                  do_errorReq(int,  struct LSFHeader *);
 extern int                  do_jobSwitchReq(XDR *, int, struct sockaddr_in *,
                                             char *, struct LSFHeader *,
@@ -1182,6 +1281,15 @@ extern int                  do_migReq(XDR *, int, struct sockaddr_in *, char *,
 extern int                  do_modifyReq (XDR *, int, struct sockaddr_in *,
                                           char *, struct LSFHeader *,
                                           struct lsfAuth *);
+extern int                  isQueryReq(mbdReqType);
+extern void                 doQueryReq(XDR *, int, struct sockaddr_in *,
+                                       struct LSFHeader *);
+extern int                  queryServerDispatch(struct clientNode *,
+                                                struct Buffer *,
+                                                struct LSFHeader *);
+extern void                 queryServerUpdate(mbdReqType);
+extern void                 queryServerRefresh(void);
+extern void                 queryServerStats(void);
 extern void                 doNewJobReply(struct sbdNode *, int);
 extern void                 doProbeReply(struct sbdNode *, int);
 extern void                 doSignalJobReply(struct sbdNode *sbdPtr, int);
@@ -1332,6 +1440,10 @@ extern void                 replay_requeuejob(struct jData *);
 extern int                  init_log(void);
 extern void                 switchELog(void);
 extern int                  switch_log(void);
+extern int                  elogCommit(void);
+extern int                  elogCommitTimer(struct timeval *);
+extern void                 elogHold(void);
+extern int                  elogRelease(void);
 extern void                 checkAcctLog(void);
 extern int                  switchAcctLog(void);
 extern void                 logJobInfo(struct submitReq *, struct jData *,
@@ -1368,11 +1480,21 @@ extern sbdReplyType         msg_job(struct jData *, struct Buffer *,
 extern sbdReplyType         probe_slave(struct hData *, char sendJobs);
 extern sbdReplyType         rebootSbd(char *host);
 extern sbdReplyType         shutdownSbd(char *host);
+extern int                  sbdChanIO(int, int);
+extern int                  sbdRecv(struct sbdNode *, struct Buffer **);
+extern int                  sbdGoAhead(struct sbdNode *, sbdReqType);
+extern void                 sbdCancel(struct sbdNode *);
+extern void                 sbdDone(struct sbdNode *);
+extern void                 processSbdNode(struct sbdNode *, int);
 extern struct dptNode *     parseDepCond(char *, struct lsfAuth * ,
                                          int *, char **,int *, int);
 extern int                  evalDepCond (struct dptNode *, struct jData *);
 extern void                 freeDepCond (struct dptNode *);
 extern void                 resetDepCond (struct dptNode *);
+extern void                 depGraphInit(void);
+extern int                  depCondValue(struct jData *);
+extern void                 depJobChanged(struct jData *);
+extern void                 depJobRemove(struct jData *);
 extern bool_t               autoAdjustIsEnabled(void);
 extern int                  getAutoAdjustAtNumPend(void);
 extern float                  getAutoAdjustAtPercent(void);
@@ -1475,7 +1597,7 @@ extern long   schedSeqNo;
                                    int ii; \
                                    for (ii=0; ii< (num); ii++) \
                                        DESTROY_BACKFILLEE_LIST((candPtr)[ii].backfilleeList); \
-                                   FREEUP((candPtr)); \
+                                   (candPtr) = NULL; \
                                } \
                            }
 
@@ -43,6 +43,44 @@ static void addMigrantHost(struct hostInfo *);
 static int rmMigrantHost(void);
 static void migrantHostJobs(struct hData *);
 
+static struct selectClass *getSelectClass(struct resVal *, struct hData *);
+static int selectClassLookup(struct selectClass *, struct hData *, int *);
+static void selectClassStore(struct selectClass *, struct hData *, int, int);
+static void freeSelectClass(struct selectClass *);
+
+unsigned int selectEpoch = 1;
+static hTab selectClassTab;
+/* Sets grow only when elements are added.
+ */
+#define SELECT_CLASS_TEST(set, id) \
+    ((id) < (set)->setSize && setTestValue((set), (id)))
+
+static int selectSession;
+
+/* Load of the server hosts pushed by the master LIM
+ * on the subscription channel, the hosts are indexed
+ * by name into the limLoad array. A LIM that pushed
+ * nothing, not even its keepalive, for LIM_LOAD_STALE
+ * seconds is taken as hung and subscribed to again.
+ */
+#define LIM_LOAD_RETRY  60
+#define LIM_LOAD_STALE  (3 * LOAD_DELTA_KEEPALIVE)
+
+int limLoadChan = -1;
+static unsigned int limLoadEpoch;
+static unsigned int limLoadSeqNo;
+static struct hostLoad *limLoad;
+static int numLimLoad;
+static int sizeLimLoad;
+static hTab limLoadTab;
+static time_t limLoadTry;
+static time_t limLoadLast;
+
+static int limLoadSubscribe(void);
+static int limLoadApply(struct loadDelta *);
+static void limLoadClose(void);
+static void limLoadFree(void);
+
 typedef enum {
     OK_UNREACH,
     UNREACH_OK,
@@ -973,6 +1011,8 @@ getLsbHostInfo(void)
                                       LIMhosts[i].resources);
     }
 
+    SELECT_CLASSES_CHANGED();
+
     i = TRUE;
     for (qp = qDataList->forw; (qp != qDataList); qp = qp->forw)
         queueHostsPF(qp, &i);
@@ -1006,14 +1046,36 @@ getLsbHostLoad(void)
         }
     }
 
+    /* Take the load from the subscription cache unless
+     * polling is configured or the master LIM cannot be
+     * subscribed to, then ask the LIM for it.
+     */
     num = 0;
-    hosts = ls_loadofhosts("-:server",
-                           &num,
-                           EFFECTIVE | LOCAL_ONLY,
-                           NULL,
-                           NULL,
-                           0);
-    if (hosts == NULL) {
+    hosts = NULL;
+    if (! daemonParams[MBD_LOAD_POLL].paramValue) {
+        if (limLoadChan >= 0)
+            limLoadIO(FALSE);
+        if (limLoadChan >= 0
+            && time(NULL) - limLoadLast > LIM_LOAD_STALE) {
+            ls_syslog(LOG_WARNING, "\
+%s: no load from the master LIM for %d seconds, subscribing again",
+                      __func__, (int)(time(NULL) - limLoadLast));
+            limLoadClose();
+        }
+        if (limLoadChan >= 0 || limLoadSubscribe() == 0) {
+            hosts = limLoad;
+            num = numLimLoad;
+        }
+    }
+
+    if (limLoadChan < 0)
+        hosts = ls_loadofhosts("-:server",
+                               &num,
+                               EFFECTIVE | LOCAL_ONLY,
+                               NULL,
+                               NULL,
+                               0);
+    if (hosts == NULL && limLoadChan < 0) {
         if (lserrno == LSE_LIM_DOWN) {
             ls_syslog(LOG_ERR, "%s: failed, lim is down %M", __func__);
             mbdDie(MASTER_FATAL);
@@ -1059,6 +1121,12 @@ getLsbHostLoad(void)
         if (!LS_ISUNAVAIL(hosts[i].status))
             hPtr->hStatus &= ~HOST_STAT_NO_LIM;
 
+        if (memcmp(hPtr->lsbLoad, hosts[i].li,
+                   allLsInfo->numIndx * sizeof(float)) != 0
+            || memcmp(hPtr->limStatus, hosts[i].status,
+                      (1 + GET_INTNUM(allLsInfo->numIndx)) * sizeof(int)) != 0)
+            HOST_SELECT_CHANGED(hPtr);
+
         for (j = 0; j < allLsInfo->numIndx; j++) {
             hPtr->lsfLoad[j] = hosts[i].li[j];
             hPtr->lsbLoad[j] = hosts[i].li[j];
@@ -1134,6 +1202,191 @@ getLsbHostLoad(void)
     return 0;
 }
 
+/* limLoadIO()
+ * Apply the deltas queued on the subscription channel,
+ * the channel is dropped on error and the next load
+ * update subscribes again.
+ */
+void
+limLoadIO(int except)
+{
+    struct loadDelta delta;
+    int cc;
+
+    if (limLoadChan < 0)
+        return;
+
+    if (except) {
+        ls_syslog(LOG_WARNING, "\
+%s: lost the load subscription to the master LIM", __func__);
+        limLoadClose();
+        return;
+    }
+
+    while ((cc = ls_loaddelta(limLoadChan, &delta)) > 0) {
+        cc = limLoadApply(&delta);
+        ls_freeloaddelta(&delta);
+        if (cc < 0)
+            break;
+    }
+
+    if (cc < 0)
+        limLoadClose();
+}
+
+/* limLoadSubscribe()
+ * Subscribe to the master LIM from the last delta
+ * applied. Failed attempts are retried only every
+ * LIM_LOAD_RETRY seconds, a LIM that does not know
+ * the request costs a connection each time.
+ */
+static int
+limLoadSubscribe(void)
+{
+    struct loadDelta delta;
+    time_t t;
+    int chfd;
+
+    t = time(NULL);
+    if (t - limLoadTry < LIM_LOAD_RETRY)
+        return -1;
+
+    chfd = ls_loadsubscribe(limLoadEpoch, limLoadSeqNo, &delta);
+    if (chfd < 0) {
+        ls_syslog(LOG_WARNING, "\
+%s: ls_loadsubscribe() failed, polling the load %M", __func__);
+        limLoadTry = t;
+        return -1;
+    }
+
+    if (limLoadApply(&delta) < 0) {
+        ls_freeloaddelta(&delta);
+        chanClose_(chfd);
+        limLoadTry = t;
+        return -1;
+    }
+    ls_freeloaddelta(&delta);
+
+    /* Deltas are drained until the channel
+     * has none, one wakeup per push is enough.
+     */
+    chanSetTrigger_(chfd, CHAN_TRIG_EDGE);
+    limLoadChan = chfd;
+    limLoadTry = 0;
+
+    if (logclass & LC_COMM)
+        ls_syslog(LOG_DEBUG, "\
+%s: subscribed to the master LIM epoch %u seqNo %u hosts %d",
+                  __func__, limLoadEpoch, limLoadSeqNo, numLimLoad);
+
+    return 0;
+}
+
+/* limLoadApply()
+ * Merge the delta into the load cache, a full delta
+ * replaces it. A delta that does not follow the last
+ * one applied makes the next subscription ask for
+ * all the hosts.
+ */
+static int
+limLoadApply(struct loadDelta *delta)
+{
+    struct hostLoad *hl;
+    hEnt *ent;
+    int staSize;
+    int new;
+    int i;
+
+    if (delta->nIndex != allLsInfo->numIndx) {
+        ls_syslog(LOG_WARNING, "\
+%s: delta has %d load indices mbatchd has %d", __func__,
+                  delta->nIndex, allLsInfo->numIndx);
+        limLoadEpoch = 0;
+        return -1;
+    }
+
+    if (delta->flags & LOAD_DELTA_FULL) {
+        limLoadFree();
+    } else if (delta->epoch != limLoadEpoch
+               || delta->baseSeqNo != limLoadSeqNo) {
+        ls_syslog(LOG_WARNING, "\
+%s: delta epoch %u seqNo %u-%u does not follow epoch %u seqNo %u",
+                  __func__, delta->epoch, delta->baseSeqNo, delta->seqNo,
+                  limLoadEpoch, limLoadSeqNo);
+        limLoadEpoch = 0;
+        return -1;
+    }
+
+    if (limLoadTab.slotPtr == NULL)
+        h_initTab_(&limLoadTab, 64);
+
+    staSize = (1 + GET_INTNUM(delta->nIndex)) * sizeof(int);
+
+    for (i = 0; i < delta->nEntry; i++) {
+
+        ent = h_addEnt_(&limLoadTab, delta->loadMatrix[i].hostName, &new);
+        if (new) {
+            if (numLimLoad == sizeLimLoad) {
+                sizeLimLoad = sizeLimLoad ? 2 * sizeLimLoad : 64;
+                limLoad = realloc(limLoad,
+                                  sizeLimLoad * sizeof(struct hostLoad));
+                if (limLoad == NULL) {
+                    ls_syslog(LOG_ERR, "%s: realloc() failed %M", __func__);
+                    mbdDie(MASTER_MEM);
+                }
+            }
+            hl = &limLoad[numLimLoad];
+            strcpy(hl->hostName, delta->loadMatrix[i].hostName);
+            hl->li = my_calloc(delta->nIndex, sizeof(float), __func__);
+            hl->status = my_calloc(1, staSize, __func__);
+            ent->hData = my_malloc(sizeof(int), __func__);
+            *(int *)ent->hData = numLimLoad;
+            numLimLoad++;
+        }
+
+        hl = &limLoad[*(int *)ent->hData];
+        memcpy(hl->li, delta->loadMatrix[i].li,
+               delta->nIndex * sizeof(float));
+        memcpy(hl->status, delta->loadMatrix[i].status, staSize);
+    }
+
+    limLoadEpoch = delta->epoch;
+    limLoadSeqNo = delta->seqNo;
+    limLoadLast = time(NULL);
+
+    if (logclass & LC_COMM)
+        ls_syslog(LOG_DEBUG, "\
+%s: %d hosts seqNo %u-%u flags %x", __func__,
+                  delta->nEntry, delta->baseSeqNo, delta->seqNo,
+                  delta->flags);
+
+    return 0;
+}
+
+/* limLoadClose()
+ */
+static void
+limLoadClose(void)
+{
+    chanClose_(limLoadChan);
+    limLoadChan = -1;
+}
+
+/* limLoadFree()
+ */
+static void
+limLoadFree(void)
+{
+    int i;
+
+    for (i = 0; i < numLimLoad; i++) {
+        FREEUP(limLoad[i].li);
+        FREEUP(limLoad[i].status);
+    }
+    numLimLoad = 0;
+    h_freeTab_(&limLoadTab, NULL);
+}
+
 int
 getHostsByResReq(struct resVal *resValPtr,
                  int *num,
@@ -1144,7 +1397,10 @@ getHostsByResReq(struct resVal *resValPtr,
 {
     static char fname[] = "getHostsByResReq";
     struct hData **hData = NULL;
+    struct selectClass *sc;
     int i, numHosts, k = 0;
+    int eligible;
+    int overRide;
     struct tclHostData tclHostData;
 
     *overRideFromType = FALSE;
@@ -1158,6 +1414,9 @@ getHostsByResReq(struct resVal *resValPtr,
     if (hData == NULL)
         hData = my_calloc(numofhosts(),
                           sizeof(struct hData *), fname);
+
+    sc = getSelectClass(resValPtr, fromHost);
+
     numHosts = 0;
     for (i = 0, k = 0; i < *num; i++) {
 
@@ -1168,16 +1427,27 @@ getHostsByResReq(struct resVal *resValPtr,
             continue;
 
         hData[k++] = hosts[i];
-        getTclHostData (&tclHostData, hosts[i], fromHost);
-        if (evalResReq(resValPtr->selectStr, &tclHostData, DFT_FROMTYPE) != 1) {
+
+        eligible = selectClassLookup(sc, hosts[i], &overRide);
+        if (eligible < 0) {
+
+            getTclHostData (&tclHostData, hosts[i], fromHost);
+            eligible = evalSelectCode(resValPtr->selectCode,
+                                      resValPtr->selectStr,
+                                      &tclHostData,
+                                      DFT_FROMTYPE) == 1;
+            overRide = tclHostData.overRideFromType;
             freeTclHostData (&tclHostData);
-            continue;
+
+            selectClassStore(sc, hosts[i], eligible, overRide);
         }
 
-        if (tclHostData.overRideFromType == TRUE)
+        if (!eligible)
+            continue;
+
+        if (overRide == TRUE)
             *overRideFromType = TRUE;
 
-        freeTclHostData (&tclHostData);
         hosts[numHosts++] = hosts[i];
         k--;
     }
@@ -1192,6 +1462,186 @@ getHostsByResReq(struct resVal *resValPtr,
 
 }
 
+/* getSelectClass()
+ * Find or create the select class of the select expression
+ * of resValPtr evaluated for jobs submitted from fromHost.
+ */
+static struct selectClass *
+getSelectClass(struct resVal *resValPtr, struct hData *fromHost)
+{
+    struct selectClass *sc;
+    hEnt *ent;
+    char *key;
+    int new;
+
+    if (resValPtr->selectStr == NULL)
+        return NULL;
+
+    if (selectClassTab.slotPtr == NULL)
+        h_initTab_(&selectClassTab, 64);
+
+    /* The from host matters only for the type and
+     * model it gives to the local keyword.
+     */
+    key = my_malloc(strlen(resValPtr->selectStr) + 2 * MAXLSFNAMELEN + 3,
+                    __func__);
+    if (fromHost != NULL)
+        sprintf(key, "%s\001%s\001%s", resValPtr->selectStr,
+                fromHost->hostType ? fromHost->hostType : "",
+                fromHost->hostModel ? fromHost->hostModel : "");
+    else
+        sprintf(key, "%s\001\001", resValPtr->selectStr);
+
+    ent = h_addEnt_(&selectClassTab, key, &new);
+    free(key);
+
+    if (new) {
+        sc = my_calloc(1, sizeof(struct selectClass), __func__);
+        sc->epoch = selectEpoch;
+        sc->numHosts = numofhosts() + 1;
+        sc->hostEpoch = my_calloc(sc->numHosts,
+                                  sizeof(unsigned int), __func__);
+        sc->eligible = simpleSetCreate(sc->numHosts, (char *)__func__);
+        sc->overRide = simpleSetCreate(sc->numHosts, (char *)__func__);
+        ent->hData = sc;
+    }
+
+    sc = ent->hData;
+    sc->session = selectSession;
+
+    if (sc->epoch != selectEpoch) {
+        memset(sc->hostEpoch, 0, sc->numHosts * sizeof(unsigned int));
+        setClear(sc->eligible);
+        setClear(sc->overRide);
+        sc->epoch = selectEpoch;
+    }
+
+    return sc;
+}
+
+/* selectClassLookup()
+ * Return the cached value of the select expression on
+ * the host or -1 if it has to be evaluated.
+ */
+static int
+selectClassLookup(struct selectClass *sc,
+                  struct hData *hPtr,
+                  int *overRide)
+{
+    if (sc == NULL
+        || hPtr->hostId >= sc->numHosts
+        || sc->hostEpoch[hPtr->hostId] != hPtr->selectEpoch) {
+        INC_CNT(PROF_CNT_selectClassMiss);
+        return -1;
+    }
+
+    INC_CNT(PROF_CNT_selectClassHit);
+    *overRide = SELECT_CLASS_TEST(sc->overRide, hPtr->hostId);
+
+    return SELECT_CLASS_TEST(sc->eligible, hPtr->hostId);
+}
+
+/* selectClassStore()
+ */
+static void
+selectClassStore(struct selectClass *sc,
+                 struct hData *hPtr,
+                 int eligible,
+                 int overRide)
+{
+    int hostId;
+
+    if (sc == NULL)
+        return;
+
+    hostId = hPtr->hostId;
+    if (hostId >= sc->numHosts) {
+        int n;
+
+        /* A migrant host joined since the class was created.
+         */
+        n = hostId + 1;
+        sc->hostEpoch = realloc(sc->hostEpoch, n * sizeof(unsigned int));
+        if (sc->hostEpoch == NULL) {
+            ls_syslog(LOG_ERR, "%s: realloc() failed %M", __func__);
+            mbdDie(MASTER_MEM);
+        }
+        memset(sc->hostEpoch + sc->numHosts, 0,
+               (n - sc->numHosts) * sizeof(unsigned int));
+        sc->numHosts = n;
+    }
+
+    if (SELECT_CLASS_TEST(sc->eligible, hostId) != eligible) {
+        if (eligible)
+            setAddElement(sc->eligible, &hostId);
+        else
+            setRemoveElement(sc->eligible, &hostId);
+    }
+    if (SELECT_CLASS_TEST(sc->overRide, hostId) != (overRide == TRUE)) {
+        if (overRide == TRUE)
+            setAddElement(sc->overRide, &hostId);
+        else
+            setRemoveElement(sc->overRide, &hostId);
+    }
+
+    sc->hostEpoch[hostId] = hPtr->selectEpoch;
+}
+
+/* instanceSelectChanged()
+ * The value of a shared resource instance changed,
+ * invalidate the select results of its hosts.
+ */
+void
+instanceSelectChanged(struct resourceInstance *instance)
+{
+    int i;
+
+    for (i = 0; i < instance->nHosts; i++) {
+        if (instance->hosts[i] != NULL)
+            HOST_SELECT_CHANGED(instance->hosts[i]);
+    }
+}
+
+/* cleanSelectClasses()
+ * Called at the end of every scheduling session, free the
+ * select classes no job used in the last sessions or all
+ * of them if requested.
+ */
+void
+cleanSelectClasses(int all)
+{
+    struct selectClass *sc;
+    sTab sPtr;
+    hEnt *ent;
+    hEnt *next;
+
+    ++selectSession;
+
+    if (selectClassTab.slotPtr == NULL)
+        return;
+
+    ent = h_firstEnt_(&selectClassTab, &sPtr);
+    while (ent) {
+
+        next = h_nextEnt_(&sPtr);
+        sc = ent->hData;
+        if (all || selectSession - sc->session > 1) {
+            freeSelectClass(sc);
+            h_rmEnt_(&selectClassTab, ent);
+        }
+        ent = next;
+    }
+}
+
+static void
+freeSelectClass(struct selectClass *sc)
+{
+    FREEUP(sc->hostEpoch);
+    setDestroy(sc->eligible);
+    setDestroy(sc->overRide);
+    free(sc);
+}
+
 void
 getTclHostData(struct tclHostData *tclHostData,
                struct hData *hPtr,
@@ -1468,6 +1918,7 @@ adjLsbLoad(struct jData *jpbw, int forResume, bool_t doAdj)
                     && forResume == FALSE)
                     jpbw->hPtr[i]->lsbLoad[ldx] = 1.0;
                 load = jpbw->hPtr[i]->lsbLoad[ldx];
+                HOST_SELECT_CHANGED(jpbw->hPtr[i]);
             } else {
                 orgnalLoad = atof (instance->value);
                 load = orgnalLoad + jackValue;
@@ -1476,6 +1927,7 @@ adjLsbLoad(struct jData *jpbw, int forResume, bool_t doAdj)
                 FREEUP (instance->value);
                 sprintf (loadString, "%-10.1f", load);
                 instance->value = safeSave (loadString);
+                instanceSelectChanged(instance);
             }
 
             if (logclass & LC_SCHED)
@@ -1815,6 +2267,7 @@ migrantHostJobs(struct hData *hPtr)
         }
         jPtr->numHostPtr = 1;
         jPtr->hPtr[0] = lost;
+        jobIdxUpdate(jPtr);
     }
 
     L = FJL;
@@ -1839,6 +2292,7 @@ znovu:
         }
         jPtr->numHostPtr = 1;
         jPtr->hPtr[0] = lost;
+        jobIdxUpdate(jPtr);
     }
 
     if (L == FJL) {
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+
+#include "mbd.h"
+
+/* Ordering of the candidate hosts of a job by one load
+ * index, for sortHosts().
+ *
+ * sortHosts() makes a number of passes of a bubble sort
+ * that carries the best host left from the end of the
+ * array. The hosts are ordered by status, the ok hosts
+ * by their sort key, the others are never swapped among
+ * themselves. With the position of the host as last key
+ * this is a total order, the one every comparison of the
+ * bubble sort agrees with, so the array after k passes
+ * is known from the ranks: let d be the number of better
+ * hosts right of a host, a pass lowers every d that is
+ * not 0 by one. The ranks come from one qsort() and the
+ * hosts are put back from the worst one, each on the
+ * d-th free slot from the right, which is n log n
+ * instead of n times the number of passes.
+ */
+
+static struct hostSortKey *cmpKeys;
+static int cmpIncr;
+
+static int *work;
+static struct candHost *hostBuf;
+static struct hostSortKey *keyBuf;
+static int workSize;
+
+static int cmpHostKeys(const void *, const void *);
+static int growWork(int);
+
+/* hostStatusTier()
+ * The class of the host status in the order of
+ * orderByStatus(), ok hosts first.
+ */
+int
+hostStatusTier(int status)
+{
+    if (LSB_HOST_OK(status))
+        return 0;
+    if (LSB_HOST_BUSY(status))
+        return 1;
+    if (LSB_HOST_CLOSED(status))
+        return 2;
+    if (LSB_HOST_UNREACH(status))
+        return 3;
+    if (LSB_HOST_UNAVAIL(status))
+        return 4;
+
+    return 5;
+}
+
+/* passSortHosts()
+ * Reorder hosts and their keys as passes passes of the
+ * bubble sort of sortHosts() do, incr tells whether the
+ * smaller key is the better. Returns -1 if there is no
+ * memory, the hosts are then left as they are.
+ */
+int
+passSortHosts(struct candHost *hosts, struct hostSortKey *keys,
+              int n, int incr, int passes)
+{
+    int *sorted;
+    int *rank;
+    int *right;
+    int *bit;
+    int free;
+    int step;
+    int slot;
+    int r;
+    int i;
+    int j;
+
+    if (n < 2 || passes <= 0)
+        return 0;
+
+    if (growWork(n) < 0)
+        return -1;
+
+    sorted = work;
+    rank = work + n;
+    right = work + 2 * n;
+    bit = work + 3 * n;
+
+    for (i = 0; i < n; i++)
+        sorted[i] = i;
+
+    cmpKeys = keys;
+    cmpIncr = incr;
+    qsort(sorted, n, sizeof(int), cmpHostKeys);
+
+    for (r = 0; r < n; r++)
+        rank[sorted[r]] = r;
+
+    /* Better hosts right of each host, counted
+     * on a Fenwick tree of the ranks.
+     */
+    memset(bit, 0, (n + 1) * sizeof(int));
+    for (i = n - 1; i >= 0; i--) {
+        right[i] = 0;
+        for (j = rank[i]; j > 0; j -= j & -j)
+            right[i] += bit[j];
+        for (j = rank[i] + 1; j <= n; j += j & -j)
+            bit[j]++;
+        right[i] = MAX(right[i] - passes, 0);
+    }
+
+    /* The tree now counts the free slots, the
+     * worst host goes first.
+     */
+    for (j = 1; j <= n; j++)
+        bit[j] = j & -j;
+
+    for (step = 1; 2 * step <= n; step *= 2)
+        ;
+
+    for (r = n - 1; r >= 0; r--) {
+        i = sorted[r];
+        free = r + 1 - right[i];
+
+        slot = 0;
+        for (j = step; j > 0; j /= 2) {
+            if (slot + j <= n && bit[slot + j] < free) {
+                slot += j;
+                free -= bit[slot];
+            }
+        }
+        for (j = slot + 1; j <= n; j += j & -j)
+            bit[j]--;
+
+        hostBuf[slot] = hosts[i];
+        keyBuf[slot] = keys[i];
+    }
+
+    memcpy(hosts, hostBuf, n * sizeof(struct candHost));
+    memcpy(keys, keyBuf, n * sizeof(struct hostSortKey));
+
+    return 0;
+}
+
+static int
+cmpHostKeys(const void *x, const void *y)
+{
+    struct hostSortKey *k1;
+    struct hostSortKey *k2;
+    int i1;
+    int i2;
+
+    i1 = *(const int *)x;
+    i2 = *(const int *)y;
+    k1 = &cmpKeys[i1];
+    k2 = &cmpKeys[i2];
+
+    if (k1->tier != k2->tier)
+        return k1->tier - k2->tier;
+
+    if (k1->tier == 0) {
+        if (k1->key < k2->key)
+            return cmpIncr ? -1 : 1;
+        if (k1->key > k2->key)
+            return cmpIncr ? 1 : -1;
+    }
+
+    return i1 - i2;
+}
+
+static int
+growWork(int n)
+{
+    if (n <= workSize)
+        return 0;
+
+    FREEUP(work);
+    FREEUP(hostBuf);
+    FREEUP(keyBuf);
+    workSize = 0;
+
+    work = my_malloc((4 * n + 1) * sizeof(int), __func__);
+    hostBuf = my_malloc(n * sizeof(struct candHost), __func__);
+    keyBuf = my_malloc(n * sizeof(struct hostSortKey), __func__);
+    if (work == NULL || hostBuf == NULL || keyBuf == NULL) {
+        ls_syslog(LOG_ERR, "%s: my_malloc() failed %m", __func__);
+        FREEUP(work);
+        FREEUP(hostBuf);
+        FREEUP(keyBuf);
+        return -1;
+    }
+
+    workSize = n;
+
+    return 0;
+}
@@ -168,8 +168,10 @@ minit(int mbdInitFlags)
         jDataList[list] = (struct jData *)listCreate(name);
         listAllowObservers((LIST_T *) jDataList[list]);
     }
+    jobIdxInit();
+    depGraphInit();
 
-    initTab(&jobIdHT);
+    jidInitTab(&jobIdHT, 50);
     initTab(&jgrpIdHT);
 
     uDataPtrTb = uDataTableCreate();
@@ -464,6 +466,7 @@ initHData(struct hData *hData)
     hData->pxySJL = NULL;
     hData->pxyRsvJL = NULL;
     hData->leftRusageMem = INFINIT_LOAD;
+    hData->selectEpoch = 1;
 
     return hData;
 }
@@ -2103,7 +2106,13 @@ setDefaultParams(void)
     rusageUpdateRate = DEF_RUSAGE_UPDATE_RATE;
     rusageUpdatePercent = DEF_RUSAGE_UPDATE_PERCENT;
     condCheckTime = DEF_COND_CHECK_TIME;
-    maxSbdConnections = DEF_MAX_SBD_CONNS;
+    /* Not bound by FD_SETSIZE any longer, keep
+     * the files mbatchd needs for itself out of
+     * the descriptor limit.
+     */
+    maxSbdConnections = sysconf(_SC_OPEN_MAX) - MBD_RESERVED_FDS;
+    if (maxSbdConnections < DEF_MAX_SBD_CONNS)
+        maxSbdConnections = DEF_MAX_SBD_CONNS;
     maxSchedStay = DEF_SCHED_STAY;
     freshPeriod = DEF_FRESH_PERIOD;
     maxJobArraySize = DEF_JOB_ARRAY_SIZE;
@@ -2868,6 +2877,9 @@ updHostList(void)
     }
 
     hostList = listCreate("Host List");
+    /* Host ids may be given to different hosts now.
+     */
+    SELECT_CLASSES_CHANGED();
 
     cc = 0;
     for (e = h_firstEnt_(&hostTab, &stab);
@@ -197,7 +197,11 @@ copyJData(struct jData *jp)
     memcpy((char *)jData, (char *)jp, sizeof(struct jData));
     jData->reqHistory = reqHistory;
     jData->numRef = 0;
+    jData->listNo = -1;
     jData->nextJob = NULL;
+    jData->depSerial = 0;
+    jData->depFiled = 0;
+    jData->reasonTb = NULL;
 
     jData->userName = safeSave(jp->userName);
     jData->schedHost = safeSave(jp->schedHost);
@@ -776,9 +776,11 @@ putOntoTree(struct jData *jp, int jobType)
     }
 
     jp->jgrpNode = newj;
+    jobIdxUpdate(jp);
 
     for (jPtr = jp->nextJob; jPtr; jPtr = jPtr->nextJob) {
          jPtr->jgrpNode = newj;
+         jobIdxUpdate(jPtr);
 
          updJgrpCountByJStatus(jPtr, JOB_STAT_NULL, jPtr->jStatus);
     }
@@ -885,7 +887,7 @@ Entry:
                    }
                    else {
                        int depCond;
-                       depCond=evalDepCond(jpbw->shared->dptRoot, jpbw);
+                       depCond = depCondValue(jpbw);
                        if (depCond == DP_FALSE) {
                            jpbw->newReason = PEND_JOB_DEPEND;
                        }
@@ -938,6 +940,8 @@ updJgrpCountByJStatus(struct jData *job, int oldStatus, int newStatus)
 {
     struct jgTreeNode *gPtr = job->jgrpNode;
 
+    depJobChanged(job);
+
     while (gPtr) {
         if (gPtr->nodeType == JGRP_NODE_GROUP) {
             if (oldStatus != JOB_STAT_NULL) {
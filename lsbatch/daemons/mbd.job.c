@@ -89,6 +89,11 @@ static char              ususpPendingEvent(struct jData *jpbw);
 static char              terminatePendingEvent(struct jData *jpbw);
 static void              initSubmitReq(struct submitReq *);
 static int               skipJobListByReq (int, int);
+static int               selectJob1(struct jobInfoReq *, struct jData *,
+                                    struct uData *, struct gData *, int,
+                                    struct jData **);
+static int               addSelectedJob(struct jData ***, int *, int *,
+                                        struct jData *);
 static void              replaceString (char *, char *, char *);
 static void initJobSig (struct jData *, struct jobSig *, int, time_t, int);
 static int modifyAJob (struct modifyReq *, struct submitMbdReply *,
@@ -118,6 +123,7 @@ extern int statusChanged;
 
 
 int            numRemoveJobs = 0;
+int            sjlNeedReorder = FALSE;
 int            eventPending = FALSE;
 
 extern int     rusageUpdateRate;
@@ -362,9 +368,11 @@ void
 addJobIdHT(struct jData *job)
 {
     static char fname[] = "addJobIdHT()";
-    hEnt *ent;
+    jidEnt *ent;
+    int new;
 
-    while ((ent=addMemb(&jobIdHT, job->jobId))== NULL)  {
+    while ((ent = jidAddEnt(&jobIdHT, job->jobId, &new)) != NULL
+           && !new)  {
 
         if (job == getJobData(job->jobId))
             return;
@@ -376,6 +384,12 @@ addJobIdHT(struct jData *job)
                       lsb_jobid2str(job->jobId));
         removeJob(job->jobId);
     }
+
+    if (ent == NULL) {
+        ls_syslog(LOG_ERR, "%s: jidAddEnt() failed for job %s %M", fname,
+                  lsb_jobid2str(job->jobId));
+        mbdDie(MASTER_MEM);
+    }
     ent->hData = (int *) job;
 
 }
@@ -901,28 +915,23 @@ int
 selectJobs (struct jobInfoReq *jobInfoReq, struct jData ***jobDataList,
             int *listSize)
 {
-    static char fname[] = "selectJobs()";
-    char allqueues = FALSE;
     char allusers = FALSE;
-    char allhosts = FALSE;
     char searchJobName = FALSE;
     struct jData *jpbw, **joblist = NULL, *recentJob = NULL;
+    struct jData **cands;
     struct gData *uGrp = NULL;
     int  list = 0;
     int numJobs = 0;
     int arraysize = 0;
+    int numCands;
+    int i;
     struct  uData *uPtr;
 
-
-    if (jobInfoReq->queue[0] == '\0')
-        allqueues = TRUE;
     if (strcmp(jobInfoReq->userName, ALL_USERS) == 0)
         allusers = TRUE;
     else
         uGrp = getUGrpData (jobInfoReq->userName);
 
-    if (jobInfoReq->host[0] == '\0')
-        allhosts = TRUE;
     if (jobInfoReq->jobName[0] != '\0' &&
         jobInfoReq->jobName[strlen(jobInfoReq->jobName) - 1] == '*') {
         searchJobName = TRUE;
@@ -932,155 +941,221 @@ selectJobs (struct jobInfoReq *jobInfoReq, struct jData ***jobDataList,
 
     uPtr = getUserData(jobInfoReq->userName);
 
+    if (!skipJobListByReq(jobInfoReq->options, SJL)
+        && jDataList[SJL]->back != jDataList[SJL])
+        reorderSJL ();
+
+    /* Take the candidates from the job indexes when the
+     * request names a job, user, queue, host or job name,
+     * they come in the same order as the list walk below.
+     */
+    numCands = jobIdxSelect(jobInfoReq,
+                            !allusers && uGrp == NULL,
+                            searchJobName,
+                            &cands);
+    if (numCands >= 0) {
+
+        for (i = 0; i < numCands; i++) {
+            jpbw = cands[i];
+
+            if (skipJobListByReq (jobInfoReq->options, jpbw->listNo))
+                continue;
+
+            if (!selectJob1(jobInfoReq, jpbw, uPtr, uGrp,
+                            searchJobName, &recentJob))
+                continue;
+
+            if (addSelectedJob(&joblist, &arraysize, &numJobs, jpbw) < 0) {
+                FREEUP(cands);
+                return LSBE_NO_MEM;
+            }
+        }
+        FREEUP(cands);
+        goto done;
+    }
 
     for (list = 0; list < NJLIST; list++) {
         struct jData *jp;
         if (skipJobListByReq (jobInfoReq->options, list)  == TRUE)
             continue;
 
-        if (list == SJL && jDataList[list]->back != jDataList[list])
-            reorderSJL ();
-
         for (jp = jDataList[list]->back;
              (jp!= jDataList[list]); jp = jp->back) {
-            int i;
 
             jpbw = jp;
 
-            if (jpbw->jobId < 0)
+            if (!selectJob1(jobInfoReq, jpbw, uPtr, uGrp,
+                            searchJobName, &recentJob))
                 continue;
 
-            if (!allqueues
-                && strcmp(jpbw->qPtr->queue, jobInfoReq->queue) != 0)
-                continue;
+            if (addSelectedJob(&joblist, &arraysize, &numJobs, jpbw) < 0)
+                return LSBE_NO_MEM;
+        }
+    }
 
+done:
+    *listSize = numJobs;
 
-            if (!allusers && (jpbw->uPtr != uPtr)) {
-                if (uGrp == NULL)
-                    continue;
-                else if (!gMember(jpbw->userName, uGrp))
-                    continue;
-            }
+    if (numJobs > 0) {
+        if(jobInfoReq->options & LAST_JOB) {
+            numJobs = 1;
+            joblist[0] = recentJob;
+        }
+        *jobDataList = joblist;
+        return(LSBE_NO_ERROR);
+    } else if (jobInfoReq->queue[0] != '\0'
+               && getQueueData (jobInfoReq->queue) == NULL) {
+        FREEUP(joblist);
+        return(LSBE_BAD_QUEUE);
+    }
+    FREEUP(joblist);
+    return(LSBE_NO_JOB);
 
+}
 
-            if (jobInfoReq->jobName[0] != '\0') {
-                char  fullName[MAXPATHLEN];
-                fullJobName_r(jpbw, fullName);
-                if ((searchJobName == FALSE &&
-                     strcmp(jobInfoReq->jobName, fullName) != 0) ||
-                    (searchJobName == TRUE &&
-                     strncmp(fullName, jobInfoReq->jobName,
-                             strlen (jobInfoReq->jobName)) != 0))
-                    continue;
-            }
+/* selectJob1()
+ * Does the job match the job information request.
+ */
+static int
+selectJob1(struct jobInfoReq *jobInfoReq,
+           struct jData *jpbw,
+           struct uData *uPtr,
+           struct gData *uGrp,
+           int searchJobName,
+           struct jData **recentJob)
+{
+    static char fname[] = "selectJobs()";
+    int i;
 
+    if (jpbw->jobId < 0)
+        return FALSE;
 
+    if (jobInfoReq->queue[0] != '\0'
+        && strcmp(jpbw->qPtr->queue, jobInfoReq->queue) != 0)
+        return FALSE;
 
-            if (jobInfoReq->jobId != 0
-                && ((LSB_ARRAY_IDX(jobInfoReq->jobId) != 0
-                     && LSB_ARRAY_IDX(jobInfoReq->jobId) != LSB_ARRAY_IDX(jpbw->jobId))
-                    ||
-                    LSB_ARRAY_JOBID(jobInfoReq->jobId) != LSB_ARRAY_JOBID(jpbw->jobId))) {
 
-                continue;
-            }
+    if (strcmp(jobInfoReq->userName, ALL_USERS) != 0
+        && (jpbw->uPtr != uPtr)) {
+        if (uGrp == NULL)
+            return FALSE;
+        else if (!gMember(jpbw->userName, uGrp))
+            return FALSE;
+    }
 
-            {
-                if (jpbw->jStatus & JOB_STAT_PEND) {
-                    if (!(jpbw->qPtr->qStatus & QUEUE_STAT_RUN))
-                        jpbw->newReason = PEND_QUE_WINDOW;
-                    if (!(jpbw->qPtr->qStatus & QUEUE_STAT_ACTIVE))
-                        jpbw->newReason = PEND_QUE_INACT;
-                }
-                else if (jpbw->jStatus & JOB_STAT_ZOMBIE)
-                    jpbw->newReason |= EXIT_ZOMBIE;
-            }
 
-            if (! matchJobStatus(jobInfoReq->options, jpbw)) {
-                continue;
-            }
+    if (jobInfoReq->jobName[0] != '\0') {
+        char  fullName[MAXPATHLEN];
+        fullJobName_r(jpbw, fullName);
+        if ((searchJobName == FALSE &&
+             strcmp(jobInfoReq->jobName, fullName) != 0) ||
+            (searchJobName == TRUE &&
+             strncmp(fullName, jobInfoReq->jobName,
+                     strlen (jobInfoReq->jobName)) != 0))
+            return FALSE;
+    }
 
 
-            if (!allhosts) {
-                struct gData *gp;
 
-                if (IS_PEND (jpbw->jStatus))
-                    continue;
+    if (jobInfoReq->jobId != 0
+        && ((LSB_ARRAY_IDX(jobInfoReq->jobId) != 0
+             && LSB_ARRAY_IDX(jobInfoReq->jobId) != LSB_ARRAY_IDX(jpbw->jobId))
+            ||
+            LSB_ARRAY_JOBID(jobInfoReq->jobId) != LSB_ARRAY_JOBID(jpbw->jobId))) {
 
-                if (jpbw->hPtr == NULL) {
-                    if (!(jpbw->jStatus & JOB_STAT_EXIT))
-                        ls_syslog(LOG_ERR, _i18n_msg_get(ls_catd , NL_SETN, 6510,
-                                                         "%s: Execution host for job <%s> is null"), /* catgets 6510 */
-                                  fname, lsb_jobid2str(jpbw->jobId));
-                    continue;
-                }
+        return FALSE;
+    }
 
-                gp = getHGrpData (jobInfoReq->host);
-                if (gp != NULL) {
-                    for (i = 0; i < jpbw->numHostPtr; i++) {
-                        if (jpbw->hPtr[i] == NULL)
-                            continue;
-                        if (gMember(jpbw->hPtr[i]->host, gp))
-                            break;
-                    }
-                    if (i >= jpbw->numHostPtr)
-                        continue;
-                } else {
-                    for (i = 0; i < jpbw->numHostPtr; i++) {
-                        if (jpbw->hPtr[i] == NULL)
-                            continue;
-                        if (equalHost_(jobInfoReq->host, jpbw->hPtr[i]->host))
-                            break;
-                    }
-                    if (i >= jpbw->numHostPtr)
-                        continue;
-                }
-            }
+    {
+        if (jpbw->jStatus & JOB_STAT_PEND) {
+            if (!(jpbw->qPtr->qStatus & QUEUE_STAT_RUN))
+                jpbw->newReason = PEND_QUE_WINDOW;
+            if (!(jpbw->qPtr->qStatus & QUEUE_STAT_ACTIVE))
+                jpbw->newReason = PEND_QUE_INACT;
+        }
+        else if (jpbw->jStatus & JOB_STAT_ZOMBIE)
+            jpbw->newReason |= EXIT_ZOMBIE;
+    }
+
+    if (! matchJobStatus(jobInfoReq->options, jpbw)) {
+        return FALSE;
+    }
 
 
-            if (findLastJob(jobInfoReq->options, jpbw, &recentJob) == FALSE)
-                continue;
+    if (jobInfoReq->host[0] != '\0') {
+        struct gData *gp;
 
-            if (arraysize == 0) {
-                arraysize = DEFAULT_LISTSIZE;
-                joblist = (struct jData **) calloc (arraysize,
-                                                    sizeof (struct jData *));
-                if (joblist == NULL)
-                    return LSBE_NO_MEM;
-            }
-            if (numJobs >= arraysize) {
-
-                struct jData **biglist;
-                arraysize *= 2;
-                biglist = (struct jData **) realloc((char *)joblist,
-                                                    arraysize * sizeof (struct jData *));
-                if (biglist == NULL) {
-                    FREEUP(joblist);
-                    return LSBE_NO_MEM;
-                }
-                joblist = biglist;
+        if (IS_PEND (jpbw->jStatus))
+            return FALSE;
+
+        if (jpbw->hPtr == NULL) {
+            if (!(jpbw->jStatus & JOB_STAT_EXIT))
+                ls_syslog(LOG_ERR, _i18n_msg_get(ls_catd , NL_SETN, 6510,
+                                                 "%s: Execution host for job <%s> is null"), /* catgets 6510 */
+                          fname, lsb_jobid2str(jpbw->jobId));
+            return FALSE;
+        }
+
+        gp = getHGrpData (jobInfoReq->host);
+        if (gp != NULL) {
+            for (i = 0; i < jpbw->numHostPtr; i++) {
+                if (jpbw->hPtr[i] == NULL)
+                    continue;
+                if (gMember(jpbw->hPtr[i]->host, gp))
+                    break;
             }
-            joblist[numJobs] = jpbw;
-            numJobs++;
+            if (i >= jpbw->numHostPtr)
+                return FALSE;
+        } else {
+            for (i = 0; i < jpbw->numHostPtr; i++) {
+                if (jpbw->hPtr[i] == NULL)
+                    continue;
+                if (equalHost_(jobInfoReq->host, jpbw->hPtr[i]->host))
+                    break;
+            }
+            if (i >= jpbw->numHostPtr)
+                return FALSE;
         }
     }
 
-    *listSize = numJobs;
 
-    if (numJobs > 0) {
-        if(jobInfoReq->options & LAST_JOB) {
-            numJobs = 1;
-            joblist[0] = recentJob;
+    if (findLastJob(jobInfoReq->options, jpbw, recentJob) == FALSE)
+        return FALSE;
+
+    return TRUE;
+}
+
+/* addSelectedJob()
+ */
+static int
+addSelectedJob(struct jData ***joblist,
+               int *arraysize,
+               int *numJobs,
+               struct jData *jpbw)
+{
+    if (*arraysize == 0) {
+        *arraysize = DEFAULT_LISTSIZE;
+        *joblist = (struct jData **) calloc (*arraysize,
+                                             sizeof (struct jData *));
+        if (*joblist == NULL)
+            return -1;
+    }
+    if (*numJobs >= *arraysize) {
+
+        struct jData **biglist;
+        *arraysize *= 2;
+        biglist = (struct jData **) realloc((char *)*joblist,
+                                            *arraysize * sizeof (struct jData *));
+        if (biglist == NULL) {
+            FREEUP(*joblist);
+            return -1;
         }
-        *jobDataList = joblist;
-        return(LSBE_NO_ERROR);
-    } else if (!allqueues && getQueueData (jobInfoReq->queue) == NULL) {
-        FREEUP(joblist);
-        return(LSBE_BAD_QUEUE);
+        *joblist = biglist;
     }
-    FREEUP(joblist);
-    return(LSBE_NO_JOB);
+    (*joblist)[*numJobs] = jpbw;
+    (*numJobs)++;
 
+    return 0;
 }
 
 static int
@@ -1110,6 +1185,11 @@ reorderSJL (void)
 {
     struct jData *tmpSJL, *jp, *next;
 
+    /* The order only changes when jobs enter
+     * the list.
+     */
+    if (!sjlNeedReorder)
+        return;
 
     tmpSJL = (struct jData *)
         tmpListHeader ((struct listEntry *) jDataList[SJL]);
@@ -1119,6 +1199,8 @@ reorderSJL (void)
         next = jp->back;
         reorderSJL1 (jp);
     }
+
+    sjlNeedReorder = FALSE;
 }
 
 static void
@@ -1155,6 +1237,7 @@ reorderSJL1 (struct jData *job)
         inList ((struct listEntry *)jDataList[SJL]->forw,
                 (struct listEntry *)job);
     }
+    jobIdxEnter(job, SJL);
 
 }
 
@@ -2558,6 +2641,7 @@ statusJob(struct statusReq *statusReq, struct hostent *hp, int *schedule)
 
         if (jpbw->jStatus & JOB_STAT_DONE) {
             jpbw->jStatus |= statusReq->newStatus;
+            depJobChanged(jpbw);
             log_newstatus(jpbw);
         } else {
             if (logclass & (LC_TRACE)) {
@@ -3396,6 +3480,11 @@ cleanSbdNode(struct jData *jpbw)
          sbdPtr = nextSbdPtr) {
         nextSbdPtr = sbdPtr->forw;
         if (sbdPtr->jData == jpbw) {
+            if (sbdPtr->tag != 0) {
+                sbdCancel(sbdPtr);
+                continue;
+            }
+            sbdMap[sbdPtr->chanfd] = NULL;
             chanClose_(sbdPtr->chanfd);
             offList((struct listEntry *) sbdPtr);
             FREEUP(sbdPtr);
@@ -3494,6 +3583,7 @@ handleFinishJob(struct jData *jData, int oldStatus, int eventTime)
     offJobList(jData, listno);
     inList ((struct listEntry *)jDataList[FJL]->forw,
             (struct  listEntry *)jData);
+    jobIdxEnter(jData, FJL);
 
     if( (jData->shared->jobBill.options & SUB_MODIFY_ONCE) &&
         (jData->newSub) ) {
@@ -3692,8 +3782,10 @@ changeJobParams(struct jData *jData)
     if (oldSub)
         jData->newSub = oldSub;
     qPtr = getQueueData (jData->shared->jobBill.queue);
-    if (qPtr != jData->qPtr)
+    if (qPtr != jData->qPtr) {
         jData->qPtr = qPtr;
+        jobIdxUpdate(jData);
+    }
 
     jData->runCount = 1;
 
@@ -4481,7 +4573,7 @@ insertAndShift (struct jData *froJob, struct jData *toJob,
 void
 initJobIdHT(void)
 {
-    h_initTab_ (&jobIdHT, 50);
+    jidInitTab(&jobIdHT, 50);
 }
 
 void
@@ -4496,7 +4588,8 @@ removeJob(LS_LONG_INT jobId)
             freeJData(zp);
         }
 
-        remvMemb(&jobIdHT, jp->jobId);
+        jidRmEnt(&jobIdHT, jp->jobId);
+        jobIdxRemove(jp);
         offJobList (jp, FJL);
         numRemoveJobs ++;
         if (mSchedStage != M_STAGE_REPLAY) {
@@ -4511,7 +4604,7 @@ removeJob(LS_LONG_INT jobId)
                 if (ARRAY_DATA(node)->counts[JGRP_COUNT_NJOBS] <= 0) {
                     if (mSchedStage != M_STAGE_REPLAY)
                         log_jobclean(ARRAY_DATA(node)->jobArray);
-                    remvMemb(&jobIdHT, ARRAY_DATA(node)->jobArray->jobId);
+                    jidRmEnt(&jobIdHT, ARRAY_DATA(node)->jobArray->jobId);
                     freeJData(ARRAY_DATA(node)->jobArray);
                     treeFree(treeClip(node));
                     rmLogJobInfo_(jp, TRUE);
@@ -4728,9 +4821,9 @@ jobInQueueEnd (struct jData *job, struct qData *qp)
 struct jData *
 getJobData (LS_LONG_INT jobId)
 {
-    hEnt *ent;
+    jidEnt *ent;
 
-    if (jobId <= 0 || (ent = chekMemb (&jobIdHT, jobId)) == NULL)
+    if ((ent = jidGetEnt(&jobIdHT, jobId)) == NULL)
         return NULL;
     return (struct jData *) ent->hData;
 
@@ -4776,7 +4869,6 @@ initJData (struct jShared  *shared)
     job->oldReason = job->newReason;
     job->subreasons = 0;
     job->reasonTb = NULL;
-    job->numReasons = 0;
     job->priority = -1.0;
     job->qPtr = NULL;
     job->hPtr = NULL;
@@ -4814,6 +4906,7 @@ initJData (struct jShared  *shared)
     job->lastDispHost = -1;
     job->requeMode = -1;
     job->numRef = 0;
+    job->listNo = -1;
     job->actPid = 0;
     job->ssuspTime = 0;
     job->lsfRusage = NULL;
@@ -5314,6 +5407,7 @@ modifyJob (struct modifyReq *req, struct submitMbdReply *reply,
         if (req->submitReq.options & SUB_JOB_NAME) {
             char   *sp, *jobName;
             int    newMaxJLimit;
+            struct jData *jPtr;
 
             if (LSB_ARRAY_IDX(jpbw->jobId) == 0
                 && req->submitReq.jobName
@@ -5350,6 +5444,12 @@ modifyJob (struct modifyReq *req, struct submitMbdReply *reply,
                             req->submitReq.jobName);
                     FREEUP(jArray->jgrpNode->name);
                     jArray->jgrpNode->name = jobName;
+
+                    /* The elements share the node of the array.
+                     */
+                    jobIdxUpdate(jArray);
+                    for (jPtr = jArray->nextJob; jPtr; jPtr = jPtr->nextJob)
+                        jobIdxUpdate(jPtr);
                 }
             } else {
                 returnErr = LSBE_MOD_JOB_NAME;
@@ -6522,7 +6622,7 @@ freeJData (struct jData *jpbw)
     }
 
     if (IS_PEND(jpbw->jStatus) && jpbw->candPtr) {
-        FREEUP (jpbw->candPtr);
+        jpbw->candPtr = NULL;
         if (jpbw->numHostPtr > 0 && (jpbw->jStatus & JOB_STAT_RESERVE)) {
 
             if (logclass & (LC_TRACE))
@@ -6539,7 +6639,7 @@ freeJData (struct jData *jpbw)
 
     FREEUP (jpbw->userName);
     FREEUP (jpbw->lsfRusage);
-    FREEUP (jpbw->reasonTb);
+    jobReasonFree(jpbw);
     FREEUP (jpbw->hPtr);
 
     FREEUP (jpbw->execHome);
@@ -6566,11 +6666,15 @@ freeJData (struct jData *jpbw)
     FREEUP(jpbw->reqHistory);
 
     FREEUP(jpbw->execHosts);
-    FREEUP (jpbw->candPtr);
+    jpbw->candPtr = NULL;
     FREEUP (jpbw->jobSpoolDir);
 
     FREE_ALL_GRPS_CAND(jpbw);
 
+    /* The jobs depending on it see it void.
+     */
+    depJobRemove(jpbw);
+
     if (jpbw->numRef <= 0 ) {
         FREEUP(jpbw);
     }
@@ -7919,10 +8023,12 @@ shouldResumeByRes (struct jData *jp)
         char loadString[MAXLSFNAMELEN];
         for (j = 0; j < allLsInfo->numIndx; j++)
             jp->hPtr[i]->lsbLoad[j] = loads[i][j];
+        HOST_SELECT_CHANGED(jp->hPtr[i]);
         for (j = 0; j < jp->hPtr[i]->numInstances; j++) {
             FREEUP (jp->hPtr[i]->instances[j]->value);
             sprintf (loadString, "%-10.1f", loads[i][allLsInfo->numIndx+j]);
             jp->hPtr[i]->instances[j]->value = safeSave (loadString);
+            instanceSelectChanged(jp->hPtr[i]->instances[j]);
         }
         FREEUP(loads[i]);
     }
@@ -8798,6 +8904,11 @@ void closeSbdConnect4ZombieJob(struct jData *jData)
          sbdPtr = nextSbdPtr) {
         nextSbdPtr = sbdPtr->forw;
         if (sbdPtr->jData == jData) {
+            if (sbdPtr->tag != 0) {
+                sbdCancel(sbdPtr);
+                continue;
+            }
+            sbdMap[sbdPtr->chanfd] = NULL;
             chanClose_(sbdPtr->chanfd);
             offList((struct listEntry *) sbdPtr);
             FREEUP(sbdPtr);
@@ -0,0 +1,608 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+
+#include <limits.h>
+#include "mbd.h"
+
+/* Job indexes used by selectJobs() so that a query
+ * by user, queue, execution host or job name looks only
+ * at the jobs filed under that key instead of walking
+ * all the job lists.
+ *
+ * Every index maps the key to the set of job ids filed
+ * under it. Jobs are filed when they enter one of the job
+ * lists and when the indexed attribute changes, they are
+ * removed when the job is cleaned. The sets are hints, a
+ * query checks every job against the request as the list
+ * walk does and drops the entries that no longer match
+ * their key.
+ *
+ * The result has to come out in the order of the job
+ * lists, so every job in a list carries its list number
+ * and a label increasing along the list.
+ *
+ * The job names are also kept sorted so that a query by
+ * name prefix finds the names having it by binary search.
+ */
+
+static hTab userIdx;
+static hTab queueIdx;
+static hTab hostIdx;
+static hTab nameIdx;
+
+static char **nameKeys;
+static int numNameKeys;
+static int sizeNameKeys;
+
+static LIST_OBSERVER_T *jobIdxObserver[NJLIST];
+
+/* Distance between the labels of jobs
+ * inserted at the ends of a list.
+ */
+#define JOBIDX_SEQ_STEP  (1ULL << 32)
+#define JOBIDX_LISTSIZE  200
+
+static int jobIdxListEnter(LIST_T *, void *, LIST_EVENT_T *);
+static int jobIdxListLeave(LIST_T *, void *, LIST_EVENT_T *);
+static void jobIdxLabel(struct jData *, struct jData *);
+static jidTab *idxSet(hTab *, const char *, int);
+static void idxAdd(hTab *, const char *, LS_LONG_INT);
+static void idxRm(hTab *, const char *, LS_LONG_INT);
+static void idxFree(hTab *, hEnt *, const char *);
+static int idxCollect(jidTab *, hTab *, const char *,
+                      struct jData ***, int *, int *);
+static int idxMatch(hTab *, const char *, struct jData *);
+static void candAppend(struct jData ***, int *, int *, struct jData *);
+static int cmpListOrder(const void *, const void *);
+static int nameKeyFind(const char *);
+static void nameKeyAdd(const char *);
+static void nameKeyRm(const char *);
+
+/* jobIdxInit()
+ */
+void
+jobIdxInit(void)
+{
+    int list;
+
+    h_initTab_(&userIdx, 64);
+    h_initTab_(&queueIdx, 16);
+    h_initTab_(&hostIdx, 64);
+    h_initTab_(&nameIdx, 1024);
+
+    for (list = 0; list < NJLIST; list++) {
+        jobIdxObserver[list] = listObserverCreate("jobIdxObserver",
+                                                  (void *)(long)list,
+                                                  NULL,
+                                                  LIST_EVENT_ENTER,
+                                                  &jobIdxListEnter,
+                                                  LIST_EVENT_LEAVE,
+                                                  &jobIdxListLeave,
+                                                  LIST_EVENT_NULL);
+        if (jobIdxObserver[list] == NULL) {
+            ls_syslog(LOG_ERR, "%s: listObserverCreate() failed %M", __func__);
+            mbdDie(MASTER_MEM);
+        }
+        listObserverAttach(jobIdxObserver[list], (LIST_T *)jDataList[list]);
+    }
+}
+
+static int
+jobIdxListEnter(LIST_T *list, void *extra, LIST_EVENT_T *event)
+{
+    jobIdxEnter((struct jData *)event->entry, (int)(long)extra);
+    return 0;
+}
+
+static int
+jobIdxListLeave(LIST_T *list, void *extra, LIST_EVENT_T *event)
+{
+    ((struct jData *)event->entry)->listNo = -1;
+    return 0;
+}
+
+/* jobIdxEnter()
+ * The job has been linked in the list listno, label
+ * its position and file it. Called by the list observers
+ * and directly where jobs are moved with inList().
+ */
+void
+jobIdxEnter(struct jData *job, int listno)
+{
+    job->listNo = listno;
+    jobIdxLabel(job, jDataList[listno]);
+
+    if (listno == SJL)
+        sjlNeedReorder = TRUE;
+
+    jobIdxUpdate(job);
+}
+
+/* jobIdxLabel()
+ * Give the job a label between the ones of its
+ * neighbours, if there is no room left the whole
+ * list is labelled again. This is rare and no more
+ * expensive than the walks done to insert in order.
+ */
+static void
+jobIdxLabel(struct jData *job, struct jData *header)
+{
+    unsigned long long lo;
+    unsigned long long hi;
+    unsigned long long step;
+    struct jData *jp;
+    int num;
+
+    lo = (job->back == header) ? 0 : job->back->listSeq;
+    hi = (job->forw == header) ? ULLONG_MAX : job->forw->listSeq;
+
+    if (lo == 0 && hi == ULLONG_MAX) {
+        job->listSeq = 1ULL << 63;
+        return;
+    }
+
+    if (hi > lo && hi - lo > 2 * JOBIDX_SEQ_STEP) {
+        if (hi == ULLONG_MAX) {
+            job->listSeq = lo + JOBIDX_SEQ_STEP;
+            return;
+        }
+        if (lo == 0) {
+            job->listSeq = hi - JOBIDX_SEQ_STEP;
+            return;
+        }
+    }
+
+    if (hi > lo && hi - lo > 1) {
+        job->listSeq = lo + (hi - lo) / 2;
+        return;
+    }
+
+    num = 0;
+    for (jp = header->forw; jp != header; jp = jp->forw)
+        ++num;
+
+    step = ULLONG_MAX / (num + 1);
+    num = 0;
+    for (jp = header->forw; jp != header; jp = jp->forw)
+        jp->listSeq = ++num * step;
+}
+
+/* jobIdxUpdate()
+ * File the job under its current user, queue, job
+ * name and execution hosts. Jobs that are not in any
+ * job list are filed when they enter one.
+ */
+void
+jobIdxUpdate(struct jData *job)
+{
+    int i;
+
+    if (job->listNo < 0 || job->jobId <= 0)
+        return;
+
+    if (job->userName)
+        idxAdd(&userIdx, job->userName, job->jobId);
+    if (job->qPtr)
+        idxAdd(&queueIdx, job->qPtr->queue, job->jobId);
+    if (job->jgrpNode && job->jgrpNode->name)
+        idxAdd(&nameIdx, job->jgrpNode->name, job->jobId);
+
+    for (i = 0; job->hPtr && i < job->numHostPtr; i++) {
+        if (job->hPtr[i] == NULL)
+            continue;
+        idxAdd(&hostIdx, job->hPtr[i]->host, job->jobId);
+    }
+
+    if (job->listNo == SJL)
+        sjlNeedReorder = TRUE;
+}
+
+/* jobIdxRemove()
+ * The job is being cleaned from memory.
+ */
+void
+jobIdxRemove(struct jData *job)
+{
+    int i;
+
+    if (job->userName)
+        idxRm(&userIdx, job->userName, job->jobId);
+    if (job->qPtr)
+        idxRm(&queueIdx, job->qPtr->queue, job->jobId);
+    if (job->jgrpNode && job->jgrpNode->name)
+        idxRm(&nameIdx, job->jgrpNode->name, job->jobId);
+
+    for (i = 0; job->hPtr && i < job->numHostPtr; i++) {
+        if (job->hPtr[i] == NULL)
+            continue;
+        idxRm(&hostIdx, job->hPtr[i]->host, job->jobId);
+    }
+}
+
+/* jobIdxSelect()
+ * Get the candidate jobs of a job information request
+ * from the smallest index it can use, in the order of
+ * the job lists. The candidates still have to be matched
+ * against the request. Return the number of candidates
+ * or -1 if the request cannot use any index, byUser is
+ * FALSE when the user is all users or a user group.
+ */
+int
+jobIdxSelect(struct jobInfoReq *req,
+             int byUser,
+             int searchJobName,
+             struct jData ***cands)
+{
+    struct jData *jp;
+    struct hData *hPtr;
+    jidTab *set;
+    jidTab *best;
+    hTab *bestIdx;
+    char *bestKey;
+    int size;
+    int num;
+    int len;
+    int first;
+    int i;
+
+    *cands = NULL;
+    size = 0;
+    num = 0;
+
+    /* A job id names at most one job or the
+     * elements of one array.
+     */
+    if (req->jobId != 0) {
+        jp = getJobData(req->jobId);
+        if (jp == NULL)
+            return 0;
+        if (jp->nodeType != JGRP_NODE_ARRAY) {
+            if (jp->listNo >= 0)
+                candAppend(cands, &num, &size, jp);
+            return num;
+        }
+        for (jp = jp->nextJob; jp; jp = jp->nextJob) {
+            if (jp->listNo >= 0)
+                candAppend(cands, &num, &size, jp);
+        }
+        goto done;
+    }
+
+    best = NULL;
+    bestIdx = NULL;
+    bestKey = NULL;
+
+    if (byUser) {
+        best = idxSet(&userIdx, req->userName, FALSE);
+        bestIdx = &userIdx;
+        bestKey = req->userName;
+        if (best == NULL)
+            return 0;
+    }
+
+    if (req->queue[0] != '\0') {
+        set = idxSet(&queueIdx, req->queue, FALSE);
+        if (set == NULL)
+            return 0;
+        if (best == NULL || JIDTAB_NUM_ENTS(set) < JIDTAB_NUM_ENTS(best)) {
+            best = set;
+            bestIdx = &queueIdx;
+            bestKey = req->queue;
+        }
+    }
+
+    if (req->host[0] != '\0'
+        && getHGrpData(req->host) == NULL
+        && (hPtr = getHostData(req->host)) != NULL) {
+        set = idxSet(&hostIdx, hPtr->host, FALSE);
+        if (set == NULL)
+            return 0;
+        if (best == NULL || JIDTAB_NUM_ENTS(set) < JIDTAB_NUM_ENTS(best)) {
+            best = set;
+            bestIdx = &hostIdx;
+            bestKey = hPtr->host;
+        }
+    }
+
+    if (req->jobName[0] != '\0' && !searchJobName) {
+        set = idxSet(&nameIdx, req->jobName, FALSE);
+        if (set == NULL)
+            return 0;
+        if (best == NULL || JIDTAB_NUM_ENTS(set) < JIDTAB_NUM_ENTS(best)) {
+            best = set;
+            bestIdx = &nameIdx;
+            bestKey = req->jobName;
+        }
+    }
+
+    if (req->jobName[0] != '\0' && searchJobName) {
+        int n;
+
+        /* Prefix of the job name, the candidates are
+         * the jobs of all the names with the prefix,
+         * they follow each other in nameKeys.
+         */
+        len = strlen(req->jobName);
+        first = nameKeyFind(req->jobName);
+        n = 0;
+        for (i = first;
+             i < numNameKeys
+                 && strncmp(nameKeys[i], req->jobName, len) == 0;
+             i++) {
+            set = idxSet(&nameIdx, nameKeys[i], FALSE);
+            n += JIDTAB_NUM_ENTS(set);
+        }
+
+        if (best == NULL || n < JIDTAB_NUM_ENTS(best)) {
+            /* A name whose set ends up empty leaves
+             * nameKeys, the next one takes its place.
+             */
+            i = first;
+            while (i < numNameKeys
+                   && strncmp(nameKeys[i], req->jobName, len) == 0) {
+                if (!idxCollect(idxSet(&nameIdx, nameKeys[i], FALSE),
+                                &nameIdx, nameKeys[i], cands, &num, &size))
+                    i++;
+            }
+            goto done;
+        }
+    }
+
+    if (best == NULL)
+        return -1;
+
+    idxCollect(best, bestIdx, bestKey, cands, &num, &size);
+
+done:
+    if (num > 1)
+        qsort(*cands, num, sizeof(struct jData *), cmpListOrder);
+
+    return num;
+}
+
+/* idxCollect()
+ * Append to cands the jobs of the set still filed
+ * under key and in a job list. The set is freed if
+ * no job is left filed under key, return TRUE if so.
+ */
+static int
+idxCollect(jidTab *set,
+           hTab *idx,
+           const char *key,
+           struct jData ***cands,
+           int *num,
+           int *size)
+{
+    struct jData *jp;
+    jidIter iter;
+    jidEnt *e;
+
+    for (e = jidFirstEnt(set, &iter); e; e = jidNextEnt(&iter)) {
+
+        jp = getJobData(e->key);
+        if (jp == NULL || !idxMatch(idx, key, jp)) {
+            jidRmEnt(set, e->key);
+            continue;
+        }
+        if (jp->listNo < 0)
+            continue;
+
+        candAppend(cands, num, size, jp);
+    }
+
+    if (JIDTAB_NUM_ENTS(set) == 0) {
+        idxFree(idx, h_getEnt_(idx, key), key);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* idxMatch()
+ * Is the job still filed correctly under key.
+ */
+static int
+idxMatch(hTab *idx, const char *key, struct jData *jp)
+{
+    int i;
+
+    if (idx == &userIdx)
+        return jp->userName && strcmp(jp->userName, key) == 0;
+
+    if (idx == &queueIdx)
+        return jp->qPtr && strcmp(jp->qPtr->queue, key) == 0;
+
+    if (idx == &nameIdx)
+        return jp->jgrpNode
+            && jp->jgrpNode->name
+            && strcmp(jp->jgrpNode->name, key) == 0;
+
+    for (i = 0; jp->hPtr && i < jp->numHostPtr; i++) {
+        if (jp->hPtr[i] && strcmp(jp->hPtr[i]->host, key) == 0)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void
+candAppend(struct jData ***cands, int *num, int *size, struct jData *jp)
+{
+    struct jData **p;
+
+    if (*num >= *size) {
+        *size = *size ? *size * 2 : JOBIDX_LISTSIZE;
+        p = realloc(*cands, *size * sizeof(struct jData *));
+        if (p == NULL) {
+            ls_syslog(LOG_ERR, "%s: realloc() failed %M", __func__);
+            mbdDie(MASTER_MEM);
+        }
+        *cands = p;
+    }
+    (*cands)[(*num)++] = jp;
+}
+
+/* cmpListOrder()
+ * The order in which selectJobs() walks the lists,
+ * list by list from the back.
+ */
+static int
+cmpListOrder(const void *x, const void *y)
+{
+    const struct jData *j1 = *(struct jData **)x;
+    const struct jData *j2 = *(struct jData **)y;
+
+    if (j1->listNo != j2->listNo)
+        return j1->listNo - j2->listNo;
+    if (j1->listSeq > j2->listSeq)
+        return -1;
+    if (j1->listSeq < j2->listSeq)
+        return 1;
+    return 0;
+}
+
+/* idxSet()
+ */
+static jidTab *
+idxSet(hTab *idx, const char *key, int create)
+{
+    hEnt *ent;
+    int new;
+
+    if (!create) {
+        ent = h_getEnt_(idx, key);
+        return ent ? ent->hData : NULL;
+    }
+
+    ent = h_addEnt_(idx, key, &new);
+    if (new) {
+        ent->hData = my_malloc(sizeof(jidTab), __func__);
+        if (jidInitTab(ent->hData, 4) < 0) {
+            ls_syslog(LOG_ERR, "%s: jidInitTab() failed %M", __func__);
+            mbdDie(MASTER_MEM);
+        }
+        if (idx == &nameIdx)
+            nameKeyAdd(key);
+    }
+
+    return ent->hData;
+}
+
+static void
+idxAdd(hTab *idx, const char *key, LS_LONG_INT jobId)
+{
+    int new;
+
+    if (jidAddEnt(idxSet(idx, key, TRUE), jobId, &new) == NULL) {
+        ls_syslog(LOG_ERR, "%s: jidAddEnt() failed for job %s %M",
+                  __func__, lsb_jobid2str(jobId));
+        mbdDie(MASTER_MEM);
+    }
+}
+
+static void
+idxRm(hTab *idx, const char *key, LS_LONG_INT jobId)
+{
+    hEnt *ent;
+
+    if ((ent = h_getEnt_(idx, key)) == NULL)
+        return;
+
+    jidRmEnt(ent->hData, jobId);
+    if (JIDTAB_NUM_ENTS((jidTab *)ent->hData) == 0)
+        idxFree(idx, ent, key);
+}
+
+/* idxFree()
+ * Drop the empty set of key, key may be the
+ * name in nameKeys so it goes last.
+ */
+static void
+idxFree(hTab *idx, hEnt *ent, const char *key)
+{
+    if (ent == NULL)
+        return;
+
+    jidFreeTab(ent->hData, NULL);
+    FREEUP(ent->hData);
+    h_rmEnt_(idx, ent);
+    if (idx == &nameIdx)
+        nameKeyRm(key);
+}
+
+/* nameKeyFind()
+ * Index of the first name in nameKeys not
+ * less than key.
+ */
+static int
+nameKeyFind(const char *key)
+{
+    int lo;
+    int hi;
+    int mid;
+
+    lo = 0;
+    hi = numNameKeys;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (strcmp(nameKeys[mid], key) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+static void
+nameKeyAdd(const char *key)
+{
+    char **p;
+    int i;
+
+    if (numNameKeys >= sizeNameKeys) {
+        sizeNameKeys = sizeNameKeys ? sizeNameKeys * 2 : JOBIDX_LISTSIZE;
+        p = realloc(nameKeys, sizeNameKeys * sizeof(char *));
+        if (p == NULL) {
+            ls_syslog(LOG_ERR, "%s: realloc() failed %M", __func__);
+            mbdDie(MASTER_MEM);
+        }
+        nameKeys = p;
+    }
+
+    i = nameKeyFind(key);
+    memmove(nameKeys + i + 1, nameKeys + i,
+            (numNameKeys - i) * sizeof(char *));
+    nameKeys[i] = safeSave((char *)key);
+    numNameKeys++;
+}
+
+static void
+nameKeyRm(const char *key)
+{
+    int i;
+
+    i = nameKeyFind(key);
+    if (i == numNameKeys || strcmp(nameKeys[i], key) != 0)
+        return;
+
+    FREEUP(nameKeys[i]);
+    numNameKeys--;
+    memmove(nameKeys + i, nameKeys + i + 1,
+            (numNameKeys - i) * sizeof(char *));
+}
@@ -76,6 +76,33 @@ static int              checkJobStarter(char *, char *);
 
 static FILE            *log_fp     = NULL;
 static FILE            *joblog_fp  = NULL;
+
+/* Group commit of lsb.events. Records are formatted in
+ * a memory buffer and appended to the file with a single
+ * write. With MBD_EVENTS_COMMIT_DELAY milliseconds in
+ * lsf.conf the records are grouped for up to that time,
+ * or up to ELOG_COMMIT_MAX bytes, and every group is
+ * synced to disk, otherwise every record is written as
+ * soon as it is logged as before. MBD_EVENTS_FORMAT=BINARY
+ * writes framed records, see lsb_puteventrec_bin().
+ */
+#define ELOG_COMMIT_MAX   (1024 * 1024)
+
+static FILE            *elogBufFp;
+static char            *elogBuf;
+static size_t           elogBufLen;
+static int              elogBufRecs;
+static pid_t            elogBufPid;
+static struct timeval   elogBufTime;
+static int              elogCommitDelay;
+static int              elogBinary;
+static int              elogHeld;
+
+static void             elogParams(void);
+static int              replayThreads(void);
+static int              replayRec(struct eventRec *, int, void *);
+static void             elogBufDrop(void);
+static int              elogPutRec(FILE *, struct eventRec *);
 static int              openEventFile(char *);
 static int              putEventRec(char *);
 static int              putEventRecTime(char *, time_t);
@@ -83,6 +110,7 @@ static int              putEventRec1(char *);
 static int              log_jobdata(struct jData *, char *, int);
 static int              createEvent0File(void);
 static int              renameElogFiles(void);
+static void             writeEventIdx(int);
 static int              createAcct0File(void);
 
 void                    log_timeExpired(int, time_t);
@@ -155,6 +183,8 @@ init_log(void)
 
     mSchedStage = M_STAGE_REPLAY;
 
+    elogParams();
+
     sprintf(elogFname, "%s/logdir/lsb.events",
             daemonParams[LSB_SHAREDIR].paramValue);
 
@@ -224,44 +254,29 @@ init_log(void)
 
     if (log_fp != NULL) {
 
-        if (lsberrno == LSBE_EOF)
-            lsberrno = LSBE_NO_ERROR;
+        struct timeval t0;
+        struct timeval t1;
+        int numRecs;
+        double sec;
 
+        gettimeofday(&t0, NULL);
+        numRecs = lsb_replayevents(log_fp, replayThreads(), &lineNum,
+                                   replayRec, &first);
+        gettimeofday(&t1, NULL);
 
-        while (lsberrno != LSBE_EOF) {
-            if ((logPtr = lsb_geteventrec(log_fp, &lineNum)) == NULL) {
-
-                if (lsberrno != LSBE_EOF) {
-                    ls_syslog(LOG_ERR, "\
+        if (numRecs < 0) {
+            ls_syslog(LOG_ERR, "\
 %s: Reading event file <%s> at line <%d>: %s",
-                              fname,
-                              elogFname,
-                              lineNum,
-                              lsb_sysmsg());
-                    first = FALSE;
-                    if (lsberrno == LSBE_NO_MEM) {
-
-                        mbdDie(MASTER_MEM);
-                    }
-
-                } else {
-                    FCLOSEUP(&log_fp);
-                    log_fp = NULL;
-                }
-                continue;
-            }
-
-            eventTime = logPtr->eventTime;
-            if (!replay_event(elogFname, lineNum) && first) {
-                ls_syslog(LOG_ERR, "\
-%s: File %s at line %d: First replay_event() failed; line ignored",
-                          fname,
-                          elogFname,
-                          lineNum);
-                first = FALSE;
-            }
+                      fname, elogFname, lineNum, lsb_sysmsg());
+            mbdDie(MASTER_MEM);
         }
 
+        sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / 1e6;
+        ls_syslog(LOG_INFO, "\
+%s: Replayed %d events of %s in %.2f seconds, %.0f events/sec",
+                  fname, numRecs, elogFname, sec,
+                  sec > 0 ? numRecs / sec : 0.0);
+
         if (log_fp)
             FCLOSEUP(&log_fp);
 
@@ -332,6 +347,69 @@ init_log(void)
     return ConfigError;
 }
 
+/* replayThreads()
+ * Number of threads parsing lsb.events at startup,
+ * MBD_REPLAY_THREADS or by default one per cpu besides
+ * the one mbatchd replays on, up to 8. With 0 mbatchd
+ * parses the records itself.
+ */
+static int
+replayThreads(void)
+{
+    char *p;
+    long n;
+
+    if ((p = daemonParams[MBD_REPLAY_THREADS].paramValue)) {
+        if (isint_(p) && atoi(p) >= 0)
+            return atoi(p);
+        ls_syslog(LOG_ERR, "\
+%s: Invalid MBD_REPLAY_THREADS %s ignored", __func__, p);
+    }
+
+    n = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    if (n < 0)
+        n = 0;
+    if (n > 8)
+        n = 8;
+
+    return n;
+}
+
+/* replayRec()
+ * Called by lsb_replayevents() with the records of
+ * lsb.events in file order, a NULL record could not be
+ * read and lsberrno tells why.
+ */
+static int
+replayRec(struct eventRec *rec, int lineNum, void *arg)
+{
+    char *first;
+
+    first = arg;
+
+    if (rec == NULL) {
+        ls_syslog(LOG_ERR, "\
+%s: Reading event file <%s> at line <%d>: %s",
+                  __func__, elogFname, lineNum, lsb_sysmsg());
+        *first = FALSE;
+        if (lsberrno == LSBE_NO_MEM)
+            mbdDie(MASTER_MEM);
+        return 0;
+    }
+
+    logPtr = rec;
+    eventTime = logPtr->eventTime;
+    if (!replay_event(elogFname, lineNum) && *first) {
+        ls_syslog(LOG_ERR, "\
+%s: File %s at line %d: First replay_event() failed; line ignored",
+                  __func__, elogFname, lineNum);
+        *first = FALSE;
+    }
+    logPtr = NULL;
+
+    return 0;
+}
+
 static int
 replay_event(char *filename, int lineNum)
 {
@@ -750,6 +828,7 @@ replay_newstat(char *filename, int lineNum)
     if ((IS_POST_DONE(newStat->jStatus))||(IS_POST_ERR(newStat->jStatus))) {
         jp->jStatus = newStat->jStatus;
         jp->endTime = newStat->endTime;
+        depJobChanged(jp);
         if ((jp->jgrpNode->nodeType == JGRP_NODE_ARRAY) &&
             ARRAY_DATA(jp->jgrpNode)->counts[JGRP_COUNT_NJOBS] ==
             (ARRAY_DATA(jp->jgrpNode)->counts[JGRP_COUNT_NDONE] +
@@ -2039,39 +2118,220 @@ log_jobForce(struct jData* job, int uid, char *userName)
 
 }
 
+/* elogParams()
+ */
+static void
+elogParams(void)
+{
+    char *p;
+
+    elogCommitDelay = 0;
+    if ((p = daemonParams[MBD_EVENTS_COMMIT_DELAY].paramValue)) {
+        if (isint_(p) && atoi(p) >= 0)
+            elogCommitDelay = atoi(p);
+        else
+            ls_syslog(LOG_ERR, "\
+%s: Invalid MBD_EVENTS_COMMIT_DELAY %s ignored", __func__, p);
+    }
+
+    elogBinary = FALSE;
+    if ((p = daemonParams[MBD_EVENTS_FORMAT].paramValue)) {
+        if (strcasecmp(p, "BINARY") == 0)
+            elogBinary = TRUE;
+        else if (strcasecmp(p, "TEXT") != 0)
+            ls_syslog(LOG_ERR, "\
+%s: Invalid MBD_EVENTS_FORMAT %s ignored", __func__, p);
+    }
+}
+
+/* elogBufDrop()
+ * Forget the buffered records, also done by children
+ * for the records they inherited from mbatchd.
+ */
+static void
+elogBufDrop(void)
+{
+    if (elogBufFp)
+        fclose(elogBufFp);
+    FREEUP(elogBuf);
+    elogBufFp = NULL;
+    elogBufLen = 0;
+    elogBufRecs = 0;
+}
+
+/* elogPutRec()
+ * Write a record in the configured format.
+ */
+static int
+elogPutRec(FILE *fp, struct eventRec *rec)
+{
+    if (elogBinary)
+        return lsb_puteventrec_bin(fp, rec);
+
+    return lsb_puteventrec(fp, rec);
+}
+
 static int
 openEventFile(char *fname)
 {
-    long pos;
+    if (elogBufFp && elogBufPid != getpid())
+        elogBufDrop();
+
+    if (elogBufFp == NULL) {
+        elogBufFp = open_memstream(&elogBuf, &elogBufLen);
+        if (elogBufFp == NULL) {
+            ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, fname, "open_memstream");
+            return -1;
+        }
+        elogBufPid = getpid();
+    }
+
+    logPtr = my_calloc(1, sizeof(struct eventRec), __func__);
+
+    sprintf(logPtr->version, "%d", OPENLAVA_VERSION);
+
+    return 0;
+}
+
+/* elogCommit()
+ * Append the buffered records to lsb.events with
+ * one write, synced when records are grouped.
+ */
+int
+elogCommit(void)
+{
     sigset_t newmask, oldmask;
+    static char hdr[] = "\
+#80                                                                            \n";
+    size_t off;
+    ssize_t cc;
+    int ret;
+    int fd;
+
+    if (elogBufFp && elogBufPid != getpid())
+        elogBufDrop();
+
+    if (elogBufFp == NULL || elogBufRecs == 0)
+        return 0;
+
+    if (fflush(elogBufFp) != 0) {
+        ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, __func__, "fflush");
+        elogBufDrop();
+        return -1;
+    }
 
     chuser(managerId);
 
     sigemptyset(&newmask);
     sigaddset(&newmask, SIGCHLD);
     sigprocmask(SIG_BLOCK, &newmask, &oldmask);
-    if ((log_fp = fopen(elogFname, "a+")) == NULL) {
-        sigprocmask(SIG_SETMASK, &oldmask, NULL);
+    fd = open(elogFname, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    sigprocmask(SIG_SETMASK, &oldmask, NULL);
+
+    if (fd < 0) {
         chuser(batchId);
-        ls_syslog(LOG_ERR, I18N_FUNC_S_FAIL_M, fname, "fopen", elogFname);
+        ls_syslog(LOG_ERR, I18N_FUNC_S_FAIL_M, __func__, "open", elogFname);
+        elogBufDrop();
         return -1;
     }
-    sigprocmask(SIG_SETMASK, &oldmask, NULL);
 
-    fseek(log_fp, 0L, SEEK_END);
+    ret = 0;
+    if (lseek(fd, 0, SEEK_END) == 0) {
+        fchmod(fd, 0644);
+        if (write(fd, hdr, sizeof(hdr) - 1) != sizeof(hdr) - 1)
+            ret = -1;
+    }
+
+    for (off = 0; ret == 0 && off < elogBufLen; off += cc) {
+        cc = write(fd, elogBuf + off, elogBufLen - off);
+        if (cc < 0) {
+            if (errno == EINTR) {
+                cc = 0;
+                continue;
+            }
+            ret = -1;
+        }
+    }
+
+    if (ret == 0
+        && elogCommitDelay > 0
+        && fsync(fd) < 0)
+        ret = -1;
 
+    if (ret < 0)
+        ls_syslog(LOG_ERR, I18N_FUNC_S_FAIL_M, __func__, "write", elogFname);
 
-    if ((pos = ftell(log_fp)) == 0) {
-        fprintf(log_fp, "#80                                                                            \n");
+    if (close(fd) < 0 && ret == 0) {
+        ls_syslog(LOG_ERR, I18N_FUNC_S_FAIL_M, __func__, "close", elogFname);
+        ret = -1;
     }
 
-    chmod(elogFname, 0644);
     chuser(batchId);
-    logPtr = my_calloc(1, sizeof(struct eventRec), __func__);
 
-    sprintf(logPtr->version, "%d", OPENLAVA_VERSION);
+    elogBufDrop();
 
-    return 0;
+    return ret;
+}
+
+/* elogHold()
+ * Keep the records logged until elogRelease() in the
+ * buffer so that a request changing many jobs is
+ * committed with one write.
+ */
+void
+elogHold(void)
+{
+    ++elogHeld;
+}
+
+/* elogRelease()
+ * Commit the records held unless they wait for the
+ * commit delay anyway.
+ */
+int
+elogRelease(void)
+{
+    if (elogHeld > 0)
+        --elogHeld;
+
+    if (elogHeld > 0 || elogCommitDelay > 0)
+        return 0;
+
+    return elogCommit();
+}
+
+/* elogCommitTimer()
+ * Commit the buffered records whose delay expired,
+ * otherwise shorten the timeout of the main loop to
+ * the time left and return TRUE.
+ */
+int
+elogCommitTimer(struct timeval *timeout)
+{
+    struct timeval t;
+    long left;
+
+    if (elogBufRecs == 0 || elogBufPid != getpid())
+        return FALSE;
+
+    gettimeofday(&t, NULL);
+    left = elogCommitDelay
+        - ((t.tv_sec - elogBufTime.tv_sec) * 1000
+           + (t.tv_usec - elogBufTime.tv_usec) / 1000);
+
+    if (left <= 0) {
+        if (elogCommit() < 0)
+            mbdDie(MASTER_FATAL);
+        return FALSE;
+    }
+
+    if (timeout->tv_sec * 1000 + timeout->tv_usec / 1000 <= left)
+        return FALSE;
+
+    timeout->tv_sec = left / 1000;
+    timeout->tv_usec = (left % 1000) * 1000;
+
+    return TRUE;
 }
 
 static int
@@ -2103,14 +2363,12 @@ static int
 putEventRec1(char *fname)
 {
     int    ret;
-    int    cc;
-    long   pos1;
+    int    type;
 
     ret = 0;
+    type = logPtr->type;
 
-    pos1 =  ftell(log_fp);
-
-    if (lsb_puteventrec(log_fp, logPtr) < 0) {
+    if (elogPutRec(elogBufFp, logPtr) < 0) {
         ls_syslog(LOG_ERR, I18N_FUNC_FAIL_EMSG_S,
                   fname, "lsb_puteventrec", lsb_sysmsg());
         ret = -1;
@@ -2118,15 +2376,15 @@ putEventRec1(char *fname)
 
     free(logPtr);
 
-    chuser(managerId);
-
-    cc = FCLOSEUP(&log_fp);
+    if (elogBufRecs++ == 0)
+        gettimeofday(&elogBufTime, NULL);
 
-    chuser(batchId);
-
-    if (cc < 0) {
-        ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, fname, "fclose");
-        ret = -1;
+    if ((elogCommitDelay == 0 && elogHeld == 0)
+        || type == EVENT_MBD_DIE
+        || type == EVENT_LOG_SWITCH
+        || ftell(elogBufFp) >= ELOG_COMMIT_MAX) {
+        if (elogCommit() < 0)
+            ret = -1;
     }
 
     return(ret);
@@ -2415,6 +2673,9 @@ switch_log(void)
     ls_syslog(LOG_INFO, "\
 %s: switching event log file: %s", __FUNCTION__, tmpfn);
 
+    if (elogCommit() < 0)
+        goto exiterr;
+
     chuser(managerId);
 
     if (createEvent0File() == -1) { ;
@@ -2589,7 +2850,7 @@ switch_log(void)
                     || (logPtr->type == EVENT_JOB_MOVE)
                     || (logPtr->type == EVENT_JOB_CLEAN)))) {
 
-            if (lsb_puteventrec(tmpfp, logPtr) == -1) {
+            if (elogPutRec(tmpfp, logPtr) == -1) {
                 ls_syslog(LOG_ERR, I18N_FUNC_S_FAIL_MM,
                           fname, "lsb_puteventrec", tmpfn);
                 chuser(managerId);
@@ -2652,6 +2913,7 @@ switch_log(void)
                     LSF_JOBIDINDEX_FILENAME);
 
             chuser(managerId);
+            writeEventIdx(totalEventFile);
             if (updateJobIdIndexFile(indexFile, elogFname, totalEventFile) < 0) {
                 chuser(batchId);
                 if (lsberrno == LSBE_SYS_CALL)
@@ -2853,12 +3115,52 @@ renameElogFiles(void)
                       "rename", tmpfn, eventfn);
             return (-1);
         }
+
+        /* The index follows its event file, it
+         * checks the inode so a stale one is harmless.
+         */
+        strcat(tmpfn, LSF_EVENTIDX_SUFFIX);
+        strcat(eventfn, LSF_EVENTIDX_SUFFIX);
+        if (rename(tmpfn, eventfn) == -1 && errno == ENOENT)
+            unlink(eventfn);
     }
     chuser(batchId);
 
     return (max);
 }
 
+/* writeEventIdx()
+ * Index the event file just switched and any older
+ * one whose index is missing or stale, bhist uses
+ * the indexes to go straight to the records it wants.
+ */
+static void
+writeEventIdx(int totalEventFile)
+{
+    struct eventIdx *idx;
+    char eventfn[MAXFILENAMELEN];
+    int i;
+
+    for (i = 1; i <= totalEventFile; i++) {
+
+        if (snprintf(eventfn, MAXFILENAMELEN, "%s.%d",
+                     elogFname, i) >= MAXFILENAMELEN) {
+            ls_syslog(LOG_ERR, "\
+%s: name of event file %s.%d too long", __func__, elogFname, i);
+            return;
+        }
+
+        if (i > 1 && (idx = lsb_openeventidx(eventfn)) != NULL) {
+            lsb_closeeventidx(idx);
+            continue;
+        }
+
+        if (lsb_puteventidx(eventfn) < 0 && i == 1)
+            ls_syslog(LOG_ERR, "\
+%s: lsb_puteventidx(%s) failed: %s %m", __func__, eventfn, lsb_sysmsg());
+    }
+}
+
 void
 logJobInfo(struct submitReq * req, struct jData *jp, struct lenData * jf)
 {
@@ -16,6 +16,8 @@
  *
  */
 
+#include <sys/resource.h>
+
 #include "mbd.h"
 
 #define MBD_THREAD_MIN_STACKSIZE  512
@@ -103,6 +105,12 @@ struct gData *usergroups[MAX_GROUPS];
 struct gData *hostgroups[MAX_GROUPS];
 struct clientNode *clientList = NULL;
 
+/* Owners of the channels by chfd, the ready list
+ * of chanPoll_() is dispatched through them.
+ */
+struct clientNode **clientMap;
+struct sbdNode **sbdMap;
+
 struct lsInfo *allLsInfo;
 struct hTab calDataList;
 struct hTab condDataList;
@@ -154,10 +162,11 @@ static int authRequest(struct lsfAuth *, XDR *, struct LSFHeader *,
                        char *, int);
 static int processClient(struct clientNode *, int *);
 
-static void clientIO(struct Masks *);
+static void clientIO(struct chanEvent *, int);
+static void raiseFileLimit(void);
+static void logChanBufStats(void);
 static int forkOnRequest(mbdReqType);
 static void shutdownSbdConnections(void);
-static void processSbdNode(struct sbdNode *, int);
 static void setNextSchedTimeWhenJobFinish(void);
 static void acceptConnection(int);
 
@@ -173,10 +182,12 @@ extern int initLimSock_(void);
 int
 main (int argc, char **argv)
 {
-    fd_set readmask;
-    struct Masks sockmask;
-    struct Masks chanmask;
+    struct chanEvent *ready;
     struct timeval timeout;
+    struct timeval elogTimeout;
+    int elogWakeup;
+    struct timeval dispTimeout;
+    int dispWakeup;
     int nready;
     int i;
     int cc;
@@ -211,6 +222,10 @@ main (int argc, char **argv)
         }
     }
 
+    /* Before the channels are sized on the limit.
+     */
+    raiseFileLimit();
+
     if (initenv_(daemonParams, env_dir) < 0) {
 
         ls_openlog("mbatchd",
@@ -377,6 +392,11 @@ main (int argc, char **argv)
         exit(lsb_CheckError);
     }
 
+    clientMap = my_calloc(sysconf(_SC_OPEN_MAX),
+                          sizeof(struct clientNode *), __func__);
+    sbdMap = my_calloc(sysconf(_SC_OPEN_MAX),
+                       sizeof(struct sbdNode *), __func__);
+
     /* Go go go...
      */
     TIMEIT(0, minit(FIRST_START),"minit");
@@ -390,11 +410,6 @@ main (int argc, char **argv)
     setJobPriUpdIntvl();
 
     for (;;) {
-        int maxfd;
-
-        FD_ZERO(&readmask);
-
-        maxfd = sysconf(_SC_OPEN_MAX);
         now = time(0);
 
         if ( (now - lastSchedTime >= msleeptime)
@@ -420,13 +435,33 @@ main (int argc, char **argv)
             timeout.tv_sec = 0;
         }
 
-        sockmask.rmask = readmask;
+        /* Send a slice of the jobs placed by the scheduler
+         * and poll without waiting while some are left.
+         */
+        dispTimeout = timeout;
+        dispWakeup = sendQueuedJobs(&timeout);
+
+        /* Wake up for the commit of buffered events
+         * without running the housekeeping early.
+         */
+        elogTimeout = timeout;
+        elogWakeup = elogCommitTimer(&timeout);
 
-        nready = chanSelect_(&sockmask, &chanmask, &timeout);
+        nready = chanPoll_(&ready, &timeout);
         if (nready < 0) {
             if (errno != EINTR)
                 ls_syslog(LOG_ERR, "\
-%s: Ohmygosh.. select() failed %m", __func__);
+%s: Ohmygosh.. chanPoll_() failed %m", __func__);
+            continue;
+        }
+
+        if (nready == 0 && elogWakeup) {
+            timeout = elogTimeout;
+            continue;
+        }
+
+        if (nready == 0 && dispWakeup) {
+            timeout = dispTimeout;
             continue;
         }
 
@@ -454,11 +489,7 @@ main (int argc, char **argv)
         timeout.tv_sec  = 0;
         timeout.tv_usec = 0;
 
-        if (FD_ISSET(batchSock, &chanmask.rmask)) {
-            acceptConnection(batchSock);
-        }
-
-        clientIO(&chanmask);
+        clientIO(ready, nready);
 
     } /* for (;;) */
 }
@@ -496,6 +527,11 @@ acceptConnection(int socket)
 
     memcpy(&from.sin_addr, hp->h_addr, hp->h_length);
 
+    /* A client is reported once per message, not
+     * at every wakeup until its message is dequeued.
+     */
+    chanSetTrigger_(s, CHAN_TRIG_EDGE);
+
     client = my_calloc(1, sizeof(struct clientNode), __func__);
     client->chanfd = s;
     client->from =  from;
@@ -505,67 +541,72 @@ acceptConnection(int socket)
 
     inList((struct listEntry *)clientList,
            (struct listEntry *) client);
+    clientMap[s] = client;
 
     ls_syslog(LOG_DEBUG, "\
 %s: Accepted connection from host %s on channel %d",
               __func__, client->fromHost, client->chanfd);
 }
 
+/* clientIO()
+ * Dispatch the channels chanPoll_() found ready, an
+ * entry whose channel was closed by the processing of
+ * an earlier one has its events cleared.
+ */
 static void
-clientIO(struct Masks *chanmask)
+clientIO(struct chanEvent *ready, int nReady)
 {
     struct clientNode *cliPtr;
-    struct clientNode *nextClient;
     struct sbdNode *sbdPtr;
-    struct sbdNode *nextSbdPtr;
-    int exception;
+    int needFree;
+    int chfd;
+    int i;
 
     if (logclass & LC_TRACE)
         ls_syslog(LOG_DEBUG,"clientIO: Entering...");
 
-    for (sbdPtr = sbdNodeList.forw;
-         sbdPtr != &sbdNodeList;
-         sbdPtr = nextSbdPtr) {
-        nextSbdPtr = sbdPtr->forw;
+    for (i = 0; i < nReady; i++) {
 
-        if (FD_ISSET(sbdPtr->chanfd, &chanmask->rmask)
-            || FD_ISSET(sbdPtr->chanfd, &chanmask->emask)) {
+        if (ready[i].events == 0)
+            continue;
+        chfd = ready[i].chfd;
 
-            if (FD_ISSET(sbdPtr->chanfd, &chanmask->emask))
-                exception = TRUE;
-            else
-                exception = FALSE;
-            processSbdNode(sbdPtr, exception);
+        if (chfd == batchSock) {
+            acceptConnection(batchSock);
+            continue;
         }
-    }
 
+        if (chfd == limLoadChan) {
+            limLoadIO(ready[i].events & CHAN_EV_EXCEPT);
+            continue;
+        }
 
-    for (cliPtr = clientList->forw;
-         cliPtr != clientList;
-         cliPtr = nextClient) {
-        int needFree;
-        nextClient = cliPtr->forw;
+        if ((sbdPtr = sbdMap[chfd]) != NULL) {
+            processSbdNode(sbdPtr, ready[i].events & CHAN_EV_EXCEPT);
+            continue;
+        }
 
-        if (FD_ISSET(cliPtr->chanfd, &chanmask->emask)) {
+        if (sbdChanIO(chfd, ready[i].events & CHAN_EV_EXCEPT))
+            continue;
+
+        if ((cliPtr = clientMap[chfd]) == NULL)
+            continue;
+
+        if (ready[i].events & CHAN_EV_EXCEPT) {
             shutDownClient(cliPtr);
             continue;
         }
-        needFree = FALSE;
-        if (FD_ISSET(cliPtr->chanfd, &chanmask->rmask)) {
-
-            int saveChfd;
-            saveChfd = cliPtr->chanfd;
-            if (processClient(cliPtr, &needFree) == 0) {
-
-                FD_CLR(saveChfd, &chanmask->rmask);
-                if (needFree == TRUE) {
-                    offList((struct listEntry *)cliPtr);
-                    FREEUP(cliPtr->fromHost);
-                    FREEUP(cliPtr);
-                }
+
+        if (ready[i].events & CHAN_EV_READ) {
+            needFree = FALSE;
+            if (processClient(cliPtr, &needFree) == 0
+                && needFree == TRUE) {
+                clientMap[chfd] = NULL;
+                offList((struct listEntry *)cliPtr);
+                FREEUP(cliPtr->fromHost);
+                FREEUP(cliPtr);
             }
         }
-
     }
 }
 
@@ -660,6 +701,10 @@ processClient(struct clientNode *client, int *needFree)
         goto endLoop;
     }
 
+    if (forkOnRequest(mbdReqtype)
+        && queryServerDispatch(client, buf, &reqHdr) == 0)
+        goto endLoop;
+
     if (forkOnRequest(mbdReqtype)) {
 
         if ((pid = fork()) < 0) {
@@ -737,6 +782,17 @@ processClient(struct clientNode *client, int *needFree)
                                                        &schedule1, &reqHdr)),
                    "do_chunkStatusReq()");
 
+            if (mSchedStage == 0) {
+                setNextSchedTimeWhenJobFinish();
+            }
+            if (client->lastTime == 0)
+                nSbdConnections++;
+            break;
+        case BATCH_STATUS_BATCH:
+            TIMEIT(0, (statusReqCC = do_statusBatchReq(&xdrs, s, &from,
+                                                       &schedule1, &reqHdr)),
+                   "do_statusBatchReq()");
+
             if (mSchedStage == 0) {
                 setNextSchedTimeWhenJobFinish();
             }
@@ -767,25 +823,13 @@ processClient(struct clientNode *client, int *needFree)
             TIMEIT(0, do_jobPeekReq(&xdrs, s, &from, client->fromHost, &reqHdr, &auth),"do_jobPeekReq()");
             break;
         case BATCH_USER_INFO:
-            TIMEIT(0, do_userInfoReq(&xdrs, s, &from, &reqHdr),"do_userInfoReq()");
-            break;
         case BATCH_PARAM_INFO:
-            TIMEIT(0, do_paramInfoReq(&xdrs, s, &from, &reqHdr),"do_paramInfoReq()");
-            break;
         case BATCH_GRP_INFO:
-            TIMEIT(3, do_groupInfoReq(&xdrs, s, &from, &reqHdr),"do_groupInfoReq()");
-            break;
         case BATCH_QUE_INFO:
-            TIMEIT(3, do_queueInfoReq(&xdrs, s, &from, &reqHdr),"do_queueInfoReq()");
-            break;
         case BATCH_JOB_INFO:
-            TIMEIT(3, do_jobInfoReq(&xdrs, s, &from, &reqHdr, schedule),"do_jobInfoReq()");
-            break;
         case BATCH_HOST_INFO:
-            TIMEIT(3, do_hostInfoReq(&xdrs, s, &from, &reqHdr),"do_hostInfoReq()");
-            break;
         case BATCH_RESOURCE_INFO:
-            TIMEIT(3, do_resourceInfoReq(&xdrs, s, &from, &reqHdr),"do_resourceInfoReq()");
+            doQueryReq(&xdrs, s, &from, &reqHdr);
             break;
         case BATCH_JOB_FORCE:
             TIMEIT(0,
@@ -806,6 +850,9 @@ processClient(struct clientNode *client, int *needFree)
         chanFreeBuf_(buf);
         exit(0);
     }
+
+    queryServerUpdate(mbdReqtype);
+
 endLoop:
     client->reqType = mbdReqtype;
     client->lastTime = now;
@@ -815,7 +862,8 @@ endLoop:
          reqHdr.opCode != BATCH_STATUS_JOB &&
          reqHdr.opCode != BATCH_RUSAGE_JOB &&
          reqHdr.opCode != BATCH_STATUS_MSG_ACK &&
-         reqHdr.opCode != BATCH_STATUS_CHUNK) ||
+         reqHdr.opCode != BATCH_STATUS_CHUNK &&
+         reqHdr.opCode != BATCH_STATUS_BATCH) ||
         statusReqCC < 0) {
         shutDownClient(client);
         return(-1);
@@ -830,10 +878,12 @@ shutDownClient(struct clientNode *client)
     if ((client->reqType == BATCH_STATUS_JOB
          || client->reqType == BATCH_STATUS_MSG_ACK
          || client->reqType == BATCH_RUSAGE_JOB
-         || client->reqType == BATCH_STATUS_CHUNK)
+         || client->reqType == BATCH_STATUS_CHUNK
+         || client->reqType == BATCH_STATUS_BATCH)
         && client->lastTime)
         nSbdConnections--;
 
+    clientMap[client->chanfd] = NULL;
     chanClose_(client->chanfd);
     offList((struct listEntry *)client);
     if (client->fromHost)
@@ -880,6 +930,9 @@ houseKeeping (int *hsKeeping)
                    "scheduleAndDispatchJobs");
             if (schedule == 0) {
                 schedule = FALSE;
+                /* New snapshot for the queries.
+                 */
+                queryServerRefresh();
             } else {
                 schedule = TRUE;
             }
@@ -921,6 +974,11 @@ periodicCheck(void)
     }
 
     switchELog();
+    queryServerStats();
+    logDispatchStats();
+    logReasonStats();
+    if (logclass & LC_COMM)
+        logChanBufStats();
 
     if (jobPriorityUpdIntvl > 0) {
         if (now - last_jobPriUpdTime >= jobPriorityUpdIntvl * 60 ) {
@@ -1139,7 +1197,8 @@ shutdownSbdConnections(void)
         if (cliPtr->reqType == BATCH_STATUS_JOB
             || cliPtr->reqType == BATCH_STATUS_MSG_ACK
             || cliPtr->reqType == BATCH_RUSAGE_JOB
-            || cliPtr->reqType == BATCH_STATUS_CHUNK) {
+            || cliPtr->reqType == BATCH_STATUS_CHUNK
+            || cliPtr->reqType == BATCH_STATUS_BATCH) {
 
             if (cliPtr->lastTime < oldest) {
                 deleteCliPtr = cliPtr;
@@ -1159,6 +1218,12 @@ shutdownSbdConnections(void)
          sbdPtr = nextSbdPtr) {
         nextSbdPtr = sbdPtr->forw;
 
+        /* Requests on the sbatchd channel
+         * have no connection to close.
+         */
+        if (sbdPtr->tag != 0)
+            continue;
+
         if (sbdPtr->lastTime < oldest) {
             if (deleteSbdPtr == NULL
                 || sbdPtr->reqCode >= deleteSbdPtr->reqCode) {
@@ -1174,14 +1239,20 @@ shutdownSbdConnections(void)
     }
 }
 
-static void
+/* processSbdNode()
+ * Process the reply to a request mbatchd sent to a
+ * sbatchd, or its failure with exception. A request
+ * on the sbatchd channel is freed, the channel stays.
+ */
+void
 processSbdNode(struct sbdNode *sbdPtr, int exception)
 {
 
     switch (sbdPtr->reqCode) {
         case MBD_NEW_JOB:
             doNewJobReply(sbdPtr, exception);
-            if (sbdPtr->reqCode == MBD_NEW_JOB_KEEP_CHAN)
+            if (sbdPtr->tag == 0
+                && sbdPtr->reqCode == MBD_NEW_JOB_KEEP_CHAN)
                 return;
             break;
         case MBD_PROBE:
@@ -1200,6 +1271,12 @@ processSbdNode(struct sbdNode *sbdPtr, int exception)
 %s: Unsupported sbdNode request %d", __func__, sbdPtr->reqCode);
     }
 
+    if (sbdPtr->tag != 0) {
+        sbdDone(sbdPtr);
+        return;
+    }
+
+    sbdMap[sbdPtr->chanfd] = NULL;
     chanClose_(sbdPtr->chanfd);
     offList((struct listEntry *) sbdPtr);
     FREEUP(sbdPtr);
@@ -1285,3 +1362,46 @@ updateJobPriorityInPJL(void)
         jp->jobPriority = MIN(newVal, (unsigned int)MAX_JOB_PRIORITY);
     }
 }
+
+/* raiseFileLimit()
+ * The channels are polled with epoll so mbatchd can
+ * hold as many sbatchd and client connections as the
+ * hard limit on open files allows.
+ */
+static void
+raiseFileLimit(void)
+{
+    struct rlimit rl;
+
+    if (getrlimit(RLIMIT_NOFILE, &rl) < 0)
+        return;
+
+    if (rl.rlim_cur == rl.rlim_max
+        || rl.rlim_max == RLIM_INFINITY)
+        return;
+
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+}
+
+/* logChanBufStats()
+ * Log the counters of the channel buffer pool
+ * since the last call.
+ */
+static void
+logChanBufStats(void)
+{
+    static struct chanBufStats last;
+    struct chanBufStats st;
+
+    chanBufStats_(&st);
+
+    ls_syslog(LOG_DEBUG, "\
+%s: allocs %ld pool hits %ld mallocs %ld inuse %ld pooled %ld writev %ld iovecs %ld",
+              __func__, st.allocs - last.allocs,
+              st.poolHits - last.poolHits, st.mallocs - last.mallocs,
+              st.inUse, st.pooled, st.writevs - last.writevs,
+              st.iovecs - last.iovecs);
+
+    last = st;
+}
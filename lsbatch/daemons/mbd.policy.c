@@ -22,6 +22,35 @@
 #define NL_SETN         10
 #define SORT_HOST_NUM   30
 
+/* The jobs placed by the scheduler are sent to
+ * their sbatchd in slices of DISPATCH_SLICE msec
+ * of the main loop, see sendQueuedJobs().
+ */
+#define DISPATCH_SLICE       50
+#define DISPATCH_STATS_INTVL (5 * 60)
+
+struct dispIntent {
+    LS_LONG_INT      jobId;
+    int              dispCount;
+    struct timeval   queued;
+};
+
+static struct dispIntent *dispQueue;
+static int dispQueueSize;
+static int dispQueueHead;
+static int numDispQueued;
+
+static struct {
+    int      numQueued;
+    int      numSent;
+    int      numFailed;
+    int      numDropped;
+    int      maxBacklog;
+    double   sumLatency;
+    double   maxLatency;
+    time_t   lastLog;
+} dispStats;
+
 enum candRetCode {
     CAND_NO_HOST,
     CAND_HOST_FOUND,
@@ -117,18 +146,6 @@ struct leftTimeTable {
 #define CANT_FINISH_BEFORE_DEADLINE(runLimit, deadline, cpuFactor)      \
     ((runLimit)/(cpuFactor) + now_disp > (deadline))
 
-#define REASON_TABLE_COPY(src, dest, fname)                             \
-    {                                                                   \
-        FREEUP (dest->reasonTb);                                        \
-        dest->numReasons = src->numReasons;                             \
-        if (dest->numReasons > 0) {                                     \
-            dest->reasonTb = (int *) my_calloc (dest->numReasons,       \
-                                                sizeof(int), fname);    \
-            memcpy((char *)dest->reasonTb, (char *)src->reasonTb,       \
-                   sizeof(int) * dest->numReasons);                     \
-        }                                                               \
-    }
-
 #define QUEUE_SCHED_DELAY(jpbw)                         \
     (((jpbw)->qPtr->schedDelay == INFINIT_INT) ?        \
      DEF_Q_SCHED_DELAY : (jpbw)->qPtr->schedDelay)
@@ -199,8 +216,10 @@ static int reservePreemptResources(struct jData *jp, int numHosts,
                                           (s->jFlags & JFLAG_URGENT_NOSTOP) || \
                                           (s->jStatus & JOB_STAT_UNKWN))
 
+struct schedBucket;
+
 static int readyToDisp(struct jData *jpbw, int *numAvailSlots);
-static enum candRetCode getCandHosts(struct jData *);
+static enum candRetCode getCandHosts(struct jData *, struct schedBucket *);
 static int getLsbUsable(void);
 static struct candHost *getJUsable(struct jData *, int *, int *);
 static void addReason(struct jData *jp, int hostId, int aReason);
@@ -208,7 +227,11 @@ static int allInOne(struct jData *jp);
 static int ckResReserve(struct hData *hD, struct resVal *resValPtr,
                         int *resource, struct jData *jp);
 
-static int getPeerCand(struct jData *jobp);
+static int getPeerCand(struct jData *jobp, struct schedBucket *);
+static struct schedBucket *jobBucket(struct jData *);
+static struct jData *bucketPeer(struct schedBucket *, struct jData *);
+static void resetSchedBuckets(void);
+static void resumeSchedBuckets(void);
 static int getPeerCand1(struct jData *jobp, struct jData *jpbw);
 static void copyPeerCand(struct jData *jobp, struct jData *jpbw);
 static void reserveSlots(struct jData *);
@@ -227,6 +250,9 @@ static int candHostOk(struct jData *jp, int indx, int *numAvailSlots,
 static int allocHosts(struct jData *jp);
 static int deallocHosts(struct jData *jp);
 static void jobStarted(struct jData *, struct jobReply *);
+static bool_t queueDispatch(struct jData *);
+static void sendDispatch(struct dispIntent *);
+static void dispatchRollback(struct jData *, int);
 static void disp_clean(void);
 static int overThreshold(float *load, float *thresh, int *reason);
 
@@ -234,7 +260,8 @@ static void hostPreference(struct jData *, int);
 static void hostPreference1(struct jData *, int, struct askedHost *,
                             int, int, int *, int);
 static int sortHosts(int , int, int, struct candHost *, int, float, bool_t);
-static int notOrdered(int , int, float , float , float, float);
+static void bubbleSortHosts(struct candHost *, struct hostSortKey *,
+                            int, int, int, bool_t);
 static int cntUserSlots(struct hTab *, struct uData *, int *);
 static void checkSlotReserve (struct jData **, int *);
 static int cntHostSlots(struct hTab *, struct hData *);
@@ -410,6 +437,24 @@ static bool_t  updateAccountsInQueue;
 
 static void resetSchedulerSession(void);
 
+/* Scheduling buckets. Pending jobs with the same queue,
+ * user, resource requirement, slots, limits and asked
+ * hosts get the same candidate hosts, a job of a bucket
+ * copies the candidates of the last member scheduled in
+ * the session instead of looking for a peer among its
+ * neighbours, and while the last member got no candidate
+ * host the other members skip getCandHosts(). Hosts only
+ * fill up while the session runs, but a session resumed
+ * after STAY_TOO_LONG may find hosts freed in between so
+ * it forgets the members that did not fit.
+ */
+struct schedBucket {
+    LS_LONG_INT peerJobId;
+    int         noFit;
+};
+static hTab schedBuckets;
+static int numSchedBuckets;
+
 /* openlava round robin
  */
 struct jRef {
@@ -437,8 +482,7 @@ readyToDisp (struct jData *jpbw, int *numAvailSlots)
     }
 
     if (!(jpbw->jFlags & JFLAG_READY2)) {
-        jpbw->numReasons = 0;
-        FREEUP (jpbw->reasonTb);
+        jobReasonFree(jpbw);
         jpbw->numSlots = 0;
         *numAvailSlots = 0;
         if (logclass & (LC_PEND))
@@ -565,8 +609,7 @@ readyToDisp (struct jData *jpbw, int *numAvailSlots)
 
     if (jReason) {
         jpbw->newReason = jReason;
-        jpbw->numReasons = 0;
-        FREEUP (jpbw->reasonTb);
+        jobReasonFree(jpbw);
         jpbw->numSlots = 0;
         *numAvailSlots = 0;
         if (logclass & (LC_PEND))
@@ -811,7 +854,7 @@ cntUQSlots (struct jData *jpbw, int *numAvailSlots)
 }
 
 static enum candRetCode
-getCandHosts (struct jData *jpbw)
+getCandHosts (struct jData *jpbw, struct schedBucket *bkt)
 {
     static char      fname[] = "getCandHosts";
     int              numJUsable;
@@ -844,7 +887,7 @@ getCandHosts (struct jData *jpbw)
          (jpbw->shared->jobBill.numProcessors <=1 ||
           jpbw->shared->resValPtr == NULL ||
           jpbw->shared->resValPtr->pTile == INFINIT_INT)) {
-        if (getPeerCand (jpbw)) {
+        if (getPeerCand (jpbw, bkt)) {
             if (jpbw->candPtr) {
                 enum candRetCode retCode;
                 INC_CNT(PROF_CNT_getPeerCandFound);
@@ -863,7 +906,7 @@ getCandHosts (struct jData *jpbw)
                 if ((retCode = XORCheckIfCandHostIsOk(jpbw)) == CAND_NO_HOST)
                 {
                     jpbw->numCandPtr = 0;
-                    FREEUP(jpbw->candPtr);
+                    jpbw->candPtr = NULL;
                     if (logclass & (LC_SCHED | LC_PEND)) {
                         ls_syslog(LOG_DEBUG2, "%s: job <%s> got peer's candHost but candHost are not usable to job", fname, lsb_jobid2str(jpbw->jobId));
                     }
@@ -913,8 +956,7 @@ getCandHosts (struct jData *jpbw)
     }
 
     jpbw->numCandPtr = numJUsable;
-    jpbw->candPtr = my_calloc (numJUsable,
-                               sizeof (struct candHost), fname);
+    jpbw->candPtr = sessionAlloc(numJUsable * sizeof(struct candHost));
     for (i = 0; i < numJUsable; i++) {
         jpbw->candPtr[i] = jUsable[i];
     }
@@ -1257,8 +1299,7 @@ getJUsable(struct jData *jp, int *numJUsable, int *nProc)
         jReasonTb = my_calloc(nhosts + 1, sizeof(int), fname);
     }
 
-    FREEUP (jp->reasonTb);
-    jp->numReasons = 0;
+    jobReasonFree(jp);
     numHosts = 0;
     numReasons = 0;
 
@@ -1384,6 +1425,9 @@ getJUsable(struct jData *jp, int *numJUsable, int *nProc)
                     safeSave(jp->qPtr->resValPtr->selectStr);
                 jp->shared->resValPtr->selectStrSize =
                     strlen(jp->qPtr->resValPtr->selectStr);
+                freeSelectCode(jp->shared->resValPtr->selectCode);
+                jp->shared->resValPtr->selectCode =
+                    compileResReq(jp->shared->resValPtr->selectStr);
 
                 jp->shared->resValPtr->options |= PR_SELECT;
             }
@@ -1573,31 +1617,22 @@ getJUsable(struct jData *jp, int *numJUsable, int *nProc)
 
 
     if (numReasons) {
-        int *reasonTb = my_calloc(numReasons + jp->numReasons,
-                                  sizeof(int), fname);
         jp->newReason = 0;
 
-        for (i = 0; i < numReasons; i++) {
-            reasonTb[i] = jReasonTb[i];
-            PUT_HIGH(reasonTb[i], jUnusable[i]->hostId);
-        }
+        for (i = 0; i < numReasons; i++)
+            PUT_HIGH(jReasonTb[i], jUnusable[i]->hostId);
 
-        for (i = 0; i < jp->numReasons; i++) {
-            reasonTb[i + numReasons] = jp->reasonTb[i];
-        }
-        jp->numReasons += numReasons;
-        FREEUP(jp->reasonTb);
-        jp->reasonTb = reasonTb;
+        jobReasonMerge(jp, jReasonTb, numReasons);
     }
 
     if (*numJUsable == 0) {
         if (logclass & (LC_SCHED | LC_PEND))
-            ls_syslog(LOG_DEBUG1, "%s: Got no eligible host for job %s; numReasons=%d", fname, lsb_jobid2str(jp->jobId), jp->numReasons);
+            ls_syslog(LOG_DEBUG1, "%s: Got no eligible host for job %s; numReasons=%d", fname, lsb_jobid2str(jp->jobId), NUM_JOB_REASONS(jp));
         return (NULL);
     }
 
     if (logclass & LC_SCHED) {
-        ls_syslog(LOG_DEBUG2, "%s: Got %d eligible hosts for job %s; numReasons=%d", fname, *numJUsable, lsb_jobid2str(jp->jobId), jp->numReasons);
+        ls_syslog(LOG_DEBUG2, "%s: Got %d eligible hosts for job %s; numReasons=%d", fname, *numJUsable, lsb_jobid2str(jp->jobId), NUM_JOB_REASONS(jp));
     }
 
     return candHosts;
@@ -1743,32 +1778,11 @@ ckResReserve(struct hData *hD, struct resVal *resValPtr, int *resource,
 static void
 addReason(struct jData *jp, int hostId, int aReason)
 {
-    int *newTb;
-    int i;
-    int oldhostId;
-
-    for (i = 0; i < jp->numReasons; i++) {
-        GET_HIGH(oldhostId, jp->reasonTb[i]);
-        if (oldhostId == hostId)
-            break;
-    }
-    if (i < jp->numReasons) {
-        jp->reasonTb[i] = aReason;
-        PUT_HIGH(jp->reasonTb[i], hostId);
-    } else {
-        newTb = myrealloc((void *)jp->reasonTb,
-                          (1 + jp->numReasons) * sizeof(int));
-        if (newTb) {
-            jp->reasonTb = newTb;
-            jp->reasonTb[jp->numReasons] = aReason;
-            PUT_HIGH(jp->reasonTb[jp->numReasons], hostId);
-            jp->numReasons++;
-        }
-    }
+    jobReasonAdd(jp, hostId, aReason);
 }
 
 static int
-getPeerCand(struct jData *jobp)
+getPeerCand(struct jData *jobp, struct schedBucket *bkt)
 {
     struct jData *jpbw;
     int numJobs = 0;
@@ -1779,6 +1793,12 @@ getPeerCand(struct jData *jobp)
 
     INC_CNT(PROF_CNT_getPeerCand);
 
+    if (bkt
+        && (jpbw = bucketPeer(bkt, jobp)) != NULL
+        && getPeerCand1(jobp, jpbw)) {
+        INC_CNT(PROF_CNT_schedBucketHit);
+        return TRUE;
+    }
 
 
     for (jpbw = jobp->forw;
@@ -1924,6 +1944,128 @@ getPeerCand1(struct jData *jobp, struct jData *jpbw)
     return FALSE;
 }
 
+/* jobBucket()
+ * The scheduling bucket of the job in this session,
+ * NULL if its candidates depend on more than the
+ * attributes of the bucket.
+ */
+static struct schedBucket *
+jobBucket(struct jData *jp)
+{
+    static char *key;
+    static int keySize;
+    struct submitReq *bill;
+    hEnt *ent;
+    char *resReq;
+    int len;
+    int new;
+    int i;
+
+    bill = &jp->shared->jobBill;
+
+    if ((jp->jStatus & (JOB_STAT_MIG | JOB_STAT_RESERVE))
+        || JOB_PREEMPT_WAIT(jp)
+        || jp->requeMode == RQE_EXCLUDE
+        || needHandleXor(jp))
+        return NULL;
+
+    resReq = (jp->shared->resValPtr && bill->resReq) ? bill->resReq : "";
+
+    len = 256 + strlen(resReq) + strlen(jp->schedHost)
+        + strlen(bill->fromHost ? bill->fromHost : "")
+        + strlen(bill->hostSpec ? bill->hostSpec : "")
+        + jp->numAskedPtr * 32;
+    if (len > keySize) {
+        FREEUP(key);
+        keySize = 0;
+        if ((key = my_malloc(len, __func__)) == NULL)
+            return NULL;
+        keySize = len;
+    }
+
+    len = sprintf(key, "%p %p %d %d %d %d %d %ld %d %s %s %s %s",
+                  jp->qPtr, jp->uPtr, bill->numProcessors,
+                  bill->maxNumProcessors, bill->options & SUB_EXCLUSIVE,
+                  bill->rLimits[LSF_RLIMIT_RUN],
+                  bill->rLimits[LSF_RLIMIT_CPU], (long)bill->termTime,
+                  jp->askedOthPrio, jp->schedHost,
+                  bill->fromHost ? bill->fromHost : "",
+                  bill->hostSpec ? bill->hostSpec : "", resReq);
+    for (i = 0; i < jp->numAskedPtr; i++)
+        len += sprintf(key + len, " %p:%d", jp->askedPtr[i].hData,
+                       jp->askedPtr[i].priority);
+
+    if (numSchedBuckets == 0)
+        h_initTab_(&schedBuckets, 64);
+
+    ent = h_addEnt_(&schedBuckets, key, &new);
+    if (new) {
+        ent->hData = my_calloc(1, sizeof(struct schedBucket), __func__);
+        numSchedBuckets++;
+    }
+
+    return ent->hData;
+}
+
+/* bucketPeer()
+ * The member of the bucket the job can take the
+ * candidates of, NULL if there is none.
+ */
+static struct jData *
+bucketPeer(struct schedBucket *bkt, struct jData *jp)
+{
+    struct jData *peer;
+
+    if (bkt->peerJobId == 0
+        || bkt->peerJobId == jp->jobId
+        || (peer = getJobData(bkt->peerJobId)) == NULL)
+        return NULL;
+
+    if (!(peer->jStatus & (JOB_STAT_PEND | JOB_STAT_MIG))
+        || !(peer->jFlags & JFLAG_READY)
+        || !(peer->processed & JOB_STAGE_CAND)
+        || peer->dispTime > now_disp)
+        return NULL;
+
+    return peer;
+}
+
+static void
+resetSchedBuckets(void)
+{
+    if (numSchedBuckets == 0)
+        return;
+
+    if (logclass & LC_SCHED)
+        ls_syslog(LOG_DEBUG, "%s: %d scheduling buckets in the session",
+                  __func__, numSchedBuckets);
+
+    h_freeTab_(&schedBuckets, free);
+    numSchedBuckets = 0;
+}
+
+/* resumeSchedBuckets()
+ * Jobs may have finished since the session stopped,
+ * the members must look for hosts again.
+ */
+static void
+resumeSchedBuckets(void)
+{
+    struct schedBucket *bkt;
+    sTab stab;
+    hEnt *ent;
+
+    if (numSchedBuckets == 0)
+        return;
+
+    for (ent = h_firstEnt_(&schedBuckets, &stab);
+         ent;
+         ent = h_nextEnt_(&stab)) {
+        bkt = ent->hData;
+        bkt->noFit = FALSE;
+    }
+}
+
 static void
 copyPeerCand (struct jData *jobp, struct jData *jpbw)
 {
@@ -1932,7 +2074,7 @@ copyPeerCand (struct jData *jobp, struct jData *jpbw)
 
     jobp->usePeerCand = TRUE;
 
-    REASON_TABLE_COPY(jpbw, jobp, fname);
+    jobReasonCopy(jobp, jpbw);
 
     if (logclass & (LC_SCHED)) {
         char  tmpJobId[32];
@@ -1954,8 +2096,7 @@ copyPeerCand (struct jData *jobp, struct jData *jpbw)
         return;
     }
 
-    jobp->candPtr = my_calloc(jpbw->numCandPtr,
-                              sizeof (struct candHost), fname);
+    jobp->candPtr = sessionAlloc(jpbw->numCandPtr * sizeof(struct candHost));
     for (i = 0; i < jpbw->numCandPtr; i++) {
         copyCandHostData(&(jobp->candPtr[i]), &(jpbw->candPtr[i]));
     }
@@ -3081,6 +3222,225 @@ dispatch_it (struct jData *jp)
     return TRUE;
 }
 
+/* queueDispatch()
+ * Start the job on the hosts the scheduler gave it
+ * and queue it to be sent to its sbatchd by
+ * sendQueuedJobs(). The job is accounted as running
+ * right away so the rest of the session sees its
+ * slots taken, sendDispatch() puts it back to pending
+ * if it cannot be sent.
+ */
+static bool_t
+queueDispatch(struct jData *jp)
+{
+    struct jobReply jobReply;
+    struct dispIntent *q;
+    struct jData *jpbw;
+    int i;
+
+    if ((jpbw = getZombieJob(jp->jobId)) != NULL) {
+        if (strcmp(jpbw->hPtr[0]->host, jp->hPtr[0]->host) == 0) {
+            jp->newReason = PEND_SBD_ZOMBIE;
+            return FALSE;
+        }
+    }
+
+    if (numDispQueued == dispQueueSize) {
+        q = my_calloc(2 * dispQueueSize + 64,
+                      sizeof(struct dispIntent), __func__);
+        for (i = 0; i < numDispQueued; i++)
+            q[i] = dispQueue[(dispQueueHead + i) % dispQueueSize];
+        FREEUP(dispQueue);
+        dispQueue = q;
+        dispQueueSize = 2 * dispQueueSize + 64;
+        dispQueueHead = 0;
+    }
+
+    jp->dispTime = now_disp;
+
+    /* What start_job() replies once the job
+     * is queued to the sbatchd.
+     */
+    memset(&jobReply, 0, sizeof(struct jobReply));
+    jobReply.jobId = jp->jobId;
+    jobReply.jStatus = JOB_STAT_RUN;
+    if (jp->shared->jobBill.options & SUB_PRE_EXEC)
+        jobReply.jStatus |= JOB_STAT_PRE_EXEC;
+
+    jobStarted(jp, &jobReply);
+    jp->newReason = 0;
+
+    q = &dispQueue[(dispQueueHead + numDispQueued) % dispQueueSize];
+    q->jobId = jp->jobId;
+    q->dispCount = jp->dispCount;
+    gettimeofday(&q->queued, NULL);
+    numDispQueued++;
+
+    dispStats.numQueued++;
+    if (numDispQueued > dispStats.maxBacklog)
+        dispStats.maxBacklog = numDispQueued;
+
+    return TRUE;
+}
+
+/* sendQueuedJobs()
+ * Send the queued jobs to their sbatchd for at most
+ * DISPATCH_SLICE msec so the replies and the client
+ * requests are served in between. If jobs are left
+ * the timeout of the main loop is set to 0 and
+ * TRUE returned.
+ */
+int
+sendQueuedJobs(struct timeval *timeout)
+{
+    struct timeval t0;
+    struct timeval t;
+    struct dispIntent q;
+
+    if (numDispQueued == 0)
+        return FALSE;
+
+    gettimeofday(&t0, NULL);
+    while (numDispQueued > 0) {
+
+        q = dispQueue[dispQueueHead];
+        dispQueueHead = (dispQueueHead + 1) % dispQueueSize;
+        numDispQueued--;
+
+        sendDispatch(&q);
+
+        gettimeofday(&t, NULL);
+        if ((t.tv_sec - t0.tv_sec) * 1000
+            + (t.tv_usec - t0.tv_usec) / 1000 >= DISPATCH_SLICE)
+            break;
+    }
+
+    if (numDispQueued == 0
+        || (timeout->tv_sec == 0 && timeout->tv_usec == 0))
+        return FALSE;
+
+    timeout->tv_sec = 0;
+    timeout->tv_usec = 0;
+
+    return TRUE;
+}
+
+/* sendDispatch()
+ * Send one queued job, unless it was finished,
+ * requeued or dispatched again since it was queued.
+ */
+static void
+sendDispatch(struct dispIntent *q)
+{
+    struct jobReply jobReply;
+    struct jobSig jobSig;
+    struct timeval t;
+    struct jData *jp;
+    sbdReplyType reply;
+    int svReason;
+    int reason;
+    double latency;
+
+    jp = getJobData(q->jobId);
+    if (jp == NULL
+        || !IS_START(jp->jStatus)
+        || jp->jobPid != 0
+        || jp->dispCount != q->dispCount) {
+        dispStats.numDropped++;
+        return;
+    }
+
+    gettimeofday(&t, NULL);
+    latency = (t.tv_sec - q->queued.tv_sec)
+        + (t.tv_usec - q->queued.tv_usec) / 1e6;
+    dispStats.sumLatency += latency;
+    if (latency > dispStats.maxLatency)
+        dispStats.maxLatency = latency;
+
+    TIMEIT(2, (reply = start_job(jp, jp->qPtr, &jobReply)), "start_job");
+
+    switch (reply) {
+        case ERR_NO_ERROR:
+            dispStats.numSent++;
+            return;
+
+        case ERR_NULL:
+            /* Ask the sbatchd whether it got the
+             * job, it reports the pid later if so.
+             */
+            jobSig.sigValue = 0;
+            jobSig.actFlags  = 0;
+            jobSig.chkPeriod = 0;
+            jobSig.actCmd = "";
+            reply = signal_job(jp, &jobSig, &jobReply);
+
+            switch (reply) {
+                case ERR_NO_ERROR:
+                    dispStats.numSent++;
+                    return;
+                case ERR_NO_JOB:
+                    ls_syslog(LOG_ERR, "\
+%s: Failed to start job %s on host %s", __func__,
+                              lsb_jobid2str(jp->jobId), jp->hPtr[0]->host);
+                    dispatchRollback(jp, PEND_JOB_START_FAIL);
+                    return;
+                default:
+                    ls_syslog(LOG_ERR, "\
+%s: mbatchd does not know job %s is started or not on host %s \
+(reply=%d) - assuming job not started", __func__,
+                              lsb_jobid2str(jp->jobId), jp->hPtr[0]->host,
+                              reply);
+                    dispatchRollback(jp, PEND_JOB_START_UNKNWN);
+                    return;
+            }
+
+        default:
+            reason = jobStartError(jp, reply);
+            svReason = jp->newReason;
+            dispatchRollback(jp, reason);
+            jp->newReason = svReason;
+            return;
+    }
+}
+
+/* dispatchRollback()
+ * The job could not be sent, back to pending.
+ */
+static void
+dispatchRollback(struct jData *jp, int reason)
+{
+    dispStats.numFailed++;
+
+    jp->newReason = reason;
+    jStatusChange(jp, JOB_STAT_PEND, LOG_IT, __func__);
+}
+
+/* logDispatchStats()
+ * Log the dispatch metrics every DISPATCH_STATS_INTVL.
+ */
+void
+logDispatchStats(void)
+{
+    if (now - dispStats.lastLog < DISPATCH_STATS_INTVL)
+        return;
+
+    if (dispStats.numQueued > 0 || numDispQueued > 0) {
+        ls_syslog(LOG_INFO, "\
+%s: queued %d sent %d failed %d dropped %d backlog %d max %d \
+latency avg %.3fs max %.3fs", __func__, dispStats.numQueued,
+                  dispStats.numSent, dispStats.numFailed,
+                  dispStats.numDropped, numDispQueued,
+                  dispStats.maxBacklog,
+                  dispStats.numSent + dispStats.numFailed > 0 ?
+                  dispStats.sumLatency
+                  / (dispStats.numSent + dispStats.numFailed) : 0.0,
+                  dispStats.maxLatency);
+    }
+
+    memset(&dispStats, 0, sizeof(dispStats));
+    dispStats.lastLog = now;
+}
+
 int
 jobStartError(struct jData *jData, sbdReplyType reply)
 {
@@ -3186,7 +3546,6 @@ jobStarted (struct jData *jp, struct jobReply *jobReply)
 
     jp->newReason = 0;
     jp->oldReason = 0;
-    jp->numReasons = 0;
 
 
     hostAcceptJobTime = time(NULL);
@@ -3194,7 +3553,7 @@ jobStarted (struct jData *jp, struct jobReply *jobReply)
     for (i = 0; i < jp->numHostPtr; i++)
         jp->hPtr[i]->acceptTime = hostAcceptJobTime;
 
-    FREEUP (jp->reasonTb);
+    jobReasonFree(jp);
 
     jp->dispCount ++;
     jp->jobPid = jobReply->jobPid;
@@ -3228,9 +3587,12 @@ disp_clean_job(struct jData *jpbw)
     jpbw->numEligProc = 0;
     jpbw->numAvailEligProc = 0;
     jpbw->oldReason = jpbw->newReason;
+    deallocExecCandPtr(jpbw);
 
-    if (jpbw->numCandPtr == 0 && jpbw->groupCands == NULL)
+    if (jpbw->numCandPtr == 0 && jpbw->groupCands == NULL) {
+        jpbw->candPtr = NULL;
         return;
+    }
 
     FREE_CAND_PTR(jpbw);
 
@@ -3263,6 +3625,11 @@ disp_clean(void)
 
     }
 
+    /* No job refers to the memory of the session
+     * any longer.
+     */
+    sessionArenaReset();
+
     return;
 }
 
@@ -3318,7 +3685,6 @@ hostPreference1 (struct jData *jp, int nHosts, struct askedHost *askedPtr,
         FREE_CAND_PTR(jp);                      \
         jp->candPtr = tmpCandPtr;               \
         jp->numCandPtr =  k;                    \
-        free(flags);                            \
         return;                                 \
     }
 
@@ -3329,9 +3695,8 @@ hostPreference1 (struct jData *jp, int nHosts, struct askedHost *askedPtr,
         return;
     }
 
-    tmpCandPtr = (struct candHost *) my_calloc (jp->numCandPtr,
-                                                sizeof (struct candHost), fname);
-    flags = (int *)my_calloc(jp->numCandPtr, sizeof(int), fname);
+    tmpCandPtr = sessionAlloc(jp->numCandPtr * sizeof(struct candHost));
+    flags = sessionAlloc(jp->numCandPtr * sizeof(int));
     k = 0;
 
 
@@ -3571,17 +3936,17 @@ getRawLsbLoad(int ncandidates, struct candHost *hosts)
         ls_syslog(LOG_DEBUG, "%s: Enter this rountine ...", fname);
 
 
-    hostNames = (char **) my_malloc(ncandidates * sizeof (char *), fname);
+    hostNames = sessionAlloc(ncandidates * sizeof(char *));
     for (i = 0; i < ncandidates; i++) {
         hostNames[i] = hosts[i].hData->host;
     }
 
     newHostLoad = ls_loadofhosts ("-:server", &num, 0, NULL, hostNames, ncandidates);
-    FREEUP(hostNames);
     if (newHostLoad != NULL) {
         for (i = 0; i < num; i++) {
             if ((hDataPtr = getHostData (newHostLoad[i].hostName)) != NULL) {
                 hDataPtr->lsbLoad[R15S] = newHostLoad[i].li[R15S];
+                HOST_SELECT_CHANGED(hDataPtr);
 
                 if (logclass & LC_TRACE)
                     ls_syslog(LOG_DEBUG, "%s: host %s R15S raw load is %f", fname, hDataPtr->host, hDataPtr->lsbLoad[R15S]);
@@ -3592,30 +3957,6 @@ getRawLsbLoad(int ncandidates, struct candHost *hosts)
 }
 
 
-static int
-notOrdered(int increasing, int lidx,
-           float load1, float load2,
-           float cpuf1, float cpuf2)
-{
-    float normal1, normal2;
-
-    if ((lidx == R15S) || (lidx == R1M) || (lidx == R15M)) {
-        normal1 = (cpuf1 != 0)?(load1 + 1)/cpuf1:load1;
-        normal2 = (cpuf2 != 0)?(load2 + 1)/cpuf2:load2;
-    }
-    else {
-        normal1 = load1;
-        normal2 = load2;
-    }
-
-    if (increasing) {
-        return (normal1 > normal2);
-    }
-    else {
-        return (normal1 < normal2);
-    }
-}
-
 static float
 getNumericLoadValue(const struct hData *hp, int lidx)
 {
@@ -3651,14 +3992,19 @@ static int
 sortHosts (int lidx, int numHosts, int ncandidates, struct candHost *hosts,
            int lastSort, float threshold, bool_t orderForPreempt)
 {
-    char swap;
-    int i, j;
+    static struct hostSortKey *keys;
+    static int maxKeys;
+    int i;
     char incr;
-    struct  candHost tmp;
     int cutoffs, shrink;
-    int order, residual;
+    int residual;
+    int passes;
+    int numFull;
     char flip;
-    float exld1, exld2;
+    float bestload;
+    float exld;
+    float value;
+    float cpuf;
 
     static char fname[]="sortHosts()";
 
@@ -3684,11 +4030,13 @@ sortHosts (int lidx, int numHosts, int ncandidates, struct candHost *hosts,
                 return ncandidates;
         } else
             cutoffs = (residual - 1)/shrink + 1;
+        passes = ncandidates - cutoffs;
     } else {
         if (ncandidates >= numHosts)
             cutoffs = numHosts;
         else
             cutoffs = ncandidates;
+        passes = cutoffs;
     }
 
     if (allLsInfo->resTable[lidx].orderType == INCR)
@@ -3699,112 +4047,123 @@ sortHosts (int lidx, int numHosts, int ncandidates, struct candHost *hosts,
     if (flip)
         incr = !incr;
 
-    if (lastSort == FALSE) {
-        float bestload = getNumericLoadValue(hosts[0].hData, lidx);
-        float bestcpuf = hosts[0].hData->cpuFactor;
-
-        for (i=1; i<ncandidates; i++) {
-            if (notOrdered(incr, lidx, bestload, getNumericLoadValue(hosts[0].hData, lidx),
-                           bestcpuf,hosts[0].hData->cpuFactor))
-                bestload = getNumericLoadValue(hosts[0].hData, lidx);
-            bestcpuf = hosts[0].hData->cpuFactor;
+    if (ncandidates > maxKeys) {
+        FREEUP(keys);
+        maxKeys = 0;
+        keys = my_malloc(ncandidates * sizeof(struct hostSortKey), fname);
+        if (keys == NULL) {
+            ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, fname, "my_malloc");
+            return (lastSort ? cutoffs : ncandidates);
         }
+        maxKeys = ncandidates;
+    }
 
+    /* The load of every host is looked up once, the
+     * first passes give a 5% margin to the hosts
+     * already in front.
+     */
+    numFull = 0;
+    for (i = 0; i < ncandidates; i++) {
+        value = getNumericLoadValue(hosts[i].hData, lidx);
+        keys[i].value = value;
+        keys[i].tier = hostStatusTier(hosts[i].hData->hStatus);
+        if (LSB_HOST_FULL(hosts[i].hData->hStatus))
+            numFull++;
+
+        if (lastSort == FALSE) {
+            exld = value * 0.05;
+            if (allLsInfo->resTable[lidx].orderType == DECR)
+                exld = -exld;
+            value = value + exld;
+        }
+
+        cpuf = hosts[i].hData->cpuFactor;
+        if ((lidx == R15S) || (lidx == R1M) || (lidx == R15M))
+            keys[i].key = (cpuf != 0) ? (value + 1)/cpuf : value;
+        else
+            keys[i].key = value;
+    }
+    bestload = keys[0].value;
 
-        swap = TRUE;
-        i = 0;
-        while (swap && (i < ncandidates-cutoffs)) {
-            swap = FALSE;
-            for (j = ncandidates-2; j>= i; j--) {
-                order = orderByStatus(hosts, j+1, orderForPreempt);
-                if (order == 0) {
-                    swap = TRUE;
-                    continue;
-                } else if (order == 1)
-                    continue;
-
-
-                exld1 = getNumericLoadValue(hosts[j].hData, lidx) * 0.05;
-                if (allLsInfo->resTable[lidx].orderType == DECR) {
-                    exld1 = -exld1;
-                }
+    if (logclass & (LC_EXEC)) {
+        ls_syslog(LOG_DEBUG3, "%s, ncandidates = %d, cutoffs = %d ", fname,
+                  ncandidates, cutoffs);
+    }
 
-                exld2 = getNumericLoadValue(hosts[j + 1].hData, lidx) * 0.05;
-                if (allLsInfo->resTable[lidx].orderType == DECR) {
-                    exld2 = -exld2;
-                }
+    /* Ordering full hosts for preemption compares
+     * their loads whatever their status, which is not
+     * an order, those are bubble sorted.
+     */
+    if ((orderForPreempt && numFull > 1)
+        || passSortHosts(hosts, keys, ncandidates, incr, passes) < 0)
+        bubbleSortHosts(hosts, keys, ncandidates, incr, passes,
+                        orderForPreempt);
 
-                if (notOrdered(incr, lidx,
-                               getNumericLoadValue(hosts[j].hData, lidx) + exld1,
-                               getNumericLoadValue(hosts[j + 1].hData, lidx) + exld2,
-                               hosts[j].hData->cpuFactor,
-                               hosts[j+1].hData->cpuFactor)) {
-                    swap = TRUE;
-                    tmp = hosts[j];
-                    hosts[j] = hosts[j+1];
-                    hosts[j+1] = tmp;
-                }
-            }
-            i++;
-        }
+    if (lastSort == FALSE) {
         for (i = ncandidates-cutoffs; i < ncandidates; i++)
-            if (fabs(getNumericLoadValue(hosts[i].hData, lidx) - bestload)
-                >= threshold)
+            if (fabs(keys[i].value - bestload) >= threshold)
                 return i;
 
         return (ncandidates);
     }
 
-
     if (logclass & (LC_EXEC)) {
-        ls_syslog(LOG_DEBUG3, "%s, ncandidates = %d, cutoffs = %d ", fname,
-                  ncandidates, cutoffs);
+        for (i=0; i < ncandidates; i++)
+            ls_syslog(LOG_DEBUG2, "%s, host[%d]'s name is %s", fname, i, hosts
+                      [i].hData->host);
     }
+
+    return (cutoffs);
+
+}
+
+/* bubbleSortHosts()
+ * The passes of the bubble sort done by passSortHosts(),
+ * one comparison at a time as orderByStatus() does.
+ */
+static void
+bubbleSortHosts(struct candHost *hosts, struct hostSortKey *keys,
+                int ncandidates, int incr, int passes,
+                bool_t orderForPreempt)
+{
+    struct candHost tmp;
+    struct hostSortKey tmpKey;
+    char swap;
+    int i, j;
+    int cmp;
+
     swap = TRUE;
     i = 0;
-    while (swap && (i < cutoffs)) {
+    while (swap && (i < passes)) {
         swap = FALSE;
         for (j = ncandidates-2; j >= i; j--) {
-            order = orderByStatus(hosts, j+1, orderForPreempt);
-            if (order == 0) {
-                swap = TRUE;
-                continue;
-            } else if (order == 1)
-                continue;
 
-
-            exld1 = getNumericLoadValue(hosts[j].hData, lidx) * 0.05;
-            if (allLsInfo->resTable[lidx].orderType == DECR) {
-                exld1 = -exld1;
-            }
-
-            exld2 = getNumericLoadValue(hosts[j + 1].hData, lidx) * 0.05;
-            if (allLsInfo->resTable[lidx].orderType == DECR) {
-                exld2 = -exld2;
+            if (keys[j + 1].tier < keys[j].tier) {
+                cmp = TRUE;
+            } else if ((keys[j].tier == 0 && keys[j + 1].tier == 0)
+                       || (orderForPreempt
+                           && LSB_HOST_FULL(hosts[j].hData->hStatus)
+                           && LSB_HOST_FULL(hosts[j + 1].hData->hStatus))) {
+                if (incr)
+                    cmp = keys[j].key > keys[j + 1].key;
+                else
+                    cmp = keys[j].key < keys[j + 1].key;
+            } else {
+                cmp = FALSE;
             }
 
-            if (notOrdered(incr, lidx,
-                           getNumericLoadValue(hosts[j].hData, lidx),
-                           getNumericLoadValue(hosts[j + 1].hData, lidx),
-                           hosts[j].hData->cpuFactor,
-                           hosts[j+1].hData->cpuFactor)) {
+            if (cmp) {
                 swap = TRUE;
                 tmp = hosts[j];
                 hosts[j] = hosts[j+1];
                 hosts[j+1] = tmp;
+                tmpKey = keys[j];
+                keys[j] = keys[j+1];
+                keys[j+1] = tmpKey;
             }
         }
         i++;
     }
-
-    if (logclass & (LC_EXEC)) {
-        for (i=0; i < ncandidates; i++)
-            ls_syslog(LOG_DEBUG2, "%s, host[%d]'s name is %s", fname, i, hosts
-                      [i].hData->host);
-    }
-
-    return (cutoffs);
-
 }
 
 int
@@ -4180,12 +4539,16 @@ scheduleAndDispatchJobs(void)
     if (jRefList == NULL)
         jRefList = listCreate("job reference list");
 
+    if (mSchedStage != 0)
+        resumeSchedBuckets();
+
     if (mSchedStage == 0) {
 
         nextSchedQ = qDataList->back;
         newLoadInfo = FALSE;
         freedSomeReserveSlot = FALSE;
         updateAccountsInQueue = TRUE;
+        resetSchedBuckets();
 
         hashEntryPtr = h_firstEnt_(&uDataList, &hashSearchPtr);
         while (hashEntryPtr) {
@@ -4561,6 +4924,8 @@ static int
 scheduleAJob(struct jData *jp, bool_t checkReady, bool_t checkOtherGroup)
 {
     static char fname[] = "scheduleAJob";
+    struct schedBucket *bkt;
+    struct jData *peer;
     int ret;
     int tmpVal = 0;
 
@@ -4589,9 +4954,23 @@ scheduleAJob(struct jData *jp, bool_t checkReady, bool_t checkOtherGroup)
 
             ret = checkIfCandHostIsOk(jp);
         }
+    } else if ((bkt = jobBucket(jp)) != NULL
+               && bkt->noFit
+               && (peer = bucketPeer(bkt, jp)) != NULL) {
+        /* A member of its bucket found no host already.
+         */
+        INC_CNT(PROF_CNT_schedBucketNoFit);
+        jobReasonCopy(jp, peer);
+        jp->newReason = peer->newReason;
+        jp->processed |= JOB_STAGE_CAND;
+        ret = CAND_NO_HOST;
     } else {
-        TIMEVAL(2, ret = getCandHosts(jp), tmpVal);
+        TIMEVAL(2, ret = getCandHosts(jp, bkt), tmpVal);
         timeGetCandHosts += tmpVal;
+        if (bkt) {
+            bkt->peerJobId = jp->jobId;
+            bkt->noFit = (ret == CAND_NO_HOST);
+        }
         if (logclass & (LC_SCHED | LC_PEND)) {
 
             ls_syslog(LOG_DEBUG2, "%s: Got %d candidate groups for job <%s>", fname, jp->numOfGroups, lsb_jobid2str(jp->jobId));
@@ -4921,7 +5300,7 @@ dispatchToCandHost(struct jData *jp)
     }
 
     jp->newReason = 0;
-    TIMEIT(3, tmpVal = dispatch_it(jp), "dispatch_it()");
+    TIMEIT(3, tmpVal = queueDispatch(jp), "queueDispatch()");
     if (tmpVal) {
 
         setExecHostsAcceptInterval(jp);
@@ -4955,7 +5334,6 @@ static void
 getNumProcs(struct jData *jp)
 {
 #define HAS_HOST_PREFERNECE(jp) ((jp)->numAskedPtr || (jp)->qPtr->numAskedPtr)
-    static char fname[] = "getNumProcs";
     int i, nSlots, nAvailSlots, backfillSlots;
     struct candHost *execCandPtr;
     struct backfillCand *backfillCandPtr;
@@ -4967,7 +5345,7 @@ getNumProcs(struct jData *jp)
     jp->numEligProc = 0;
     jp->numAvailEligProc = 0;
 
-    execCandPtr = (struct candHost *)my_malloc(jp->numCandPtr * sizeof(struct candHost), fname);
+    execCandPtr = sessionAlloc(jp->numCandPtr * sizeof(struct candHost));
     for (i = 0; i < jp->numCandPtr; i++) {
         execCandPtr[i].hData = NULL;
         execCandPtr[i].numSlots = 0;
@@ -4982,7 +5360,8 @@ getNumProcs(struct jData *jp)
         sortedBackfilleeList = listCreate(NULL);
 
         sortBackfillee(jp, sortedBackfilleeList);
-        backfillCandPtr = (struct backfillCand *)my_malloc(jp->numCandPtr * sizeof(struct backfillCand), fname);
+        backfillCandPtr = sessionAlloc(jp->numCandPtr
+                                       * sizeof(struct backfillCand));
         backfillCandPtrIndex = 0;
         for (i = 0; i < jp->numCandPtr; i++) {
             backfillCandPtr[i].numSlots = 0;
@@ -5162,10 +5541,8 @@ getNumProcs(struct jData *jp)
             execCandPtr[i].numAvailSlots = backfillCandPtr[i].numAvailSlots;
             execCandPtr[i].backfilleeList = backfillCandPtr[i].backfilleeList;
         }
-        free(backfillCandPtr);
 
         jp->numExecCandPtr = backfillCandPtrIndex;
-        FREEUP(jp->execCandPtr);
         jp->execCandPtr = execCandPtr;
         doBackfill(jp);
 
@@ -5243,7 +5620,6 @@ getNumProcs(struct jData *jp)
             }
         }
 
-        FREEUP(jp->execCandPtr);
         jp->execCandPtr = execCandPtr;
         if (JOB_CAN_BACKFILL(jp) && jobHasBackfillee(jp)) {
 
@@ -6047,8 +6423,7 @@ deallocExecCandPtr(struct jData *jp)
         }
     }
 
-
-    FREEUP(jp->execCandPtr);
+    jp->execCandPtr = NULL;
     jp->numExecCandPtr = 0;
 
 }
@@ -6526,8 +6901,11 @@ resetSchedulerSession(void)
     struct jRef *jR0;
 
     copyReason();
-    mSchedStage = 0;
     clearJobReason();
+    /* The candidate hosts of the jobs live in the
+     * memory of the session, drop them with it.
+     */
+    disp_clean();
 
     for (jR = (struct jRef *)jRefList->back;
          jR != (void *)jRefList; ) {
@@ -6538,6 +6916,8 @@ resetSchedulerSession(void)
         jR = jR0;
     }
 
+    cleanSelectClasses(FALSE);
+
     DUMP_TIMERS(__func__);
     DUMP_CNT();
     RESET_CNT();
@@ -6601,6 +6981,8 @@ resetStaticSchedVariables(void)
     }
     getPeerCand1(NULL, NULL);
     getJUsable(NULL, NULL, NULL);
+    cleanSelectClasses(TRUE);
+    resetSchedBuckets();
 }
 
 static bool_t
@@ -6874,7 +7256,7 @@ handleXor(struct jData *jpbw)
     for (j = 0; j < numXorExprs; j++) {
         groupCandHostsInit(&jpbw->groupCands[j]);
     }
-    indicesOfCandPtr = (int *) my_calloc (jpbw->numCandPtr, sizeof (int), fname);
+    indicesOfCandPtr = sessionAlloc(jpbw->numCandPtr * sizeof(int));
 
     for (j = 0; j < numXorExprs; j++) {
         numCandPtr = 0;
@@ -6883,7 +7265,11 @@ handleXor(struct jData *jpbw)
 
         for (i = 0; i<jpbw->numCandPtr; i++) {
             getTclHostData(&tclHostData, jpbw->candPtr[i].hData, NULL);
-            if (evalResReq (resValPtr->xorExprs[j], &tclHostData, FALSE) > 0 ) {
+            if (evalSelectCode(resValPtr->xorCodes ?
+                               resValPtr->xorCodes[j] : NULL,
+                               resValPtr->xorExprs[j],
+                               &tclHostData,
+                               FALSE) > 0 ) {
                 indicesOfCandPtr[numCandPtr] = i;
                 numCandPtr++;
             }
@@ -6896,8 +7282,7 @@ handleXor(struct jData *jpbw)
 
         if (numCandPtr != 0 ) {
 
-            candPtr = (struct candHost *) my_calloc (numCandPtr,
-                                                     sizeof (struct candHost), fname);
+            candPtr = sessionAlloc(numCandPtr * sizeof(struct candHost));
             for (i=0; i<numCandPtr; i++) {
                 copyCandHostData(&(candPtr[i]),&(jpbw->candPtr[indicesOfCandPtr[
                                                          i]]));
@@ -6915,7 +7300,6 @@ handleXor(struct jData *jpbw)
         jpbw->groupCands[j].numOfMembers = numCandPtr;
     }
 
-    FREEUP(indicesOfCandPtr);
     FREE_IND_CANDPTR(jpbw->candPtr, jpbw->numCandPtr);
 
     jpbw->numCandPtr = 0;
@@ -6950,14 +7334,13 @@ needHandleXor(struct jData *jpbw)
 static void
 copyCandHostPtr(struct candHost **sourceCandPtr, struct candHost **destCandPtr, int *sourceNum, int *destNum)
 {
-    static char fname[]="copyCandHostPtr";
     int j;
 
 
     FREE_IND_CANDPTR((*destCandPtr), *destNum);
 
     if (*sourceNum > 0) {
-        *destCandPtr = (struct candHost *)my_malloc((*sourceNum) * sizeof(struct candHost), fname);
+        *destCandPtr = sessionAlloc((*sourceNum) * sizeof(struct candHost));
     }
     for (j=0; j < (*sourceNum); j++)
         copyCandHostData(&((*destCandPtr)[j]),&((*sourceCandPtr)[j]));
@@ -7114,7 +7497,7 @@ removeCandHostFromCandPtr(struct candHost **pCandPtr, int *pNumCandPtr, int i)
     }
     (*pNumCandPtr)--;
     if ((*pNumCandPtr) == 0) {
-        FREEUP(*pCandPtr);
+        *pCandPtr = NULL;
     }
 }
 
@@ -7170,14 +7553,12 @@ static void
 groupCands2CandPtr(int numOfGroups, struct groupCandHosts *gc,
                    int *numCandPtr, struct candHost **candPtr)
 {
-    static char fname[] = "groupCands2CandPtr";
     int i, j, k, num;
 
     for (i = 0, num = 0; i < numOfGroups; i++) {
         num += gc[i].numOfMembers;
     }
-    *candPtr = (struct candHost *)my_calloc(num, sizeof(struct candHost),
-                                            fname);
+    *candPtr = sessionAlloc(num * sizeof(struct candHost));
     for (i = 0, num = 0; i < numOfGroups; i++) {
         for (j = 0; j < gc[i].numOfMembers; j++) {
             for (k = 0; k < num; k++) {
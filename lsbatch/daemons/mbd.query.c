@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "mbd.h"
+
+extern void chanCloseAllBut_(int);
+extern int schedule;
+
+/* Query children. Instead of forking mbatchd for every
+ * information request the requests are passed, together
+ * with the client socket, to query children forked from
+ * mbatchd. Each child is a read only snapshot of mbatchd
+ * serving requests one at a time until the snapshot is
+ * retired, at the end of every scheduling session or when
+ * a request changes the jobs, queues or hosts. Children
+ * are forked again only when queries arrive.
+ *
+ * MBD_QUERY_CHILDREN in lsf.conf is the number of
+ * children, 0 keeps forking per request, and
+ * MBD_MAX_QUERIES the maximum number of requests queued
+ * to the children, beyond it requests are rejected.
+ */
+
+/* Largest request passed to the children,
+ * larger ones are served by forking.
+ */
+#define QUERY_MAX_MSG       (64 * 1024)
+#define QUERY_STATS_INTVL   (5 * 60)
+
+struct queryChild {
+    pid_t   pid;
+    int     sock;
+    int     pending;
+};
+
+struct queryMsg {
+    struct sockaddr_in   from;
+    struct timeval       stamp;
+    int                  len;
+};
+
+struct queryAck {
+    struct timeval       stamp;
+    int                  opCode;
+};
+
+static struct queryChild *queryChildren;
+static int numQueryChildren = -1;
+static int maxQueries;
+static int numPending;
+
+static struct {
+    int      numQueries;
+    int      numRejected;
+    int      numForks;
+    double   sumLatency;
+    double   maxLatency;
+    time_t   lastLog;
+} queryStats;
+
+static void initQueryServer(void);
+static int spawnQueryChild(struct queryChild *);
+static void retireQueryChild(struct queryChild *);
+static void readQueryAcks(struct queryChild *);
+static void queryChildLoop(int);
+
+/* initQueryServer()
+ */
+static void
+initQueryServer(void)
+{
+    int i;
+
+    numQueryChildren = 0;
+    if (daemonParams[MBD_DONT_FORK].paramValue)
+        return;
+
+    if (daemonParams[MBD_QUERY_CHILDREN].paramValue) {
+        if (isint_(daemonParams[MBD_QUERY_CHILDREN].paramValue)
+            && atoi(daemonParams[MBD_QUERY_CHILDREN].paramValue) >= 0) {
+            numQueryChildren
+                = atoi(daemonParams[MBD_QUERY_CHILDREN].paramValue);
+        } else {
+            ls_syslog(LOG_ERR, "\
+%s: Invalid MBD_QUERY_CHILDREN %s ignored", __func__,
+                      daemonParams[MBD_QUERY_CHILDREN].paramValue);
+        }
+    }
+
+    if (daemonParams[MBD_MAX_QUERIES].paramValue) {
+        if (isint_(daemonParams[MBD_MAX_QUERIES].paramValue)
+            && atoi(daemonParams[MBD_MAX_QUERIES].paramValue) > 0) {
+            maxQueries = atoi(daemonParams[MBD_MAX_QUERIES].paramValue);
+        } else {
+            ls_syslog(LOG_ERR, "\
+%s: Invalid MBD_MAX_QUERIES %s ignored", __func__,
+                      daemonParams[MBD_MAX_QUERIES].paramValue);
+        }
+    }
+
+    if (numQueryChildren == 0)
+        return;
+
+    queryChildren = my_calloc(numQueryChildren,
+                              sizeof(struct queryChild), __func__);
+    for (i = 0; i < numQueryChildren; i++)
+        queryChildren[i].sock = -1;
+
+    ls_syslog(LOG_INFO, "\
+%s: %d query children, max queries %d", __func__,
+              numQueryChildren, maxQueries);
+}
+
+/* isQueryReq()
+ * Requests that only read mbatchd data.
+ */
+int
+isQueryReq(mbdReqType req)
+{
+    if (req == BATCH_JOB_INFO
+        || req == BATCH_QUE_INFO
+        || req == BATCH_HOST_INFO
+        || req == BATCH_GRP_INFO
+        || req == BATCH_RESOURCE_INFO
+        || req == BATCH_PARAM_INFO
+        || req == BATCH_USER_INFO)
+        return 1;
+
+    return 0;
+}
+
+/* doQueryReq()
+ * Serve a query, in mbatchd, in a child forked
+ * for it or in a query child.
+ */
+void
+doQueryReq(XDR *xdrs,
+           int chfd,
+           struct sockaddr_in *from,
+           struct LSFHeader *reqHdr)
+{
+    switch (reqHdr->opCode) {
+        case BATCH_USER_INFO:
+            TIMEIT(0, do_userInfoReq(xdrs, chfd, from, reqHdr),"do_userInfoReq()");
+            break;
+        case BATCH_PARAM_INFO:
+            TIMEIT(0, do_paramInfoReq(xdrs, chfd, from, reqHdr),"do_paramInfoReq()");
+            break;
+        case BATCH_GRP_INFO:
+            TIMEIT(3, do_groupInfoReq(xdrs, chfd, from, reqHdr),"do_groupInfoReq()");
+            break;
+        case BATCH_QUE_INFO:
+            TIMEIT(3, do_queueInfoReq(xdrs, chfd, from, reqHdr),"do_queueInfoReq()");
+            break;
+        case BATCH_JOB_INFO:
+            TIMEIT(3, do_jobInfoReq(xdrs, chfd, from, reqHdr, schedule),"do_jobInfoReq()");
+            break;
+        case BATCH_HOST_INFO:
+            TIMEIT(3, do_hostInfoReq(xdrs, chfd, from, reqHdr),"do_hostInfoReq()");
+            break;
+        case BATCH_RESOURCE_INFO:
+            TIMEIT(3, do_resourceInfoReq(xdrs, chfd, from, reqHdr),"do_resourceInfoReq()");
+            break;
+        default:
+            errorBack(chfd, LSBE_PROTOCOL, from);
+            break;
+    }
+}
+
+/* queryServerDispatch()
+ * Pass the query in buf to a query child. Return 0 if
+ * the request has been taken care of, -1 if the caller
+ * has to serve it.
+ */
+int
+queryServerDispatch(struct clientNode *client,
+                    struct Buffer *buf,
+                    struct LSFHeader *reqHdr)
+{
+    struct queryChild *qc;
+    struct queryChild *freeQc;
+    struct queryMsg msg;
+    struct msghdr mh;
+    struct iovec iov[2];
+    struct cmsghdr *cmsg;
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    int s;
+    int i;
+
+    if (numQueryChildren < 0)
+        initQueryServer();
+
+    if (numQueryChildren == 0
+        || !isQueryReq(reqHdr->opCode)
+        || buf->len > QUERY_MAX_MSG)
+        return -1;
+
+    for (i = 0; i < numQueryChildren; i++)
+        if (queryChildren[i].sock >= 0)
+            readQueryAcks(&queryChildren[i]);
+
+    if (maxQueries > 0 && numPending >= maxQueries) {
+        queryStats.numRejected++;
+        ls_syslog(LOG_DEBUG, "\
+%s: %d queries pending, request from %s rejected", __func__,
+                  numPending, client->fromHost);
+        errorBack(client->chanfd, LSBE_NO_FORK, &client->from);
+        return 0;
+    }
+
+    /* The least loaded child, fork a new
+     * one if all are busy and there is room.
+     */
+    qc = freeQc = NULL;
+    for (i = 0; i < numQueryChildren; i++) {
+        if (queryChildren[i].sock < 0) {
+            if (freeQc == NULL)
+                freeQc = &queryChildren[i];
+            continue;
+        }
+        if (qc == NULL || queryChildren[i].pending < qc->pending)
+            qc = &queryChildren[i];
+    }
+
+    if ((qc == NULL || qc->pending > 0)
+        && freeQc != NULL
+        && spawnQueryChild(freeQc) == 0)
+        qc = freeQc;
+
+    if (qc == NULL)
+        return -1;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.from = client->from;
+    msg.len = buf->len;
+    gettimeofday(&msg.stamp, NULL);
+
+    iov[0].iov_base = (char *)&msg;
+    iov[0].iov_len = sizeof(msg);
+    iov[1].iov_base = buf->data;
+    iov[1].iov_len = buf->len;
+
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = iov;
+    mh.msg_iovlen = 2;
+    mh.msg_control = cbuf;
+    mh.msg_controllen = sizeof(cbuf);
+
+    cmsg = CMSG_FIRSTHDR(&mh);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    s = chanSock_(client->chanfd);
+    memcpy(CMSG_DATA(cmsg), &s, sizeof(int));
+
+    if (sendmsg(qc->sock, &mh, MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+        ls_syslog(LOG_ERR, "\
+%s: sendmsg() to query child %d failed %m", __func__, qc->pid);
+        retireQueryChild(qc);
+        return -1;
+    }
+
+    qc->pending++;
+    numPending++;
+
+    return 0;
+}
+
+/* queryServerUpdate()
+ * Called after every request, the snapshots are retired
+ * if the request changed what queries would see.
+ */
+void
+queryServerUpdate(mbdReqType req)
+{
+    switch (req) {
+        case BATCH_JOB_SUB:
+        case BATCH_JOB_SIG:
+        case BATCH_JOB_MSG:
+        case BATCH_QUE_CTRL:
+        case BATCH_RECONFIG:
+        case BATCH_JOB_MIG:
+        case BATCH_HOST_CTRL:
+        case BATCH_JOB_SWITCH:
+        case BATCH_JOB_MOVE:
+        case BATCH_SET_JOB_ATTR:
+        case BATCH_JOB_MODIFY:
+        case BATCH_JOB_FORCE:
+            queryServerRefresh();
+            break;
+        default:
+            break;
+    }
+}
+
+/* queryServerRefresh()
+ * Retire all query children, they exit after
+ * serving the requests they already have.
+ */
+void
+queryServerRefresh(void)
+{
+    int i;
+
+    for (i = 0; i < numQueryChildren; i++) {
+        if (queryChildren[i].sock >= 0) {
+            readQueryAcks(&queryChildren[i]);
+            if (queryChildren[i].sock >= 0)
+                retireQueryChild(&queryChildren[i]);
+        }
+    }
+}
+
+/* queryServerStats()
+ * Log the query metrics every QUERY_STATS_INTVL.
+ */
+void
+queryServerStats(void)
+{
+    if (numQueryChildren <= 0)
+        return;
+
+    if (now - queryStats.lastLog < QUERY_STATS_INTVL)
+        return;
+
+    if (queryStats.numQueries > 0 || queryStats.numRejected > 0) {
+        ls_syslog(LOG_INFO, "\
+%s: queries %d rejected %d snapshots %d latency avg %.3fs max %.3fs",
+                  __func__, queryStats.numQueries,
+                  queryStats.numRejected, queryStats.numForks,
+                  queryStats.numQueries > 0 ?
+                  queryStats.sumLatency / queryStats.numQueries : 0.0,
+                  queryStats.maxLatency);
+    }
+
+    memset(&queryStats, 0, sizeof(queryStats));
+    queryStats.lastLog = now;
+}
+
+/* spawnQueryChild()
+ */
+static int
+spawnQueryChild(struct queryChild *qc)
+{
+    int sv[2];
+    int i;
+    pid_t pid;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+        ls_syslog(LOG_ERR, "%s: socketpair() failed %m", __func__);
+        return -1;
+    }
+
+    if ((pid = fork()) < 0) {
+        ls_syslog(LOG_ERR, "%s: fork() failed %m", __func__);
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+
+    if (pid == 0) {
+
+        close(sv[0]);
+        /* Other children must see their
+         * socket closed when retired.
+         */
+        for (i = 0; i < numQueryChildren; i++)
+            if (queryChildren[i].sock >= 0)
+                close(queryChildren[i].sock);
+
+        chanCloseAllBut_(-1);
+        if (debug < 2)
+            closeExceptFD(sv[1]);
+
+        queryChildLoop(sv[1]);
+        exit(0);
+    }
+
+    close(sv[1]);
+    io_nonblock_(sv[0]);
+
+    qc->pid = pid;
+    qc->sock = sv[0];
+    qc->pending = 0;
+    queryStats.numForks++;
+
+    if (logclass & LC_COMM)
+        ls_syslog(LOG_DEBUG, "%s: query child %d started", __func__, pid);
+
+    return 0;
+}
+
+/* retireQueryChild()
+ */
+static void
+retireQueryChild(struct queryChild *qc)
+{
+    close(qc->sock);
+    numPending -= qc->pending;
+    qc->sock = -1;
+    qc->pending = 0;
+}
+
+/* readQueryAcks()
+ * Every served request is acknowledged by the child
+ * with the time the request was passed to it.
+ */
+static void
+readQueryAcks(struct queryChild *qc)
+{
+    struct queryAck ack;
+    struct timeval t;
+    double latency;
+    int cc;
+
+    while ((cc = recv(qc->sock, &ack, sizeof(ack), MSG_DONTWAIT))
+           == sizeof(ack)) {
+
+        gettimeofday(&t, NULL);
+        latency = (t.tv_sec - ack.stamp.tv_sec)
+            + (t.tv_usec - ack.stamp.tv_usec) / 1e6;
+
+        queryStats.numQueries++;
+        queryStats.sumLatency += latency;
+        if (latency > queryStats.maxLatency)
+            queryStats.maxLatency = latency;
+
+        if (qc->pending > 0) {
+            qc->pending--;
+            numPending--;
+        }
+    }
+
+    if (cc == 0
+        || (cc < 0 && errno != EAGAIN
+            && errno != EWOULDBLOCK && errno != EINTR)) {
+        ls_syslog(LOG_ERR, "\
+%s: query child %d gone, %d requests lost", __func__,
+                  qc->pid, qc->pending);
+        retireQueryChild(qc);
+    }
+}
+
+/* queryChildLoop()
+ * Serve the requests passed by mbatchd till
+ * it closes the socket.
+ */
+static void
+queryChildLoop(int sock)
+{
+    static char buf[sizeof(struct queryMsg) + QUERY_MAX_MSG];
+    struct queryMsg msg;
+    struct queryAck ack;
+    struct LSFHeader reqHdr;
+    struct msghdr mh;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char cbuf[CMSG_SPACE(sizeof(int))];
+    XDR xdrs;
+    int cc;
+    int s;
+    int chfd;
+
+    for (;;) {
+
+        memset(&mh, 0, sizeof(mh));
+        iov.iov_base = buf;
+        iov.iov_len = sizeof(buf);
+        mh.msg_iov = &iov;
+        mh.msg_iovlen = 1;
+        mh.msg_control = cbuf;
+        mh.msg_controllen = sizeof(cbuf);
+
+        cc = recvmsg(sock, &mh, 0);
+        if (cc < 0 && errno == EINTR)
+            continue;
+        if (cc <= 0)
+            break;
+
+        cmsg = CMSG_FIRSTHDR(&mh);
+        if (cmsg == NULL
+            || cmsg->cmsg_type != SCM_RIGHTS
+            || cc < sizeof(struct queryMsg)) {
+            ls_syslog(LOG_ERR, "%s: bad message from mbatchd", __func__);
+            break;
+        }
+        memcpy(&s, CMSG_DATA(cmsg), sizeof(int));
+        memcpy(&msg, buf, sizeof(struct queryMsg));
+
+        now = time(NULL);
+        if ((chfd = chanOpenSock_(s, 0)) < 0) {
+            ls_syslog(LOG_ERR, "%s: chanOpenSock_() failed %M", __func__);
+            close(s);
+            continue;
+        }
+
+        memset(&reqHdr, 0, sizeof(reqHdr));
+        xdrmem_create(&xdrs, buf + sizeof(struct queryMsg),
+                      msg.len, XDR_DECODE);
+        if (xdr_LSFHeader(&xdrs, &reqHdr))
+            doQueryReq(&xdrs, chfd, &msg.from, &reqHdr);
+        else
+            ls_syslog(LOG_ERR, I18N_FUNC_FAIL, __func__, "xdr_LSFHeader");
+        xdr_destroy(&xdrs);
+        chanClose_(chfd);
+
+        ack.stamp = msg.stamp;
+        ack.opCode = reqHdr.opCode;
+        if (send(sock, &ack, sizeof(ack), MSG_NOSIGNAL) < 0)
+            break;
+    }
+
+    exit(0);
+}
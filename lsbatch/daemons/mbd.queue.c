@@ -27,7 +27,7 @@ void
 fillHostnames();
 
 #define JOBIDSTRLEN 20
-struct hTab jobIdHT;
+jidTab jobIdHT;
 struct hTab jgrpIdHT;
 
 static int
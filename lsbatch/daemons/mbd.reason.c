@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+
+#include "mbd.h"
+
+/* Per host pending reasons of the jobs.
+ *
+ * getJUsable() gives a pending job one entry for every
+ * host it cannot use, and the reasons stay with the job
+ * until the next pass for bjobs -p. The jobs of a class,
+ * same queue, user and resource requirement, get the
+ * same entries in the same host order, so the tables are
+ * kept once: a new table is looked up by its contents
+ * and shared with the jobs already holding the same one.
+ * A table is never changed while shared, a job changing
+ * its reasons gets another table.
+ */
+
+#define REASON_STATS_INTVL (5 * 60)
+
+static jidTab reasonTbs;
+static int *scratch;
+static int scratchSize;
+
+static struct reasonStats {
+    time_t lastLog;
+    int    numTables;
+    int    numRefs;
+    int    numShared;
+    int    numNew;
+    size_t numBytes;
+} reasonStats;
+
+static struct jReasonTb *reasonTbGet(int *, int);
+static void reasonTbRelease(struct jReasonTb *);
+static unsigned int reasonTbHash(int *, int);
+static int growScratch(int);
+
+/* jobReasonFree()
+ * Drop the pending reasons of the job.
+ */
+void
+jobReasonFree(struct jData *jp)
+{
+    if (jp->reasonTb == NULL)
+        return;
+
+    reasonTbRelease(jp->reasonTb);
+    jp->reasonTb = NULL;
+}
+
+/* jobReasonCopy()
+ * The job gets the pending reasons of its peer.
+ */
+void
+jobReasonCopy(struct jData *jp, struct jData *peer)
+{
+    struct jReasonTb *tb;
+
+    tb = peer->reasonTb;
+    if (tb) {
+        tb->refCount++;
+        reasonStats.numRefs++;
+        reasonStats.numShared++;
+    }
+    jobReasonFree(jp);
+    jp->reasonTb = tb;
+}
+
+/* jobReasonMerge()
+ * Put num reasons in front of the ones the job has.
+ */
+void
+jobReasonMerge(struct jData *jp, int *reasons, int num)
+{
+    struct jReasonTb *tb;
+    int old;
+
+    if (num <= 0)
+        return;
+
+    old = NUM_JOB_REASONS(jp);
+    if (old == 0) {
+        tb = reasonTbGet(reasons, num);
+    } else {
+        if (growScratch(num + old) < 0)
+            return;
+        memcpy(scratch, reasons, num * sizeof(int));
+        memcpy(scratch + num, jp->reasonTb->reasons, old * sizeof(int));
+        tb = reasonTbGet(scratch, num + old);
+    }
+
+    if (tb == NULL)
+        return;
+
+    jobReasonFree(jp);
+    jp->reasonTb = tb;
+}
+
+/* jobReasonAdd()
+ * Set the reason of the job on one host.
+ */
+void
+jobReasonAdd(struct jData *jp, int hostId, int reason)
+{
+    struct jReasonTb *tb;
+    int num;
+    int i;
+    int k;
+
+    num = NUM_JOB_REASONS(jp);
+    if (growScratch(num + 1) < 0)
+        return;
+
+    if (num > 0)
+        memcpy(scratch, jp->reasonTb->reasons, num * sizeof(int));
+
+    for (i = 0; i < num; i++) {
+        GET_HIGH(k, scratch[i]);
+        if (k == hostId)
+            break;
+    }
+    if (i == num)
+        num++;
+
+    scratch[i] = reason;
+    PUT_HIGH(scratch[i], hostId);
+
+    if ((tb = reasonTbGet(scratch, num)) == NULL)
+        return;
+
+    jobReasonFree(jp);
+    jp->reasonTb = tb;
+}
+
+/* logReasonStats()
+ * Log how many reason tables the pending jobs
+ * share every REASON_STATS_INTVL.
+ */
+void
+logReasonStats(void)
+{
+    if (now - reasonStats.lastLog < REASON_STATS_INTVL)
+        return;
+
+    if (reasonStats.numNew > 0 || reasonStats.numShared > 0) {
+        ls_syslog(LOG_INFO, "\
+%s: tables %d jobs %d bytes %lu, since last new %d shared %d", __func__,
+                  reasonStats.numTables, reasonStats.numRefs,
+                  (unsigned long)reasonStats.numBytes,
+                  reasonStats.numNew, reasonStats.numShared);
+    }
+
+    reasonStats.numNew = reasonStats.numShared = 0;
+    reasonStats.lastLog = now;
+}
+
+/* reasonTbGet()
+ * The table holding reasons, with one more reference.
+ * Returns NULL if there is no memory.
+ */
+static struct jReasonTb *
+reasonTbGet(int *reasons, int num)
+{
+    struct jReasonTb *tb;
+    unsigned int hash;
+    jidEnt *ent;
+    int new;
+
+    if (reasonTbs.slots == NULL
+        && jidInitTab(&reasonTbs, 64) < 0) {
+        ls_syslog(LOG_ERR, "%s: jidInitTab() failed %M", __func__);
+        return NULL;
+    }
+
+    hash = reasonTbHash(reasons, num);
+
+    ent = jidAddEnt(&reasonTbs, (LS_LONG_INT)hash + 1, &new);
+    if (ent == NULL) {
+        ls_syslog(LOG_ERR, "%s: jidAddEnt() failed %M", __func__);
+        return NULL;
+    }
+
+    for (tb = ent->hData; tb; tb = tb->next) {
+        if (tb->numReasons == num
+            && memcmp(tb->reasons, reasons, num * sizeof(int)) == 0) {
+            tb->refCount++;
+            reasonStats.numRefs++;
+            reasonStats.numShared++;
+            return tb;
+        }
+    }
+
+    tb = my_malloc(sizeof(struct jReasonTb) + num * sizeof(int), __func__);
+    if (tb == NULL) {
+        ls_syslog(LOG_ERR, "%s: my_malloc() failed %M", __func__);
+        if (ent->hData == NULL)
+            jidRmEnt(&reasonTbs, (LS_LONG_INT)hash + 1);
+        return NULL;
+    }
+
+    tb->hash = hash;
+    tb->refCount = 1;
+    tb->numReasons = num;
+    tb->reasons = (int *)(tb + 1);
+    memcpy(tb->reasons, reasons, num * sizeof(int));
+    tb->next = ent->hData;
+    ent->hData = tb;
+
+    reasonStats.numTables++;
+    reasonStats.numRefs++;
+    reasonStats.numNew++;
+    reasonStats.numBytes += sizeof(struct jReasonTb) + num * sizeof(int);
+
+    return tb;
+}
+
+static void
+reasonTbRelease(struct jReasonTb *tb)
+{
+    struct jReasonTb **pp;
+    jidEnt *ent;
+
+    reasonStats.numRefs--;
+    if (--tb->refCount > 0)
+        return;
+
+    ent = jidGetEnt(&reasonTbs, (LS_LONG_INT)tb->hash + 1);
+    if (ent) {
+        for (pp = (struct jReasonTb **)&ent->hData; *pp; pp = &(*pp)->next) {
+            if (*pp == tb) {
+                *pp = tb->next;
+                break;
+            }
+        }
+        if (ent->hData == NULL)
+            jidRmEnt(&reasonTbs, (LS_LONG_INT)tb->hash + 1);
+    }
+
+    reasonStats.numTables--;
+    reasonStats.numBytes -= sizeof(struct jReasonTb)
+        + tb->numReasons * sizeof(int);
+    FREEUP(tb);
+}
+
+/* reasonTbHash()
+ * FNV-1a of the entries, 31 bits so the key
+ * of the table is positive.
+ */
+static unsigned int
+reasonTbHash(int *reasons, int num)
+{
+    unsigned int h;
+    int i;
+
+    h = 2166136261U;
+    for (i = 0; i < num; i++) {
+        h ^= (unsigned int)reasons[i];
+        h *= 16777619U;
+    }
+
+    return h & 0x7fffffff;
+}
+
+static int
+growScratch(int num)
+{
+    if (num <= scratchSize)
+        return 0;
+
+    FREEUP(scratch);
+    scratchSize = 0;
+
+    scratch = my_malloc(num * sizeof(int), __func__);
+    if (scratch == NULL) {
+        ls_syslog(LOG_ERR, "%s: my_malloc() failed %M", __func__);
+        return -1;
+    }
+    scratchSize = num;
+
+    return 0;
+}
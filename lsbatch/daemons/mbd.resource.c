@@ -63,6 +63,7 @@ getLsbResourceInfo (void)
     }
     if (numResources > 0)
         freeSharedResource();
+    SELECT_CLASSES_CHANGED();
     initHostInstances (numRes);
     for (i = 0; i < numRes; i++)
         addSharedResource(&resourceInfo[i]);
@@ -420,6 +421,7 @@ resetSharedResource()
 		safeSave(sharedResources[i]->instances[j]->lsfValue);
 	}
     }
+    SELECT_CLASSES_CHANGED();
 }
 void
 updSharedResourceByRUNJob(const struct jData* jp)
@@ -589,6 +591,7 @@ adjustLoadValue:
 
 	    FREEUP (instance->value);
 	    instance->value = safeSave (loadString);
+	    instanceSelectChanged(instance);
 
 	    SET_BIT (ldx, rusgBitMaps);
 
@@ -32,17 +32,34 @@ extern bool_t xdr_resourceInfoReq(XDR *, struct resourceInfoReq *,
                                   struct LSFHeader *);
 
 extern char *jgrpNodeParentPath(struct jgTreeNode *);
-static int packJgrpInfo(struct jgTreeNode *, int, char **, int, int);
-static int packJobInfo(struct jData *, int, char **, int, int, int);
+static int packJgrpInfo(struct jgTreeNode *, int, int, int);
+static int packJobInfo(struct jData *, int, int, int, int);
+static void briefJobBill(struct jData *, struct submitReq *, char *);
+static char *jobInfoBufGet(int);
+static int jobInfoBufFlush(int, char *, int);
 static void initSubmit(int *, struct submitReq *, struct submitMbdReply *);
 static int sendBack(int, struct submitReq *, struct submitMbdReply *, int);
 static void addPendSigEvent(struct sbdNode *sbdPtr);
 static void freeJobHead (struct jobInfoHead *);
-static void freeJobInfoReply (struct jobInfoReply *);
+static void freeJobInfoReply (struct jobInfoReply *, int);
 static void freeShareResourceInfoReply (struct  lsbShareResourceInfoReply *);
 static int xdrsize_QueueInfoReply(struct queueInfoReply * );
 extern void closeSession(int);
 
+/* Job information replies are encoded back to back
+ * in one buffer kept across requests and written out,
+ * together with the reply head, once it holds
+ * JOBINFO_FLUSH bytes instead of using a buffer
+ * and a write per job.
+ */
+#define JOBINFO_FLUSH   (256 * 1024)
+
+static struct {
+    char   *data;
+    int    size;
+    int    len;
+} jobInfoBuf;
+
 int
 do_submitReq(XDR *xdrs,
              int chfd,
@@ -147,7 +164,6 @@ do_jobInfoReq(XDR *xdrs,
 {
     static char             fname[] = "do_jobInfoReq";
     char                    *reply_buf = NULL;
-    char                   *buf = NULL;
     XDR                     xdrs2;
     struct jobInfoReq       jobInfoReq;
     struct jobInfoHead      jobInfoHead;
@@ -241,67 +257,137 @@ do_jobInfoReq(XDR *xdrs,
         return(-1);
     }
     len = XDR_GETPOS(&xdrs2);
-
-    {
-        if (chanWrite_(chfd, reply_buf, len) != len) {
-            ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, fname, "chanWrite_");
-            FREEUP (reply_buf);
-            freeJobHead (&jobInfoHead);
-            FREEUP (jgrplist);
-            xdr_destroy(&xdrs2);
-            return(-1);
-        }
-    }
-    FREEUP (reply_buf);
-
     xdr_destroy(&xdrs2);
     freeJobHead (&jobInfoHead);
+
     if (reply != LSBE_NO_ERROR ||
-        (jobInfoReq.options & (JOBID_ONLY|JOBID_ONLY_ALL))) {
-        FREEUP (jgrplist);
-        return(0);
-    }
+        (jobInfoReq.options & (JOBID_ONLY|JOBID_ONLY_ALL)))
+        listSize = 0;
 
+    /* The head goes out with the first batch
+     * of jobs, or alone if there are none.
+     */
+    jobInfoBuf.len = 0;
     for (i = 0; i < listSize; i++) {
         if (jgrplist[i].isJData &&
-            ((len = packJobInfo ((struct jData *)jgrplist[i].info,
-                                 listSize - 1 - i,  &buf, schedule,
-                                 jobInfoReq.options, reqHdr->version)) < 0)) {
+            packJobInfo((struct jData *)jgrplist[i].info,
+                        listSize - 1 - i, schedule,
+                        jobInfoReq.options, reqHdr->version) < 0) {
             ls_syslog(LOG_ERR, I18N_FUNC_FAIL, fname, "packJobInfo");
+            FREEUP (reply_buf);
             FREEUP (jgrplist);
             return(-1);
         }
-        if ( !jgrplist[i].isJData &&
-             ((len = packJgrpInfo ((struct jgTreeNode *)jgrplist[i].info,
-                                   listSize - 1 - i, &buf, schedule, reqHdr->version)) < 0)) {
+        if (!jgrplist[i].isJData &&
+            packJgrpInfo((struct jgTreeNode *)jgrplist[i].info,
+                         listSize - 1 - i, schedule, reqHdr->version) < 0) {
             ls_syslog(LOG_ERR, I18N_FUNC_FAIL, fname, "packJgrpInfo");
+            FREEUP (reply_buf);
             FREEUP (jgrplist);
             return(-1);
         }
 
-        {
-            if (chanWrite_(chfd, buf, len) != len) {
-                ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, fname, "chanWrite_");
-                FREEUP(buf);
-                FREEUP (jgrplist);
-                return(-1);
-            }
+        if (jobInfoBuf.len < JOBINFO_FLUSH)
+            continue;
+
+        if (jobInfoBufFlush(chfd, reply_buf, len) < 0) {
+            ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, fname, "chanWritev_");
+            FREEUP (reply_buf);
+            FREEUP (jgrplist);
+            return(-1);
         }
-        FREEUP(buf);
+        len = 0;
     }
     FREEUP (jgrplist);
 
+    if (jobInfoBufFlush(chfd, reply_buf, len) < 0) {
+        ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, fname, "chanWritev_");
+        FREEUP (reply_buf);
+        return(-1);
+    }
+    FREEUP (reply_buf);
+
+    if (reply != LSBE_NO_ERROR ||
+        (jobInfoReq.options & (JOBID_ONLY|JOBID_ONLY_ALL)))
+        return(0);
+
     chanClose_(chfd);
     return(0);
 }
 
+/* jobInfoBufGet()
+ * Return room for len more bytes at the end
+ * of the job information buffer.
+ */
+static char *
+jobInfoBufGet(int len)
+{
+    char *p;
+    int size;
+
+    if (jobInfoBuf.len + len <= jobInfoBuf.size)
+        return jobInfoBuf.data + jobInfoBuf.len;
+
+    size = jobInfoBuf.size > 0 ? jobInfoBuf.size : JOBINFO_FLUSH;
+    while (size < jobInfoBuf.len + len)
+        size = 2 * size;
+
+    p = realloc(jobInfoBuf.data, size);
+    if (p == NULL) {
+        ls_syslog(LOG_ERR, "\
+%s: realloc(%d) failed %m", __func__, size);
+        return NULL;
+    }
+    jobInfoBuf.data = p;
+    jobInfoBuf.size = size;
+
+    return jobInfoBuf.data + jobInfoBuf.len;
+}
+
+/* jobInfoBufFlush()
+ * Write the reply head, if any, and the encoded
+ * jobs with one system call. The buffer is given
+ * back if a very large job made it grow.
+ */
+static int
+jobInfoBufFlush(int chfd, char *head, int headLen)
+{
+    struct iovec iov[2];
+    int n;
+    int len;
+
+    n = 0;
+    if (headLen > 0) {
+        iov[n].iov_base = head;
+        iov[n].iov_len = headLen;
+        ++n;
+    }
+    if (jobInfoBuf.len > 0) {
+        iov[n].iov_base = jobInfoBuf.data;
+        iov[n].iov_len = jobInfoBuf.len;
+        ++n;
+    }
+
+    len = headLen + jobInfoBuf.len;
+    if (n > 0 && chanWritev_(chfd, iov, n) != len)
+        len = -1;
+
+    jobInfoBuf.len = 0;
+    if (jobInfoBuf.size > 4 * JOBINFO_FLUSH) {
+        FREEUP(jobInfoBuf.data);
+        jobInfoBuf.size = 0;
+    }
+
+    return len < 0 ? -1 : 0;
+}
+
 static int
-packJgrpInfo(struct jgTreeNode * jgNode, int remain, char **replyBuf, int schedule, int version)
+packJgrpInfo(struct jgTreeNode * jgNode, int remain, int schedule, int version)
 {
     struct jobInfoReply jobInfoReply;
     struct submitReq jobBill;
     struct LSFHeader hdr;
-    char  *request_buf = NULL;
+    char  *request_buf;
     static char fname[] = "packJgrpInfo";
     XDR xdrs;
     int i, len;
@@ -339,7 +425,8 @@ packJgrpInfo(struct jgTreeNode * jgNode, int remain, char **replyBuf, int schedu
 
     len = (len * 4) / 4;
 
-    request_buf = (char *) my_malloc(len, "packJgrpInfo");
+    if ((request_buf = jobInfoBufGet(len)) == NULL)
+        return -1;
     xdrmem_create(&xdrs, request_buf, len, XDR_ENCODE);
     hdr.reserved = remain;
     hdr.version = version;
@@ -349,11 +436,10 @@ packJgrpInfo(struct jgTreeNode * jgNode, int remain, char **replyBuf, int schedu
         ls_syslog(LOG_ERR, I18N_FUNC_S_FAIL, fname,
                   "xdr_encodeMsg", "jobInfoReply");
         xdr_destroy(&xdrs);
-        FREEUP (request_buf);
         return -1;
     }
     i = XDR_GETPOS(&xdrs);
-    *replyBuf = request_buf;
+    jobInfoBuf.len += i;
     xdr_destroy(&xdrs);
     return (i);
 
@@ -414,18 +500,24 @@ jobInfoReplyXdrBufLen(struct jobInfoReply *jobInfoReplyPtr)
 static int
 packJobInfo(struct jData * jobData,
             int remain,
-            char **replyBuf,
             int schedule,
             int options, int version)
 {
     static char fname[] = "packJobInfo";
+    /* Scratch tables sized on the number of hosts
+     * and load indexes, kept from job to job.
+     */
+    static int *reasonTb;
+    static int *jReasonTb;
+    static int numReasonTb;
+    static float *loadSched;
+    static float *loadStop;
+    static int numLoad;
     struct jobInfoReply jobInfoReply;
     struct submitReq jobBill;
     struct LSFHeader hdr;
     struct hData *hPtr;
-    char *request_buf = NULL;
-    int *reasonTb = NULL;
-    int *jReasonTb;
+    char *request_buf;
     XDR xdrs;
     int i;
     int k;
@@ -434,8 +526,6 @@ packJobInfo(struct jData * jobData,
     int *pkHReasonTb;
     int *pkQReasonTb;
     int *pkUReasonTb;
-    float *loadSched = NULL;
-    float *loadStop = NULL;
     float *cpuFactor;
     float one = 1.0;
     float cpuF;
@@ -444,12 +534,19 @@ packJobInfo(struct jData * jobData,
     int job_numReasons;
     int *job_reasonTb;
 
-    job_numReasons = jobData->numReasons;
-    job_reasonTb = jobData->reasonTb;
+    job_numReasons = NUM_JOB_REASONS(jobData);
+    job_reasonTb = jobData->reasonTb ? jobData->reasonTb->reasons : NULL;
 
-    if (reasonTb == NULL) {
-        reasonTb = my_calloc(numofhosts(), sizeof(int), fname);
-        jReasonTb = my_calloc(numofhosts(), sizeof(int), fname);
+    if (numReasonTb < numofhosts() + 1) {
+        FREEUP(reasonTb);
+        FREEUP(jReasonTb);
+        numReasonTb = numofhosts() + 1;
+        reasonTb = my_calloc(numReasonTb, sizeof(int), fname);
+        jReasonTb = my_calloc(numReasonTb, sizeof(int), fname);
+        if (reasonTb == NULL || jReasonTb == NULL) {
+            ls_syslog(LOG_ERR, I18N_FUNC_FAIL, fname, "calloc");
+            mbdDie(MASTER_FATAL);
+        }
     }
 
     jobInfoReply.jobId = jobData->jobId;
@@ -501,6 +598,8 @@ packJobInfo(struct jData * jobData,
             pkQReasonTb = jobData->qPtr->reasonTb[0];
             pkUReasonTb = jobData->uPtr->reasonTb[0];
 
+            memset(jReasonTb, 0, numReasonTb * sizeof(int));
+
             for (i = 0; i < job_numReasons; i++) {
 
                 if (job_reasonTb[i]) {
@@ -573,10 +672,12 @@ packJobInfo(struct jData * jobData,
     }
 
     jobInfoReply.nIdx = allLsInfo->numIndx;
-    if (!loadSched) {
-
-        loadSched = calloc(allLsInfo->numIndx, sizeof(float *));
-        loadStop = calloc(allLsInfo->numIndx, sizeof(float *));
+    if (numLoad < allLsInfo->numIndx) {
+        FREEUP(loadSched);
+        FREEUP(loadStop);
+        numLoad = allLsInfo->numIndx;
+        loadSched = calloc(numLoad, sizeof(float));
+        loadStop = calloc(numLoad, sizeof(float));
 
         if ((!loadSched) || (!loadStop)) {
             ls_syslog(LOG_ERR, I18N_FUNC_FAIL, fname, "malloc");
@@ -584,7 +685,13 @@ packJobInfo(struct jData * jobData,
         }
     }
 
-    if ((jobData->numHostPtr > 0) && (jobData->hPtr[0] != NULL)) {
+    if (options & JOB_BRIEF_INFO) {
+        /* No thresholds in brief replies.
+         */
+        jobInfoReply.nIdx = 0;
+        jobInfoReply.loadSched = loadSched;
+        jobInfoReply.loadStop = loadStop;
+    } else if ((jobData->numHostPtr > 0) && (jobData->hPtr[0] != NULL)) {
         jobInfoReply.loadSched = loadSched;
         jobInfoReply.loadStop = loadStop;
 
@@ -620,6 +727,12 @@ packJobInfo(struct jData * jobData,
     jobInfoReply.jobPriority = jobData->jobPriority;
 
     jobInfoReply.jobBill = &jobBill;
+    if (options & JOB_BRIEF_INFO) {
+        fullJobName_r(jobData, fullName);
+        briefJobBill(jobData, jobInfoReply.jobBill, fullName);
+        goto encode;
+    }
+
     copyJobBill (&jobData->shared->jobBill, jobInfoReply.jobBill, FALSE);
     if (jobInfoReply.jobBill->options2 & SUB2_USE_DEF_PROCLIMIT) {
 
@@ -673,6 +786,7 @@ packJobInfo(struct jData * jobData,
             jobInfoReply.jobBill->rLimits[LSF_RLIMIT_RUN] /= *cpuFactor;
     }
 
+encode:
     jgNode = jobData->jgrpNode;
     jobInfoReply.jType    = jobData->nodeType;
     jobInfoReply.parentGroup = jgrpNodeParentPath(jgNode);
@@ -687,12 +801,20 @@ packJobInfo(struct jData * jobData,
 
     memcpy(&jobInfoReply.runRusage,
            &jobData->runRusage, sizeof(struct jRusage));
+    if (options & JOB_BRIEF_INFO) {
+        jobInfoReply.runRusage.npids = 0;
+        jobInfoReply.runRusage.pidInfo = NULL;
+        jobInfoReply.runRusage.npgids = 0;
+        jobInfoReply.runRusage.pgid = NULL;
+    }
 
     len = jobInfoReplyXdrBufLen(&jobInfoReply);
     len += 1024;
 
-    FREEUP (request_buf);
-    request_buf = my_malloc(len, "packJobInfo");
+    if ((request_buf = jobInfoBufGet(len)) == NULL) {
+        freeJobInfoReply (&jobInfoReply, options);
+        return -1;
+    }
     xdrmem_create(&xdrs, request_buf, len, XDR_ENCODE);
     hdr.reserved = remain;
     hdr.version = version;
@@ -702,26 +824,73 @@ packJobInfo(struct jData * jobData,
         ls_syslog(LOG_ERR, I18N_FUNC_S_FAIL, fname,
                   "xdr_encodeMsg", "jobInfoReply");
         xdr_destroy(&xdrs);
-        freeJobInfoReply (&jobInfoReply);
-        FREEUP(reasonTb);
-        FREEUP(jReasonTb);
-        FREEUP(loadSched);
-        FREEUP(loadStop);
-        FREEUP (request_buf);
+        freeJobInfoReply (&jobInfoReply, options);
         return -1;
     }
-    FREEUP(reasonTb);
-    FREEUP(jReasonTb);
-    FREEUP(loadSched);
-    FREEUP(loadStop);
-    freeJobInfoReply (&jobInfoReply);
+    freeJobInfoReply (&jobInfoReply, options);
     i = XDR_GETPOS(&xdrs);
-    *replyBuf = request_buf;
+    jobInfoBuf.len += i;
     xdr_destroy(&xdrs);
     return (i);
 
 }
 
+/* briefJobBill()
+ * The submission parameters of a JOB_BRIEF_INFO
+ * reply, only what the short bjobs formats print.
+ * The strings point into the job and are not freed.
+ */
+static void
+briefJobBill(struct jData *jobData,
+             struct submitReq *jobBill,
+             char *fullName)
+{
+    struct submitReq *sub;
+    int i;
+
+    sub = &jobData->shared->jobBill;
+
+    memset(jobBill, 0, sizeof(struct submitReq));
+    jobBill->options = sub->options;
+    jobBill->options2 = sub->options2;
+    jobBill->numProcessors = sub->numProcessors;
+    jobBill->maxNumProcessors = sub->maxNumProcessors;
+    jobBill->submitTime = sub->submitTime;
+    jobBill->beginTime = sub->beginTime;
+    jobBill->termTime = sub->termTime;
+    jobBill->userPriority = sub->userPriority;
+    if (jobBill->options2 & SUB2_USE_DEF_PROCLIMIT) {
+        jobBill->numProcessors = 1;
+        jobBill->maxNumProcessors = 1;
+    }
+    for (i = 0; i < LSF_RLIM_NLIMITS; i++)
+        jobBill->rLimits[i] = DEFAULT_RLIMIT;
+
+    jobBill->jobName = fullName;
+    jobBill->queue = jobData->qPtr->queue;
+    jobBill->fromHost = sub->fromHost;
+    jobBill->projectName = sub->projectName ? sub->projectName : "";
+
+    jobBill->resReq = "";
+    jobBill->hostSpec = "";
+    jobBill->dependCond = "";
+    jobBill->subHomeDir = "";
+    jobBill->inFile = "";
+    jobBill->outFile = "";
+    jobBill->errFile = "";
+    jobBill->command = "";
+    jobBill->inFileSpool = "";
+    jobBill->commandSpool = "";
+    jobBill->chkpntDir = "";
+    jobBill->jobFile = "";
+    jobBill->cwd = "";
+    jobBill->preExecCmd = "";
+    jobBill->mailUser = "";
+    jobBill->loginShell = "";
+    jobBill->schedHostType = "";
+    jobBill->userGroup = "";
+}
+
 int
 do_jobPeekReq (XDR *xdrs, int chfd, struct sockaddr_in *from, char *hostName,
                struct LSFHeader *reqHdr, struct lsfAuth *auth)
@@ -1131,6 +1300,114 @@ do_chunkStatusReq(XDR * xdrs, int chfd, struct sockaddr_in * from,
 }
 
 
+/* do_statusBatchReq()
+ * The status and rusage of all the jobs that changed on
+ * a host in one request. The jobs are processed in one
+ * pass, their events committed with one write, and the
+ * reply carries the code of every job in request order.
+ */
+int
+do_statusBatchReq(XDR *xdrs, int chfd, struct sockaddr_in *from,
+                  int *schedule, struct LSFHeader *reqHdr)
+{
+    struct statusBatchReq req;
+    struct statusBatchReply reply;
+    struct LSFHeader replyHdr;
+    struct hostent *hp;
+    struct hData *hData;
+    char *reply_buf;
+    XDR xdrs2;
+    int len;
+    int cc;
+    int i;
+
+    if (!portok(from)) {
+        ls_syslog(LOG_ERR, "\
+%s: Received status report from bad port %s",
+                  __func__, sockAdd2Str_(from));
+        errorBack(chfd, LSBE_PORT, from);
+        return -1;
+    }
+
+    hp = Gethostbyaddr_(&from->sin_addr.s_addr,
+                        sizeof(in_addr_t),
+                        AF_INET);
+    if (hp == NULL) {
+        ls_syslog(LOG_ERR, "\
+%s: gethostbyaddr() failed %s", __func__,
+                  sockAdd2Str_(from));
+        errorBack(chfd, LSBE_BAD_HOST, from);
+        return -1;
+    }
+
+    if (!xdr_statusBatchReq(xdrs, &req, reqHdr)) {
+        ls_syslog(LOG_ERR, I18N_FUNC_FAIL, __func__, "xdr_statusBatchReq");
+        errorBack(chfd, LSBE_XDR, from);
+        return -1;
+    }
+
+    reply.numReplies = req.numStatusReqs;
+    reply.replies = my_calloc(req.numStatusReqs + 1, sizeof(int), __func__);
+
+    elogHold();
+
+    for (i = 0; i < req.numStatusReqs; i++) {
+        switch (req.reqTypes[i]) {
+            case BATCH_STATUS_JOB:
+                reply.replies[i] = statusJob(&req.statusReqs[i], hp, schedule);
+                break;
+            case BATCH_RUSAGE_JOB:
+                reply.replies[i] = rusageJob(&req.statusReqs[i], hp);
+                break;
+            default:
+                reply.replies[i] = LSBE_PROTOCOL;
+                break;
+        }
+    }
+
+    if (elogRelease() < 0) {
+        ls_syslog(LOG_ERR, I18N_FUNC_FAIL, __func__, "elogRelease");
+        mbdDie(MASTER_FATAL);
+    }
+
+    if (logclass & LC_COMM)
+        ls_syslog(LOG_DEBUG, "%s: %d jobs from host %s", __func__,
+                  req.numStatusReqs, hp->h_name);
+
+    xdr_lsffree(xdr_statusBatchReq, (char *)&req, reqHdr);
+
+    len = sizeof(struct LSFHeader) + sizeof(int) * reply.numReplies + 100;
+    reply_buf = my_malloc(len, __func__);
+    xdrmem_create(&xdrs2, reply_buf, len, XDR_ENCODE);
+    initLSFHeader_(&replyHdr);
+    replyHdr.opCode = LSBE_NO_ERROR;
+
+    if (!xdr_encodeMsg(&xdrs2, (char *)&reply, &replyHdr,
+                       xdr_statusBatchReply, 0, NULL)) {
+        ls_syslog(LOG_ERR, I18N_FUNC_FAIL, __func__, "xdr_encodeMsg");
+        xdr_destroy(&xdrs2);
+        FREEUP(reply_buf);
+        FREEUP(reply.replies);
+        return -1;
+    }
+
+    cc = chanWrite_(chfd, reply_buf, XDR_GETPOS(&xdrs2));
+    xdr_destroy(&xdrs2);
+    FREEUP(reply_buf);
+    FREEUP(reply.replies);
+
+    if (cc <= 0) {
+        ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, __func__, "chanWrite_");
+        return -1;
+    }
+
+    if ((hData = getHostData(hp->h_name)) != NULL)
+        hStatChange(hData, 0);
+
+    return 0;
+}
+
+
 int
 do_restartReq(XDR * xdrs, int chfd, struct sockaddr_in * from,
               struct LSFHeader * reqHdr)
@@ -2002,7 +2279,7 @@ doNewJobReply(struct sbdNode *sbdPtr, int exception)
     if (jData->jobPid != 0)
         return;
 
-    if (exception == TRUE || chanRecv_(sbdPtr->chanfd, &buf) < 0) {
+    if (exception == TRUE || sbdRecv(sbdPtr, &buf) < 0) {
         if (exception == TRUE)
             ls_syslog(LOG_ERR, _i18n_msg_get(ls_catd , NL_SETN, 7887,
                                              "%s: Exception bit of <%d> is set for job <%s>"), /* catgets 7887 */
@@ -2075,7 +2352,10 @@ doNewJobReply(struct sbdNode *sbdPtr, int exception)
 
         log_startjobaccept(jData);
 
-        if (daemonParams[LSB_MBD_BLOCK_SEND].paramValue == NULL) {
+        if (sbdPtr->tag != 0) {
+            if (sbdGoAhead(sbdPtr, MBD_NEW_JOB_GO) == 0)
+                sbdPtr->reqCode = MBD_NEW_JOB_KEEP_CHAN;
+        } else if (daemonParams[LSB_MBD_BLOCK_SEND].paramValue == NULL) {
             struct Buffer *replyBuf;
 
             if (chanAllocBuf_(&replyBuf, sizeof(struct LSFHeader)) < 0) {
@@ -2129,7 +2409,7 @@ doProbeReply(struct sbdNode *sbdPtr, int exception)
         ls_syslog(LOG_DEBUG, "%s: Entering ...", __func__);
 
     if (exception == TRUE
-        || chanRecv_(sbdPtr->chanfd, &buf) < 0) {
+        || sbdRecv(sbdPtr, &buf) < 0) {
 
         if (exception == TRUE)
             ls_syslog(LOG_ERR, "\
@@ -2189,7 +2469,7 @@ doSwitchJobReply(struct sbdNode *sbdPtr, int exception)
 
         return;
 
-    if (exception == TRUE || chanRecv_(sbdPtr->chanfd, &buf) < 0) {
+    if (exception == TRUE || sbdRecv(sbdPtr, &buf) < 0) {
         if (exception == TRUE)
             ls_syslog(LOG_ERR, _i18n_msg_get(ls_catd , NL_SETN, 7898,
                                              "%s: Exception bit of <%d> is set for job <%s>"), /* catgets 7898 */
@@ -2293,7 +2573,7 @@ doSignalJobReply(struct sbdNode *sbdPtr, int exception)
         return;
     }
 
-    if (exception == TRUE || chanRecv_(sbdPtr->chanfd, &buf) < 0) {
+    if (exception == TRUE || sbdRecv(sbdPtr, &buf) < 0) {
         if (exception == TRUE)
             ls_syslog(LOG_ERR, _i18n_msg_get(ls_catd , NL_SETN, 7905,
                                              "%s: Exception bit of <%d> is set for job <%s>"), /* catgets 7905 */
@@ -2700,15 +2980,15 @@ freeJobHead (struct jobInfoHead *jobInfoHead)
 }
 
 static void
-freeJobInfoReply (struct jobInfoReply *job)
+freeJobInfoReply (struct jobInfoReply *job, int options)
 {
     int i;
 
     if (job == NULL)
         return;
 
-
-    freeSubmitReq (job->jobBill);
+    if (!(options & JOB_BRIEF_INFO))
+        freeSubmitReq (job->jobBill);
     if (job->numToHosts > 0) {
         for (i = 0; i < job->numToHosts; i++)
             FREEUP(job->toHosts[i]);
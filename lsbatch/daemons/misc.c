@@ -686,8 +686,9 @@ checkResumeByLoad (LS_LONG_INT jobId, int num, struct thresholds thresholds,
 
 
         if (resumeCondVal != NULL) {
-            if (evalResReq (resumeCondVal->selectStr,
-                                    &tclHostData[j], DFT_FROMTYPE) == 1) {
+            if (evalSelectCode(resumeCondVal->selectCode,
+                               resumeCondVal->selectStr,
+                               &tclHostData[j], DFT_FROMTYPE) == 1) {
                 resume = TRUE;
                 break;
             } else {
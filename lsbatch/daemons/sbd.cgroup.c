@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+
+#include <sys/stat.h>
+#include "sbd.h"
+
+/* Job tracking with cgroup v2. With LSB_JOB_CGROUP set to
+ * a directory of the cgroup v2 hierarchy every job runs in
+ * its own cgroup job.<jobid> below it. The processes of the
+ * job are then the ones in its cgroup.procs whatever process
+ * group or session they moved to, and the cpu and memory
+ * usage come from the cgroup stat files, so the cost is in
+ * the number of job processes not in the number of host
+ * processes pim scans. A job started without a cgroup, or
+ * on a host where the cgroup cannot be used, is tracked by
+ * pim and its process groups as before.
+ */
+
+static char *cgroupDir;
+
+static char *cgroupPath(struct jobCard *, const char *);
+static int readCgroupFile(const char *, char *, int);
+static int writeCgroupFile(const char *, const char *);
+static int readCgroupProcs(struct jobCard *, int **);
+static int procStat(int, int *, int *, unsigned long *, long *);
+
+/* cgroupInit()
+ * Create the parent cgroup and give the job cgroups the
+ * memory and io controllers.
+ */
+void
+cgroupInit(void)
+{
+    char path[MAXFILENAMELEN];
+    char *dir;
+
+    dir = daemonParams[LSB_JOB_CGROUP].paramValue;
+    if (dir == NULL || dir[0] == 0)
+        return;
+
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        ls_syslog(LOG_ERR, "\
+%s: mkdir(%s) failed %m, jobs will not run in a cgroup", __func__, dir);
+        return;
+    }
+
+    sprintf(path, "%s/cgroup.procs", dir);
+    if (access(path, R_OK) < 0) {
+        ls_syslog(LOG_ERR, "\
+%s: %s is not a cgroup v2 directory, jobs will not run in a cgroup",
+                  __func__, dir);
+        return;
+    }
+
+    /* Without the memory controller the memory
+     * is summed from the processes.
+     */
+    sprintf(path, "%s/cgroup.subtree_control", dir);
+    if (writeCgroupFile(path, "+memory") < 0)
+        ls_syslog(LOG_WARNING, "\
+%s: cannot enable the memory controller in %s %m", __func__, dir);
+    if (writeCgroupFile(path, "+io") < 0)
+        ls_syslog(LOG_WARNING, "\
+%s: cannot enable the io controller in %s %m", __func__, dir);
+
+    cgroupDir = dir;
+
+    ls_syslog(LOG_INFO, "%s: jobs run in cgroups under %s", __func__, dir);
+}
+
+/* cgroupAttach()
+ * Move the calling job process into the job cgroup,
+ * called by the job child before it gives up root.
+ */
+int
+cgroupAttach(struct jobCard *jp)
+{
+    char path[MAXFILENAMELEN];
+
+    if (cgroupDir == NULL)
+        return 0;
+
+    strcpy(path, cgroupPath(jp, NULL));
+    if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+        ls_syslog(LOG_ERR, "\
+%s: mkdir(%s) failed for job %s %m", __func__, path,
+                  lsb_jobid2str(jp->jobSpecs.jobId));
+        return -1;
+    }
+
+    if (writeCgroupFile(cgroupPath(jp, "cgroup.procs"), "0") < 0) {
+        ls_syslog(LOG_ERR, "\
+%s: cannot move job %s into cgroup %s %m", __func__,
+                  lsb_jobid2str(jp->jobSpecs.jobId), path);
+        rmdir(path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* cgroupRemove()
+ * Remove the cgroup of a job that is gone, the kernel
+ * refuses as long as some process is left in it.
+ */
+void
+cgroupRemove(struct jobCard *jp)
+{
+    char *path;
+
+    if (cgroupDir == NULL)
+        return;
+
+    path = cgroupPath(jp, NULL);
+    if (rmdir(path) < 0 && errno != ENOENT) {
+        ls_syslog(LOG_DEBUG, "\
+%s: rmdir(%s) failed for job %s %m", __func__, path,
+                  lsb_jobid2str(jp->jobSpecs.jobId));
+    }
+}
+
+/* cgroupRusage()
+ * The usage of the job read from its cgroup. Returns NULL
+ * if the job has no cgroup or no process left in it, the
+ * caller then asks pim.
+ */
+struct jRusage *
+cgroupRusage(struct jobCard *jp)
+{
+    static struct jRusage jru;
+    static int maxPids;
+    char buf[MSGSIZE];
+    unsigned long vsize;
+    long long usec;
+    long long bytes;
+    long rss;
+    int *pids;
+    int npids;
+    int ppid;
+    int pgid;
+    char *p;
+    int i;
+    int j;
+
+    if (cgroupDir == NULL)
+        return NULL;
+
+    if ((npids = readCgroupProcs(jp, &pids)) <= 0)
+        return NULL;
+
+    if (npids > maxPids) {
+        FREEUP(jru.pidInfo);
+        FREEUP(jru.pgid);
+        maxPids = 0;
+        jru.pidInfo = calloc(npids, sizeof(struct pidInfo));
+        jru.pgid = calloc(npids, sizeof(int));
+        if (jru.pidInfo == NULL || jru.pgid == NULL) {
+            ls_syslog(LOG_ERR, "%s: calloc() failed %m", __func__);
+            FREEUP(jru.pidInfo);
+            FREEUP(jru.pgid);
+            return NULL;
+        }
+        maxPids = npids;
+    }
+
+    jru.mem = 0;
+    jru.swap = 0;
+    jru.utime = 0;
+    jru.stime = 0;
+    jru.npids = 0;
+    jru.npgids = 0;
+
+    for (i = 0; i < npids; i++) {
+
+        if (procStat(pids[i], &ppid, &pgid, &vsize, &rss) < 0)
+            continue;
+
+        jru.pidInfo[jru.npids].pid = pids[i];
+        jru.pidInfo[jru.npids].ppid = ppid;
+        jru.pidInfo[jru.npids].pgid = pgid;
+        jru.pidInfo[jru.npids].jobid = 0;
+        jru.npids++;
+
+        jru.swap += vsize / 1024;
+        jru.mem += rss * (sysconf(_SC_PAGESIZE) / 1024);
+
+        for (j = 0; j < jru.npgids; j++) {
+            if (jru.pgid[j] == pgid)
+                break;
+        }
+        if (j == jru.npgids)
+            jru.pgid[jru.npgids++] = pgid;
+    }
+
+    if (jru.npids == 0)
+        return NULL;
+
+    /* The cgroup counts the processes that
+     * already exited as well.
+     */
+    if (readCgroupFile(cgroupPath(jp, "cpu.stat"), buf, sizeof(buf)) > 0) {
+        if ((p = strstr(buf, "user_usec")) != NULL
+            && sscanf(p, "user_usec %lld", &usec) == 1)
+            jru.utime = usec / 1000000;
+        if ((p = strstr(buf, "system_usec")) != NULL
+            && sscanf(p, "system_usec %lld", &usec) == 1)
+            jru.stime = usec / 1000000;
+    }
+
+    if (readCgroupFile(cgroupPath(jp, "memory.current"), buf, sizeof(buf)) > 0
+        && sscanf(buf, "%lld", &bytes) == 1)
+        jru.mem = bytes / 1024;
+
+    if (logclass & (LC_SIGNAL | LC_EXEC)) {
+        ls_syslog(LOG_DEBUG, "\
+%s: job %s npids %d npgids %d mem %d swap %d utime %d stime %d",
+                  __func__, lsb_jobid2str(jp->jobSpecs.jobId), jru.npids,
+                  jru.npgids, jru.mem, jru.swap, jru.utime, jru.stime);
+        if (readCgroupFile(cgroupPath(jp, "io.stat"),
+                           buf, sizeof(buf)) > 0)
+            ls_syslog(LOG_DEBUG, "%s: job %s io.stat %s", __func__,
+                      lsb_jobid2str(jp->jobSpecs.jobId), buf);
+    }
+
+    return &jru;
+}
+
+/* cgroupKill()
+ * Send sig to all the processes in the job cgroup.
+ * Returns the number of processes signaled, 0 if
+ * none is left and -1 if the job has no cgroup.
+ */
+int
+cgroupKill(struct jobCard *jp, int sig)
+{
+    int *pids;
+    int npids;
+    int n;
+    int i;
+
+    if (cgroupDir == NULL)
+        return -1;
+
+    if ((npids = readCgroupProcs(jp, &pids)) < 0)
+        return -1;
+
+    if (npids == 0)
+        return 0;
+
+    /* Kill them all at once, even if they
+     * are forking, when the kernel knows how.
+     */
+    if (sig == SIGKILL
+        && writeCgroupFile(cgroupPath(jp, "cgroup.kill"), "1") == 0)
+        return npids;
+
+    n = 0;
+    for (i = 0; i < npids; i++) {
+        if (kill(pids[i], sig) == 0)
+            n++;
+    }
+
+    if (logclass & LC_SIGNAL)
+        ls_syslog(LOG_DEBUG, "\
+%s: job %s signal %d sent to %d of %d processes", __func__,
+                  lsb_jobid2str(jp->jobSpecs.jobId), sig, n, npids);
+
+    return n;
+}
+
+static char *
+cgroupPath(struct jobCard *jp, const char *file)
+{
+    static char path[MAXFILENAMELEN];
+
+    if (file == NULL)
+        sprintf(path, "%s/job.%s", cgroupDir,
+                lsb_jobidinstr(jp->jobSpecs.jobId));
+    else
+        sprintf(path, "%s/job.%s/%s", cgroupDir,
+                lsb_jobidinstr(jp->jobSpecs.jobId), file);
+
+    return path;
+}
+
+/* readCgroupProcs()
+ * The pids in the job cgroup.procs, in a buffer
+ * reused by the next call. Returns -1 if the
+ * job has no cgroup.
+ */
+static int
+readCgroupProcs(struct jobCard *jp, int **pids)
+{
+    static int *buf;
+    static int size;
+    FILE *fp;
+    int *p;
+    int pid;
+    int n;
+
+    if ((fp = fopen(cgroupPath(jp, "cgroup.procs"), "r")) == NULL)
+        return -1;
+
+    n = 0;
+    while (fscanf(fp, "%d", &pid) == 1) {
+        if (n == size) {
+            p = realloc(buf, (size + 64) * sizeof(int));
+            if (p == NULL) {
+                ls_syslog(LOG_ERR, "%s: realloc() failed %m", __func__);
+                break;
+            }
+            buf = p;
+            size += 64;
+        }
+        buf[n++] = pid;
+    }
+    fclose(fp);
+
+    *pids = buf;
+    return n;
+}
+
+/* procStat()
+ * Parent, process group and sizes of one process from
+ * its /proc stat, the command may contain blanks and
+ * parenthesis so the fields start after the last ')'.
+ */
+static int
+procStat(int pid, int *ppid, int *pgid, unsigned long *vsize, long *rss)
+{
+    char path[64];
+    char buf[1024];
+    char state;
+    char *p;
+
+    sprintf(path, "/proc/%d/stat", pid);
+    if (readCgroupFile(path, buf, sizeof(buf)) <= 0)
+        return -1;
+
+    if ((p = strrchr(buf, ')')) == NULL)
+        return -1;
+
+    if (sscanf(p + 2, "\
+%c %d %d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d \
+%*u %lu %ld", &state, ppid, pgid, vsize, rss) != 5)
+        return -1;
+
+    if (state == 'Z')
+        *vsize = *rss = 0;
+
+    return 0;
+}
+
+static int
+readCgroupFile(const char *path, char *buf, int size)
+{
+    int fd;
+    int cc;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+
+    cc = read(fd, buf, size - 1);
+    close(fd);
+    if (cc < 0)
+        return -1;
+    buf[cc] = 0;
+
+    return cc;
+}
+
+static int
+writeCgroupFile(const char *path, const char *val)
+{
+    int fd;
+    int cc;
+
+    if ((fd = open(path, O_WRONLY)) < 0)
+        return -1;
+
+    cc = write(fd, val, strlen(val));
+    close(fd);
+    if (cc < 0)
+        return -1;
+
+    return 0;
+}
@@ -31,6 +31,12 @@ static int msgSbd(LS_LONG_INT, char *, sbdReqType, int (*)());
 extern int jRusageUpdatePeriod;
 
 #define NL_SETN     11
+
+static void initStatusReq(struct statusReq *, struct jobCard *, int,
+                          sbdReplyType);
+static int statusReqLen(struct statusReq *);
+static int statusReply(struct jobCard *, int);
+
 int
 status_job(mbdReqType reqType,
            struct jobCard *jp,
@@ -38,9 +44,7 @@ status_job(mbdReqType reqType,
            sbdReplyType err)
 {
     static char        fname[] = "status_job()";
-    static int         seq = 1;
     static char        lastHost[MAXHOSTNAMELEN];
-    int                reply;
     char               *request_buf;
     char               *reply_buf = NULL;
     XDR                xdrs;
@@ -48,7 +52,6 @@ status_job(mbdReqType reqType,
     int                cc;
     struct statusReq   statusReq;
     int                flags;
-    int                i;
     int                len;
     struct lsfAuth     *auth = NULL;
 
@@ -78,63 +81,9 @@ status_job(mbdReqType reqType,
         return (0);
     }
 
-    statusReq.jobId = jp->jobSpecs.jobId;
-    statusReq.actPid = jp->jobSpecs.actPid;
-    statusReq.jobPid = jp->jobSpecs.jobPid;
-    statusReq.jobPGid = jp->jobSpecs.jobPGid;
-    statusReq.newStatus = newStatus;
-    statusReq.reason = jp->jobSpecs.reasons;
-    statusReq.subreasons = jp->jobSpecs.subreasons;
-    statusReq.sbdReply = err;
-    statusReq.lsfRusage = jp->lsfRusage;
-    statusReq.execUid = jp->jobSpecs.execUid;
-    statusReq.numExecHosts = 0;
-    statusReq.execHosts = NULL;
-    statusReq.exitStatus = jp->w_status;
-    statusReq.execCwd=jp->jobSpecs.execCwd;
-    statusReq.execHome=jp->jobSpecs.execHome;
-    statusReq.execUsername = jp->execUsername;
-    statusReq.queuePostCmd = "";
-    statusReq.queuePreCmd = "";
-    statusReq.msgId = jp->delieveredMsgId;
+    initStatusReq(&statusReq, jp, newStatus, err);
 
-    if ( IS_FINISH(newStatus) ) {
-        if (jp->maxRusage.mem > jp->runRusage.mem)
-            jp->runRusage.mem = jp->maxRusage.mem;
-        if (jp->maxRusage.swap > jp->runRusage.swap)
-            jp->runRusage.swap = jp->maxRusage.swap;
-        if (jp->maxRusage.stime > jp->runRusage.stime)
-            jp->runRusage.stime = jp->maxRusage.stime;
-        if (jp->maxRusage.utime > jp->runRusage.utime)
-            jp->runRusage.utime = jp->maxRusage.utime;
-    }
-    statusReq.runRusage.mem = jp->runRusage.mem;
-    statusReq.runRusage.swap = jp->runRusage.swap;
-    statusReq.runRusage.utime = jp->runRusage.utime;
-    statusReq.runRusage.stime = jp->runRusage.stime;
-    statusReq.runRusage.npids = jp->runRusage.npids;
-    statusReq.runRusage.pidInfo = jp->runRusage.pidInfo;
-    statusReq.runRusage.npgids = jp->runRusage.npgids;
-    statusReq.runRusage.pgid = jp->runRusage.pgid;
-    statusReq.actStatus = jp->actStatus;
-    statusReq.sigValue  = jp->jobSpecs.actValue;
-    statusReq.seq = seq;
-    seq++;
-    if (seq >= MAX_SEQ_NUM)
-        seq = 1;
-
-    len = 1024 +
-        ALIGNWORD_(sizeof (struct statusReq));
-
-    len += ALIGNWORD_(strlen (statusReq.execHome)) + 4 +
-        ALIGNWORD_(strlen (statusReq.execCwd)) + 4 +
-        ALIGNWORD_(strlen (statusReq.execUsername)) + 4;
-
-    for (i = 0; i < statusReq.runRusage.npids; i++)
-        len += ALIGNWORD_(sizeof (struct pidInfo)) + 4;
-
-    for (i = 0; i < statusReq.runRusage.npgids; i++)
-        len += ALIGNWORD_(sizeof (int)) + 4;
+    len = statusReqLen(&statusReq);
 
     if (logclass & (LC_TRACE | LC_COMM))
         ls_syslog(LOG_DEBUG, "%s: The length of the job message is: <%d>", fname, len);
@@ -222,7 +171,256 @@ status_job(mbdReqType reqType,
             ls_syslog(LOG_DEBUG1, "%s: Job <%s> rd_select() failed, assume connection broken", fname, lsb_jobid2str(jp->jobSpecs.jobId));
         return(-1);
     }
-    reply = hdr.opCode;
+
+    return statusReply(jp, hdr.opCode);
+}
+
+/* status_jobs()
+ * Report the status or the rusage of njobs jobs, reqTypes[i]
+ * being BATCH_STATUS_JOB or BATCH_RUSAGE_JOB for jobs[i], in
+ * one BATCH_STATUS_BATCH request on statusChan, the channel
+ * kept open to mbatchd. The code mbatchd replies for every
+ * job is handled like status_job() does and the result
+ * stored in reps[i]. An mbatchd that does not know the
+ * request gets the jobs one by one with status_job(), it
+ * is asked again when the channel to it is opened again
+ * or every OLD_MBD_RETRY seconds, it may have been upgraded.
+ * Returns -1, and all reps[i] -1, if mbatchd could not
+ * be reached.
+ */
+#define OLD_MBD_RETRY  600
+
+int
+status_jobs(struct jobCard **jobs, int *reqTypes, int njobs, int *reps)
+{
+    static char lastHost[MAXHOSTNAMELEN];
+    static char oldMbdHost[MAXHOSTNAMELEN];
+    static time_t oldMbdTime;
+    struct statusBatchReq req;
+    struct statusBatchReply reply;
+    struct LSFHeader hdr;
+    char *request_buf;
+    char *reply_buf;
+    XDR xdrs;
+    int flags;
+    int len;
+    int cc;
+    int i;
+
+    for (i = 0; i < njobs; i++)
+        reps[i] = -1;
+
+    if (masterHost == NULL)
+        return -1;
+
+    if (equalHost_(masterHost, oldMbdHost)
+        && statusChan >= 0
+        && now - oldMbdTime < OLD_MBD_RETRY)
+        goto onebyone;
+    oldMbdHost[0] = 0;
+
+    req.numStatusReqs = njobs;
+    req.reqTypes = reqTypes;
+    req.statusReqs = my_calloc(njobs, sizeof(struct statusReq), __func__);
+
+    len = 1024;
+    for (i = 0; i < njobs; i++) {
+        initStatusReq(&req.statusReqs[i], jobs[i],
+                      jobs[i]->jobSpecs.jStatus, ERR_NO_ERROR);
+        len += statusReqLen(&req.statusReqs[i]) + sizeof(int);
+    }
+
+    request_buf = my_malloc(len, __func__);
+    xdrmem_create(&xdrs, request_buf, len, XDR_ENCODE);
+    initLSFHeader_(&hdr);
+    hdr.opCode = BATCH_STATUS_BATCH;
+
+    if (!xdr_encodeMsg(&xdrs, (char *)&req, &hdr, xdr_statusBatchReq, 0,
+                       NULL)) {
+        ls_syslog(LOG_ERR, I18N_FUNC_FAIL, __func__, "xdr_statusBatchReq");
+        lsb_merr2(I18N_FUNC_FAIL, __func__, "xdr_statusBatchReq");
+        xdr_destroy(&xdrs);
+        FREEUP(request_buf);
+        relife();
+    }
+    FREEUP(req.statusReqs);
+
+    flags = CALL_SERVER_NO_HANDSHAKE;
+    if (statusChan >= 0)
+        flags |= CALL_SERVER_USE_SOCKET;
+
+    if (logclass & LC_COMM)
+        ls_syslog(LOG_DEBUG1, "\
+%s: %d jobs message length %d statusChan=%d flags=%d",
+                  __func__, njobs, XDR_GETPOS(&xdrs), statusChan, flags);
+
+    reply_buf = NULL;
+    cc = call_server(masterHost,
+                     mbd_port,
+                     request_buf,
+                     XDR_GETPOS(&xdrs),
+                     &reply_buf,
+                     &hdr,
+                     connTimeout,
+                     readTimeout,
+                     &statusChan,
+                     NULL,
+                     NULL,
+                     flags);
+    xdr_destroy(&xdrs);
+    FREEUP(request_buf);
+
+    if (cc < 0) {
+        statusChan = -1;
+        if (!equalHost_(masterHost, lastHost)) {
+            if (errno != EINTR)
+                ls_syslog(LOG_DEBUG, "\
+%s: Failed to reach mbatchd on host <%s>: %s", __func__,
+                          masterHost, lsb_sysmsg());
+            strcpy(lastHost, masterHost);
+        }
+        failcnt++;
+        return -1;
+    }
+
+    failcnt = 0;
+    lastHost[0] = 0;
+
+    if (hdr.opCode == LSBE_PROTOCOL) {
+        ls_syslog(LOG_INFO, "\
+%s: mbatchd on host <%s> does not take batched status, reporting jobs one by one",
+                  __func__, masterHost);
+        strcpy(oldMbdHost, masterHost);
+        oldMbdTime = now;
+        CLOSECD(statusChan);
+        FREEUP(reply_buf);
+        goto onebyone;
+    }
+
+    if (hdr.opCode != LSBE_NO_ERROR) {
+        ls_syslog(LOG_ERR, I18N(5221,
+                                "%s: Illegal reply code <%d> from mbatchd on host <%s>"), /* catgets 5221 */
+                  __func__, hdr.opCode, masterHost);
+        CLOSECD(statusChan);
+        FREEUP(reply_buf);
+        return -1;
+    }
+
+    xdrmem_create(&xdrs, reply_buf, XDR_DECODE_SIZE_(hdr.length),
+                  XDR_DECODE);
+    if (!xdr_statusBatchReply(&xdrs, &reply, &hdr)
+        || reply.numReplies != njobs) {
+        ls_syslog(LOG_ERR, I18N_FUNC_FAIL, __func__, "xdr_statusBatchReply");
+        if (reply.numReplies != njobs)
+            xdr_lsffree(xdr_statusBatchReply, (char *)&reply, &hdr);
+        xdr_destroy(&xdrs);
+        CLOSECD(statusChan);
+        FREEUP(reply_buf);
+        return -1;
+    }
+    xdr_destroy(&xdrs);
+    FREEUP(reply_buf);
+
+    for (i = 0; i < njobs; i++)
+        reps[i] = statusReply(jobs[i], reply.replies[i]);
+
+    xdr_lsffree(xdr_statusBatchReply, (char *)&reply, &hdr);
+
+    return 0;
+
+onebyone:
+    for (i = 0; i < njobs; i++)
+        reps[i] = status_job(reqTypes[i], jobs[i],
+                             jobs[i]->jobSpecs.jStatus, ERR_NO_ERROR);
+    return 0;
+}
+
+/* initStatusReq()
+ * The status request of a job, pointing to its strings
+ * and pids.
+ */
+static void
+initStatusReq(struct statusReq *statusReq, struct jobCard *jp,
+              int newStatus, sbdReplyType err)
+{
+    static int seq = 1;
+
+    statusReq->jobId = jp->jobSpecs.jobId;
+    statusReq->actPid = jp->jobSpecs.actPid;
+    statusReq->jobPid = jp->jobSpecs.jobPid;
+    statusReq->jobPGid = jp->jobSpecs.jobPGid;
+    statusReq->newStatus = newStatus;
+    statusReq->reason = jp->jobSpecs.reasons;
+    statusReq->subreasons = jp->jobSpecs.subreasons;
+    statusReq->sbdReply = err;
+    statusReq->lsfRusage = jp->lsfRusage;
+    statusReq->execUid = jp->jobSpecs.execUid;
+    statusReq->numExecHosts = 0;
+    statusReq->execHosts = NULL;
+    statusReq->exitStatus = jp->w_status;
+    statusReq->execCwd=jp->jobSpecs.execCwd;
+    statusReq->execHome=jp->jobSpecs.execHome;
+    statusReq->execUsername = jp->execUsername;
+    statusReq->queuePostCmd = "";
+    statusReq->queuePreCmd = "";
+    statusReq->msgId = jp->delieveredMsgId;
+
+    if ( IS_FINISH(newStatus) ) {
+        if (jp->maxRusage.mem > jp->runRusage.mem)
+            jp->runRusage.mem = jp->maxRusage.mem;
+        if (jp->maxRusage.swap > jp->runRusage.swap)
+            jp->runRusage.swap = jp->maxRusage.swap;
+        if (jp->maxRusage.stime > jp->runRusage.stime)
+            jp->runRusage.stime = jp->maxRusage.stime;
+        if (jp->maxRusage.utime > jp->runRusage.utime)
+            jp->runRusage.utime = jp->maxRusage.utime;
+    }
+    statusReq->runRusage.mem = jp->runRusage.mem;
+    statusReq->runRusage.swap = jp->runRusage.swap;
+    statusReq->runRusage.utime = jp->runRusage.utime;
+    statusReq->runRusage.stime = jp->runRusage.stime;
+    statusReq->runRusage.npids = jp->runRusage.npids;
+    statusReq->runRusage.pidInfo = jp->runRusage.pidInfo;
+    statusReq->runRusage.npgids = jp->runRusage.npgids;
+    statusReq->runRusage.pgid = jp->runRusage.pgid;
+    statusReq->actStatus = jp->actStatus;
+    statusReq->sigValue  = jp->jobSpecs.actValue;
+    statusReq->seq = seq;
+    seq++;
+    if (seq >= MAX_SEQ_NUM)
+        seq = 1;
+}
+
+static int
+statusReqLen(struct statusReq *statusReq)
+{
+    int len;
+    int i;
+
+    len = 1024 +
+        ALIGNWORD_(sizeof (struct statusReq));
+
+    len += ALIGNWORD_(strlen (statusReq->execHome)) + 4 +
+        ALIGNWORD_(strlen (statusReq->execCwd)) + 4 +
+        ALIGNWORD_(strlen (statusReq->execUsername)) + 4;
+
+    for (i = 0; i < statusReq->runRusage.npids; i++)
+        len += ALIGNWORD_(sizeof (struct pidInfo)) + 4;
+
+    for (i = 0; i < statusReq->runRusage.npgids; i++)
+        len += ALIGNWORD_(sizeof (int)) + 4;
+
+    return len;
+}
+
+/* statusReply()
+ * Act on the reply of mbatchd to the status of a job.
+ */
+static int
+statusReply(struct jobCard *jp, int reply)
+{
+    static char fname[] = "status_job()";
+
     switch (reply) {
         case LSBE_NO_ERROR:
         case LSBE_LOCK_JOB:
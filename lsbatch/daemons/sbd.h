@@ -110,6 +110,14 @@ struct jobCard {
     char *spooledExec;
     char   postJobStarted;
     char   userJobSucc;
+    /* A job started on the mbatchd channel waits
+     * for its go-ahead on a pipe, the job file
+     * came in the MBD_NEW_JOB message.
+     */
+    struct lenData jobFile;
+    int    goAheadFd;
+    int    mbdChan;
+    unsigned int mbdTag;
 };
 
 typedef enum {
@@ -138,6 +146,7 @@ struct clientNode {
     int jobType;
     LS_LONG_INT jobId;
     struct jobCard *jp;
+    int mbdChan;
 };
 
 struct jobSetup {
@@ -222,7 +231,11 @@ extern int statusChan;
 extern void start_master(void);
 extern void shutDownClient(struct clientNode *);
 
-extern void do_newjob(XDR *xdrs, int s, struct LSFHeader *);
+extern void do_newjob(XDR *xdrs, int s, struct LSFHeader *,
+                      struct clientNode *);
+extern void do_openChan(XDR *, int, struct LSFHeader *, struct clientNode *);
+extern void do_goAhead(int, struct LSFHeader *);
+extern void closeGoAhead(int);
 extern void do_switchjob(XDR *xdrs, int s, struct LSFHeader *);
 extern void do_sigjob(XDR *xdrs, int s, struct LSFHeader *);
 extern void do_probe(XDR *xdrs, int s, struct LSFHeader *);
@@ -237,6 +250,7 @@ extern void deliverMsg(struct bucket *);
 
 extern void getJobsState(struct sbdPackage *sbdPackage);
 extern int status_job(mbdReqType, struct jobCard *, int, sbdReplyType);
+extern int status_jobs(struct jobCard **, int *, int, int *);
 extern void sbdSyslog(int, char *);
 extern void jobSetupStatus(int, int, struct jobCard *);
 extern int msgSupervisor(struct lsbMsg *, struct clientNode *);
@@ -318,6 +332,11 @@ extern int sizeofJobCard(struct jobCard *);
 extern int jobSigStart (struct jobCard *jp, int sigValue, int actFlags, int actPeriod, logType logFlag);
 extern int jobact (struct jobCard *, int, char *, int, int);
 extern int jobsig(struct jobCard *jobTable, int sig, int forkKill);
+extern void cgroupInit(void);
+extern int cgroupAttach(struct jobCard *);
+extern void cgroupRemove(struct jobCard *);
+extern struct jRusage *cgroupRusage(struct jobCard *);
+extern int cgroupKill(struct jobCard *, int);
 extern int sbdread_jobstatus (struct jobCard *jp);
 extern int sbdCheckUnreportedStatus();
 extern void exeActCmd(struct jobCard *jp, char *actCmd, char *exitFile);
@@ -109,6 +109,26 @@ my_getpwnam(const char *name, char *caller)
     return (pw);
 }
 
+/* closeGoAhead()
+ * Close the go-ahead pipes of the jobs started on the
+ * mbatchd channel chfd, -1 all of them. A job that did
+ * not get its go-ahead reads end of file and aborts.
+ */
+void
+closeGoAhead(int chfd)
+{
+    struct jobCard *jp;
+
+    for (jp = jobQueHead->forw; jp != jobQueHead; jp = jp->forw) {
+        if (jp->goAheadFd < 0)
+            continue;
+        if (chfd >= 0 && jp->mbdChan != chfd)
+            continue;
+        close(jp->goAheadFd);
+        jp->goAheadFd = -1;
+    }
+}
+
 static void
 sbdChildCloseChan(int exceptChan)
 {
@@ -134,6 +154,7 @@ job_exec(struct jobCard *jobCardPtr, int chfd)
 {
     static char fname[] = "job_exec";
     struct jobSpecs *jobSpecsPtr;
+    int goAhead[2];
     int pid;
 
     jobSpecsPtr = &(jobCardPtr->jobSpecs);
@@ -146,21 +167,50 @@ job_exec(struct jobCard *jobCardPtr, int chfd)
     jobSpecsPtr->reasons = 0;
     jobSpecsPtr->subreasons = 0;
 
+    /* A job started on the mbatchd channel, chfd -1,
+     * waits for the go-ahead on a pipe from sbatchd.
+     */
+    goAhead[0] = goAhead[1] = -1;
+    if (chfd < 0
+        && (daemonParams[LSB_BSUBI_OLD].paramValue
+            || !PURE_INTERACTIVE(jobSpecsPtr))) {
+        if (pipe(goAhead) < 0) {
+            ls_syslog(LOG_ERR, I18N_JOB_FAIL_S_M, fname,
+                      lsb_jobid2str(jobSpecsPtr->jobId), "pipe");
+            return ERR_FORK_FAIL;
+        }
+    }
+
     pid = fork();
 
     if (pid < 0) {
         ls_syslog(LOG_ERR, I18N_JOB_FAIL_S_M, fname,
                   lsb_jobid2str(jobSpecsPtr->jobId), "fork");
+        if (goAhead[0] >= 0) {
+            close(goAhead[0]);
+            close(goAhead[1]);
+        }
         return ERR_FORK_FAIL;
     }
 
     if (pid == 0) {
         closeBatchSocket();
         sbdChildCloseChan (chfd);
+        closeGoAhead(-1);
+        if (goAhead[1] >= 0)
+            close(goAhead[1]);
+        jobCardPtr->goAheadFd = goAhead[0];
         execJob(jobCardPtr, chfd);
         exit(-1);
     }
 
+    if (goAhead[0] >= 0) {
+        close(goAhead[0]);
+        fcntl(goAhead[1], F_SETFD, FD_CLOEXEC);
+        jobCardPtr->goAheadFd = goAhead[1];
+    }
+    FREEUP(jobCardPtr->jobFile.data);
+
 
 
     jobSpecsPtr->jobPid = pid;
@@ -296,15 +346,30 @@ execJob(struct jobCard *jobCardPtr, int chfd)
     jobSpecsPtr->jobPGid = jobSpecsPtr->jobPid;
     jobCardPtr->stdinFile = NULL;
 
-    if (rcvJobFile(chfd, &jf) == -1) {
+    if (chfd < 0) {
+        jf = jobCardPtr->jobFile;
+    } else if (rcvJobFile(chfd, &jf) == -1) {
         ls_syslog(LOG_ERR, "\
 %s: failed receiving job file job %s", __func__,
                   lsb_jobid2str(jobSpecsPtr->jobId));
         jobSetupStatus(JOB_STAT_PEND, PEND_JOB_NO_FILE, jobCardPtr);
     }
 
-    if (daemonParams[LSB_BSUBI_OLD].paramValue
-        || !PURE_INTERACTIVE(jobSpecsPtr)) {
+    if (chfd < 0 && jobCardPtr->goAheadFd >= 0) {
+
+        if (read(jobCardPtr->goAheadFd, buf, 1) != 1) {
+            ls_syslog(LOG_WARNING, "\
+%s: Fail to get go-ahead from mbatchd; abort job %s",
+                      fname, lsb_jobid2str(jobSpecsPtr->jobId));
+
+            jobSetupStatus(JOB_STAT_PEND, PEND_JOB_START_FAIL, jobCardPtr);
+        }
+        close(jobCardPtr->goAheadFd);
+        jobCardPtr->goAheadFd = -1;
+
+    } else if (chfd >= 0
+               && (daemonParams[LSB_BSUBI_OLD].paramValue
+                   || !PURE_INTERACTIVE(jobSpecsPtr))) {
 
         xdrmem_create(&xdrs, buf, MSGSIZE, XDR_DECODE);
         if (readDecodeHdr_(chfd, buf, chanRead_, &xdrs, &replyHdr) < 0) {
@@ -331,6 +396,11 @@ execJob(struct jobCard *jobCardPtr, int chfd)
     if ((jobCardPtr->jobSpecs.jobPGid = setPGid(jobCardPtr)) < 0)
         jobSetupStatus(JOB_STAT_PEND, PEND_JOB_EXEC_INIT, jobCardPtr);
 
+    /* Without its cgroup the job is
+     * still tracked by process group.
+     */
+    cgroupAttach(jobCardPtr);
+
     putEnv(LS_EXEC_T, "START");
 
     if (setJobEnv(jobCardPtr) < 0) {
@@ -1200,17 +1270,38 @@ finishJob(struct jobCard *jobCard)
 
 
 
+/* status_report()
+ * Report the jobs whose status or rusage changed to
+ * mbatchd, up to STATUS_BATCH_MAX jobs in one request.
+ */
+#define STATUS_BATCH_MAX 1024
+
+static struct jobCard **statusJobs;
+static int *statusReqTypes;
+static int *statusReps;
+
+static int statusFlush(int);
+
 void
 status_report (void)
 {
     static char fname[] = "status_report()";
     struct jobCard *jp, *next;
     static char mailed = TRUE;
-    int rep, allReported = TRUE;
+    int allReported = TRUE;
+    int njobs;
 
     if (logclass & LC_TRACE)
         ls_syslog(LOG_DEBUG2,"status_report: Entering..");
 
+    if (statusJobs == NULL) {
+        statusJobs = my_calloc(STATUS_BATCH_MAX,
+                               sizeof(struct jobCard *), fname);
+        statusReqTypes = my_calloc(STATUS_BATCH_MAX, sizeof(int), fname);
+        statusReps = my_calloc(STATUS_BATCH_MAX, sizeof(int), fname);
+    }
+
+    njobs = 0;
     for (jp = jobQueHead->back; (jp != jobQueHead); jp = next) {
         next = jp->back;
 
@@ -1242,41 +1333,75 @@ status_report (void)
             continue;
         /* don't retry other jobs either */
 
-        if (IS_START(jp->jobSpecs.jStatus)) {
-            mbdReqType reqType;
-
-            if (!jp->notReported && jp->needReportRU)
-                reqType = BATCH_RUSAGE_JOB;
-            else
-                reqType = BATCH_STATUS_JOB;
+        if (!IS_START(jp->jobSpecs.jStatus))
+            continue;
 
-            rep = status_job (reqType, jp, jp->jobSpecs.jStatus,
-                              ERR_NO_ERROR);
+        statusJobs[njobs] = jp;
+        if (!jp->notReported && jp->needReportRU)
+            statusReqTypes[njobs] = BATCH_RUSAGE_JOB;
+        else
+            statusReqTypes[njobs] = BATCH_STATUS_JOB;
 
-            if (reqType == BATCH_STATUS_JOB) {
-                if (rep >= 0) {
-                    if (jp->notReported > 0)
-                        jp->notReported = 0;
-                } else {
-                    allReported = FALSE;
-                    jp->notReported++;
-                    if (jp->notReported == 40 && !mailed) {
-                        mailed = TRUE;
-                        lsb_merr(_i18n_printf(_i18n_msg_get(ls_catd , NL_SETN, 411,
-                                                            "%s: unable to report job %s status to master; retried %d times\n"), /* catgets 411 */
-                                              fname, lsb_jobid2str(jp->jobSpecs.jobId), jp->notReported));
-                    }
-                }
-            }
+        if (++njobs == STATUS_BATCH_MAX) {
+            if (statusFlush(njobs) < 0)
+                allReported = FALSE;
+            njobs = 0;
         }
     }
 
+    if (njobs > 0 && statusFlush(njobs) < 0)
+        allReported = FALSE;
 
     if (allReported == TRUE)
         mailed = FALSE;
+    else if (!mailed) {
+        for (jp = jobQueHead->back; jp != jobQueHead; jp = jp->back) {
+            if (jp->notReported == 40) {
+                mailed = TRUE;
+                lsb_merr(_i18n_printf(_i18n_msg_get(ls_catd , NL_SETN, 411,
+                                                    "%s: unable to report job %s status to master; retried %d times\n"), /* catgets 411 */
+                                      fname, lsb_jobid2str(jp->jobSpecs.jobId), jp->notReported));
+                break;
+            }
+        }
+    }
 
 }
 
+/* statusFlush()
+ * Send the status of the jobs collected by status_report()
+ * in one request and count the retries of the ones
+ * mbatchd did not get. Returns -1 if some job is left
+ * unreported.
+ */
+static int
+statusFlush(int njobs)
+{
+    struct jobCard *jp;
+    int cc;
+    int i;
+
+    status_jobs(statusJobs, statusReqTypes, njobs, statusReps);
+
+    cc = 0;
+    for (i = 0; i < njobs; i++) {
+
+        if (statusReqTypes[i] != BATCH_STATUS_JOB)
+            continue;
+
+        jp = statusJobs[i];
+        if (statusReps[i] >= 0) {
+            if (jp->notReported > 0)
+                jp->notReported = 0;
+        } else {
+            cc = -1;
+            jp->notReported++;
+        }
+    }
+
+    return cc;
+}
+
 void
 rmvJobStarterStr(char *line, char *jobStarter)
 {
@@ -2138,6 +2263,7 @@ addJob (struct jobSpecs *jobSpecs, int mbdVersion)
 
     jp =  (struct jobCard *) my_calloc (1, sizeof (struct jobCard), fname);
     memcpy((char *) &jp->jobSpecs, jobSpecs, sizeof(struct jobSpecs));
+    jp->goAheadFd = -1;
 
     if (jobSpecs->execUsername[0] == '\0') {
 
@@ -2598,6 +2724,12 @@ deallocJobCard(struct jobCard *jobCard)
     static char fname[] = "deallocJobCard()";
     char fileBuf[MAXFILENAMELEN];
 
+    cgroupRemove(jobCard);
+
+    if (jobCard->goAheadFd >= 0)
+        close(jobCard->goAheadFd);
+    FREEUP(jobCard->jobFile.data);
+
     sprintf(fileBuf, "%s/.%s.%s.fail", LSTMPDIR, jobCard->jobSpecs.jobFile,
             lsb_jobidinstr(jobCard->jobSpecs.jobId));
 
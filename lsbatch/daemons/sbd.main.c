@@ -320,6 +320,8 @@ main (int argc, char **argv)
 	}
     }
 
+    cgroupInit();
+
     now = time(0);
 
     for (i=0; i<8; i++)
@@ -468,6 +470,7 @@ main (int argc, char **argv)
         client->from = from;
 	client->jp = NULL;
 	client->jobId = -1;
+	client->mbdChan = FALSE;
 
         inList( (struct listEntry *)clientList, (struct listEntry *) client);
 
@@ -552,7 +555,7 @@ processMsg(struct clientNode *client)
     if (sbdReqtype == MBD_NEW_JOB || sbdReqtype == MBD_SIG_JOB ||
 	sbdReqtype == MBD_SWIT_JOB || sbdReqtype == MBD_PROBE ||
 	sbdReqtype == MBD_REBOOT || sbdReqtype == MBD_SHUTDOWN ||
-	sbdReqtype == MBD_MODIFY_JOB) {
+	sbdReqtype == MBD_MODIFY_JOB || sbdReqtype == MBD_OPEN_CHAN) {
 #ifdef INTER_DAEMON_AUTH
 	if (daemonParams[LSF_AUTH_DAEMONS].paramValue) {
 	    char *aux_file, aux_file_buf[MAXPATHLEN];
@@ -629,10 +632,21 @@ processMsg(struct clientNode *client)
         break;
 
     case MBD_NEW_JOB:
-        TIMEIT(2, do_newjob (&xdrs, client->chanfd, &reqHdr), "do_newjob");
+        TIMEIT(2, do_newjob (&xdrs, client->chanfd, &reqHdr, client),
+               "do_newjob");
         delay_check = TRUE;
         break;
 
+    case MBD_OPEN_CHAN:
+        do_openChan(&xdrs, client->chanfd, &reqHdr, client);
+        break;
+
+    case MBD_NEW_JOB_GO:
+    case MBD_NEW_JOB_ABORT:
+        if (client->mbdChan)
+            do_goAhead(client->chanfd, &reqHdr);
+        break;
+
     case MBD_SIG_JOB:
         TIMEIT(2, do_sigjob (&xdrs, client->chanfd, &reqHdr), "do_sigjob");
         delay_check = TRUE;
@@ -702,7 +716,8 @@ processMsg(struct clientNode *client)
     xdr_destroy(&xdrs);
     chanFreeBuf_(buf);
     if (reqHdr.opCode != PREPARE_FOR_OP &&
-	reqHdr.opCode != RM_CONNECT )
+	reqHdr.opCode != RM_CONNECT &&
+        !client->mbdChan)
         shutDownClient(client);
 
 }
@@ -712,6 +727,9 @@ processMsg(struct clientNode *client)
 void
 shutDownClient(struct clientNode *client)
 {
+    if (client->mbdChan)
+        closeGoAhead(client->chanfd);
+
     chanClose_(client->chanfd);
     offList((struct listEntry *)client);
 
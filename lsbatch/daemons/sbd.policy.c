@@ -658,8 +658,9 @@ shouldStop (struct hostLoad *loadV,
                 returnCode = getTclHostData (load, &tclHostData, TRUE);
             }
             if (returnCode >= 0 
-		     && evalResReq (jobCard->stopCondVal->selectStr, 
-    	       	        &tclHostData, DFT_FROMTYPE) == 1) {
+		     && evalSelectCode(jobCard->stopCondVal->selectCode,
+                                       jobCard->stopCondVal->selectStr,
+                                       &tclHostData, DFT_FROMTYPE) == 1) {
         	*reasons |= SUSP_QUE_STOP_COND;
 		break;
             }
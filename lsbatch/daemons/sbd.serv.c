@@ -35,7 +35,8 @@ extern int lsbJobCpuLimit;
 extern int lsbJobMemLimit;
 
 void 
-do_newjob(XDR *xdrs, int chfd, struct LSFHeader *reqHdr)
+do_newjob(XDR *xdrs, int chfd, struct LSFHeader *reqHdr,
+          struct clientNode *client)
 {
     static char        fname[] = "do_newjob()";
     char               reply_buf[MSGSIZE];
@@ -47,15 +48,34 @@ do_newjob(XDR *xdrs, int chfd, struct LSFHeader *reqHdr)
     struct LSFHeader   replyHdr;
     char               *replyStruct;
     struct lsfAuth     *auth = NULL;
+    struct lenData     jf;
 
     memset(&jobReply, 0, sizeof(struct jobReply));
+    jf.len = 0;
+    jf.data = NULL;
     
     if (!xdr_jobSpecs(xdrs, &jobSpecs, reqHdr)) {
 	reply = ERR_BAD_REQ;
 	ls_syslog(LOG_ERR, I18N_FUNC_FAIL, fname, "xdr_jobSpecs");
 	goto sendReply;
     }
-    
+
+    /* On the mbatchd channel the job file follows
+     * the job specs, otherwise the job reads it
+     * from the connection.
+     */
+    if (client->mbdChan) {
+        if (!xdr_int(xdrs, &jf.len) || jf.len < 0
+            || (jf.data = malloc(jf.len + 1)) == NULL
+            || !xdr_opaque(xdrs, jf.data, jf.len)) {
+            ls_syslog(LOG_ERR, "\
+%s: cannot decode the job file of job %s", __func__,
+                      lsb_jobid2str(jobSpecs.jobId));
+            FREEUP(jf.data);
+            reply = ERR_BAD_REQ;
+            goto sendReply;
+        }
+    }
     
     for (jp = jobQueHead->forw; (jp != jobQueHead); jp = jp->forw) {
         if (jp->jobSpecs.jobId == jobSpecs.jobId) {
@@ -76,6 +96,7 @@ do_newjob(XDR *xdrs, int chfd, struct LSFHeader *reqHdr)
 	reply = ERR_MEM;
 	goto sendReply;
     }
+    jp->goAheadFd = -1;
     memcpy((char *) &jp->jobSpecs, (char *) &jobSpecs,
 	   sizeof(struct jobSpecs));
 
@@ -136,7 +157,15 @@ do_newjob(XDR *xdrs, int chfd, struct LSFHeader *reqHdr)
         else
             SBD_SET_STATE(jp, JOB_STAT_RUN);
 
-    reply = job_exec(jp, chfd);
+    if (client->mbdChan) {
+        jp->jobFile = jf;
+        jp->mbdChan = chfd;
+        jp->mbdTag = reqHdr->reserved0;
+        jf.data = NULL;
+        reply = job_exec(jp, -1);
+    } else {
+        reply = job_exec(jp, chfd);
+    }
     
     if (reply != ERR_NO_ERROR) {
 	ls_syslog(LOG_ERR, I18N_JOB_FAIL_S, fname, 
@@ -154,6 +183,7 @@ do_newjob(XDR *xdrs, int chfd, struct LSFHeader *reqHdr)
 
 
 sendReply:
+    FREEUP(jf.data);
     xdr_lsffree(xdr_jobSpecs, (char *)&jobSpecs, reqHdr);
 #ifdef INTER_DAEMON_AUTH
     if (daemonParams[LSF_AUTH_DAEMONS].paramValue) {
@@ -166,6 +196,7 @@ sendReply:
     xdrmem_create(&xdrs2, reply_buf, MSGSIZE, XDR_ENCODE);
     initLSFHeader_(&replyHdr);
     replyHdr.opCode = reply;
+    replyHdr.reserved0 = reqHdr->reserved0;
     replyStruct = (reply == ERR_NO_ERROR) ? (char *) &jobReply : (char *) NULL;
     if (!xdr_encodeMsg(&xdrs2, replyStruct, &replyHdr, xdr_jobReply, 0, auth)) {
 	ls_syslog(LOG_ERR, I18N_FUNC_FAIL, fname, "xdr_jobReply");
@@ -325,6 +356,7 @@ sendReply:
     xdrmem_create(&xdrs2, reply_buf, MSGSIZE, XDR_ENCODE);
     initLSFHeader_(&replyHdr);
     replyHdr.opCode = reply;
+    replyHdr.reserved0 = reqHdr->reserved0;
     if (reply == ERR_NO_ERROR)
 	replyStruct = (char *) &jobReply;
     else {
@@ -464,6 +496,7 @@ sendReply:
     xdrmem_create(&xdrs2, reply_buf, MSGSIZE, XDR_ENCODE);
     initLSFHeader_(&replyHdr);
     replyHdr.opCode = reply;
+    replyHdr.reserved0 = reqHdr->reserved0;
     if (reply == ERR_NO_ERROR)
 	replyStruct = (char *) &jobReply;
     else {
@@ -504,6 +537,7 @@ do_probe(XDR * xdrs, int chfd, struct LSFHeader * reqHdr)
 
     initLSFHeader_(&replyHdr);
     replyHdr.opCode = ERR_NO_ERROR;
+    replyHdr.reserved0 = reqHdr->reserved0;
     jobSpecs = NULL;
 
     if (!xdr_sbdPackage(xdrs, &sbdPackage, reqHdr)) {
@@ -700,6 +734,7 @@ Reply1:
 
     initLSFHeader_(&replyHdr);
     replyHdr.opCode = reply;
+    replyHdr.reserved0 = reqHdr->reserved0;
     if (reply == ERR_NO_ERROR) {
         jobReply.jobPid = jp->jobSpecs.jobPid;
         jobReply.actPid = jp->jobSpecs.actPid;
@@ -736,6 +771,78 @@ Reply1:
     return;
 }				
 
+/* do_openChan()
+ * mbatchd keeps this connection open and queues its
+ * requests on it tagged, each reply carries the tag
+ * of its request. If the reply cannot be sent the
+ * connection is closed as any other one.
+ */
+void
+do_openChan(XDR *xdrs, int chfd, struct LSFHeader *reqHdr,
+            struct clientNode *client)
+{
+    char reply_buf[MSGSIZE];
+    struct LSFHeader replyHdr;
+    XDR xdrs2;
+
+    xdrmem_create(&xdrs2, reply_buf, MSGSIZE, XDR_ENCODE);
+    initLSFHeader_(&replyHdr);
+    replyHdr.opCode = ERR_NO_ERROR;
+
+    if (!xdr_encodeMsg(&xdrs2, NULL, &replyHdr, NULL, 0, NULL)) {
+        ls_syslog(LOG_ERR, "%s: xdr_encodeMsg() failed", __func__);
+        xdr_destroy(&xdrs2);
+        return;
+    }
+
+    if (chanWrite_(chfd, reply_buf, XDR_GETPOS(&xdrs2)) <= 0) {
+        ls_syslog(LOG_ERR, "%s: chanWrite_() failed %m", __func__);
+        xdr_destroy(&xdrs2);
+        return;
+    }
+
+    xdr_destroy(&xdrs2);
+    client->mbdChan = TRUE;
+
+    ls_syslog(LOG_INFO, "\
+%s: mbatchd channel open on %d", __func__, chfd);
+}
+
+/* do_goAhead()
+ * mbatchd logged the start of the job of the tagged
+ * MBD_NEW_JOB, or with MBD_NEW_JOB_ABORT it did not.
+ * Closing the pipe without a go-ahead aborts the job.
+ * Tags are given per channel, so only a job started on
+ * the channel chfd the request came from can match.
+ */
+void
+do_goAhead(int chfd, struct LSFHeader *reqHdr)
+{
+    struct jobCard *jp;
+
+    for (jp = jobQueHead->forw; jp != jobQueHead; jp = jp->forw) {
+
+        if (jp->goAheadFd < 0
+            || jp->mbdChan != chfd
+            || jp->mbdTag != reqHdr->reserved0)
+            continue;
+
+        if (reqHdr->opCode == MBD_NEW_JOB_GO
+            && write(jp->goAheadFd, "1", 1) != 1) {
+            ls_syslog(LOG_ERR, "\
+%s: write() go-ahead failed for job %s %m", __func__,
+                      lsb_jobid2str(jp->jobSpecs.jobId));
+        }
+        close(jp->goAheadFd);
+        jp->goAheadFd = -1;
+        return;
+    }
+
+    if (logclass & LC_EXEC)
+        ls_syslog(LOG_DEBUG, "\
+%s: no job waits for go-ahead tag %u on channel %d", __func__,
+                  reqHdr->reserved0, chfd);
+}
 
 void
 do_jobMsg(struct bucket * bucket, XDR *xdrs, int s, struct LSFHeader * reqHdr)
@@ -753,7 +753,7 @@ mykillpg(struct jobCard *jp, int sig)
     if (jp->regOpFlag & REG_RUSAGE) {
         jru = &(jp->runRusage);
     }
-    else {
+    else if ((jru = cgroupRusage(jp)) == NULL) {
         TIMEIT(0, jru = getJInfo_(npgid, pgid, 0, jp->jobSpecs.jobPGid), "getJInfo_ in mykillpg");
     }
 
@@ -892,6 +892,19 @@ mykillpg: job file name = %s\n", jobFileName);
 
 
 
+    /* The job cgroup has all the processes,
+     * whatever process group they moved to.
+     */
+    if ((i = cgroupKill(jp, sig)) >= 0) {
+	if (i == 0) {
+	    if (logclass & LC_SIGNAL)
+		ls_syslog(LOG_DEBUG, "%s: Job %s cgroup is empty", fname,
+			  lsb_jobid2str(jp->jobSpecs.jobId));
+	    return (-1);
+	}
+	return (0);
+    }
+
     if (kill(jp->jobSpecs.jobPid, sig) == 0) {
 
 	if (logclass & LC_SIGNAL)
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#if _CGROUP_TEST_
+
+/* Benchmark of the job process tracking, build with:
+ *
+ * gcc -D_CGROUP_TEST_=1 -O2 testcgroup.c -o testcgroup
+ *
+ * and run as root as testcgroup cgroupdir [nprocs [njobprocs]],
+ * cgroupdir being a directory of the cgroup v2 hierarchy. It
+ * starts nprocs processes, 20000 by default, njobprocs of them
+ * in a job cgroup, and reports the time pim takes to scan all
+ * the processes of the host against the time sbatchd takes to
+ * read the job cgroup.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ROUNDS 10
+
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_usec - t0->tv_usec) / 1e6;
+}
+
+static int
+readFile(const char *path, char *buf, int size)
+{
+    int fd;
+    int cc;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+    cc = read(fd, buf, size - 1);
+    close(fd);
+    if (cc < 0)
+        return -1;
+    buf[cc] = 0;
+    return cc;
+}
+
+static int
+statPid(int pid)
+{
+    char path[64];
+    char buf[1024];
+    unsigned long utime;
+    unsigned long vsize;
+    long rss;
+    int ppid;
+    int pgid;
+    char *p;
+    char c;
+
+    sprintf(path, "/proc/%d/stat", pid);
+    if (readFile(path, buf, sizeof(buf)) <= 0)
+        return -1;
+    if ((p = strrchr(buf, ')')) == NULL)
+        return -1;
+    if (sscanf(p + 2, "\
+%c %d %d %*d %*d %*d %*u %*u %*u %*u %*u %lu %*u %*d %*d %*d %*d %*d %*d \
+%*u %lu %ld", &c, &ppid, &pgid, &utime, &vsize, &rss) != 6)
+        return -1;
+    return 0;
+}
+
+/* What pim does, every process of the host.
+ */
+static int
+scanProc(void)
+{
+    struct dirent *d;
+    DIR *dir;
+    int n;
+
+    if ((dir = opendir("/proc")) == NULL)
+        return -1;
+    n = 0;
+    while ((d = readdir(dir)) != NULL) {
+        if (!isdigit(d->d_name[0]))
+            continue;
+        if (statPid(atoi(d->d_name)) == 0)
+            n++;
+    }
+    closedir(dir);
+    return n;
+}
+
+/* What sbatchd does, the job cgroup only.
+ */
+static int
+scanCgroup(const char *job)
+{
+    char path[PATH_MAX];
+    char buf[4096];
+    FILE *fp;
+    int pid;
+    int n;
+
+    sprintf(path, "%s/cgroup.procs", job);
+    if ((fp = fopen(path, "r")) == NULL)
+        return -1;
+    n = 0;
+    while (fscanf(fp, "%d", &pid) == 1) {
+        if (statPid(pid) == 0)
+            n++;
+    }
+    fclose(fp);
+
+    sprintf(path, "%s/cpu.stat", job);
+    readFile(path, buf, sizeof(buf));
+    sprintf(path, "%s/memory.current", job);
+    readFile(path, buf, sizeof(buf));
+
+    return n;
+}
+
+int
+main(int argc, char **argv)
+{
+    char job[PATH_MAX];
+    char path[PATH_MAX];
+    struct timeval t0;
+    pid_t *pids;
+    double t;
+    int nprocs;
+    int njob;
+    int fd;
+    int n;
+    int i;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s cgroupdir [nprocs [njobprocs]]\n", argv[0]);
+        exit(-1);
+    }
+    nprocs = argc > 2 ? atoi(argv[2]) : 20000;
+    njob = argc > 3 ? atoi(argv[3]) : 10;
+    if (njob > nprocs)
+        njob = nprocs;
+
+    sprintf(job, "%s/job.bench.%d", argv[1], (int)getpid());
+    if (mkdir(job, 0755) < 0) {
+        perror(job);
+        exit(-1);
+    }
+    sprintf(path, "%s/cgroup.procs", job);
+
+    pids = calloc(nprocs, sizeof(pid_t));
+    for (i = 0; i < nprocs; i++) {
+        if ((pids[i] = fork()) == 0) {
+            if (i < njob) {
+                fd = open(path, O_WRONLY);
+                if (fd < 0 || write(fd, "0", 1) < 0)
+                    perror(path);
+                close(fd);
+            }
+            pause();
+            _exit(0);
+        }
+        if (pids[i] < 0) {
+            perror("fork");
+            nprocs = i;
+            break;
+        }
+    }
+    sleep(1);
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < ROUNDS; i++)
+        n = scanProc();
+    t = elapsed(&t0) / ROUNDS;
+    printf("/proc scan    %6d processes %10.3f ms per scan\n", n, t * 1000);
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < ROUNDS; i++)
+        n = scanCgroup(job);
+    t = elapsed(&t0) / ROUNDS;
+    printf("cgroup read   %6d processes %10.3f ms per read\n", n, t * 1000);
+
+    for (i = 0; i < nprocs; i++)
+        kill(pids[i], SIGKILL);
+    while (wait(NULL) > 0)
+        ;
+    rmdir(job);
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#if _DEPGRAPH_TEST_
+
+/* Benchmark of the dependency conditions of a large
+ * workflow, build in the build tree with:
+ *
+ * gcc -D_DEPGRAPH_TEST_=1 -O2 -I../.. -I../../lsf -I../../lsf/lib \
+ *     -I.. -I../lib -I. -DHAVE_CONFIG_H testdepgraph.c mbd.dep.c \
+ *     ../lib/liblsbatch.a ../../lsf/lib/liblsf.a \
+ *     ../../lsf/intlib/liblsfint.a -ltirpc -lnsl -lm -o testdepgraph
+ *
+ * and run as testdepgraph [njobs [passes]]. Four workflows
+ * of njobs jobs, 100000 by default, are parsed with
+ * parseDepCond(): a fan out where every job waits for the
+ * first one, a fan in where the last job waits for 5000
+ * others, a layered DAG where every job waits for two
+ * jobs of the layer before and a fan out on post_done()
+ * of the first one. At every scheduling pass 1% of the
+ * jobs whose condition is true finish, the jobs done at
+ * the pass before get their post execution done, and the pass
+ * evaluates the condition of all the pending jobs with
+ * evalDepCond() as mbatchd used to and with depCondValue().
+ * The values must be the same, the time of both is reported.
+ */
+#include <sys/time.h>
+#include "mbd.h"
+
+#define FANIN_MAX  5000
+
+static jidTab jobs;
+static struct jData *jobArr;
+static int numJobs;
+
+int mSchedStage;
+int jobDepLastSub;
+time_t now;
+struct jgTreeNode *groupRoot;
+
+void *
+my_malloc(int len, const char *s)
+{
+    return malloc(len);
+}
+
+void *
+my_calloc(int n, int size, const char *s)
+{
+    return calloc(n, size);
+}
+
+void
+mbdDie(int sig)
+{
+    exit(-1);
+}
+
+struct jData *
+getJobData(LS_LONG_INT jobId)
+{
+    jidEnt *ent;
+
+    if ((ent = jidGetEnt(&jobs, jobId)) == NULL)
+        return NULL;
+    return ent->hData;
+}
+
+struct jData *
+createjDataRef(struct jData *jp)
+{
+    jp->numRef++;
+    return jp;
+}
+
+void
+destroyjDataRef(struct jData *jp)
+{
+    jp->numRef--;
+}
+
+struct uData *
+getUserData(char *user)
+{
+    return NULL;
+}
+
+struct idxList *
+parseJobArrayIndex(char *job, int *error, int *maxJLimit)
+{
+    *error = LSBE_NO_ERROR;
+    return NULL;
+}
+
+void freeIdxList(struct idxList *l) {}
+struct idxList *getIdxListContext(void) { return NULL; }
+int inIdxList(LS_LONG_INT jobId, struct idxList *l) { return 1; }
+struct timeWindow *newTimeWindow(void) { return NULL; }
+void freeTimeWindow(struct timeWindow *w) {}
+void updateTimeWindow(struct timeWindow *w) {}
+struct jgArrayBase *createJgArrayBaseRef(struct jgArrayBase *b) { return b; }
+void destroyJgArrayBaseRef(struct jgArrayBase *b) {}
+
+static void
+noFree(void *p)
+{
+}
+
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_usec - t0->tv_usec) / 1e6;
+}
+
+static void
+newJobs(int n)
+{
+    struct jShared *shared;
+    int new;
+    int i;
+
+    jidInitTab(&jobs, n);
+    jobArr = calloc(n + 1, sizeof(struct jData));
+    shared = calloc(n + 1, sizeof(struct jShared));
+    for (i = 1; i <= n; i++) {
+        jobArr[i].jobId = i;
+        jobArr[i].jStatus = JOB_STAT_PEND;
+        jobArr[i].nodeType = JGRP_NODE_JOB;
+        jobArr[i].shared = &shared[i];
+        jidAddEnt(&jobs, i, &new)->hData = &jobArr[i];
+    }
+    numJobs = n;
+}
+
+static void
+setCond(int job, char *cond)
+{
+    struct lsfAuth auth;
+    char *badName;
+    int replyCode;
+    int jFlags;
+
+    memset(&auth, 0, sizeof(auth));
+    jFlags = 0;
+    jobArr[job].shared->dptRoot = parseDepCond(cond, &auth, &replyCode,
+                                               &badName, &jFlags, 0);
+    if (jobArr[job].shared->dptRoot == NULL) {
+        fprintf(stderr, "job %d: cannot parse %.40s... %d\n",
+                job, cond, replyCode);
+        exit(-1);
+    }
+}
+
+static void
+freeJobs(void)
+{
+    int i;
+
+    for (i = 1; i <= numJobs; i++)
+        freeDepCond(jobArr[i].shared->dptRoot);
+    free(jobArr[1].shared - 1);
+    free(jobArr);
+    jidFreeTab(&jobs, noFree);
+}
+
+/* The walk of the readiness of the pending jobs,
+ * the value of every job in value.
+ */
+static double
+walk(int graph, int *value)
+{
+    struct timeval t0;
+    int i;
+
+    gettimeofday(&t0, NULL);
+    for (i = 1; i <= numJobs; i++) {
+        if (!IS_PEND(jobArr[i].jStatus))
+            continue;
+        if (jobArr[i].shared->dptRoot == NULL)
+            value[i] = DP_TRUE;
+        else if (graph)
+            value[i] = depCondValue(&jobArr[i]);
+        else
+            value[i] = evalDepCond(jobArr[i].shared->dptRoot, &jobArr[i]);
+    }
+
+    return elapsed(&t0);
+}
+
+/* Scheduling passes until every job is done or
+ * passes is reached, the two walks alternate first
+ * so neither gets the cache warmed by the other.
+ */
+static void
+run(const char *name, int passes)
+{
+    double tFull;
+    double tGraph;
+    int *value;
+    int *gvalue;
+    int numReady;
+    int numDone;
+    int errors;
+    int pass;
+    int i;
+
+    value = calloc(numJobs + 1, sizeof(int));
+    gvalue = calloc(numJobs + 1, sizeof(int));
+    tFull = tGraph = 0;
+    errors = 0;
+    numDone = 0;
+
+    for (pass = 0; pass < passes && numDone < numJobs; pass++) {
+
+        if (pass % 2) {
+            tGraph += walk(TRUE, gvalue);
+            tFull += walk(FALSE, value);
+        } else {
+            tFull += walk(FALSE, value);
+            tGraph += walk(TRUE, gvalue);
+        }
+
+        /* 1% of the ready jobs run and finish, the post
+         * execution of the ones done before is done as
+         * statusJob() does it.
+         */
+        numReady = 0;
+        for (i = 1; i <= numJobs; i++) {
+            if (jobArr[i].jStatus == JOB_STAT_DONE
+                && jobArr[i].endTime == pass) {
+                jobArr[i].jStatus |= JOB_STAT_PDONE;
+                depJobChanged(&jobArr[i]);
+                continue;
+            }
+            if (!IS_PEND(jobArr[i].jStatus))
+                continue;
+            if (gvalue[i] != value[i])
+                errors++;
+            if (gvalue[i] != DP_TRUE || numReady++ % 100)
+                continue;
+            jobArr[i].jStatus = JOB_STAT_DONE;
+            jobArr[i].endTime = pass + 1;
+            depJobChanged(&jobArr[i]);
+            numDone++;
+        }
+    }
+
+    printf("%-8s %7d jobs %4d passes %6d done: evalDepCond %9.3f ms \
+depCondValue %9.3f ms %s\n", name, numJobs, pass, numDone,
+           tFull * 1000, tGraph * 1000, errors ? "DIFFER" : "same");
+
+    free(value);
+    free(gvalue);
+}
+
+int
+main(int argc, char **argv)
+{
+    char *cond;
+    char *p;
+    int passes;
+    int width;
+    int n;
+    int i;
+
+    n = argc > 1 ? atoi(argv[1]) : 100000;
+    passes = argc > 2 ? atoi(argv[2]) : 50;
+    if (n < 10) {
+        fprintf(stderr, "usage: %s [njobs [passes]]\n", argv[0]);
+        exit(-1);
+    }
+    cond = malloc(16 * (FANIN_MAX + 1));
+    depGraphInit();
+
+    newJobs(n);
+    for (i = 2; i <= n; i++)
+        setCond(i, "done(1)");
+    run("fanout", passes);
+    freeJobs();
+
+    newJobs(n);
+    p = cond;
+    for (i = 1; i < n && i <= FANIN_MAX; i++)
+        p += sprintf(p, "%sdone(%d)", i > 1 ? "&&" : "", i);
+    setCond(n, cond);
+    run("fanin", passes);
+    freeJobs();
+
+    newJobs(n);
+    width = 1000;
+    for (i = width + 1; i <= n; i++) {
+        /* The job above and its right neighbour.
+         */
+        p = cond + sprintf(cond, "done(%d)", i - width);
+        sprintf(p, "&&done(%d)",
+                i - width - (i - width - 1) % width + (i - width) % width);
+        setCond(i, cond);
+    }
+    run("layered", passes);
+    freeJobs();
+
+    newJobs(n);
+    for (i = 2; i <= n; i++)
+        setCond(i, "post_done(1)");
+    run("postdone", passes);
+    freeJobs();
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#if _HOSTSORT_TEST_
+
+/* Regression test and benchmark of passSortHosts(), build
+ * in the build tree with:
+ *
+ * gcc -D_HOSTSORT_TEST_=1 -O2 -I../.. -I../../lsf -I../../lsf/lib \
+ *     -I.. -I../lib -I. -DHAVE_CONFIG_H testhostsort.c mbd.hostsort.c \
+ *     ../../lsf/lib/liblsf.a -ltirpc -lm -o testhostsort
+ *
+ * and run as testhostsort [rounds [nhosts]]. Random candidate
+ * hosts are ordered by the bubble sort sortHosts() used to run,
+ * comparing with orderByStatus() and notOrdered(), and by
+ * passSortHosts(), for every number of passes the scheduler
+ * asks. Any difference in the order is reported, then the
+ * time of both on nhosts hosts, 5000 by default.
+ */
+#include <sys/time.h>
+#include "mbd.h"
+
+static int status[] = {
+    HOST_STAT_OK, HOST_STAT_OK, HOST_STAT_OK, HOST_STAT_OK,
+    HOST_STAT_BUSY, HOST_STAT_BUSY | HOST_STAT_WIND,
+    HOST_STAT_WIND, HOST_STAT_FULL, HOST_STAT_LOCKED,
+    HOST_STAT_UNREACH, HOST_STAT_UNAVAIL, HOST_STAT_EXCLUSIVE
+};
+
+void *
+my_malloc(int len, const char *s)
+{
+    return malloc(len);
+}
+
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_usec - t0->tv_usec) / 1e6;
+}
+
+/* The old sortHosts() loop, lastSort FALSE gives the 5%
+ * margin to the loads, norm the cpu factor normalization
+ * of the r15s, r1m and r15m indexes.
+ */
+static int
+notOrdered(int increasing, int norm, float load1, float load2,
+           float cpuf1, float cpuf2)
+{
+    float normal1, normal2;
+
+    if (norm) {
+        normal1 = (cpuf1 != 0)?(load1 + 1)/cpuf1:load1;
+        normal2 = (cpuf2 != 0)?(load2 + 1)/cpuf2:load2;
+    } else {
+        normal1 = load1;
+        normal2 = load2;
+    }
+
+    if (increasing)
+        return (normal1 > normal2);
+
+    return (normal1 < normal2);
+}
+
+static int
+orderStatus(struct candHost *hosts, int j)
+{
+    int status1, status2;
+    struct candHost tmp;
+
+    status1 = hosts[j-1].hData->hStatus;
+    status2 = hosts[j].hData->hStatus;
+
+    if ((LSB_HOST_OK(status2) && !LSB_HOST_OK(status1))
+        || (LSB_HOST_BUSY(status2) && !LSB_HOST_OK(status1)
+            && !LSB_HOST_BUSY(status1))
+        || (LSB_HOST_CLOSED(status2) && !LSB_HOST_OK(status1)
+            && !LSB_HOST_BUSY(status1) && !LSB_HOST_CLOSED(status1))
+        || (LSB_HOST_UNREACH(status2) && !LSB_HOST_OK(status1)
+            && !LSB_HOST_BUSY(status1) && !LSB_HOST_CLOSED(status1)
+            && !LSB_HOST_UNREACH(status1))
+        || (LSB_HOST_UNAVAIL(status2) && !LSB_HOST_OK(status1)
+            && !LSB_HOST_BUSY(status1) && !LSB_HOST_CLOSED(status1)
+            && !LSB_HOST_UNREACH(status1) && !LSB_HOST_UNAVAIL(status1)))  {
+        tmp = hosts[j];
+        hosts[j] = hosts[j-1];
+        hosts[j-1] = tmp;
+        return (0);
+    }
+
+    if (LSB_HOST_OK(status2) && LSB_HOST_OK(status1))
+        return (2);
+
+    return (1);
+}
+
+static void
+bubble(struct candHost *hosts, int n, int passes, int incr, int decr,
+       int norm, int lastSort)
+{
+    struct candHost tmp;
+    float exld1, exld2;
+    float load1, load2;
+    char swap;
+    int order;
+    int i, j;
+
+    swap = TRUE;
+    i = 0;
+    while (swap && (i < passes)) {
+        swap = FALSE;
+        for (j = n-2; j >= i; j--) {
+            order = orderStatus(hosts, j+1);
+            if (order == 0) {
+                swap = TRUE;
+                continue;
+            } else if (order == 1)
+                continue;
+
+            load1 = hosts[j].hData->lsbLoad[0];
+            load2 = hosts[j + 1].hData->lsbLoad[0];
+            exld1 = exld2 = 0;
+            if (!lastSort) {
+                exld1 = load1 * 0.05;
+                exld2 = load2 * 0.05;
+                if (decr) {
+                    exld1 = -exld1;
+                    exld2 = -exld2;
+                }
+            }
+
+            if (notOrdered(incr, norm, load1 + exld1, load2 + exld2,
+                           hosts[j].hData->cpuFactor,
+                           hosts[j+1].hData->cpuFactor)) {
+                swap = TRUE;
+                tmp = hosts[j];
+                hosts[j] = hosts[j+1];
+                hosts[j+1] = tmp;
+            }
+        }
+        i++;
+    }
+}
+
+/* The keys as sortHosts() computes them.
+ */
+static void
+setKeys(struct candHost *hosts, struct hostSortKey *keys, int n,
+        int decr, int norm, int lastSort)
+{
+    float value;
+    float exld;
+    float cpuf;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        value = hosts[i].hData->lsbLoad[0];
+        keys[i].value = value;
+        keys[i].tier = hostStatusTier(hosts[i].hData->hStatus);
+        if (!lastSort) {
+            exld = value * 0.05;
+            if (decr)
+                exld = -exld;
+            value = value + exld;
+        }
+        cpuf = hosts[i].hData->cpuFactor;
+        if (norm)
+            keys[i].key = (cpuf != 0) ? (value + 1)/cpuf : value;
+        else
+            keys[i].key = value;
+    }
+}
+
+static void
+randomHosts(struct hData *hd, struct candHost *hosts, int n, int spread)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        hd[i].hStatus = status[random() % (sizeof(status)/sizeof(int))];
+        /* Few distinct values for ties.
+         */
+        hd[i].lsbLoad[0] = (random() % spread) / 4.0;
+        hd[i].cpuFactor = (random() % 4) ? 1.0 + (random() % 8) / 2.0 : 0.0;
+        hosts[i].hData = &hd[i];
+        hosts[i].numSlots = i;
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    struct candHost *ref;
+    struct candHost *hosts;
+    struct hostSortKey *keys;
+    struct hData *hd;
+    struct timeval t0;
+    float *loads;
+    double t1, t2;
+    int rounds;
+    int nhosts;
+    int errors;
+    int passes;
+    int incr, decr, norm, lastSort;
+    int r, n, i;
+
+    rounds = argc > 1 ? atoi(argv[1]) : 2000;
+    nhosts = argc > 2 ? atoi(argv[2]) : 5000;
+
+    hd = calloc(nhosts, sizeof(struct hData));
+    ref = calloc(nhosts, sizeof(struct candHost));
+    hosts = calloc(nhosts, sizeof(struct candHost));
+    keys = calloc(nhosts, sizeof(struct hostSortKey));
+    loads = calloc(nhosts, sizeof(float));
+    if (nhosts < 64 || !hd || !ref || !hosts || !keys || !loads) {
+        fprintf(stderr, "%s: bad nhosts %d or no memory\n", argv[0], nhosts);
+        exit(-1);
+    }
+    for (i = 0; i < nhosts; i++)
+        hd[i].lsbLoad = &loads[i];
+
+    errors = 0;
+    for (r = 0; r < rounds; r++) {
+
+        n = 1 + random() % 64;
+        passes = random() % (n + 2);
+        incr = random() % 2;
+        decr = random() % 2;
+        norm = random() % 2;
+        lastSort = random() % 2;
+
+        randomHosts(hd, ref, n, 1 + random() % 40);
+        memcpy(hosts, ref, n * sizeof(struct candHost));
+
+        bubble(ref, n, passes, incr, decr, norm, lastSort);
+        setKeys(hosts, keys, n, decr, norm, lastSort);
+        passSortHosts(hosts, keys, n, incr, passes);
+
+        for (i = 0; i < n; i++) {
+            if (ref[i].hData != hosts[i].hData
+                || keys[i].value != hosts[i].hData->lsbLoad[0])
+                break;
+        }
+        if (i < n) {
+            fprintf(stderr, "\
+round %d: n %d passes %d incr %d: hosts differ at %d\n",
+                    r, n, passes, incr, i);
+            errors++;
+        }
+    }
+    printf("%d rounds %d errors\n", rounds, errors);
+
+    randomHosts(hd, ref, nhosts, 1000);
+    memcpy(hosts, ref, nhosts * sizeof(struct candHost));
+    passes = nhosts - nhosts / 5;
+
+    gettimeofday(&t0, NULL);
+    bubble(ref, nhosts, passes, TRUE, FALSE, TRUE, FALSE);
+    t1 = elapsed(&t0);
+
+    gettimeofday(&t0, NULL);
+    setKeys(hosts, keys, nhosts, FALSE, TRUE, FALSE);
+    passSortHosts(hosts, keys, nhosts, TRUE, passes);
+    t2 = elapsed(&t0);
+
+    printf("%d hosts %d passes: bubble %.3f ms passSortHosts %.3f ms %s\n",
+           nhosts, passes, t1 * 1000, t2 * 1000,
+           memcmp(ref, hosts, nhosts * sizeof(struct candHost)) ?
+           "differ" : "same");
+
+    return errors ? 1 : 0;
+}
+
+#endif
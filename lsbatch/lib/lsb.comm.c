@@ -99,6 +99,88 @@ serv_connect (char *serv_host, ushort serv_port, int timeout)
     return(chfd);
 }
 
+/* addSeg()
+ * Append len bytes of data to the message msg. With
+ * attach the data is taken as it is and freed with
+ * the message, otherwise it is copied into a buffer
+ * of the channel pool.
+ */
+static int
+addSeg(struct Buffer **msg, char *data, int len, int attach)
+{
+    struct Buffer *seg;
+
+    if (attach) {
+        if (chanAttachBuf_(&seg, data, len) < 0)
+            return -1;
+    } else {
+        if (chanAllocBuf_(&seg, len) < 0)
+            return -1;
+        memcpy(seg->data, data, len);
+    }
+    seg->len = len;
+
+    if (*msg == NULL)
+        *msg = seg;
+    else
+        chanChainBuf_(*msg, seg);
+
+    return 0;
+}
+
+/* reqMsg()
+ * Make the channel message of a request and the data
+ * of postSndFunc. With CALL_SERVER_GIVE_BUF neither is
+ * copied, if the message cannot be made they are left
+ * to the caller.
+ */
+static struct Buffer *
+reqMsg(char *req_buf, int req_size, struct lenData *jf, int flags)
+{
+    struct Buffer *msg;
+    struct Buffer *seg;
+    int give;
+    int nlen;
+
+    give = flags & CALL_SERVER_GIVE_BUF;
+    msg = NULL;
+
+    if (addSeg(&msg, req_buf, req_size, give) < 0)
+        return NULL;
+
+    if (jf) {
+        nlen = htonl(jf->len);
+        if (addSeg(&msg, (char *) NET_INTADDR_(&nlen), NET_INTSIZE_, FALSE) < 0
+            || addSeg(&msg, jf->data, jf->len, give) < 0) {
+            if (give) {
+                for (seg = msg; seg; seg = seg->next)
+                    if (seg->data == req_buf || seg->data == jf->data)
+                        seg->data = NULL;
+            }
+            chanFreeBuf_(msg);
+            return NULL;
+        }
+    }
+
+    return msg;
+}
+
+/* giveBack()
+ * With CALL_SERVER_GIVE_BUF call_server() owns the
+ * request and the data of postSndFunc and frees
+ * them once they are sent or the call failed.
+ */
+static void
+giveBack(char *req_buf, int (*postSndFunc)(), int *postSndFuncArg, int flags)
+{
+    if (!(flags & CALL_SERVER_GIVE_BUF))
+        return;
+
+    FREEUP(req_buf);
+    if (postSndFunc)
+        FREEUP(((struct lenData *)postSndFuncArg)->data);
+}
+
 int
 call_server (char * host,
              ushort serv_port,
@@ -116,9 +198,10 @@ call_server (char * host,
     int cc;
     static char fname[] = "call_server";
     struct Buffer *sndBuf;
-    struct Buffer reqbuf, reqbuf2, replybuf;
+    struct Buffer reqbuf, lenbuf, reqbuf2, replybuf;
     struct Buffer *replyBufPtr;
     int serverSock;
+    int nlen;
 
     if (logclass & LC_COMM)
         ls_syslog (LOG_DEBUG1, "callserver: Entering this routine...");
@@ -127,14 +210,17 @@ call_server (char * host,
     lsberrno = LSBE_NO_ERROR;
 
     if (!(flags & CALL_SERVER_USE_SOCKET)) {
-	if ((serverSock = serv_connect (host, serv_port, conn_timeout)) < 0)
+	if ((serverSock = serv_connect (host, serv_port, conn_timeout)) < 0) {
+	    giveBack(req_buf, postSndFunc, postSndFuncArg, flags);
 	    return(-2);
+	}
     } else {
 	if (connectedSock == NULL) {
 	    ls_syslog(LOG_ERR, _i18n_msg_get(ls_catd , NL_SETN, 5000,
 		      "%s: CALL_SERVER_USE_SOCKET defined, but %s is NULL"),  /* catgets 5000 */
 		      fname, "connectedSock");
 	    lsberrno = LSBE_BAD_ARG;
+	    giveBack(req_buf, postSndFunc, postSndFuncArg, flags);
 	    return (-2);
 	}
 	serverSock = *connectedSock;
@@ -149,6 +235,7 @@ call_server (char * host,
 	    CLOSECD(serverSock);
 	    if (logclass & LC_COMM)
 		ls_syslog (LOG_DEBUG, "%s: handShake_(socket=%d, conn_timeout=%d) failed", fname, serverSock, conn_timeout);
+	    giveBack(req_buf, postSndFunc, postSndFuncArg, flags);
 	    return(-2);
 	}
 
@@ -156,15 +243,24 @@ call_server (char * host,
 	    ls_syslog (LOG_DEBUG1, "%s: handShake_() succeeded", fname);
     }
 
+    /* The request goes out as one message of up to
+     * three segments: the request, the length of the
+     * data of postSndFunc and the data itself.
+     */
     CHAN_INIT_BUF(&reqbuf);
     reqbuf.len = req_size;
     reqbuf.data = req_buf;
 
     if (postSndFunc) {
+       nlen = htonl(((struct lenData *)postSndFuncArg)->len);
+       CHAN_INIT_BUF(&lenbuf);
+       lenbuf.len = NET_INTSIZE_;
+       lenbuf.data = (char *) NET_INTADDR_(&nlen);
        CHAN_INIT_BUF(&reqbuf2);
        reqbuf2.len =  ((struct lenData *)postSndFuncArg)->len;
        reqbuf2.data = ((struct lenData *)postSndFuncArg)->data;
-       reqbuf.forw = &reqbuf2;
+       reqbuf.next = &lenbuf;
+       lenbuf.next = &reqbuf2;
     }
     if (flags & CALL_SERVER_NO_WAIT_REPLY)
        replyBufPtr = NULL;
@@ -172,39 +268,27 @@ call_server (char * host,
        replyBufPtr = &replybuf;
 
     if (flags & CALL_SERVER_ENQUEUE_ONLY) {
-	int tsize = req_size;
 
 	if (logclass & LC_COMM)
 	    ls_syslog(LOG_DEBUG2, "callserver: Enqueue only");
 
 	if (chanSetMode_(serverSock, CHAN_MODE_NONBLOCK) < 0) {
 	    ls_syslog(LOG_ERR, I18N_FUNC_FAIL_MM, "callserver",  "chanSetMode");            CLOSECD(serverSock);
+	    giveBack(req_buf, postSndFunc, postSndFuncArg, flags);
 	    return (-2);
 	}
 
-	if (postSndFunc)
-	    tsize += ((struct lenData *)postSndFuncArg)->len + NET_INTSIZE_;
-
-	if (chanAllocBuf_(&sndBuf, tsize) < 0) {
+	sndBuf = reqMsg(req_buf, req_size,
+			postSndFunc ? (struct lenData *)postSndFuncArg : NULL,
+			flags);
+	if (sndBuf == NULL) {
 	    ls_syslog(LOG_ERR, I18N_FUNC_D_FAIL_M, fname,  "chanAllocBuf_",
-			tsize);
+			req_size);
 	    CLOSECD(serverSock);
+	    giveBack(req_buf, postSndFunc, postSndFuncArg, flags);
 	    return (-2);
 	}
 
-	sndBuf->len = tsize;
-	memcpy((char *) sndBuf->data, (char *) req_buf, req_size);
-
-	if (postSndFunc) {
-	    int nlen = htonl(((struct lenData *)postSndFuncArg)->len);
-
-	    memcpy((char *) sndBuf->data + req_size,
-		   (char *) NET_INTADDR_(&nlen), NET_INTSIZE_);
-	    memcpy((char *) sndBuf->data + req_size + NET_INTSIZE_,
-		   (char *) ((struct lenData *)postSndFuncArg)->data,
-		   ((struct lenData *)postSndFuncArg)->len);
-	}
-
 	if (chanEnqueue_(serverSock, sndBuf) < 0) {
 	    ls_syslog(LOG_ERR, I18N_FUNC_FAIL_ENO_D, fname,
 			"chanEnqueue_", cherrno);
@@ -218,6 +302,7 @@ call_server (char * host,
                       replyBufPtr,
                       replyHdr,
 		      recv_timeout * 1000);
+	giveBack(req_buf, postSndFunc, postSndFuncArg, flags);
 	if ( cc < 0 ) {
 	    lsberrno = LSBE_LSLIB;
 	    CLOSECD(serverSock);
@@ -31,6 +31,22 @@ extern int _lsb_recvtimeout;
 
 static int mbdSock = -1;
 
+/* mbatchd writes many job replies at once, they are
+ * read in large chunks and decoded in place instead
+ * of reading and allocating every reply by itself.
+ */
+#define JOBINFO_READ    (256 * 1024)
+
+static struct {
+    char   *data;
+    int    size;
+    int    pos;
+    int    len;
+} jobInfoBuf;
+
+static int jobInfoFill(int);
+static int readJobInfoPacket(char **, struct LSFHeader *);
+
 int
 lsb_openjobinfo (LS_LONG_INT jobId, char *jobName, char *userName,
                  char *queueName, char *hostName, int options)
@@ -140,8 +156,9 @@ lsb_openjobinfo_a (LS_LONG_INT jobId, char *jobName, char *userName,
         }
 	strcpy(jobInfoReq.userName, userName);
     }
-    if ((options & ~(JOBID_ONLY | JOBID_ONLY_ALL | HOST_NAME | NO_PEND_REASONS)) == 0)
-	jobInfoReq.options = CUR_JOB;
+    if ((options & ~(JOBID_ONLY | JOBID_ONLY_ALL | HOST_NAME
+                     | NO_PEND_REASONS | JOB_BRIEF_INFO)) == 0)
+	jobInfoReq.options = CUR_JOB | (options & JOB_BRIEF_INFO);
     else
         jobInfoReq.options = options;
 
@@ -152,6 +169,8 @@ lsb_openjobinfo_a (LS_LONG_INT jobId, char *jobName, char *userName,
     jobInfoReq.jobId = jobId;
 
 
+    jobInfoBuf.pos = jobInfoBuf.len = 0;
+
     mbdReqtype = BATCH_JOB_INFO;
     xdrmem_create(&xdrs, request_buf, MSGSIZE, XDR_ENCODE);
 
@@ -217,8 +236,7 @@ lsb_readjobinfo(int *more)
     static int *pgid = NULL;
 
 
-    TIMEIT(0, (num = readNextPacket(&buffer, _lsb_recvtimeout, &hdr,
-				    mbdSock)), "readNextPacket");
+    TIMEIT(0, (num = readJobInfoPacket(&buffer, &hdr)), "readJobInfoPacket");
     if (num < 0) {
 	closeSession(mbdSock);
         lsberrno = LSBE_EOF;
@@ -252,7 +270,6 @@ lsb_readjobinfo(int *more)
 	    FREEUP(jobInfoReply.userName);
 	    FREEUP(submitReq.cwd);
 
-	    free(buffer);
 	    return NULL;
 	}
 
@@ -290,14 +307,12 @@ lsb_readjobinfo(int *more)
     if (aa == FALSE) {
 	lsberrno = LSBE_XDR;
 	xdr_destroy(&xdrs);
-	free(buffer);
 	jobInfoReply.toHosts = NULL;
 	jobInfoReply.numToHosts = 0;
 	return NULL;
     }
 
     TIMEIT(1, xdr_destroy(&xdrs), "xdr_destroy");
-    free(buffer);
     jobInfo.jobId = jobInfoReply.jobId;
     jobInfo.status = jobInfoReply.status;
     jobInfo.numReasons = jobInfoReply.numReasons;
@@ -410,6 +425,109 @@ void
 lsb_closejobinfo()
 {
      closeSession(mbdSock);
+     jobInfoBuf.pos = jobInfoBuf.len = 0;
+}
+
+/* jobInfoFill()
+ * Read from mbatchd till there are at least
+ * need unread bytes in the buffer.
+ */
+static int
+jobInfoFill(int need)
+{
+    struct timeval timeout;
+    char *p;
+    int size;
+    int cc;
+
+    if (jobInfoBuf.len - jobInfoBuf.pos >= need)
+        return 0;
+
+    if (jobInfoBuf.pos > 0) {
+        memmove(jobInfoBuf.data, jobInfoBuf.data + jobInfoBuf.pos,
+                jobInfoBuf.len - jobInfoBuf.pos);
+        jobInfoBuf.len -= jobInfoBuf.pos;
+        jobInfoBuf.pos = 0;
+    }
+
+    if (need > jobInfoBuf.size) {
+        size = jobInfoBuf.size > 0 ? jobInfoBuf.size : JOBINFO_READ;
+        while (size < need)
+            size = 2 * size;
+        if ((p = realloc(jobInfoBuf.data, size)) == NULL) {
+            lsberrno = LSBE_NO_MEM;
+            return -1;
+        }
+        jobInfoBuf.data = p;
+        jobInfoBuf.size = size;
+    }
+
+    while (jobInfoBuf.len < need) {
+
+        timeout.tv_sec = _lsb_recvtimeout;
+        timeout.tv_usec = 0;
+        cc = rd_select_(chanSock_(mbdSock),
+                        _lsb_recvtimeout > 0 ? &timeout : NULL);
+        if (cc <= 0) {
+            lsberrno = LSBE_LSLIB;
+            lserrno = cc == 0 ? LSE_TIME_OUT : LSE_SELECT_SYS;
+            return -1;
+        }
+
+        cc = read(chanSock_(mbdSock), jobInfoBuf.data + jobInfoBuf.len,
+                  jobInfoBuf.size - jobInfoBuf.len);
+        if (cc < 0 && errno == EINTR)
+            continue;
+        if (cc <= 0) {
+            lsberrno = LSBE_LSLIB;
+            lserrno = LSE_MSG_SYS;
+            return -1;
+        }
+        jobInfoBuf.len += cc;
+    }
+
+    return 0;
+}
+
+/* readJobInfoPacket()
+ * Like readNextPacket() but the message is left
+ * in the read buffer, valid till the next call.
+ */
+static int
+readJobInfoPacket(char **msgBuf, struct LSFHeader *hdr)
+{
+    XDR xdrs;
+
+    if (mbdSock < 0) {
+        lsberrno = LSBE_CONN_NONEXIST;
+        return -1;
+    }
+
+    if (jobInfoFill(LSF_HEADER_LEN) < 0)
+        return -1;
+
+    xdrmem_create(&xdrs, jobInfoBuf.data + jobInfoBuf.pos,
+                  LSF_HEADER_LEN, XDR_DECODE);
+    if (!xdr_LSFHeader(&xdrs, hdr)) {
+        xdr_destroy(&xdrs);
+        lsberrno = LSBE_XDR;
+        return -1;
+    }
+    xdr_destroy(&xdrs);
+    jobInfoBuf.pos += LSF_HEADER_LEN;
+
+    if (hdr->length == 0 || hdr->length > (1 << 28)) {
+        lsberrno = LSBE_EOF;
+        return -1;
+    }
+
+    if (jobInfoFill(hdr->length) < 0)
+        return -1;
+
+    *msgBuf = jobInfoBuf.data + jobInfoBuf.pos;
+    jobInfoBuf.pos += hdr->length;
+
+    return hdr->reserved;
 }
 
 int
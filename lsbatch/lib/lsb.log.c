@@ -16,6 +16,10 @@
  *
  */
 
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <ctype.h>
+
 #include "lsb.h"
 #include <errno.h>
 
@@ -91,6 +95,10 @@ static int writeJobAttrSet(FILE* , struct jobAttrSetLog*);
 static int readJobAttrSet(char *, struct jobAttrSetLog* );
 
 static void freeLogRec(struct eventRec *);
+static char *readEventLine(FILE *);
+static int eventResync(FILE *, long);
+static size_t eventFrameFind(const char *, size_t, size_t);
+static unsigned int eventCrc(const char *, unsigned int);
 
 struct eventRec * lsbGetNextJobEvent (struct eventLogHandle *, \
                                       int *, int, LS_LONG_INT *, struct jobIdIndexS *);
@@ -99,6 +107,8 @@ static struct eventRec * lsbGetNextJobRecFromFile(FILE *, int *, int, \
 static int checkJobEventAndJobId(char *, int, int,  LS_LONG_INT *);
 static int getEventTypeAndKind(char *, int *);
 static void readEventRecord (char *, struct eventRec *);
+static int parseEventRecord(char *, struct eventRec *);
+static int eventTypeAndKind(char *, int *);
 int lsb_readeventrecord(char *, struct eventRec *);
 #define   EVENT_JOB_RELATED     1
 #define   EVENT_NON_JOB_RELATED 0
@@ -157,6 +167,18 @@ time_t lsb_getAcctFileTime(char * fileName);
 
 float version;
 
+/* Framed event records, the text record preceded by
+ * a header with a magic, the length of the record and
+ * its CRC-32 both in network byte order. Readers detect
+ * torn or corrupted records and can skip a record without
+ * parsing it. The magic cannot start a text record so
+ * framed and text records can be in the same file.
+ */
+#define EVENT_FRAME_HDRLEN  12
+#define EVENT_FRAME_MAXLEN  (64 * 1024 * 1024)
+
+static const unsigned char eventFrameMagic[4] = {0x1e, 'E', 'V', '1'};
+
 
 struct eventLogHandle *
 lsb_openelog (struct eventLogFile *ePtr, int *lineNum)
@@ -272,6 +294,21 @@ lsb_openelog (struct eventLogFile *ePtr, int *lineNum)
             }
             if (fseek (elog_fp, pos, SEEK_SET) != 0)
                 ls_syslog(LOG_ERR, I18N_FUNC_D_FAIL_M, fname, "fseek", pos);
+        } else {
+            struct eventIdx *idx;
+            int recNum;
+
+            /* With an index skip the records
+             * older than the search window.
+             */
+            if ((idx = lsb_openeventidx(eventFile)) != NULL) {
+                recNum = lsb_eventidxtime(idx, ePtr->beginTime);
+                if (recNum > 0
+                    && fseek(elog_fp,
+                             lsb_eventidxoffset(idx, recNum), SEEK_SET) == 0)
+                    *lineNum = recNum;
+                lsb_closeeventidx(idx);
+            }
         }
     } else {
         ls_syslog(LOG_ERR, _i18n_msg_get(ls_catd , NL_SETN, 5505,
@@ -386,7 +423,7 @@ lsb_geteventrec_ex(FILE *log_fp, int *LineNum, char* usedLine)
 
     (*LineNum)++;
 
-    if ((line = getNextLine_(log_fp, FALSE)) == NULL) {
+    if ((line = readEventLine(log_fp)) == NULL) {
         if (lserrno == LSE_NO_MEM) {
             lsberrno = LSBE_NO_MEM;
         } else {
@@ -397,7 +434,7 @@ lsb_geteventrec_ex(FILE *log_fp, int *LineNum, char* usedLine)
 
     while (*line == '#') {
 
-        line = getNextLine_(log_fp, FALSE);
+        line = readEventLine(log_fp);
         if (line == NULL) {
             fclose(log_fp);
             lsberrno = LSBE_EOF;
@@ -474,6 +511,98 @@ lsb_geteventrec_ex(FILE *log_fp, int *LineNum, char* usedLine)
 
 }
 
+/* lsb_geteventline()
+ * Next record line of an event file in either format,
+ * comment lines are skipped. The line is in a static
+ * buffer valid until the next call. Returns NULL with
+ * lsberrno set to LSBE_EOF or LSBE_NO_MEM.
+ */
+char *
+lsb_geteventline(FILE *log_fp)
+{
+    char *line;
+
+    do {
+        if ((line = readEventLine(log_fp)) == NULL) {
+            if (lserrno == LSE_NO_MEM)
+                lsberrno = LSBE_NO_MEM;
+            else
+                lsberrno = LSBE_EOF;
+            return NULL;
+        }
+    } while (*line == '#');
+
+    return line;
+}
+
+/* lsb_parseeventrec()
+ * Parse a record line as read by lsb_geteventline()
+ * into logRec. Unlike lsb_geteventrec() it sets neither
+ * lsberrno nor version so lines can be parsed by several
+ * threads, the caller sets version from logRec->version
+ * when it consumes the record. Returns an LSBE_ code,
+ * logRec must be released by lsb_freeeventrec() even
+ * if the parse failed.
+ */
+int
+lsb_parseeventrec(char *line, struct eventRec *logRec)
+{
+    char etype[MAX_LSB_NAME_LEN];
+    char *namebuf;
+    int eventKind;
+    int tempTimeStamp;
+    int ccount;
+
+    memset(logRec, 0, sizeof(struct eventRec));
+    logRec->type = -1;
+
+    if ((namebuf = malloc(strlen(line) + 1)) == NULL)
+        return LSBE_NO_MEM;
+
+    if ((ccount = stripQStr(line, namebuf)) < 0
+        || strlen(line) == ccount
+        || strlen(namebuf) >= MAX_LSB_NAME_LEN) {
+        free(namebuf);
+        return LSBE_EVENT_FORMAT;
+    }
+    strcpy(etype, namebuf);
+    line += ccount + 1;
+
+    if ((ccount = stripQStr(line, namebuf)) < 0
+        || strlen(line) == ccount
+        || strlen(namebuf) >= MAX_VERSION_LEN
+        || atof(namebuf) <= 0.0) {
+        free(namebuf);
+        return LSBE_EVENT_FORMAT;
+    }
+    strcpy(logRec->version, namebuf);
+    line += ccount + 1;
+    free(namebuf);
+
+    if (sscanf(line, "%d%n", &tempTimeStamp, &ccount) != 1)
+        return LSBE_EVENT_FORMAT;
+    logRec->eventTime = tempTimeStamp;
+    line += ccount + 1;
+
+    if ((logRec->type = eventTypeAndKind(etype, &eventKind)) == -1)
+        return LSBE_UNKNOWN_EVENT;
+
+    return parseEventRecord(line, logRec);
+}
+
+/* lsb_freeeventrec()
+ * Release a record filled by lsb_parseeventrec().
+ */
+void
+lsb_freeeventrec(struct eventRec *logRec)
+{
+    if (logRec == NULL)
+        return;
+
+    freeLogRec(logRec);
+    free(logRec);
+}
+
 static void
 freeLogRec(struct eventRec *logRec)
 {
@@ -1774,6 +1903,745 @@ lsb_puteventrec(FILE *log_fp, struct eventRec *logPtr)
 
 }
 
+/* lsb_puteventrec_bin()
+ * Write the record framed, see readEventLine().
+ */
+int
+lsb_puteventrec_bin(FILE *log_fp, struct eventRec *logPtr)
+{
+    unsigned char hdr[EVENT_FRAME_HDRLEN];
+    unsigned int crc;
+    char *buf;
+    size_t len;
+    FILE *fp;
+    int cc;
+
+    buf = NULL;
+    len = 0;
+    if ((fp = open_memstream(&buf, &len)) == NULL) {
+        lsberrno = LSBE_NO_MEM;
+        return -1;
+    }
+
+    cc = lsb_puteventrec(fp, logPtr);
+    if (fclose(fp) != 0 && cc == 0) {
+        lsberrno = LSBE_NO_MEM;
+        cc = -1;
+    }
+    if (cc < 0) {
+        FREEUP(buf);
+        return -1;
+    }
+
+    crc = eventCrc(buf, len);
+
+    memcpy(hdr, eventFrameMagic, sizeof(eventFrameMagic));
+    hdr[4] = (len >> 24) & 0xff;
+    hdr[5] = (len >> 16) & 0xff;
+    hdr[6] = (len >> 8) & 0xff;
+    hdr[7] = len & 0xff;
+    hdr[8] = (crc >> 24) & 0xff;
+    hdr[9] = (crc >> 16) & 0xff;
+    hdr[10] = (crc >> 8) & 0xff;
+    hdr[11] = crc & 0xff;
+
+    if (fwrite(hdr, EVENT_FRAME_HDRLEN, 1, log_fp) != 1
+        || fwrite(buf, len, 1, log_fp) != 1) {
+        FREEUP(buf);
+        lsberrno = LSBE_SYS_CALL;
+        return -1;
+    }
+
+    FREEUP(buf);
+    return 0;
+}
+
+/* readEventLine()
+ * Get the next record line of an event file, framed
+ * records are checked and returned as the text line
+ * they carry. A torn or corrupted record is skipped up
+ * to the next frame, mbatchd appends after a torn
+ * record it crashed writing.
+ */
+static char *
+readEventLine(FILE *fp)
+{
+    static char *buf;
+    static unsigned int bufSize;
+    unsigned char hdr[EVENT_FRAME_HDRLEN];
+    unsigned int len;
+    unsigned int crc;
+    long start;
+    char *p;
+    int ch;
+
+again:
+    start = ftell(fp);
+    if ((ch = getc(fp)) == EOF) {
+        lserrno = LSE_NO_ERR;
+        return NULL;
+    }
+
+    if (ch != eventFrameMagic[0]) {
+        ungetc(ch, fp);
+        return getNextLine_(fp, FALSE);
+    }
+
+    hdr[0] = ch;
+    if (fread(hdr + 1, EVENT_FRAME_HDRLEN - 1, 1, fp) != 1
+        || memcmp(hdr, eventFrameMagic, sizeof(eventFrameMagic)) != 0)
+        goto bad;
+
+    len = (hdr[4] << 24) | (hdr[5] << 16) | (hdr[6] << 8) | hdr[7];
+    crc = ((unsigned int)hdr[8] << 24) | (hdr[9] << 16)
+        | (hdr[10] << 8) | hdr[11];
+    if (len == 0 || len > EVENT_FRAME_MAXLEN)
+        goto bad;
+
+    if (len + 1 > bufSize) {
+        if ((p = realloc(buf, len + 1)) == NULL) {
+            lserrno = LSE_NO_MEM;
+            return NULL;
+        }
+        buf = p;
+        bufSize = len + 1;
+    }
+
+    if (fread(buf, len, 1, fp) != 1
+        || eventCrc(buf, len) != crc)
+        goto bad;
+
+    while (len > 0 && buf[len - 1] == '\n')
+        --len;
+    buf[len] = 0;
+
+    return buf;
+
+bad:
+    ls_syslog(LOG_ERR, "\
+%s: torn or corrupted event record at offset %ld", __func__, start);
+    if (start >= 0 && eventResync(fp, start + 1) == 0)
+        goto again;
+
+    lserrno = LSE_NO_ERR;
+    return NULL;
+}
+
+/* eventResync()
+ * Position fp at the next frame magic from offset
+ * off. Returns -1 if there is none.
+ */
+static int
+eventResync(FILE *fp, long off)
+{
+    long pos;
+    int n;
+    int ch;
+
+    if (fseek(fp, off, SEEK_SET) < 0)
+        return -1;
+
+    /* pos is the offset of the next byte,
+     * n the bytes of the magic matched.
+     */
+    n = 0;
+    pos = off;
+    while ((ch = getc(fp)) != EOF) {
+        ++pos;
+        if (ch == eventFrameMagic[n])
+            ++n;
+        else
+            n = (ch == eventFrameMagic[0]) ? 1 : 0;
+        if (n < sizeof(eventFrameMagic))
+            continue;
+
+        pos -= n;
+        if (fseek(fp, pos, SEEK_SET) < 0)
+            return -1;
+        ls_syslog(LOG_ERR, "\
+%s: skipped %ld bytes to the event record at offset %ld", __func__,
+                  pos - off + 1, pos);
+        return 0;
+    }
+
+    return -1;
+}
+
+/* eventFrameFind()
+ * Offset of the next frame magic from off in an event
+ * file mapped in memory, size if there is none.
+ */
+static size_t
+eventFrameFind(const char *base, size_t size, size_t off)
+{
+    const char *p;
+
+    while (off + sizeof(eventFrameMagic) <= size) {
+        p = memchr(base + off, eventFrameMagic[0], size - off);
+        if (p == NULL)
+            break;
+        off = p - base;
+        if (off + sizeof(eventFrameMagic) <= size
+            && memcmp(p, eventFrameMagic, sizeof(eventFrameMagic)) == 0)
+            return off;
+        ++off;
+    }
+
+    return size;
+}
+
+/* eventCrc()
+ * CRC-32 as in zlib and ethernet.
+ */
+static unsigned int
+eventCrc(const char *buf, unsigned int len)
+{
+    static unsigned int table[256];
+    unsigned int crc;
+    unsigned int c;
+    int i;
+    int k;
+
+    if (table[1] == 0) {
+        for (i = 0; i < 256; i++) {
+            c = i;
+            for (k = 0; k < 8; k++)
+                c = (c & 1) ? 0xedb88320U ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+
+    crc = 0xffffffffU;
+    while (len-- > 0)
+        crc = table[(crc ^ (unsigned char)*buf++) & 0xff] ^ (crc >> 8);
+
+    return crc ^ 0xffffffffU;
+}
+
+/* Sidecar index of a switched event file, lsb.events.N.idx.
+ * One entry per record in file order with the job id, 0 for
+ * records not about a job, the event time and the offset of
+ * the record, followed by the numbers of the job entries
+ * sorted by job id. The header has the inode and the size
+ * of the event file, an index that does not match the file
+ * it sits next to is ignored and the file is scanned.
+ */
+#define EVENT_IDX_MAGIC  "LSBEIDX1"
+
+struct eventIdxHdr {
+    char magic[8];
+    int hdrSize;
+    int numRecs;
+    int numJobRecs;
+    int pad;
+    long long ino;
+    long long size;
+    long long minTime;
+    long long maxTime;
+};
+
+struct eventIdxRec {
+    int jobId;
+    int eventTime;
+    long long offset;
+};
+
+struct eventIdx {
+    char *base;
+    size_t size;
+    char *idxBase;
+    size_t idxSize;
+    struct eventIdxHdr *hdr;
+    struct eventIdxRec *recs;
+    int *byJob;
+};
+
+/* eventLineAt()
+ * Record line at *off of an event file mapped in memory,
+ * as readEventLine() would return it, *off is moved past
+ * the record and *start set to where it begins. Torn
+ * framed records are skipped as readEventLine() does.
+ * Returns NULL at the end of the file.
+ */
+static char *
+eventLineAt(const char *base, size_t size, size_t *off, size_t *start)
+{
+    static char *buf;
+    static size_t bufSize;
+    const unsigned char *hdr;
+    const char *p;
+    const char *end;
+    size_t len;
+    size_t i;
+    char *q;
+
+    while (*off < size) {
+
+        *start = *off;
+        p = base + *off;
+        if ((unsigned char)*p == eventFrameMagic[0]) {
+            hdr = (const unsigned char *)p;
+            len = 0;
+            if (size - *off >= EVENT_FRAME_HDRLEN
+                && memcmp(hdr, eventFrameMagic, sizeof(eventFrameMagic)) == 0)
+                len = ((size_t)hdr[4] << 24) | (hdr[5] << 16)
+                    | (hdr[6] << 8) | hdr[7];
+            if (len == 0
+                || len > size - *off - EVENT_FRAME_HDRLEN
+                || eventCrc(p + EVENT_FRAME_HDRLEN, len)
+                   != (((unsigned int)hdr[8] << 24) | (hdr[9] << 16)
+                       | (hdr[10] << 8) | hdr[11])) {
+                *off = eventFrameFind(base, size, *off + 1);
+                continue;
+            }
+            p += EVENT_FRAME_HDRLEN;
+            *off += EVENT_FRAME_HDRLEN + len;
+        } else {
+            end = memchr(p, '\n', size - *off);
+            len = end ? end - p : size - *off;
+            *off += len + (end ? 1 : 0);
+        }
+
+        if (len + 1 > bufSize) {
+            if ((q = realloc(buf, len + 1)) == NULL)
+                return NULL;
+            buf = q;
+            bufSize = len + 1;
+        }
+
+        /* Same cleanup as getNextLine_(), white space
+         * becomes blank and trailing blanks go.
+         */
+        for (i = 0; i < len; i++)
+            buf[i] = isspace((unsigned char)p[i]) ? ' ' : p[i];
+        while (len > 0 && buf[len - 1] == ' ')
+            --len;
+        buf[len] = 0;
+
+        if (len > 0)
+            return buf;
+    }
+
+    return NULL;
+}
+
+static int
+cmpIdxJob(const void *x, const void *y)
+{
+    const struct eventIdxRec *a = x;
+    const struct eventIdxRec *b = y;
+
+    if (a->jobId != b->jobId)
+        return a->jobId < b->jobId ? -1 : 1;
+    if (a->offset != b->offset)
+        return a->offset < b->offset ? -1 : 1;
+    return 0;
+}
+
+/* lsb_puteventidx()
+ * Write the sidecar index of eventFile, mbatchd does it
+ * when it switches lsb.events. The index is written
+ * aside and renamed so readers never see half of it.
+ */
+int
+lsb_puteventidx(char *eventFile)
+{
+    struct eventIdxHdr hdr;
+    struct eventIdxRec *recs;
+    struct eventIdxRec *jobs;
+    struct stat st;
+    char idxFile[MAXFILENAMELEN];
+    char tmpFile[MAXFILENAMELEN];
+    char *nameBuf;
+    char *base;
+    char *line;
+    int *byJob;
+    size_t nameBufSize;
+    size_t len;
+    size_t off;
+    size_t off0;
+    int maxRecs;
+    int eventKind;
+    int eventType;
+    int eventTime;
+    int ccount;
+    int fd;
+    int i;
+    FILE *fp;
+
+    if (snprintf(idxFile, MAXFILENAMELEN, "%s%s",
+                 eventFile, LSF_EVENTIDX_SUFFIX) >= MAXFILENAMELEN
+        || snprintf(tmpFile, MAXFILENAMELEN, "%s.%d",
+                    idxFile, (int)getpid()) >= MAXFILENAMELEN) {
+        errno = ENAMETOOLONG;
+        lsberrno = LSBE_SYS_CALL;
+        return -1;
+    }
+
+    if ((fd = open(eventFile, O_RDONLY)) < 0) {
+        lsberrno = LSBE_SYS_CALL;
+        return -1;
+    }
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        lsberrno = LSBE_SYS_CALL;
+        return -1;
+    }
+
+    base = NULL;
+    if (st.st_size > 0) {
+        base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            lsberrno = LSBE_SYS_CALL;
+            return -1;
+        }
+    }
+    close(fd);
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, EVENT_IDX_MAGIC, sizeof(hdr.magic));
+    hdr.hdrSize = sizeof(hdr);
+    hdr.ino = st.st_ino;
+    hdr.size = st.st_size;
+
+    nameBuf = NULL;
+    nameBufSize = 0;
+    maxRecs = 1024;
+    recs = malloc(maxRecs * sizeof(struct eventIdxRec));
+    if (recs == NULL)
+        goto nomem;
+
+    off = 0;
+    while (TRUE) {
+
+        if ((line = eventLineAt(base, st.st_size, &off, &off0)) == NULL)
+            break;
+        if (*line == '#')
+            continue;
+
+        /* The quoted words are as long as the line
+         * at most, whatever the file has in it.
+         */
+        len = strlen(line) + 1;
+        if (len > nameBufSize) {
+            char *p;
+
+            p = realloc(nameBuf, len);
+            if (p == NULL)
+                goto nomem;
+            nameBuf = p;
+            nameBufSize = len;
+        }
+
+        if ((ccount = stripQStr(line, nameBuf)) < 0
+            || strlen(line) == ccount
+            || strlen(nameBuf) >= MAX_LSB_NAME_LEN)
+            continue;
+        line += ccount + 1;
+        if ((eventType = eventTypeAndKind(nameBuf, &eventKind)) == -1)
+            continue;
+
+        if ((ccount = stripQStr(line, nameBuf)) < 0
+            || strlen(line) == ccount)
+            continue;
+        line += ccount + 1;
+        if (sscanf(line, "%d%n", &eventTime, &ccount) != 1)
+            continue;
+        line += ccount + 1;
+
+        if (hdr.numRecs == maxRecs) {
+            struct eventIdxRec *p;
+
+            maxRecs *= 2;
+            p = realloc(recs, maxRecs * sizeof(struct eventIdxRec));
+            if (p == NULL)
+                goto nomem;
+            recs = p;
+        }
+
+        recs[hdr.numRecs].jobId = 0;
+        if (eventKind == EVENT_JOB_RELATED) {
+            recs[hdr.numRecs].jobId = getJobIdFromEvent(line, eventType);
+            if (recs[hdr.numRecs].jobId > 0)
+                hdr.numJobRecs++;
+        }
+        recs[hdr.numRecs].eventTime = eventTime;
+        recs[hdr.numRecs].offset = off0;
+
+        if (hdr.numRecs == 0 || eventTime < hdr.minTime)
+            hdr.minTime = eventTime;
+        if (hdr.numRecs == 0 || eventTime > hdr.maxTime)
+            hdr.maxTime = eventTime;
+        hdr.numRecs++;
+    }
+
+    if (base)
+        munmap(base, st.st_size);
+    base = NULL;
+    FREEUP(nameBuf);
+
+    /* Sort the job records by job id then offset,
+     * the offset gives back the entry number.
+     */
+    jobs = malloc((hdr.numJobRecs + 1) * sizeof(struct eventIdxRec));
+    byJob = malloc((hdr.numJobRecs + 1) * sizeof(int));
+    if (jobs == NULL || byJob == NULL) {
+        FREEUP(jobs);
+        FREEUP(byJob);
+        goto nomem;
+    }
+    for (i = 0, ccount = 0; i < hdr.numRecs; i++) {
+        /* eventTime carries the entry number
+         * while sorting.
+         */
+        if (recs[i].jobId > 0) {
+            jobs[ccount] = recs[i];
+            jobs[ccount].eventTime = i;
+            ccount++;
+        }
+    }
+    qsort(jobs, hdr.numJobRecs, sizeof(struct eventIdxRec), cmpIdxJob);
+    for (i = 0; i < hdr.numJobRecs; i++)
+        byJob[i] = jobs[i].eventTime;
+    free(jobs);
+
+    if ((fp = fopen(tmpFile, "w")) == NULL) {
+        free(recs);
+        free(byJob);
+        lsberrno = LSBE_SYS_CALL;
+        return -1;
+    }
+    fchmod(fileno(fp), 0644);
+
+    if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1
+        || (hdr.numRecs > 0
+            && fwrite(recs, sizeof(struct eventIdxRec), hdr.numRecs, fp)
+            != hdr.numRecs)
+        || (hdr.numJobRecs > 0
+            && fwrite(byJob, sizeof(int), hdr.numJobRecs, fp)
+            != hdr.numJobRecs)
+        || fclose(fp) != 0
+        || rename(tmpFile, idxFile) < 0) {
+        unlink(tmpFile);
+        free(recs);
+        free(byJob);
+        lsberrno = LSBE_SYS_CALL;
+        return -1;
+    }
+
+    free(recs);
+    free(byJob);
+
+    return 0;
+
+nomem:
+    if (base)
+        munmap(base, st.st_size);
+    FREEUP(nameBuf);
+    FREEUP(recs);
+    lsberrno = LSBE_NO_MEM;
+    return -1;
+}
+
+/* lsb_openeventidx()
+ * Map eventFile and its sidecar index. Returns NULL if
+ * there is no index or it does not match the file.
+ */
+struct eventIdx *
+lsb_openeventidx(char *eventFile)
+{
+    struct eventIdx *idx;
+    struct eventIdxHdr *hdr;
+    struct stat st;
+    struct stat ist;
+    char idxFile[MAXFILENAMELEN];
+    size_t need;
+    int fd;
+    int ifd;
+
+    if (snprintf(idxFile, MAXFILENAMELEN, "%s%s",
+                 eventFile, LSF_EVENTIDX_SUFFIX) >= MAXFILENAMELEN)
+        return NULL;
+
+    if ((ifd = open(idxFile, O_RDONLY)) < 0)
+        return NULL;
+    if ((fd = open(eventFile, O_RDONLY)) < 0) {
+        close(ifd);
+        return NULL;
+    }
+
+    if (fstat(fd, &st) < 0
+        || fstat(ifd, &ist) < 0
+        || ist.st_size < sizeof(struct eventIdxHdr)
+        || st.st_size == 0
+        || (idx = calloc(1, sizeof(struct eventIdx))) == NULL) {
+        close(fd);
+        close(ifd);
+        return NULL;
+    }
+
+    idx->idxSize = ist.st_size;
+    idx->idxBase = mmap(NULL, idx->idxSize, PROT_READ, MAP_SHARED, ifd, 0);
+    idx->size = st.st_size;
+    idx->base = mmap(NULL, idx->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    close(ifd);
+
+    if (idx->idxBase == MAP_FAILED || idx->base == MAP_FAILED)
+        goto bad;
+
+    hdr = (struct eventIdxHdr *)idx->idxBase;
+    need = sizeof(struct eventIdxHdr)
+        + (size_t)hdr->numRecs * sizeof(struct eventIdxRec)
+        + (size_t)hdr->numJobRecs * sizeof(int);
+    if (memcmp(hdr->magic, EVENT_IDX_MAGIC, sizeof(hdr->magic)) != 0
+        || hdr->hdrSize != sizeof(struct eventIdxHdr)
+        || hdr->numRecs < 0
+        || hdr->numJobRecs < 0
+        || hdr->numJobRecs > hdr->numRecs
+        || need != idx->idxSize
+        || hdr->ino != (long long)st.st_ino
+        || hdr->size != (long long)st.st_size)
+        goto bad;
+
+    idx->hdr = hdr;
+    idx->recs = (struct eventIdxRec *)(hdr + 1);
+    idx->byJob = (int *)(idx->recs + hdr->numRecs);
+
+    return idx;
+
+bad:
+    if (idx->idxBase != MAP_FAILED)
+        munmap(idx->idxBase, idx->idxSize);
+    if (idx->base != MAP_FAILED)
+        munmap(idx->base, idx->size);
+    free(idx);
+    return NULL;
+}
+
+void
+lsb_closeeventidx(struct eventIdx *idx)
+{
+    if (idx == NULL)
+        return;
+
+    munmap(idx->idxBase, idx->idxSize);
+    munmap(idx->base, idx->size);
+    free(idx);
+}
+
+/* lsb_eventidxjob()
+ * Point *recNums at the numbers of the records of jobId,
+ * in file order, and return how many there are.
+ */
+int
+lsb_eventidxjob(struct eventIdx *idx, int jobId, int **recNums)
+{
+    int lo;
+    int hi;
+    int mid;
+    int first;
+
+    lo = 0;
+    hi = idx->hdr->numJobRecs;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (idx->recs[idx->byJob[mid]].jobId < jobId)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    first = lo;
+    hi = idx->hdr->numJobRecs;
+    while (lo < hi && idx->recs[idx->byJob[lo]].jobId == jobId)
+        lo++;
+
+    *recNums = idx->byJob + first;
+
+    return lo - first;
+}
+
+/* lsb_eventidxtime()
+ * Number of the first record with eventTime >= beginTime,
+ * all the records before it are older and a reader looking
+ * at a time window can start there.
+ */
+int
+lsb_eventidxtime(struct eventIdx *idx, time_t beginTime)
+{
+    int i;
+
+    if (idx->hdr->maxTime < beginTime)
+        return idx->hdr->numRecs;
+
+    for (i = 0; i < idx->hdr->numRecs; i++)
+        if (idx->recs[i].eventTime >= beginTime)
+            break;
+
+    return i;
+}
+
+/* lsb_geteventidxrec()
+ * Parse record number recNum of the indexed file, the
+ * record is valid until the next call as with
+ * lsb_geteventrec().
+ */
+struct eventRec *
+lsb_geteventidxrec(struct eventIdx *idx, int recNum)
+{
+    static struct eventRec *logRec;
+    size_t off;
+    size_t start;
+    char *line;
+    int cc;
+
+    if (logRec != NULL) {
+        freeLogRec(logRec);
+        free(logRec);
+        logRec = NULL;
+    }
+
+    if (recNum < 0 || recNum >= idx->hdr->numRecs) {
+        lsberrno = LSBE_EOF;
+        return NULL;
+    }
+
+    off = idx->recs[recNum].offset;
+    if ((line = eventLineAt(idx->base, idx->size, &off, &start)) == NULL) {
+        lsberrno = LSBE_EVENT_FORMAT;
+        return NULL;
+    }
+
+    if ((logRec = calloc(1, sizeof(struct eventRec))) == NULL) {
+        lsberrno = LSBE_NO_MEM;
+        return NULL;
+    }
+
+    if ((cc = lsb_parseeventrec(line, logRec)) != LSBE_NO_ERROR) {
+        lsberrno = cc;
+        return NULL;
+    }
+
+    version = atof(logRec->version);
+    lsberrno = LSBE_NO_ERROR;
+
+    return logRec;
+}
+
+/* lsb_eventidxoffset()
+ * Offset in the event file of record number recNum.
+ */
+long
+lsb_eventidxoffset(struct eventIdx *idx, int recNum)
+{
+    if (recNum >= idx->hdr->numRecs)
+        return idx->size;
+
+    return idx->recs[recNum].offset;
+}
+
 static int
 writeJobNew(FILE *log_fp, struct jobNewLog *jobNewLog)
 {
@@ -2990,7 +3858,7 @@ lsbGetNextJobRecFromFile(FILE *logFp, int *lineNum,
     while(TRUE) {
         (*lineNum)++;
 
-        if ((line = getNextLine_(logFp, FALSE)) == NULL) {
+        if ((line = readEventLine(logFp)) == NULL) {
             if (lserrno == LSE_NO_MEM) {
                 lsberrno = LSBE_NO_MEM;
             } else {
@@ -3135,6 +4003,17 @@ getEventTypeAndKind(char *typeStr, int *eventKind)
 {
     int eventType;
 
+    if ((eventType = eventTypeAndKind(typeStr, eventKind)) == -1)
+        lsberrno = LSBE_UNKNOWN_EVENT;
+
+    return eventType;
+}
+
+static int
+eventTypeAndKind(char *typeStr, int *eventKind)
+{
+    int eventType;
+
     if (strcmp(typeStr, "JOB_NEW") == 0)
         eventType = EVENT_JOB_NEW;
     else if (strcmp(typeStr, "JOB_START") == 0)
@@ -3196,7 +4075,6 @@ getEventTypeAndKind(char *typeStr, int *eventKind)
     else if (strcmp(typeStr, "LOG_SWITCH") == 0)
         eventType = EVENT_LOG_SWITCH;
     else {
-        lsberrno = LSBE_UNKNOWN_EVENT;
         *eventKind = EVENT_NON_JOB_RELATED;
         return (-1);
     }
@@ -3306,96 +4184,109 @@ lsb_readeventrecord(char *line, struct eventRec *logRec)
 void
 readEventRecord (char *line, struct eventRec *logRec)
 {
+    lsberrno = parseEventRecord(line, logRec);
+}
+
+/* parseEventRecord()
+ * Parse the body of a record whose header has been read
+ * into logRec, returns an LSBE_ code and does not touch
+ * any global so it can run in several threads.
+ */
+static int
+parseEventRecord(char *line, struct eventRec *logRec)
+{
+    int cc;
 
+    cc = LSBE_NO_ERROR;
     switch (logRec->type) {
         case EVENT_JOB_NEW:
         case EVENT_JOB_MODIFY:
-            lsberrno = readJobNew(line, &(logRec->eventLog.jobNewLog));
+            cc = readJobNew(line, &(logRec->eventLog.jobNewLog));
             break;
         case EVENT_JOB_MODIFY2:
-            lsberrno = readJobMod(line, &(logRec->eventLog.jobModLog));
+            cc = readJobMod(line, &(logRec->eventLog.jobModLog));
             break;
         case EVENT_PRE_EXEC_START:
         case EVENT_JOB_START:
-            lsberrno = readJobStart(line, &(logRec->eventLog.jobStartLog));
+            cc = readJobStart(line, &(logRec->eventLog.jobStartLog));
             break;
         case EVENT_JOB_START_ACCEPT:
-            lsberrno = readJobStartAccept(line,
+            cc = readJobStartAccept(line,
                                           &(logRec->eventLog.jobStartAcceptLog));
             break;
         case EVENT_JOB_STATUS:
-            lsberrno = readJobStatus(line, &(logRec->eventLog.jobStatusLog));
+            cc = readJobStatus(line, &(logRec->eventLog.jobStatusLog));
             break;
         case EVENT_SBD_JOB_STATUS:
-            lsberrno = readSbdJobStatus(line, &(logRec->eventLog.sbdJobStatusLog));
+            cc = readSbdJobStatus(line, &(logRec->eventLog.sbdJobStatusLog));
             break;
         case EVENT_JOB_SWITCH:
-            lsberrno = readJobSwitch(line, &(logRec->eventLog.jobSwitchLog));
+            cc = readJobSwitch(line, &(logRec->eventLog.jobSwitchLog));
             break;
         case EVENT_JOB_MOVE:
-            lsberrno = readJobMove(line, &(logRec->eventLog.jobMoveLog));
+            cc = readJobMove(line, &(logRec->eventLog.jobMoveLog));
             break;
         case EVENT_QUEUE_CTRL:
-            lsberrno = readQueueCtrl(line, &(logRec->eventLog.queueCtrlLog));
+            cc = readQueueCtrl(line, &(logRec->eventLog.queueCtrlLog));
             break;
         case EVENT_HOST_CTRL:
-            lsberrno = readHostCtrl(line, &(logRec->eventLog.hostCtrlLog));
+            cc = readHostCtrl(line, &(logRec->eventLog.hostCtrlLog));
             break;
         case EVENT_MBD_START:
-            lsberrno = readMbdStart(line, &(logRec->eventLog.mbdStartLog));
+            cc = readMbdStart(line, &(logRec->eventLog.mbdStartLog));
             break;
         case EVENT_MBD_DIE:
-            lsberrno = readMbdDie (line, &(logRec->eventLog.mbdDieLog));
+            cc = readMbdDie (line, &(logRec->eventLog.mbdDieLog));
             break;
         case EVENT_MBD_UNFULFILL:
-            lsberrno = readUnfulfill (line, &(logRec->eventLog.unfulfillLog));
+            cc = readUnfulfill (line, &(logRec->eventLog.unfulfillLog));
             break;
         case EVENT_LOAD_INDEX:
-            lsberrno = readLoadIndex (line, &(logRec->eventLog.loadIndexLog));
+            cc = readLoadIndex (line, &(logRec->eventLog.loadIndexLog));
             break;
         case EVENT_JOB_FINISH:
-            lsberrno = readJobFinish(line, &(logRec->eventLog.jobFinishLog),
-                                     logRec->eventTime);
+            cc = readJobFinish(line, &(logRec->eventLog.jobFinishLog),
+                               logRec->eventTime);
             break;
         case EVENT_CHKPNT:
-            lsberrno = readChkpnt(line, &(logRec->eventLog.chkpntLog));
+            cc = readChkpnt(line, &(logRec->eventLog.chkpntLog));
             break;
         case EVENT_MIG:
-            lsberrno = readMig(line, &(logRec->eventLog.migLog));
+            cc = readMig(line, &(logRec->eventLog.migLog));
             break;
         case EVENT_JOB_ATTR_SET:
-            lsberrno = readJobAttrSet(line, &(logRec->eventLog.jobAttrSetLog));
+            cc = readJobAttrSet(line, &(logRec->eventLog.jobAttrSetLog));
             break;
         case EVENT_JOB_SIGNAL:
-            lsberrno = readJobSignal(line, &(logRec->eventLog.signalLog));
+            cc = readJobSignal(line, &(logRec->eventLog.signalLog));
             break;
         case EVENT_JOB_EXECUTE:
-            lsberrno = readJobExecute(line, &(logRec->eventLog.jobExecuteLog));
+            cc = readJobExecute(line, &(logRec->eventLog.jobExecuteLog));
             break;
         case EVENT_JOB_MSG:
-            lsberrno = readJobMsg(line, &(logRec->eventLog.jobMsgLog));
+            cc = readJobMsg(line, &(logRec->eventLog.jobMsgLog));
             break;
         case EVENT_JOB_MSG_ACK:
-            lsberrno = readJobMsgAck(line, &(logRec->eventLog.jobMsgAckLog));
+            cc = readJobMsgAck(line, &(logRec->eventLog.jobMsgAckLog));
             break;
         case EVENT_JOB_SIGACT:
-            lsberrno = readJobSigAct(line, &(logRec->eventLog.sigactLog));
+            cc = readJobSigAct(line, &(logRec->eventLog.sigactLog));
             break;
         case EVENT_JOB_REQUEUE:
-            lsberrno = readJobRequeue(line, &(logRec->eventLog.jobRequeueLog));
+            cc = readJobRequeue(line, &(logRec->eventLog.jobRequeueLog));
             break;
         case EVENT_JOB_CLEAN:
-            lsberrno = readJobClean(line, &(logRec->eventLog.jobCleanLog));
+            cc = readJobClean(line, &(logRec->eventLog.jobCleanLog));
             break;
         case EVENT_JOB_FORCE:
-            lsberrno = readJobForce(line, &(logRec->eventLog.jobForceRequestLog));
+            cc = readJobForce(line, &(logRec->eventLog.jobForceRequestLog));
             break;
         case EVENT_LOG_SWITCH:
-            lsberrno = readLogSwitch(line, &(logRec->eventLog.logSwitchLog));
+            cc = readLogSwitch(line, &(logRec->eventLog.logSwitchLog));
             break;
     }
 
-    return;
+    return cc;
 }
 
 int
@@ -3436,7 +4327,7 @@ getJobIdIndexFromEventFile (char *eventFile, struct sortIntList *header,
 
     while(TRUE) {
 
-        if ((line = getNextLine_(eventFp, FALSE)) == NULL) {
+        if ((line = readEventLine(eventFp)) == NULL) {
             if (lserrno == LSE_NO_MEM) {
                 lsberrno = LSBE_NO_MEM;
             } else {
@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+
+#include <pthread.h>
+#include <stdio_ext.h>
+
+#include "lsb.h"
+
+/* Replay of an event file with the parsing of the
+ * records spread over threads. The caller thread reads
+ * lines into a ring of batches, the threads parse the
+ * batches and the caller hands the records to the apply
+ * function strictly in file order, so the apply function
+ * sees exactly what a lsb_geteventrec() loop would see
+ * and does not need to be thread safe.
+ */
+#define REPLAY_BATCH       256
+#define REPLAY_SLOTS       4      /* batches per thread */
+
+enum replayState {
+    REPLAY_FREE,
+    REPLAY_FILLED,
+    REPLAY_PARSED
+};
+
+struct replayBatch {
+    enum replayState state;
+    int num;
+    char *buf;
+    size_t bufLen;
+    size_t bufSize;
+    size_t off[REPLAY_BATCH];
+    struct eventRec *recs[REPLAY_BATCH];
+    int errs[REPLAY_BATCH];
+};
+
+struct replayRing {
+    pthread_mutex_t mtx;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    struct replayBatch *slots;
+    int numSlots;
+    int filled;       /* batches handed to the threads */
+    int taken;        /* batches taken by the threads */
+    int quit;
+};
+
+extern float version;
+
+static void *replayThread(void *);
+static void parseBatch(struct replayBatch *);
+static int fillBatch(FILE *, struct replayBatch *);
+static int applyBatch(struct replayBatch *, int *,
+                      int (*)(struct eventRec *, int, void *), void *);
+static void freeBatch(struct replayBatch *);
+
+/* lsb_replayevents()
+ * Read the records of log_fp and call func(logRec, lineNum, arg)
+ * for each of them in file order, with version set from the
+ * record. A record that cannot be parsed is passed as NULL
+ * with lsberrno telling why. The record is released when func
+ * returns, func returning < 0 stops the replay. With numThreads
+ * 0 the records are parsed by the caller. Returns the number of records or -1
+ * with lsberrno set.
+ */
+int
+lsb_replayevents(FILE *log_fp, int numThreads, int *lineNum,
+                 int (*func)(struct eventRec *, int, void *), void *arg)
+{
+    struct replayRing ring;
+    struct replayBatch *b;
+    pthread_t *tids;
+    int numRecs;
+    int locking;
+    int applied;
+    int eof;
+    int cc;
+    int i;
+
+    if (numThreads <= 0) {
+        struct replayBatch one;
+
+        memset(&one, 0, sizeof(one));
+        numRecs = 0;
+        while ((cc = fillBatch(log_fp, &one)) > 0) {
+            parseBatch(&one);
+            numRecs += one.num;
+            if (applyBatch(&one, lineNum, func, arg) < 0) {
+                numRecs = -1;
+                break;
+            }
+        }
+        freeBatch(&one);
+        if (cc < 0)
+            return -1;
+        return numRecs;
+    }
+
+    memset(&ring, 0, sizeof(ring));
+    ring.numSlots = numThreads * REPLAY_SLOTS;
+    ring.slots = calloc(ring.numSlots, sizeof(struct replayBatch));
+    tids = calloc(numThreads, sizeof(pthread_t));
+    if (ring.slots == NULL || tids == NULL) {
+        FREEUP(ring.slots);
+        FREEUP(tids);
+        lsberrno = LSBE_NO_MEM;
+        return -1;
+    }
+
+    /* Only this thread reads log_fp, spare the stdio
+     * lock getc() takes once the process has threads.
+     */
+    locking = __fsetlocking(log_fp, FSETLOCKING_BYCALLER);
+
+    pthread_mutex_init(&ring.mtx, NULL);
+    pthread_cond_init(&ring.work, NULL);
+    pthread_cond_init(&ring.done, NULL);
+
+    for (i = 0; i < numThreads; i++) {
+        if (pthread_create(&tids[i], NULL, replayThread, &ring) != 0) {
+            ls_syslog(LOG_ERR, "\
+%s: pthread_create() failed %m, replaying with %d threads",
+                      __func__, i);
+            break;
+        }
+    }
+    numThreads = i;
+
+    numRecs = 0;
+    applied = 0;
+    eof = FALSE;
+    cc = 0;
+
+    while (!eof || applied < ring.filled) {
+
+        /* Keep the threads fed as long as there
+         * is a free batch, then apply the oldest
+         * batch once it is parsed.
+         */
+        if (!eof && ring.filled - applied < ring.numSlots) {
+
+            b = &ring.slots[ring.filled % ring.numSlots];
+            if ((cc = fillBatch(log_fp, b)) <= 0) {
+                eof = TRUE;
+                continue;
+            }
+            if (numThreads == 0)
+                parseBatch(b);
+
+            pthread_mutex_lock(&ring.mtx);
+            b->state = numThreads == 0 ? REPLAY_PARSED : REPLAY_FILLED;
+            ring.filled++;
+            pthread_cond_signal(&ring.work);
+            pthread_mutex_unlock(&ring.mtx);
+
+            if (b->num < REPLAY_BATCH)
+                eof = TRUE;
+        }
+
+        b = &ring.slots[applied % ring.numSlots];
+
+        pthread_mutex_lock(&ring.mtx);
+        if (b->state != REPLAY_PARSED
+            && !eof
+            && ring.filled - applied < ring.numSlots) {
+            pthread_mutex_unlock(&ring.mtx);
+            continue;
+        }
+        while (b->state != REPLAY_PARSED)
+            pthread_cond_wait(&ring.done, &ring.mtx);
+        pthread_mutex_unlock(&ring.mtx);
+
+        numRecs += b->num;
+        if (applyBatch(b, lineNum, func, arg) < 0) {
+            numRecs = -1;
+            break;
+        }
+        b->state = REPLAY_FREE;
+        applied++;
+    }
+
+    pthread_mutex_lock(&ring.mtx);
+    ring.quit = TRUE;
+    pthread_cond_broadcast(&ring.work);
+    pthread_mutex_unlock(&ring.mtx);
+
+    for (i = 0; i < numThreads; i++)
+        pthread_join(tids[i], NULL);
+
+    for (i = 0; i < ring.numSlots; i++)
+        freeBatch(&ring.slots[i]);
+
+    pthread_mutex_destroy(&ring.mtx);
+    pthread_cond_destroy(&ring.work);
+    pthread_cond_destroy(&ring.done);
+    free(ring.slots);
+    free(tids);
+    __fsetlocking(log_fp, locking);
+
+    if (cc < 0)
+        return -1;
+
+    return numRecs;
+}
+
+/* replayThread()
+ * Parse the batches in the order they are filled,
+ * which is also the order they will be applied.
+ */
+static void *
+replayThread(void *arg)
+{
+    struct replayRing *ring;
+    struct replayBatch *b;
+
+    ring = arg;
+
+    pthread_mutex_lock(&ring->mtx);
+    while (1) {
+
+        while (!ring->quit && ring->taken == ring->filled)
+            pthread_cond_wait(&ring->work, &ring->mtx);
+        if (ring->taken == ring->filled)
+            break;
+
+        b = &ring->slots[ring->taken % ring->numSlots];
+        ring->taken++;
+        pthread_mutex_unlock(&ring->mtx);
+
+        parseBatch(b);
+
+        pthread_mutex_lock(&ring->mtx);
+        b->state = REPLAY_PARSED;
+        pthread_cond_broadcast(&ring->done);
+    }
+    pthread_mutex_unlock(&ring->mtx);
+
+    return NULL;
+}
+
+/* fillBatch()
+ * Copy up to REPLAY_BATCH record lines into the batch.
+ * Returns the number of lines, 0 at the end of the
+ * file and -1 with lsberrno set.
+ */
+static int
+fillBatch(FILE *log_fp, struct replayBatch *b)
+{
+    char *line;
+    size_t len;
+    char *p;
+
+    b->num = 0;
+    b->bufLen = 0;
+
+    while (b->num < REPLAY_BATCH) {
+
+        if ((line = lsb_geteventline(log_fp)) == NULL) {
+            if (lsberrno == LSBE_NO_MEM)
+                return -1;
+            break;
+        }
+
+        len = strlen(line) + 1;
+        if (b->bufLen + len > b->bufSize) {
+            size_t size;
+
+            size = b->bufSize ? b->bufSize : 64 * 1024;
+            while (size < b->bufLen + len)
+                size *= 2;
+            if ((p = realloc(b->buf, size)) == NULL) {
+                lsberrno = LSBE_NO_MEM;
+                return -1;
+            }
+            b->buf = p;
+            b->bufSize = size;
+        }
+
+        memcpy(b->buf + b->bufLen, line, len);
+        b->off[b->num] = b->bufLen;
+        b->bufLen += len;
+        b->num++;
+    }
+
+    return b->num;
+}
+
+static void
+parseBatch(struct replayBatch *b)
+{
+    int i;
+
+    for (i = 0; i < b->num; i++) {
+        b->recs[i] = calloc(1, sizeof(struct eventRec));
+        if (b->recs[i] == NULL) {
+            b->errs[i] = LSBE_NO_MEM;
+            continue;
+        }
+        b->errs[i] = lsb_parseeventrec(b->buf + b->off[i], b->recs[i]);
+    }
+}
+
+/* applyBatch()
+ * Hand the parsed records to func in order,
+ * in the caller thread.
+ */
+static int
+applyBatch(struct replayBatch *b, int *lineNum,
+           int (*func)(struct eventRec *, int, void *), void *arg)
+{
+    int cc;
+    int i;
+
+    cc = 0;
+    for (i = 0; i < b->num; i++) {
+
+        (*lineNum)++;
+
+        if (cc < 0) {
+            lsb_freeeventrec(b->recs[i]);
+            b->recs[i] = NULL;
+            continue;
+        }
+
+        if (b->errs[i] != LSBE_NO_ERROR) {
+            lsberrno = b->errs[i];
+            cc = (*func)(NULL, *lineNum, arg);
+        } else {
+            lsberrno = LSBE_NO_ERROR;
+            version = atof(b->recs[i]->version);
+            cc = (*func)(b->recs[i], *lineNum, arg);
+        }
+
+        lsb_freeeventrec(b->recs[i]);
+        b->recs[i] = NULL;
+    }
+
+    b->num = 0;
+
+    return cc;
+}
+
+static void
+freeBatch(struct replayBatch *b)
+{
+    int i;
+
+    for (i = 0; i < b->num; i++)
+        lsb_freeeventrec(b->recs[i]);
+    FREEUP(b->buf);
+    b->num = 0;
+    b->bufLen = 0;
+    b->bufSize = 0;
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#if _REPLAY_TEST_
+
+/* Benchmark of lsb_replayevents(), build in the build tree with:
+ *
+ * gcc -D_REPLAY_TEST_=1 -O2 -I../.. -I../../lsf -I.. \
+ *     -I/usr/include/tirpc -DHAVE_CONFIG_H testreplay.c liblsbatch.a \
+ *     ../../lsf/lib/liblsf.a ../../lsf/intlib/liblsfint.a \
+ *     -lpthread -lnsl -ltirpc -lm -o testreplay
+ *
+ * and run as testreplay lsb.events [maxThreads]. It reports
+ * the events/sec of lsb_geteventrec() and of the replay with
+ * 0, 1, 2, 4... parsing threads. The apply function only
+ * counts so this is the read and parse rate of mbatchd
+ * at startup.
+ *
+ * Run as testreplay -t file it writes to file framed records
+ * with a torn record and a corrupted one among them, as left
+ * by an mbatchd that crashed writing and appended after the
+ * restart, and checks that lsb_geteventrec(), the replay and
+ * the index all get every good record in order.
+ */
+#include <sys/time.h>
+#include "lsb.h"
+
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_usec - t0->tv_usec) / 1e6;
+}
+
+static int
+countRec(struct eventRec *rec, int lineNum, void *arg)
+{
+    int *count;
+
+    count = arg;
+    if (rec != NULL)
+        ++(*count);
+
+    return 0;
+}
+
+#define TORN_NREC  8
+
+/* putRec()
+ * Write the framed LOG_SWITCH record of jobId, keep
+ * only len bytes of it if len >= 0, flip one bit of
+ * its last byte if corrupt.
+ */
+static void
+putRec(FILE *fp, int jobId, long len, int corrupt)
+{
+    struct eventRec rec;
+    char *buf;
+    size_t size;
+    FILE *mp;
+
+    memset(&rec, 0, sizeof(rec));
+    sprintf(rec.version, "%d", OPENLAVA_VERSION);
+    rec.type = EVENT_LOG_SWITCH;
+    rec.eventTime = 1000 + jobId;
+    rec.eventLog.logSwitchLog.lastJobId = jobId;
+
+    buf = NULL;
+    mp = open_memstream(&buf, &size);
+    if (mp == NULL || lsb_puteventrec_bin(mp, &rec) < 0) {
+        fprintf(stderr, "lsb_puteventrec_bin: %s\n", lsb_sysmsg());
+        exit(-1);
+    }
+    fclose(mp);
+
+    if (len >= 0 && len < size)
+        size = len;
+    if (corrupt)
+        buf[size - 1] ^= 1;
+    fwrite(buf, size, 1, fp);
+    free(buf);
+}
+
+static int
+nextJobId(struct eventRec *rec, int *want, char *what)
+{
+    if (rec->eventLog.logSwitchLog.lastJobId != *want) {
+        printf("%s: got record %d wanted %d\n", what,
+               rec->eventLog.logSwitchLog.lastJobId, *want);
+        return 1;
+    }
+    ++(*want);
+    return 0;
+}
+
+static int
+checkRec(struct eventRec *rec, int lineNum, void *arg)
+{
+    int *want;
+
+    want = arg;
+    if (rec != NULL && nextJobId(rec, &want[0], "replay"))
+        ++want[1];
+
+    return 0;
+}
+
+/* tornTest()
+ * Records 1..3, torn 100, 4..6, corrupted 101, 7..8.
+ */
+static int
+tornTest(char *file)
+{
+    struct eventRec *rec;
+    struct eventIdx *idx;
+    FILE *fp;
+    int lineNum;
+    int want[2];
+    int numBad;
+    int n;
+    int i;
+
+    if ((fp = fopen(file, "w")) == NULL) {
+        perror(file);
+        exit(-1);
+    }
+    for (i = 1; i <= 3; i++)
+        putRec(fp, i, -1, FALSE);
+    putRec(fp, 100, 20, FALSE);
+    for (i = 4; i <= 6; i++)
+        putRec(fp, i, -1, FALSE);
+    putRec(fp, 101, -1, TRUE);
+    for (i = 7; i <= TORN_NREC; i++)
+        putRec(fp, i, -1, FALSE);
+    fclose(fp);
+
+    numBad = 0;
+
+    fp = fopen(file, "r");
+    want[0] = 1;
+    lineNum = 0;
+    while ((rec = lsb_geteventrec(fp, &lineNum)) != NULL)
+        numBad += nextJobId(rec, &want[0], "geteventrec");
+    fclose(fp);
+    if (want[0] != TORN_NREC + 1) {
+        printf("geteventrec: %d records\n", want[0] - 1);
+        numBad++;
+    }
+
+    for (n = 0; n <= 2; n += 2) {
+        fp = fopen(file, "r");
+        want[0] = 1;
+        want[1] = 0;
+        lineNum = 0;
+        if (lsb_replayevents(fp, n, &lineNum, checkRec, want) < 0) {
+            printf("replay %d: %s\n", n, lsb_sysmsg());
+            numBad++;
+        }
+        fclose(fp);
+        numBad += want[1];
+        if (want[0] != TORN_NREC + 1) {
+            printf("replay %d: %d records\n", n, want[0] - 1);
+            numBad++;
+        }
+    }
+
+    if (lsb_puteventidx(file) < 0
+        || (idx = lsb_openeventidx(file)) == NULL) {
+        printf("index: %s\n", lsb_sysmsg());
+        numBad++;
+    } else {
+        want[0] = 1;
+        for (i = 0; (rec = lsb_geteventidxrec(idx, i)) != NULL; i++)
+            numBad += nextJobId(rec, &want[0], "index");
+        if (want[0] != TORN_NREC + 1) {
+            printf("index: %d records\n", want[0] - 1);
+            numBad++;
+        }
+        lsb_closeeventidx(idx);
+    }
+
+    printf("torn records: %s\n", numBad ? "FAILED" : "ok");
+
+    return numBad != 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    struct timeval t0;
+    FILE *fp;
+    double t;
+    int maxThreads;
+    int lineNum;
+    int count;
+    int n;
+
+    if (argc < 2) {
+        fprintf(stderr, "\
+usage: %s eventfile [maxThreads] | -t file\n", argv[0]);
+        exit(-1);
+    }
+    if (strcmp(argv[1], "-t") == 0 && argc > 2)
+        return tornTest(argv[2]);
+    maxThreads = argc > 2 ? atoi(argv[2]) : 8;
+
+    if ((fp = fopen(argv[1], "r")) == NULL) {
+        perror(argv[1]);
+        exit(-1);
+    }
+
+    count = 0;
+    lineNum = 0;
+    lsberrno = LSBE_NO_ERROR;
+    gettimeofday(&t0, NULL);
+    while (lsberrno != LSBE_EOF) {
+        if (lsb_geteventrec(fp, &lineNum) != NULL)
+            ++count;
+        else if (lsberrno != LSBE_EOF)
+            lsberrno = LSBE_NO_ERROR;
+    }
+    t = elapsed(&t0);
+    printf("geteventrec  %8d events %8.3fs %10.0f events/sec\n",
+           count, t, count / t);
+
+    for (n = 0; n <= maxThreads; n = n ? 2 * n : 1) {
+
+        if ((fp = fopen(argv[1], "r")) == NULL) {
+            perror(argv[1]);
+            exit(-1);
+        }
+
+        count = 0;
+        lineNum = 0;
+        gettimeofday(&t0, NULL);
+        if (lsb_replayevents(fp, n, &lineNum, countRec, &count) < 0) {
+            fprintf(stderr, "%s: %s\n", argv[1], lsb_sysmsg());
+            exit(-1);
+        }
+        t = elapsed(&t0);
+        fclose(fp);
+
+        printf("replay %2d    %8d events %8.3fs %10.0f events/sec\n",
+               n, count, t, count / t);
+    }
+
+    return 0;
+}
+
+#endif
@@ -590,6 +590,7 @@ struct submig {
 #define JGRP_ARRAY_INFO 0x1000
 #define JOBID_ONLY_ALL  0x02000
 #define ZOMBIE_JOB      0x04000
+#define JOB_BRIEF_INFO  0x08000
 
 #define    JGRP_NODE_JOB	1
 #define    JGRP_NODE_GROUP	2
@@ -1307,6 +1308,9 @@ struct eventLogHandle {
 
 #define LSF_JOBIDINDEX_FILENAME "lsb.events.index"
 #define LSF_JOBIDINDEX_FILETAG "#LSF_JOBID_INDEX_FILE"
+#define LSF_EVENTIDX_SUFFIX    ".idx"
+
+struct eventIdx;
 
 struct jobIdIndexS {
     char fileName[MAXFILENAMELEN];
@@ -1488,7 +1492,21 @@ extern char *lsb_pendreason P_((int, int *, struct jobInfoHead *,
                             struct loadIndexLog *));
 
 extern int lsb_puteventrec P_((FILE *, struct eventRec *));
+extern int lsb_puteventrec_bin P_((FILE *, struct eventRec *));
 extern struct eventRec *lsb_geteventrec P_((FILE *, int *));
+extern char *lsb_geteventline P_((FILE *));
+extern int lsb_parseeventrec P_((char *, struct eventRec *));
+extern void lsb_freeeventrec P_((struct eventRec *));
+extern int lsb_puteventidx P_((char *));
+extern struct eventIdx *lsb_openeventidx P_((char *));
+extern void lsb_closeeventidx P_((struct eventIdx *));
+extern int lsb_eventidxjob P_((struct eventIdx *, int, int **));
+extern int lsb_eventidxtime P_((struct eventIdx *, time_t));
+extern long lsb_eventidxoffset P_((struct eventIdx *, int));
+extern struct eventRec *lsb_geteventidxrec P_((struct eventIdx *, int));
+extern int lsb_replayevents P_((FILE *, int, int *,
+                                int (*)(struct eventRec *, int, void *),
+                                void *));
 extern struct lsbSharedResourceInfo *lsb_sharedresourceinfo P_((char **, int *, char *, int));
 
 extern int lsb_runjob P_((struct runJobRequest*));
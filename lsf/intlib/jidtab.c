@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "jidtab.h"
+
+/* Slot keys, job ids are always positive.
+ */
+#define JID_EMPTY     0
+#define JID_DELETED   (-1)
+
+#define JIDTAB_MIN_BITS   4
+/* Number of old slots moved to the new
+ * array at every insertion while resizing.
+ */
+#define JIDTAB_DRAIN      32
+
+static unsigned int jidHash(LS_LONG_INT, unsigned int);
+static jidEnt *jidProbe(jidEnt *, unsigned int, unsigned int, LS_LONG_INT);
+static jidEnt *jidPlace(jidTab *, LS_LONG_INT);
+static void jidDrain(jidTab *, unsigned int);
+static int jidGrow(jidTab *);
+static void jidClearEnt(jidEnt *, jidEnt *, unsigned int);
+
+/* jidHash()
+ * Fibonacci hashing, the multiplication mixes the
+ * sequential job ids and array indexes in the high
+ * bits which are the ones we keep.
+ */
+static unsigned int
+jidHash(LS_LONG_INT key, unsigned int bits)
+{
+    return (unsigned int)(((unsigned long long)key
+                           * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+/* jidInitTab()
+ * Initialize the table for about size entries.
+ */
+int
+jidInitTab(jidTab *tab, unsigned int size)
+{
+    unsigned int bits;
+
+    memset(tab, 0, sizeof(jidTab));
+
+    bits = JIDTAB_MIN_BITS;
+    while ((1U << bits) * 7 / 10 < size && bits < 31)
+        ++bits;
+
+    tab->slots = calloc(1U << bits, sizeof(jidEnt));
+    if (tab->slots == NULL)
+        return -1;
+
+    tab->size = 1U << bits;
+    tab->bits = bits;
+
+    return 0;
+}
+
+/* jidFreeTab()
+ * Free the table memory and the data of every
+ * entry, with freeFunc if given like h_freeTab_().
+ */
+void
+jidFreeTab(jidTab *tab, void (*freeFunc)(void *))
+{
+    jidEnt *slots[2];
+    unsigned int size[2];
+    unsigned int i;
+    int n;
+
+    slots[0] = tab->slots;
+    size[0] = tab->size;
+    slots[1] = tab->oldSlots;
+    size[1] = tab->oldSize;
+
+    for (n = 0; n < 2; n++) {
+        for (i = 0; slots[n] && i < size[n]; i++) {
+            if (slots[n][i].key <= 0 || slots[n][i].hData == NULL)
+                continue;
+            if (freeFunc != NULL)
+                (*freeFunc)(slots[n][i].hData);
+            else
+                free(slots[n][i].hData);
+        }
+    }
+
+    free(tab->slots);
+    free(tab->oldSlots);
+    memset(tab, 0, sizeof(jidTab));
+}
+
+/* jidProbe()
+ * Linear probing from the home slot of key
+ * up to the first empty slot.
+ */
+static jidEnt *
+jidProbe(jidEnt *slots,
+         unsigned int size,
+         unsigned int bits,
+         LS_LONG_INT key)
+{
+    unsigned int i;
+
+    i = jidHash(key, bits);
+    while (slots[i].key != JID_EMPTY) {
+        if (slots[i].key == key)
+            return &slots[i];
+        i = (i + 1) & (size - 1);
+    }
+
+    return NULL;
+}
+
+/* jidGetEnt()
+ */
+jidEnt *
+jidGetEnt(jidTab *tab, LS_LONG_INT key)
+{
+    jidEnt *e;
+
+    if (key <= 0 || tab->slots == NULL)
+        return NULL;
+
+    e = jidProbe(tab->slots, tab->size, tab->bits, key);
+    if (e == NULL && tab->oldSlots)
+        e = jidProbe(tab->oldSlots, tab->oldSize, tab->oldBits, key);
+
+    return e;
+}
+
+/* jidPlace()
+ * Put key, known not to be in the table, in the
+ * first free slot of its probe sequence.
+ */
+static jidEnt *
+jidPlace(jidTab *tab, LS_LONG_INT key)
+{
+    unsigned int i;
+
+    i = jidHash(key, tab->bits);
+    while (tab->slots[i].key > 0)
+        i = (i + 1) & (tab->size - 1);
+
+    if (tab->slots[i].key == JID_EMPTY)
+        ++tab->used;
+
+    tab->slots[i].key = key;
+    tab->slots[i].hData = NULL;
+
+    return &tab->slots[i];
+}
+
+/* jidDrain()
+ * Move up to num slots of the old array in the
+ * current one. Moved slots become deleted so the
+ * probe sequences of the others stay intact.
+ */
+static void
+jidDrain(jidTab *tab, unsigned int num)
+{
+    jidEnt *o;
+    jidEnt *e;
+
+    while (tab->oldSlots && num > 0) {
+
+        o = &tab->oldSlots[tab->oldCursor];
+        if (o->key > 0) {
+            e = jidPlace(tab, o->key);
+            e->hData = o->hData;
+            o->key = JID_DELETED;
+        }
+
+        ++tab->oldCursor;
+        --num;
+
+        if (tab->oldCursor == tab->oldSize) {
+            free(tab->oldSlots);
+            tab->oldSlots = NULL;
+            tab->oldSize = tab->oldBits = tab->oldCursor = 0;
+        }
+    }
+}
+
+/* jidGrow()
+ * Start a resize, the table doubles if it is more
+ * than a third full of live entries otherwise it is
+ * rebuilt with the same size to get rid of the
+ * deleted slots.
+ */
+static int
+jidGrow(jidTab *tab)
+{
+    jidEnt *slots;
+    unsigned int bits;
+
+    if (tab->oldSlots)
+        jidDrain(tab, tab->oldSize);
+
+    bits = tab->bits;
+    if (tab->numEnts * 3 > tab->size && bits < 31)
+        ++bits;
+
+    slots = calloc(1U << bits, sizeof(jidEnt));
+    if (slots == NULL)
+        return -1;
+
+    tab->oldSlots = tab->slots;
+    tab->oldSize = tab->size;
+    tab->oldBits = tab->bits;
+    tab->oldCursor = 0;
+
+    tab->slots = slots;
+    tab->size = 1U << bits;
+    tab->bits = bits;
+    tab->used = 0;
+
+    return 0;
+}
+
+/* jidAddEnt()
+ * Return the entry of key setting new to TRUE
+ * if it was just added. NULL if the key is not
+ * valid or there is no memory.
+ */
+jidEnt *
+jidAddEnt(jidTab *tab, LS_LONG_INT key, int *new)
+{
+    jidEnt *e;
+
+    *new = FALSE;
+
+    if (key <= 0 || tab->slots == NULL)
+        return NULL;
+
+    jidDrain(tab, JIDTAB_DRAIN);
+
+    if ((e = jidGetEnt(tab, key)) != NULL)
+        return e;
+
+    /* Keep the load factor under 0.7 counting
+     * the deleted slots as they lengthen probes too.
+     */
+    if ((tab->used + 1) * 10 > tab->size * 7) {
+        if (jidGrow(tab) < 0 && tab->used + 1 >= tab->size)
+            return NULL;
+    }
+
+    e = jidPlace(tab, key);
+    ++tab->numEnts;
+    *new = TRUE;
+
+    return e;
+}
+
+/* jidClearEnt()
+ * A slot followed by an empty one is not
+ * in the middle of any probe sequence so it
+ * can be emptied instead of deleted.
+ */
+static void
+jidClearEnt(jidEnt *slots, jidEnt *e, unsigned int size)
+{
+    unsigned int i;
+
+    i = (e - slots + 1) & (size - 1);
+    if (slots[i].key == JID_EMPTY)
+        e->key = JID_EMPTY;
+    else
+        e->key = JID_DELETED;
+    e->hData = NULL;
+}
+
+/* jidRmEnt()
+ */
+int
+jidRmEnt(jidTab *tab, LS_LONG_INT key)
+{
+    jidEnt *e;
+
+    if (key <= 0 || tab->slots == NULL)
+        return FALSE;
+
+    e = jidProbe(tab->slots, tab->size, tab->bits, key);
+    if (e) {
+        jidClearEnt(tab->slots, e, tab->size);
+        if (e->key == JID_EMPTY)
+            --tab->used;
+        --tab->numEnts;
+        return TRUE;
+    }
+
+    if (tab->oldSlots == NULL)
+        return FALSE;
+
+    e = jidProbe(tab->oldSlots, tab->oldSize, tab->oldBits, key);
+    if (e == NULL)
+        return FALSE;
+
+    jidClearEnt(tab->oldSlots, e, tab->oldSize);
+    --tab->numEnts;
+
+    return TRUE;
+}
+
+/* jidFirstEnt()
+ * Start the traversal of the table, an ongoing
+ * resize is completed first. Entries can be removed
+ * while traversing but not added.
+ */
+jidEnt *
+jidFirstEnt(jidTab *tab, jidIter *iter)
+{
+    if (tab->oldSlots)
+        jidDrain(tab, tab->oldSize);
+
+    iter->tab = tab;
+    iter->pos = 0;
+
+    return jidNextEnt(iter);
+}
+
+/* jidNextEnt()
+ */
+jidEnt *
+jidNextEnt(jidIter *iter)
+{
+    jidTab *tab;
+
+    tab = iter->tab;
+    while (iter->pos < tab->size) {
+        if (tab->slots[iter->pos].key > 0)
+            return &tab->slots[iter->pos++];
+        ++iter->pos;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#ifndef __JIDTAB__
+#define __JIDTAB__
+
+#include "../lsf.h"
+
+/* Open addressing hash table keyed by job id,
+ * the 64 bit array job id LSB_JOBID(jobId, idx).
+ * Keys must be positive. Entries live inside the
+ * slot array so a jidEnt pointer is valid only
+ * until the next jidAddEnt(), lookups and removals
+ * never move entries.
+ *
+ * When the table has to grow the new slot array is
+ * allocated and the old one is drained a few slots
+ * at every insertion, so no single operation pays
+ * for rehashing the whole table.
+ */
+typedef struct jidEnt {
+    LS_LONG_INT   key;
+    void          *hData;
+} jidEnt;
+
+typedef struct jidTab {
+    jidEnt          *slots;
+    unsigned int    size;
+    unsigned int    bits;
+    /* numEnts counts the entries in both slot
+     * arrays, used the non empty slots in slots.
+     */
+    unsigned int    numEnts;
+    unsigned int    used;
+    /* Table being drained during a resize,
+     * oldCursor is the first slot not yet moved.
+     */
+    jidEnt          *oldSlots;
+    unsigned int    oldSize;
+    unsigned int    oldBits;
+    unsigned int    oldCursor;
+} jidTab;
+
+typedef struct jidIter {
+    jidTab          *tab;
+    unsigned int    pos;
+} jidIter;
+
+#define JIDTAB_NUM_ENTS(T) ((T)->numEnts)
+
+int      jidInitTab(jidTab *, unsigned int);
+void     jidFreeTab(jidTab *, void (*)(void *));
+jidEnt   *jidAddEnt(jidTab *, LS_LONG_INT, int *);
+jidEnt   *jidGetEnt(jidTab *, LS_LONG_INT);
+int      jidRmEnt(jidTab *, LS_LONG_INT);
+jidEnt   *jidFirstEnt(jidTab *, jidIter *);
+jidEnt   *jidNextEnt(jidIter *);
+
+#endif /* __JIDTAB__ */
@@ -32,6 +32,9 @@
 #include <tcl.h>
 #endif
 
+#include <limits.h>
+#include <math.h>
+
 #include "lsftcl.h"
 #include "../lib/lproto.h"
 
@@ -55,6 +58,99 @@ int stringValue (ClientData, Tcl_Interp *, int, const char **);
 static int copyTclLsInfo (struct tclLsInfo *);
 static char *getResValue (int);
 static int definedCmd(ClientData, Tcl_Interp *, int, const char **);
+static int stringCompare(int, const char *, const char *, int *);
+static int definedRes(int);
+static int checkResult(char, int);
+
+/* Bumped every time initTcl() rebuilds the symbol tables,
+ * select code compiled against older tables is not trusted
+ * and evaluated by tcl instead.
+ */
+static int                  tclGeneration;
+
+static attribFunc attrFuncTable[] = {
+    {"cpu"   , R1M},
+    {"login" , LS},
+    {"idle"  , IT},
+    {"swap"  , SWP},
+    {"cpuf"  , 0},
+    {"ndisks", 0},
+    {"rexpri", 0},
+    {"ncpus" , 0},
+    {"maxmem", 0},
+    {"maxswp", 0},
+    {"maxtmp" ,0},
+    {"server", 0},
+    {NULL, -1}
+};
+
+/* Opcodes of the compiled select expression. The code
+ * is a simple stack machine working on Tcl_Value so the
+ * numeric semantic is the same as the one of tcl expr.
+ */
+enum selectOp {
+    SOP_INT,
+    SOP_DOUBLE,
+    SOP_CMD,
+    SOP_NUMERIC,
+    SOP_BOOLEAN,
+    SOP_NEG,
+    SOP_PLUS,
+    SOP_NOT,
+    SOP_MUL,
+    SOP_DIV,
+    SOP_ADD,
+    SOP_SUB,
+    SOP_LT,
+    SOP_GT,
+    SOP_LE,
+    SOP_GE,
+    SOP_EQ,
+    SOP_NE,
+    SOP_BITAND,
+    SOP_BITOR,
+    SOP_JZ,
+    SOP_JNZ,
+    SOP_TOBOOL
+};
+
+struct selectInst {
+    int     op;
+    int     arg;
+    long    intValue;
+    double  doubleValue;
+};
+
+/* The [cmd "op" "val"] string commands are substituted
+ * by tcl before expr runs, so they are evaluated first,
+ * all of them and in order, their results are the operands
+ * of SOP_CMD.
+ */
+struct selectCmd {
+    int     indx;
+    char    *op;
+    char    *val;
+};
+
+struct selectCode {
+    int                  generation;
+    int                  numInst;
+    int                  maxInst;
+    struct selectInst    *inst;
+    int                  numCmds;
+    struct selectCmd     *cmds;
+    int                  *cmdValues;
+    Tcl_Value            *stack;
+};
+
+/* Internal result of runSelectCode() asking the caller to
+ * let tcl evaluate the expression, for example on integer
+ * overflow where tcl switches to big numbers.
+ */
+#define SELECT_FALLBACK  (-2)
+
+static int compileOr(struct selectCode *, char **);
+static int runSelectCode(struct selectCode *, int *);
 
 /* numericValue()
  * Evaluate host or shared resource numerica value.
@@ -208,11 +304,7 @@ stringValue(ClientData clientData,
             const char *argv[])
 {
     int *indx;
-    char *sp;
-    char *sp2;
-    char *value;
-    char status[MAXLSFNAMELEN];
-    struct hostent *hp;
+    int result;
 
     if (argc != 3) {
         Tcl_SetResult(interp, "wrong # args", NULL);
@@ -227,37 +319,61 @@ stringValue: arg0 %s arg1 %s arg2 %s indx %d hostname %s",
                   argv[0], argv[1], argv[2],
                   *indx, hPtr->hostName);
 
-    switch (*indx) {
+    if (stringCompare(*indx, argv[1], argv[2], &result) != TCL_OK)
+        return TCL_ERROR;
+
+    if (result)
+        Tcl_SetResult(interp, "1", NULL);
+    else
+        Tcl_SetResult(interp, "0", NULL);
+
+    return TCL_OK;
+}
+
+/* stringCompare()
+ * Compare the host string attribute or string resource
+ * indx with val using the tcl operator op.
+ */
+static int
+stringCompare(int indx, const char *op, const char *val, int *result)
+{
+    char *sp;
+    char *sp2;
+    char *value;
+    char status[MAXLSFNAMELEN];
+    struct hostent *hp;
+
+    switch (indx) {
 
         case HOSTNAME:
             overRideFromType = TRUE;
             sp = hPtr->hostName;
-            hp = Gethostbyname_((char *)argv[2]);
+            hp = Gethostbyname_((char *)val);
             if (hp)
                 sp2 = hp->h_name;
             else
-                sp2 = (char *) argv[2];
+                sp2 = (char *) val;
             break;
 
         case HOSTTYPE:
             sp = hPtr->hostType;
-            if (strcmp(argv[2], LOCAL_STR) == 0) {
+            if (strcmp(val, LOCAL_STR) == 0) {
                 sp2 = hPtr->fromHostType;
-                if (strcmp (argv[1], "eq") != 0)
+                if (strcmp (op, "eq") != 0)
                     overRideFromType = TRUE;
             } else {
                 overRideFromType = TRUE;
-                sp2 = (char *) argv[2];
+                sp2 = (char *) val;
             }
             break;
 
         case HOSTMODEL:
             overRideFromType = TRUE;
             sp = hPtr->hostModel;
-            if (strcmp(argv[2], LOCAL_STR) == 0)
+            if (strcmp(val, LOCAL_STR) == 0)
                 sp2 = hPtr->fromHostModel;
             else
-                sp2 = (char *) argv[2];
+                sp2 = (char *) val;
             break;
 
         case HOSTSTATUS:
@@ -282,14 +398,14 @@ stringValue: arg0 %s arg1 %s arg2 %s indx %d hostname %s",
                 strcpy(status,"ok");
             }
             sp = status;
-            sp2 = (char *) argv[2];
+            sp2 = (char *) val;
             break;
         default:
 
-            value = getResValue (*indx - LAST_STRING);
+            value = getResValue (indx - LAST_STRING);
             if (value == NULL || value[0] == '-') {
                 if (hPtr->flag == TCL_CHECK_SYNTAX) {
-                    Tcl_SetResult(interp, "1", NULL);
+                    *result = 1;
                     return(TCL_OK);
                 } else {
                     return (TCL_ERROR);
@@ -297,50 +413,32 @@ stringValue: arg0 %s arg1 %s arg2 %s indx %d hostname %s",
             }
             overRideFromType = TRUE;
             sp = value;
-            sp2 = (char *)argv[2];
+            sp2 = (char *)val;
             break;
     }
 
     if (logclass & LC_TRACE) {
         ls_syslog(LOG_DEBUG3, "\
-stringValue: sp = %s, sp2 = %s", sp, sp2);
+stringCompare: sp = %s, sp2 = %s", sp, sp2);
     }
 
     if (strcmp(sp2, WILDCARD_STR) == 0 ) {
-        Tcl_SetResult(interp, "1", NULL);
+        *result = 1;
         return TCL_OK;
     }
 
-    if (strcmp(argv[1],"eq") == 0) {
-        if (strcmp(sp2, sp) == 0)
-            Tcl_SetResult(interp, "1", NULL);
-        else
-            Tcl_SetResult(interp, "0", NULL);
-    } else if (strcmp(argv[1],"ne") == 0) {
-        if (strcmp(sp2, sp) != 0)
-            Tcl_SetResult(interp, "1", NULL);
-        else
-            Tcl_SetResult(interp, "0", NULL);
-    } else if (strcmp(argv[1],"ge") == 0) {
-        if (strcmp(sp2, sp) <= 0)
-            Tcl_SetResult(interp, "1", NULL);
-        else
-            Tcl_SetResult(interp, "0", NULL);
-    } else if (strcmp(argv[1],"le") == 0) {
-        if (strcmp(sp2,sp) >= 0)
-            Tcl_SetResult(interp, "1", NULL);
-        else
-            Tcl_SetResult(interp, "0", NULL);
-    } else if (strcmp(argv[1],"gt") == 0) {
-        if (strcmp(sp2, sp) < 0)
-            Tcl_SetResult(interp, "1", NULL);
-        else
-            Tcl_SetResult(interp, "0", NULL);
-    } else if (strcmp(argv[1],"lt") == 0) {
-        if (strcmp(sp2, sp) > 0)
-            Tcl_SetResult(interp, "1", NULL);
-        else
-            Tcl_SetResult(interp, "0", NULL);
+    if (strcmp(op, "eq") == 0) {
+        *result = (strcmp(sp2, sp) == 0);
+    } else if (strcmp(op, "ne") == 0) {
+        *result = (strcmp(sp2, sp) != 0);
+    } else if (strcmp(op, "ge") == 0) {
+        *result = (strcmp(sp2, sp) <= 0);
+    } else if (strcmp(op, "le") == 0) {
+        *result = (strcmp(sp2, sp) >= 0);
+    } else if (strcmp(op, "gt") == 0) {
+        *result = (strcmp(sp2, sp) < 0);
+    } else if (strcmp(op, "lt") == 0) {
+        *result = (strcmp(sp2, sp) > 0);
     } else {
         return TCL_ERROR;
     }
@@ -356,9 +454,7 @@ definedCmd(ClientData clientData,
 {
     int    resNo;
     int    hasRes = FALSE;
-    int    isSet;
     int    *indx;
-    char   *value;
 
     if (argc != 2) {
         Tcl_SetResult(interp, "wrong # args", NULL);
@@ -382,26 +478,37 @@ definedCmd: argv0 %s argv1 %s indx %d",
     if (hasRes == FALSE)
         return(TCL_ERROR);
 
-    if (hPtr->resBitMaps == NULL) {
+    if (definedRes(resNo))
+        Tcl_SetResult(interp, "1", NULL);
+    else
         Tcl_SetResult(interp, "0", NULL);
-        return TCL_OK;
-    }
+
+    return TCL_OK;
+
+}
+
+/* definedRes()
+ * Tell if the resource resNo is defined on the current host.
+ */
+static int
+definedRes(int resNo)
+{
+    int    isSet;
+
+    if (hPtr->resBitMaps == NULL)
+        return 0;
+
     TEST_BIT(resNo, hPtr->resBitMaps, isSet);
     if (isSet == 1)
-        Tcl_SetResult(interp, "1", NULL);
-    else {
-        value = getResValue (resNo);
-        if (value == NULL) {
-            if (hPtr->flag == TCL_CHECK_SYNTAX)
-                Tcl_SetResult(interp, "1", NULL);
-            else
-                Tcl_SetResult(interp, "0", NULL);
-        } else
-            Tcl_SetResult(interp, "1", NULL);
-    }
+        return 1;
 
-    return TCL_OK;
+    if (getResValue (resNo) == NULL) {
+        if (hPtr->flag == TCL_CHECK_SYNTAX)
+            return 1;
+        return 0;
+    }
 
+    return 1;
 }
 
 /* initTcl()
@@ -417,22 +524,6 @@ initTcl(struct tclLsInfo *tclLsInfo)
     static int   ar3[5];
     attribFunc   *funcPtr;
 
-    static attribFunc attrFuncTable[] = {
-        {"cpu"   , R1M},
-        {"login" , LS},
-        {"idle"  , IT},
-        {"swap"  , SWP},
-        {"cpuf"  , 0},
-        {"ndisks", 0},
-        {"rexpri", 0},
-        {"ncpus" , 0},
-        {"maxmem", 0},
-        {"maxswp", 0},
-        {"maxtmp" ,0},
-        {"server", 0},
-        {NULL, -1}
-    };
-
     if (myTclLsInfo) {
         freeTclLsInfo(myTclLsInfo, 1);
     }
@@ -445,6 +536,7 @@ initTcl(struct tclLsInfo *tclLsInfo)
 
     numIndx = tclLsInfo->numIndx;
     nRes = tclLsInfo->nRes;
+    ++tclGeneration;
 
     attrFuncTable[4].clientData  = CPUFACTOR;
     attrFuncTable[5].clientData  = NDISK;
@@ -596,9 +688,21 @@ evalResReq(char *resReq,
            struct tclHostData *hPtr2,
            char useFromType)
 {
-    int code;
-    int i;
-    int resBits;
+    return evalSelectCode(NULL, resReq, hPtr2, useFromType);
+}
+
+/* evalSelectCode()
+ * Evaluate the select expression resReq on the host hPtr2
+ * running its compiled code if available, tcl otherwise.
+ */
+int
+evalSelectCode(struct selectCode *code,
+               char *resReq,
+               struct tclHostData *hPtr2,
+               char useFromType)
+{
+    int cc;
+    int result;
 
     hPtr = hPtr2;
 
@@ -609,13 +713,40 @@ evalResReq(char *resReq,
 
     if (logclass & LC_TRACE)
         ls_syslog(LOG_DEBUG3, "\
-evalResReq: resReq=%s, host = %s", resReq, hPtr->hostName);
+evalSelectCode: resReq=%s, host = %s compiled %d", resReq,
+                  hPtr->hostName, code != NULL);
+
+    cc = SELECT_FALLBACK;
+    if (code != NULL
+        && code->generation == tclGeneration) {
+        cc = runSelectCode(code, &result);
+        if (cc == SELECT_FALLBACK) {
+            overRideFromType = FALSE;
+            runTimeDataQueried = FALSE;
+        }
+    }
 
-    code = Tcl_Eval(globinterp, resReq);
-    if (code != TCL_OK) {
+    if (cc == SELECT_FALLBACK) {
+        if (Tcl_Eval(globinterp, resReq) != TCL_OK)
+            return -1;
+        result = strcmp(Tcl_GetStringResult(globinterp), "0") != 0;
+    } else if (cc < 0) {
         return -1;
     }
 
+    return checkResult(useFromType, result);
+}
+
+/* checkResult()
+ * Apply to the expression result the dedicated resources,
+ * host type and host availability constraints.
+ */
+static int
+checkResult(char useFromType, int result)
+{
+    int i;
+    int resBits;
+
     hPtr->overRideFromType = overRideFromType;
 
     resBits = 0;
@@ -640,12 +771,885 @@ evalResReq: resReq=%s, host = %s", resReq, hPtr->hostName);
     if (runTimeDataQueried && LS_ISUNAVAIL(hPtr->status))
         return 0;
 
-    if (strcmp(Tcl_GetStringResult(globinterp), "0") == 0)
+    if (result == 0)
         return 0;
 
     return 1;
 }
 
+/* compileResReq()
+ * Compile the tcl select string generated by parseResReq()
+ * into select code. The string is the subset of tcl
+ * expr syntax produced by resToClassNew()/resToClassOld(),
+ * anything else is left to tcl by returning NULL.
+ */
+struct selectCode *
+compileResReq(char *resReq)
+{
+    struct selectCode *code;
+    char              *p;
+
+    if (myTclLsInfo == NULL
+        || resReq == NULL
+        || strncmp(resReq, "expr ", 5) != 0)
+        return NULL;
+
+    code = calloc(1, sizeof(struct selectCode));
+    if (code == NULL)
+        return NULL;
+
+    code->generation = tclGeneration;
+    p = resReq + 5;
+
+    if (compileOr(code, &p) < 0)
+        goto bad;
+
+    while (isspace(*p))
+        ++p;
+    if (*p != 0)
+        goto bad;
+
+    /* A value can be pushed at most once per instruction.
+     */
+    code->stack = calloc(code->numInst + 1, sizeof(Tcl_Value));
+    if (code->stack == NULL)
+        goto bad;
+
+    if (code->numCmds > 0) {
+        code->cmdValues = calloc(code->numCmds, sizeof(int));
+        if (code->cmdValues == NULL)
+            goto bad;
+    }
+
+    if (logclass & LC_TRACE)
+        ls_syslog(LOG_DEBUG3, "\
+compileResReq: %s compiled in %d instructions %d commands",
+                  resReq, code->numInst, code->numCmds);
+
+    return code;
+
+bad:
+    if (logclass & LC_TRACE)
+        ls_syslog(LOG_DEBUG3, "\
+compileResReq: %s left to tcl at <%s>", resReq, p);
+    freeSelectCode(code);
+    return NULL;
+}
+
+/* freeSelectCode()
+ */
+void
+freeSelectCode(struct selectCode *code)
+{
+    int i;
+
+    if (code == NULL)
+        return;
+
+    for (i = 0; i < code->numCmds; i++) {
+        FREEUP(code->cmds[i].op);
+        FREEUP(code->cmds[i].val);
+    }
+    FREEUP(code->cmds);
+    FREEUP(code->cmdValues);
+    FREEUP(code->inst);
+    FREEUP(code->stack);
+    FREEUP(code);
+}
+
+/* emit()
+ * Append an instruction and return its address.
+ */
+static int
+emit(struct selectCode *code, int op, int arg)
+{
+    struct selectInst *inst;
+
+    if (code->numInst == code->maxInst) {
+        int n;
+
+        n = code->maxInst == 0 ? 32 : 2 * code->maxInst;
+        inst = realloc(code->inst, n * sizeof(struct selectInst));
+        if (inst == NULL)
+            return -1;
+        code->inst = inst;
+        code->maxInst = n;
+    }
+
+    inst = &code->inst[code->numInst];
+    inst->op = op;
+    inst->arg = arg;
+    inst->intValue = 0;
+    inst->doubleValue = 0.0;
+
+    return code->numInst++;
+}
+
+/* matchOp()
+ * Consume the operator op if it is the next token. Single
+ * character operators must not be the prefix of a double one.
+ */
+static int
+matchOp(char **p, const char *op)
+{
+    int len;
+
+    while (isspace(**p))
+        ++(*p);
+
+    len = strlen(op);
+    if (strncmp(*p, op, len) != 0)
+        return FALSE;
+
+    if (len == 1) {
+        char c = (*p)[1];
+
+        if ((op[0] == '&' && c == '&')
+            || (op[0] == '|' && c == '|')
+            || ((op[0] == '<' || op[0] == '>' || op[0] == '!')
+                && c == '='))
+            return FALSE;
+    }
+
+    *p += len;
+    return TRUE;
+}
+
+/* getWord()
+ * Get one word of a bracketed command, quoted words with
+ * tcl special characters in them are not compiled.
+ */
+static char *
+getWord(char **p)
+{
+    char   *w;
+    char   *s;
+    int    len;
+
+    while (**p == ' ' || **p == '\t')
+        ++(*p);
+
+    s = *p;
+    if (*s == '"') {
+        ++s;
+        for (len = 0; s[len] && s[len] != '"'; len++) {
+            if (strchr("$[]\\{}", s[len]))
+                return NULL;
+        }
+        if (s[len] != '"')
+            return NULL;
+        if (s[len + 1] != ' '
+            && s[len + 1] != '\t'
+            && s[len + 1] != ']')
+            return NULL;
+        *p = s + len + 1;
+    } else {
+        for (len = 0;
+             s[len] && !isspace(s[len]) && s[len] != ']'; len++) {
+            if (strchr("$[\\{}\";", s[len]))
+                return NULL;
+        }
+        if (len == 0)
+            return NULL;
+        *p = s + len;
+    }
+
+    w = malloc(len + 1);
+    if (w == NULL)
+        return NULL;
+    memcpy(w, s, len);
+    w[len] = 0;
+
+    return w;
+}
+
+/* compileCmd()
+ * Compile a [cmd "op" "val"] or [defined "res"] command.
+ */
+static int
+compileCmd(struct selectCode *code, char **p)
+{
+    struct selectCmd *cmds;
+    char             *words[4];
+    int              n;
+    int              indx;
+    int              resNo;
+    int              isSet;
+    int              cc;
+
+    words[0] = words[1] = words[2] = words[3] = NULL;
+    ++(*p);
+    for (n = 0; n < 4; n++) {
+        while (**p == ' ' || **p == '\t')
+            ++(*p);
+        if (**p == ']')
+            break;
+        if (n == 3
+            || (words[n] = getWord(p)) == NULL)
+            goto bad;
+    }
+    if (**p != ']' || n < 2)
+        goto bad;
+    ++(*p);
+
+    indx = -1;
+    /* String resources were registered after the builtin
+     * commands and hide them.
+     */
+    for (resNo = 0; resNo < myTclLsInfo->nRes; resNo++) {
+        TEST_BIT(resNo, myTclLsInfo->stringResBitMaps, isSet);
+        if (isSet
+            && strcmp(myTclLsInfo->resName[resNo], words[0]) == 0) {
+            indx = resNo + LAST_STRING;
+            break;
+        }
+    }
+
+    if (indx < 0) {
+        if (strcmp(words[0], "type") == 0)
+            indx = HOSTTYPE;
+        else if (strcmp(words[0], "model") == 0)
+            indx = HOSTMODEL;
+        else if (strcmp(words[0], "status") == 0)
+            indx = HOSTSTATUS;
+        else if (strcmp(words[0], "hname") == 0)
+            indx = HOSTNAME;
+        else if (strcmp(words[0], "defined") == 0)
+            indx = DEFINEDFUNCTION;
+        else
+            goto bad;
+    }
+
+    if (indx == DEFINEDFUNCTION) {
+        if (n != 2)
+            goto bad;
+        for (resNo = 0; resNo < myTclLsInfo->nRes; resNo++) {
+            if (strcmp(myTclLsInfo->resName[resNo], words[1]) == 0)
+                break;
+        }
+        if (resNo == myTclLsInfo->nRes)
+            goto bad;
+        free(words[0]);
+        free(words[1]);
+        words[0] = NULL;
+        words[1] = NULL;
+    } else {
+        if (n != 3)
+            goto bad;
+        if (strcmp(words[1], "eq") != 0
+            && strcmp(words[1], "ne") != 0
+            && strcmp(words[1], "ge") != 0
+            && strcmp(words[1], "le") != 0
+            && strcmp(words[1], "gt") != 0
+            && strcmp(words[1], "lt") != 0)
+            goto bad;
+        free(words[0]);
+        resNo = -1;
+    }
+
+    cmds = realloc(code->cmds, (code->numCmds + 1) * sizeof(struct selectCmd));
+    if (cmds == NULL)
+        goto bad1;
+    code->cmds = cmds;
+
+    cmds[code->numCmds].indx = indx;
+    if (indx == DEFINEDFUNCTION) {
+        cmds[code->numCmds].op = NULL;
+        cmds[code->numCmds].val = NULL;
+        /* Keep the resource index in the command itself.
+         */
+        cmds[code->numCmds].indx = -(resNo + 1);
+    } else {
+        cmds[code->numCmds].op = words[1];
+        cmds[code->numCmds].val = words[2];
+    }
+
+    cc = emit(code, SOP_CMD, code->numCmds);
+    code->numCmds++;
+
+    return cc < 0 ? -1 : 0;
+
+bad1:
+    FREEUP(words[1]);
+    FREEUP(words[2]);
+    return -1;
+
+bad:
+    while (--n >= 0)
+        FREEUP(words[n]);
+    return -1;
+}
+
+/* compileFunc()
+ * Compile a name() math function call resolving the name
+ * the same way the functions were registered in initTcl(),
+ * last registered first.
+ */
+static int
+compileFunc(struct selectCode *code, char **p)
+{
+    char         name[MAXLSFNAMELEN];
+    int          len;
+    int          resNo;
+    int          isSet;
+    attribFunc   *funcPtr;
+
+    for (len = 0; IS_LETTER((*p)[len])
+             || IS_DIGIT((*p)[len])
+             || (*p)[len] == '_'; len++) {
+        if (len == MAXLSFNAMELEN - 1)
+            return -1;
+        name[len] = (*p)[len];
+    }
+    name[len] = 0;
+    *p += len;
+
+    if ((*p)[0] != '(' || (*p)[1] != ')')
+        return -1;
+    *p += 2;
+
+    for (resNo = myTclLsInfo->nRes - 1; resNo >= 0; resNo--) {
+        TEST_BIT(resNo, myTclLsInfo->numericResBitMaps, isSet);
+        if (isSet)
+            continue;
+        TEST_BIT(resNo, myTclLsInfo->stringResBitMaps, isSet);
+        if (isSet)
+            continue;
+        if (strcmp(myTclLsInfo->resName[resNo], name) == 0)
+            return emit(code, SOP_BOOLEAN, resNo);
+    }
+
+    for (funcPtr = attrFuncTable; funcPtr->name != NULL; funcPtr++)
+        ;
+    while (--funcPtr >= attrFuncTable) {
+        if (strcmp(funcPtr->name, name) == 0)
+            return emit(code, SOP_NUMERIC, funcPtr->clientData);
+    }
+
+    for (resNo = myTclLsInfo->nRes - 1; resNo >= 0; resNo--) {
+        TEST_BIT(resNo, myTclLsInfo->numericResBitMaps, isSet);
+        if (isSet
+            && strcmp(myTclLsInfo->resName[resNo], name) == 0)
+            return emit(code, SOP_NUMERIC, resNo + myTclLsInfo->numIndx);
+    }
+
+    for (resNo = myTclLsInfo->numIndx - 1; resNo >= 0; resNo--) {
+        if (strcmp(myTclLsInfo->indexNames[resNo], name) == 0)
+            return emit(code, SOP_NUMERIC, resNo);
+    }
+
+    return -1;
+}
+
+/* compileNumber()
+ * Compile a numeric literal, octal looking integers
+ * are left to tcl.
+ */
+static int
+compileNumber(struct selectCode *code, char **p)
+{
+    char    *s;
+    char    *end;
+    int     len;
+    int     dots;
+    int     n;
+
+    s = *p;
+    dots = 0;
+    for (len = 0; IS_DIGIT(s[len]) || s[len] == '.'; len++) {
+        if (s[len] == '.')
+            ++dots;
+    }
+
+    if (dots > 1
+        || (len == 1 && dots == 1)
+        || IS_LETTER(s[len])
+        || s[len] == '_'
+        || s[len] == '(')
+        return -1;
+
+    errno = 0;
+    if (dots == 0) {
+        long l;
+
+        if (len > 1 && s[0] == '0')
+            return -1;
+        l = strtol(s, &end, 10);
+        if (errno != 0 || end != s + len)
+            return -1;
+        if ((n = emit(code, SOP_INT, 0)) < 0)
+            return -1;
+        code->inst[n].intValue = l;
+    } else {
+        double d;
+
+        d = strtod(s, &end);
+        if (errno != 0 || end != s + len)
+            return -1;
+        if ((n = emit(code, SOP_DOUBLE, 0)) < 0)
+            return -1;
+        code->inst[n].doubleValue = d;
+    }
+
+    *p += len;
+    return n;
+}
+
+static int
+compileUnary(struct selectCode *code, char **p)
+{
+    while (isspace(**p))
+        ++(*p);
+
+    if (matchOp(p, "-")) {
+        if (compileUnary(code, p) < 0)
+            return -1;
+        return emit(code, SOP_NEG, 0);
+    }
+
+    if (matchOp(p, "+")) {
+        if (compileUnary(code, p) < 0)
+            return -1;
+        return emit(code, SOP_PLUS, 0);
+    }
+
+    if (matchOp(p, "!")) {
+        if (compileUnary(code, p) < 0)
+            return -1;
+        return emit(code, SOP_NOT, 0);
+    }
+
+    if (**p == '(') {
+        ++(*p);
+        if (compileOr(code, p) < 0)
+            return -1;
+        if (!matchOp(p, ")"))
+            return -1;
+        return 0;
+    }
+
+    if (**p == '[')
+        return compileCmd(code, p);
+
+    if (IS_DIGIT(**p) || **p == '.')
+        return compileNumber(code, p);
+
+    if (IS_LETTER(**p))
+        return compileFunc(code, p);
+
+    return -1;
+}
+
+static int
+compileMul(struct selectCode *code, char **p)
+{
+    int op;
+
+    if (compileUnary(code, p) < 0)
+        return -1;
+
+    for (;;) {
+        if (matchOp(p, "*"))
+            op = SOP_MUL;
+        else if (matchOp(p, "/"))
+            op = SOP_DIV;
+        else
+            return 0;
+        if (compileUnary(code, p) < 0
+            || emit(code, op, 0) < 0)
+            return -1;
+    }
+}
+
+static int
+compileAdd(struct selectCode *code, char **p)
+{
+    int op;
+
+    if (compileMul(code, p) < 0)
+        return -1;
+
+    for (;;) {
+        if (matchOp(p, "+"))
+            op = SOP_ADD;
+        else if (matchOp(p, "-"))
+            op = SOP_SUB;
+        else
+            return 0;
+        if (compileMul(code, p) < 0
+            || emit(code, op, 0) < 0)
+            return -1;
+    }
+}
+
+static int
+compileRel(struct selectCode *code, char **p)
+{
+    int op;
+
+    if (compileAdd(code, p) < 0)
+        return -1;
+
+    for (;;) {
+        if (matchOp(p, "<="))
+            op = SOP_LE;
+        else if (matchOp(p, ">="))
+            op = SOP_GE;
+        else if (matchOp(p, "<"))
+            op = SOP_LT;
+        else if (matchOp(p, ">"))
+            op = SOP_GT;
+        else
+            return 0;
+        if (compileAdd(code, p) < 0
+            || emit(code, op, 0) < 0)
+            return -1;
+    }
+}
+
+static int
+compileEq(struct selectCode *code, char **p)
+{
+    int op;
+
+    if (compileRel(code, p) < 0)
+        return -1;
+
+    for (;;) {
+        if (matchOp(p, "=="))
+            op = SOP_EQ;
+        else if (matchOp(p, "!="))
+            op = SOP_NE;
+        else
+            return 0;
+        if (compileRel(code, p) < 0
+            || emit(code, op, 0) < 0)
+            return -1;
+    }
+}
+
+static int
+compileBitAnd(struct selectCode *code, char **p)
+{
+    if (compileEq(code, p) < 0)
+        return -1;
+
+    while (matchOp(p, "&")) {
+        if (compileEq(code, p) < 0
+            || emit(code, SOP_BITAND, 0) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+static int
+compileBitOr(struct selectCode *code, char **p)
+{
+    if (compileBitAnd(code, p) < 0)
+        return -1;
+
+    while (matchOp(p, "|")) {
+        if (compileBitAnd(code, p) < 0
+            || emit(code, SOP_BITOR, 0) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+static int
+compileAnd(struct selectCode *code, char **p)
+{
+    int jump;
+
+    if (compileBitOr(code, p) < 0)
+        return -1;
+
+    while (matchOp(p, "&&")) {
+        if ((jump = emit(code, SOP_JZ, 0)) < 0
+            || compileBitOr(code, p) < 0
+            || emit(code, SOP_TOBOOL, 0) < 0)
+            return -1;
+        code->inst[jump].arg = code->numInst;
+    }
+
+    return 0;
+}
+
+static int
+compileOr(struct selectCode *code, char **p)
+{
+    int jump;
+
+    if (compileAnd(code, p) < 0)
+        return -1;
+
+    while (matchOp(p, "||")) {
+        if ((jump = emit(code, SOP_JNZ, 0)) < 0
+            || compileAnd(code, p) < 0
+            || emit(code, SOP_TOBOOL, 0) < 0)
+            return -1;
+        code->inst[jump].arg = code->numInst;
+    }
+
+    return 0;
+}
+
+#define IS_TRUE(v) ((v)->type == TCL_INT ? (v)->intValue != 0 \
+                    : (v)->doubleValue != 0.0)
+
+/* runSelectCode()
+ * Execute the select code on the current host. Returns 0
+ * and the value of the expression in result, -1 when tcl
+ * would have failed the evaluation or SELECT_FALLBACK.
+ */
+static int
+runSelectCode(struct selectCode *code, int *result)
+{
+    struct selectInst *inst;
+    Tcl_Value         *stack;
+    Tcl_Value         *a;
+    Tcl_Value         *b;
+    double            x;
+    double            y;
+    int               sp;
+    int               pc;
+    int               i;
+
+    for (i = 0; i < code->numCmds; i++) {
+        struct selectCmd *cmd = &code->cmds[i];
+
+        if (cmd->indx < 0) {
+            overRideFromType = TRUE;
+            code->cmdValues[i] = definedRes(-cmd->indx - 1);
+            continue;
+        }
+        if (stringCompare(cmd->indx,
+                          cmd->op,
+                          cmd->val,
+                          &code->cmdValues[i]) != TCL_OK)
+            return -1;
+    }
+
+    stack = code->stack;
+    sp = -1;
+    pc = 0;
+
+    while (pc < code->numInst) {
+
+        inst = &code->inst[pc++];
+
+        switch (inst->op) {
+            case SOP_INT:
+                ++sp;
+                stack[sp].type = TCL_INT;
+                stack[sp].intValue = inst->intValue;
+                continue;
+            case SOP_DOUBLE:
+                ++sp;
+                stack[sp].type = TCL_DOUBLE;
+                stack[sp].doubleValue = inst->doubleValue;
+                continue;
+            case SOP_CMD:
+                ++sp;
+                stack[sp].type = TCL_INT;
+                stack[sp].intValue = code->cmdValues[inst->arg];
+                continue;
+            case SOP_NUMERIC:
+                ++sp;
+                if (numericValue((ClientData)&inst->arg,
+                                 NULL,
+                                 NULL,
+                                 &stack[sp]) != TCL_OK)
+                    return -1;
+                continue;
+            case SOP_BOOLEAN:
+                ++sp;
+                if (booleanValue((ClientData)&inst->arg,
+                                 NULL,
+                                 NULL,
+                                 &stack[sp]) != TCL_OK)
+                    return -1;
+                continue;
+            case SOP_NEG:
+                a = &stack[sp];
+                if (a->type == TCL_INT) {
+                    if (a->intValue == LONG_MIN)
+                        return SELECT_FALLBACK;
+                    a->intValue = -a->intValue;
+                } else {
+                    a->doubleValue = -a->doubleValue;
+                }
+                continue;
+            case SOP_PLUS:
+                continue;
+            case SOP_NOT:
+                a = &stack[sp];
+                a->intValue = !IS_TRUE(a);
+                a->type = TCL_INT;
+                continue;
+            case SOP_TOBOOL:
+                a = &stack[sp];
+                a->intValue = IS_TRUE(a);
+                a->type = TCL_INT;
+                continue;
+            case SOP_JZ:
+                a = &stack[sp];
+                if (!IS_TRUE(a)) {
+                    a->type = TCL_INT;
+                    a->intValue = 0;
+                    pc = inst->arg;
+                } else {
+                    --sp;
+                }
+                continue;
+            case SOP_JNZ:
+                a = &stack[sp];
+                if (IS_TRUE(a)) {
+                    a->type = TCL_INT;
+                    a->intValue = 1;
+                    pc = inst->arg;
+                } else {
+                    --sp;
+                }
+                continue;
+            default:
+                break;
+        }
+
+        /* Binary operators.
+         */
+        b = &stack[sp--];
+        a = &stack[sp];
+
+        if (a->type == TCL_INT && b->type == TCL_INT) {
+            long l;
+            long r;
+
+            l = a->intValue;
+            r = b->intValue;
+
+            switch (inst->op) {
+                case SOP_MUL:
+                    if (__builtin_mul_overflow(l, r, &a->intValue))
+                        return SELECT_FALLBACK;
+                    break;
+                case SOP_DIV:
+                    if (r == 0)
+                        return -1;
+                    if (l == LONG_MIN && r == -1)
+                        return SELECT_FALLBACK;
+                    /* tcl integer division rounds
+                     * towards negative infinity.
+                     */
+                    a->intValue = l / r;
+                    if (l % r != 0 && ((l < 0) != (r < 0)))
+                        a->intValue--;
+                    break;
+                case SOP_ADD:
+                    if (__builtin_add_overflow(l, r, &a->intValue))
+                        return SELECT_FALLBACK;
+                    break;
+                case SOP_SUB:
+                    if (__builtin_sub_overflow(l, r, &a->intValue))
+                        return SELECT_FALLBACK;
+                    break;
+                case SOP_LT:
+                    a->intValue = l < r;
+                    break;
+                case SOP_GT:
+                    a->intValue = l > r;
+                    break;
+                case SOP_LE:
+                    a->intValue = l <= r;
+                    break;
+                case SOP_GE:
+                    a->intValue = l >= r;
+                    break;
+                case SOP_EQ:
+                    a->intValue = l == r;
+                    break;
+                case SOP_NE:
+                    a->intValue = l != r;
+                    break;
+                case SOP_BITAND:
+                    a->intValue = l & r;
+                    break;
+                case SOP_BITOR:
+                    a->intValue = l | r;
+                    break;
+                default:
+                    return SELECT_FALLBACK;
+            }
+            continue;
+        }
+
+        x = a->type == TCL_INT ? (double)a->intValue : a->doubleValue;
+        y = b->type == TCL_INT ? (double)b->intValue : b->doubleValue;
+
+        a->type = TCL_INT;
+        switch (inst->op) {
+            case SOP_MUL:
+                a->type = TCL_DOUBLE;
+                a->doubleValue = x * y;
+                break;
+            case SOP_DIV:
+                a->type = TCL_DOUBLE;
+                a->doubleValue = x / y;
+                break;
+            case SOP_ADD:
+                a->type = TCL_DOUBLE;
+                a->doubleValue = x + y;
+                break;
+            case SOP_SUB:
+                a->type = TCL_DOUBLE;
+                a->doubleValue = x - y;
+                break;
+            case SOP_LT:
+                a->intValue = x < y;
+                break;
+            case SOP_GT:
+                a->intValue = x > y;
+                break;
+            case SOP_LE:
+                a->intValue = x <= y;
+                break;
+            case SOP_GE:
+                a->intValue = x >= y;
+                break;
+            case SOP_EQ:
+                a->intValue = x == y;
+                break;
+            case SOP_NE:
+                a->intValue = x != y;
+                break;
+            default:
+                /* tcl refuses floating point operands
+                 * of the bitwise operators.
+                 */
+                return -1;
+        }
+
+        /* tcl reports a domain error rather
+         * than producing a NaN.
+         */
+        if (a->type == TCL_DOUBLE
+            && isnan(a->doubleValue))
+            return -1;
+    }
+
+    if (sp != 0)
+        return SELECT_FALLBACK;
+
+    /* tcl compares the string result with "0" so any
+     * double, even a zero one, selects the host.
+     */
+    *result = !(stack[0].type == TCL_INT && stack[0].intValue == 0);
+
+    return 0;
+}
+
 /* getResValue()
  */
 static char *
@@ -80,3 +80,9 @@ struct tclLsInfo {
 extern int initTcl(struct tclLsInfo *);
 extern void freeTclLsInfo(struct tclLsInfo *, int);
 extern int evalResReq(char *, struct tclHostData *, char);
+extern struct selectCode *compileResReq(char *);
+extern void freeSelectCode(struct selectCode *);
+extern int evalSelectCode(struct selectCode *,
+                          char *,
+                          struct tclHostData *,
+                          char);
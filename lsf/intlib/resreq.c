@@ -56,6 +56,7 @@ static int setDefaults(struct resVal *,
                        int);
 static int getVal(char **, float *);
 static enum syntaxType getSyntax(char *);
+static void compileSelect(struct resVal *);
 static int getKeyEntry (char *);
 static int getTimeVal(char **, float *);
 void freeResVal (struct resVal *);
@@ -272,9 +273,37 @@ parseResReq(char *resReq,
             return(cc);
     }
 
+    compileSelect(resVal);
+
     return(PARSE_OK);
 }
 
+/* compileSelect()
+ * Translate the select string, and the xor expressions if any,
+ * into native select code once so that the per host evaluation
+ * does not go through the tcl interpreter. A NULL code just
+ * means evalSelectCode() will fall back to tcl.
+ */
+static void
+compileSelect(struct resVal *resVal)
+{
+    int   i;
+
+    resVal->selectCode = compileResReq(resVal->selectStr);
+
+    if (resVal->xorExprs == NULL)
+        return;
+
+    for (i = 0; resVal->xorExprs[i]; i++)
+        ;
+    resVal->xorCodes = calloc(i + 1, sizeof(struct selectCode *));
+    if (resVal->xorCodes == NULL)
+        return;
+
+    for (i = 0; resVal->xorExprs[i]; i++)
+        resVal->xorCodes[i] = compileResReq(resVal->xorExprs[i]);
+}
+
 static int
 parseSection(char *resReq, struct sections *section)
 {
@@ -1150,12 +1179,18 @@ freeResVal (struct resVal *resVal)
     FREEUP (resVal->selectStr);
     resVal->selectStrSize = 0;
     FREEUP (resVal->rusgBitMaps);
+    freeSelectCode(resVal->selectCode);
+    resVal->selectCode = NULL;
     if (resVal->xorExprs) {
         int i;
-	for (i=0; resVal->xorExprs[i]; i++)
+	for (i=0; resVal->xorExprs[i]; i++) {
+            if (resVal->xorCodes)
+                freeSelectCode(resVal->xorCodes[i]);
 	    FREEUP (resVal->xorExprs[i]);
+        }
 	FREEUP (resVal->xorExprs);
     }
+    FREEUP(resVal->xorCodes);
 }
 
 void
@@ -1170,7 +1205,8 @@ initResVal (struct resVal *resVal)
     resVal->selectStr= NULL;
     resVal->selectStrSize= 0;
     resVal->xorExprs = NULL;
-
+    resVal->selectCode = NULL;
+    resVal->xorCodes = NULL;
 }
 
 
@@ -44,6 +44,8 @@
 
 #define IDLETIME 5
 
+struct selectCode;
+
 struct resVal {
     char *selectStr;
     int  nphase;
@@ -61,6 +63,8 @@ struct resVal {
     int  options;
     int  selectStrSize;
     char **xorExprs;
+    struct selectCode *selectCode;
+    struct selectCode **xorCodes;
 };
 
 extern int getValPair(char **resReq, int *val1, int *val2);
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#if _HTAB_TEST_
+
+/* Benchmark of the hTab in lib.table.c, build with:
+ *
+ * gcc -D_HTAB_TEST_=1 -O2 -I.. testhtab.c ../lib/liblsf.a -o testhtab
+ *
+ * and run as testhtab [numKeys]. Besides the totals it
+ * reports the slowest single h_addEnt_() which is where
+ * the table growth shows.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "../lib/lib.table.h"
+
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_usec - t0->tv_usec) / 1e6;
+}
+
+static void
+noFree(void *p)
+{
+}
+
+static void
+testKeys(const char *name, char **keys, int num)
+{
+    struct timeval t0;
+    struct timeval t1;
+    double worst;
+    double t;
+    hTab tab;
+    hEnt *e;
+    sTab s;
+    int i;
+    int new;
+    int found;
+
+    h_initTab_(&tab, 50);
+
+    worst = 0.0;
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < num; i++) {
+        gettimeofday(&t1, NULL);
+        e = h_addEnt_(&tab, keys[i], &new);
+        e->hData = keys[i];
+        t = elapsed(&t1);
+        if (t > worst)
+            worst = t;
+    }
+    printf("%-6s add    %8d %8.3fs worst %8.3fms\n",
+           name, num, elapsed(&t0), worst * 1000);
+
+    gettimeofday(&t0, NULL);
+    for (i = 0, found = 0; i < num; i++) {
+        e = h_getEnt_(&tab, keys[(i * 7919L) % num]);
+        if (e && e->hData == keys[(i * 7919L) % num])
+            ++found;
+    }
+    printf("%-6s get    %8d %8.3fs\n", name, found, elapsed(&t0));
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < num; i += 2)
+        h_rmEnt_(&tab, h_getEnt_(&tab, keys[i]));
+    printf("%-6s remove %8d %8.3fs\n", name, num / 2, elapsed(&t0));
+
+    for (i = 0, e = h_firstEnt_(&tab, &s); e; e = h_nextEnt_(&s))
+        ++i;
+    if (i != tab.numEnts || i != num - (num + 1) / 2) {
+        printf("%-6s wrong content %d entries\n", name, i);
+        exit(-1);
+    }
+
+    h_freeTab_(&tab, noFree);
+}
+
+int
+main(int argc, char **argv)
+{
+    char **keys;
+    char buf[64];
+    int num;
+    int i;
+
+    num = argc > 1 ? atoi(argv[1]) : 1000000;
+    keys = calloc(num, sizeof(char *));
+
+    /* Job ids as printed by the string
+     * keyed job tables.
+     */
+    for (i = 0; i < num; i++) {
+        sprintf(buf, "%lld", ((long long)(i % 1000 + 1) << 32) | (i / 1000 + 1));
+        keys[i] = strdup(buf);
+    }
+    testKeys("jobs", keys, num);
+    for (i = 0; i < num; i++)
+        free(keys[i]);
+
+    /* Host and user like names.
+     */
+    for (i = 0; i < num; i++) {
+        sprintf(buf, "node%04d.rack%03d.cluster", i % 10000, i / 10000);
+        keys[i] = strdup(buf);
+    }
+    testKeys("hosts", keys, num);
+    for (i = 0; i < num; i++)
+        free(keys[i]);
+
+    free(keys);
+    return 0;
+}
+
+#endif
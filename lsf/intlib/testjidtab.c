@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#if _JIDTAB_TEST_
+
+/* Microbenchmark of the job id table against the
+ * string keyed hTab used before, build in the build tree with:
+ *
+ * gcc -D_JIDTAB_TEST_=1 -O2 -I../.. -I.. -I/usr/include/tirpc \
+ *     -DHAVE_CONFIG_H testjidtab.c jidtab.c ../lib/liblsf.a \
+ *     -ltirpc -o testjidtab
+ *
+ * and run as testjidtab [numJobs] [numArrayElements]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include "jidtab.h"
+#include "../lib/lib.table.h"
+
+#define LSB_JOBID(jobId, idx) ((((LS_LONG_INT)(idx)) << 32) | (jobId))
+
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return (t.tv_sec - t0->tv_sec) + (t.tv_usec - t0->tv_usec) / 1e6;
+}
+
+static void
+noFree(void *p)
+{
+}
+
+static void
+testHTab(LS_LONG_INT *ids, int num)
+{
+    struct timeval t0;
+    char key[32];
+    hTab tab;
+    hEnt *e;
+    int i;
+    int new;
+    int found;
+
+    h_initTab_(&tab, 50);
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < num; i++) {
+        sprintf(key, "%lld", ids[i]);
+        e = h_addEnt_(&tab, key, &new);
+        e->hData = &ids[i];
+    }
+    printf("hTab   add    %d %8.3fs\n", num, elapsed(&t0));
+
+    gettimeofday(&t0, NULL);
+    for (i = 0, found = 0; i < num; i++) {
+        sprintf(key, "%lld", ids[(i * 7919L) % num]);
+        if (h_getEnt_(&tab, key))
+            ++found;
+    }
+    printf("hTab   get    %d %8.3fs\n", found, elapsed(&t0));
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < num; i += 2) {
+        sprintf(key, "%lld", ids[i]);
+        h_rmEnt_(&tab, h_getEnt_(&tab, key));
+    }
+    printf("hTab   remove %d %8.3fs\n", num / 2, elapsed(&t0));
+
+    h_freeTab_(&tab, noFree);
+}
+
+static void
+testJidTab(LS_LONG_INT *ids, int num)
+{
+    struct timeval t0;
+    jidTab tab;
+    jidIter iter;
+    jidEnt *e;
+    int i;
+    int new;
+    int found;
+
+    jidInitTab(&tab, 50);
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < num; i++) {
+        e = jidAddEnt(&tab, ids[i], &new);
+        if (e == NULL || !new) {
+            printf("jidAddEnt failed at %d\n", i);
+            exit(-1);
+        }
+        e->hData = &ids[i];
+    }
+    printf("jidTab add    %d %8.3fs\n", num, elapsed(&t0));
+
+    gettimeofday(&t0, NULL);
+    for (i = 0, found = 0; i < num; i++) {
+        e = jidGetEnt(&tab, ids[(i * 7919L) % num]);
+        if (e && *(LS_LONG_INT *)e->hData == ids[(i * 7919L) % num])
+            ++found;
+    }
+    printf("jidTab get    %d %8.3fs\n", found, elapsed(&t0));
+
+    gettimeofday(&t0, NULL);
+    for (i = 0; i < num; i += 2)
+        jidRmEnt(&tab, ids[i]);
+    printf("jidTab remove %d %8.3fs\n", num / 2, elapsed(&t0));
+
+    for (i = 0, e = jidFirstEnt(&tab, &iter); e; e = jidNextEnt(&iter))
+        ++i;
+    if (i != num / 2 || JIDTAB_NUM_ENTS(&tab) != num / 2
+        || jidGetEnt(&tab, ids[0]) || !jidGetEnt(&tab, ids[1])) {
+        printf("jidTab wrong content %d entries\n", i);
+        exit(-1);
+    }
+
+    jidFreeTab(&tab, noFree);
+}
+
+int
+main(int argc, char **argv)
+{
+    LS_LONG_INT *ids;
+    int numJobs;
+    int numElems;
+    int num;
+    int i;
+    int j;
+
+    numJobs = argc > 1 ? atoi(argv[1]) : 1000000;
+    numElems = argc > 2 ? atoi(argv[2]) : 1;
+
+    ids = calloc(numJobs * numElems, sizeof(LS_LONG_INT));
+    for (i = 0, num = 0; i < numJobs; i++)
+        for (j = 0; j < numElems; j++)
+            ids[num++] = LSB_JOBID(i + 1, numElems > 1 ? j + 1 : 0);
+
+    testHTab(ids, num);
+    testJidTab(ids, num);
+
+    free(ids);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2011-2014 David Bigagli
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ *
+ */
+#if _SELECT_TEST_
+
+/* Equivalence test of the compiled select code and of the
+ * tcl evaluation, build in the build tree with:
+ *
+ * gcc -D_SELECT_TEST_=1 -O2 -I../.. -I.. -I../lib -I. \
+ *     -I/usr/include/tirpc -DHAVE_CONFIG_H testselect.c \
+ *     liblsfint.a ../lib/liblsf.a -ltcl -ltirpc -lm -o testselect
+ *
+ * and run as testselect [-v]. Every select string of the
+ * table is parsed by parseResReq(), which must compile it,
+ * then evaluated on every host, with and without the from
+ * host type and in both tcl check modes, by evalSelectCode()
+ * and by evalResReq(). Any difference in the result or in
+ * overRideFromType is reported and the exit status is 1.
+ */
+#include "../lsf.h"
+#include "../lib/lib.h"
+#include "../lib/lib.conf.h"
+#include "intlibout.h"
+
+/* The cluster resources after the builtin ones, in the
+ * order tcl numbers them.
+ */
+static struct builtIn userRes[] = {
+    {"nlic", "Shared licenses", LS_NUMERIC, DECR, RESF_SHARED, 0},
+    {"osver", "OS version", LS_STRING, NA, 0, 0},
+    {"linux", "Linux host", LS_BOOLEAN, NA, 0, 0},
+    {"fs", "File server", LS_BOOLEAN, NA, 0, 0},
+    {"gpu", "Number of GPUs", LS_NUMERIC, DECR, 0, 0},
+    {NULL, NULL, LS_NUMERIC, NA, 0, 0}
+};
+
+#define NLIC   0
+#define OSVER  1
+#define LINUX  2
+#define FS     3
+#define GPU    4
+
+static char *types[] = {"LINUX", "SUNSOL", "AIX"};
+static char *models[] = {"M1", "M2", "M3"};
+
+/* Operators, precedence, string resources, booleans and
+ * defined(), in the new and in the old syntax.
+ */
+static char *selects[] = {
+    "r1m < 0.5",
+    "r15s <= 1 && r15m >= -1",
+    "ut > 0.3 || pg == 0",
+    "io != 10",
+    "mem > 100 && swp >= 200 / 2 - 10",
+    "ut*2+1 > 1 && (ls < 3 || it > 10)",
+    "1 + 2 * 3 == 7",
+    "(1 + 2) * 3 == 9",
+    "7 / 2 == 3",
+    "7.0 / 2 > 3",
+    "10 - 4 - 3 == 3",
+    "-mem < -100",
+    "!(r1m > 1) || tmp < 50",
+    "!!linux",
+    "ncpus >= 2 && maxmem > 1000 || maxswp < 100",
+    "maxtmp > 10 && ndisks > 0 && rexpri == 0",
+    "cpuf > 10.5",
+    "server && !fs",
+    "cpu < 1 && login < 5 && idle > 0 && swap > 0",
+    "linux",
+    "!linux",
+    "linux && fs || !linux && !fs",
+    "linux || fs && gpu > 0",
+    "(linux || fs) && gpu > 0",
+    "nlic > 2",
+    "nlic >= 1 && gpu == 0",
+    "gpu",
+    "type == LINUX",
+    "type != LINUX",
+    "type == any",
+    "type == local",
+    "model == M1 || model == M3",
+    "model != M2 && type == SUNSOL",
+    "osver == v2",
+    "osver != v2",
+    "osver >= v2",
+    "osver > v2",
+    "osver <= v2",
+    "osver < v2",
+    "status == ok",
+    "status == busy || status == unavail",
+    "defined(nlic)",
+    "defined(osver) && !defined(gpu)",
+    "!defined(fs) || defined(linux)",
+    "r1m < 1 && type == LINUX && defined(osver) && nlic > 0",
+    "r1m=0.5:mem=100",
+    "linux:-fs",
+    "type=SUNSOL:model=M2",
+    "ut=0.2:it",
+    NULL
+};
+
+struct host {
+    char    *name;
+    char    *type;
+    char    *model;
+    float   cpuFactor;
+    int     status;
+    int     ncpus;
+    int     nDisks;
+    int     inactivity;
+    float   r1m;
+    float   ut;
+    float   mem;
+    int     bools;
+    char    *nlic;
+    char    *osver;
+    char    *gpu;
+};
+
+static struct host hosts[] = {
+    {"h1", "LINUX", "M1", 1.0, 0, 4, 1, 0,
+     0.2, 0.1, 512, 1 << LINUX, "4", "v2", "2"},
+    {"h2", "SUNSOL", "M2", 12.0, LIM_BUSY, 1, 0, 0,
+     1.5, 0.9, 64, 1 << FS, "0", "v10", NULL},
+    {"h3", "LINUX", "M3", 2.5, 0, 8, 2, -1,
+     0.0, 0.4, 4096, (1 << LINUX) | (1 << FS), NULL, "v1", "0"},
+    {"h4", "AIX", "M1", 0.5, LIM_UNAVAIL, 2, 1, 0,
+     3.0, 1.0, 100, 0, "-", NULL, "-"},
+    {"h5", "LINUX", "M2", 1.0, 0, 2, 1, 0,
+     0.4, 0.3, INFINIT_LOAD, 1 << LINUX, "3", "v3", "1"},
+    {NULL}
+};
+
+static struct lsInfo lsInfo;
+static struct tclLsInfo tclLsInfo;
+static int verbose;
+
+static void
+makeLsInfo(void)
+{
+    static char *resName[sizeof(userRes) / sizeof(userRes[0])];
+    static char *indexNames[NBUILTINDEX];
+    static int stringBits[1];
+    static int numericBits[1];
+    struct builtIn *b;
+    int i;
+    int n;
+
+    n = 0;
+    for (b = builtInRes; b->name; b++)
+        n++;
+    for (b = userRes; b->name; b++)
+        n++;
+
+    lsInfo.resTable = calloc(n, sizeof(struct resItem));
+    for (b = builtInRes; b->name; b++) {
+        struct resItem *r = &lsInfo.resTable[lsInfo.nRes++];
+
+        strcpy(r->name, b->name);
+        strcpy(r->des, b->des);
+        r->valueType = b->valueType;
+        r->orderType = b->orderType;
+        r->flags = b->flags | RESF_BUILTIN;
+        if (lsInfo.nRes <= NBUILTINDEX)
+            r->flags |= RESF_DYNAMIC;
+        r->interval = b->interval;
+    }
+
+    tclLsInfo.resName = resName;
+    tclLsInfo.stringResBitMaps = stringBits;
+    tclLsInfo.numericResBitMaps = numericBits;
+    for (b = userRes; b->name; b++) {
+        struct resItem *r = &lsInfo.resTable[lsInfo.nRes++];
+
+        strcpy(r->name, b->name);
+        strcpy(r->des, b->des);
+        r->valueType = b->valueType;
+        r->orderType = b->orderType;
+        r->flags = b->flags;
+
+        if (b->valueType == LS_STRING)
+            SET_BIT(tclLsInfo.nRes, stringBits);
+        if (b->valueType == LS_NUMERIC)
+            SET_BIT(tclLsInfo.nRes, numericBits);
+        resName[tclLsInfo.nRes++] = b->name;
+    }
+
+    lsInfo.numIndx = NBUILTINDEX;
+    for (i = 0; i < NBUILTINDEX; i++)
+        indexNames[i] = lsInfo.resTable[i].name;
+    tclLsInfo.numIndx = NBUILTINDEX;
+    tclLsInfo.indexNames = indexNames;
+
+    for (i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+        strcpy(lsInfo.hostTypes[lsInfo.nTypes++], types[i]);
+    for (i = 0; i < sizeof(models) / sizeof(models[0]); i++)
+        strcpy(lsInfo.hostModels[lsInfo.nModels++], models[i]);
+}
+
+static void
+makeHost(struct host *h, struct tclHostData *t)
+{
+    int i;
+
+    memset(t, 0, sizeof(struct tclHostData));
+
+    t->hostName = h->name;
+    t->maxCpus = h->ncpus;
+    t->maxMem = h->ncpus * 1024;
+    t->maxSwap = 2 * t->maxMem;
+    t->maxTmp = 100;
+    t->nDisks = h->nDisks;
+    t->hostInactivityCount = h->inactivity;
+    t->status = calloc(1, sizeof(int));
+    t->status[0] = h->status;
+    t->loadIndex = calloc(NBUILTINDEX, sizeof(float));
+    for (i = 0; i < NBUILTINDEX; i++)
+        t->loadIndex[i] = 10 * i + 1;
+    t->loadIndex[R15S] = h->r1m / 2;
+    t->loadIndex[R1M] = h->r1m;
+    t->loadIndex[R15M] = h->r1m * 2;
+    t->loadIndex[UT] = h->ut;
+    t->loadIndex[PG] = 0;
+    t->loadIndex[MEM] = h->mem;
+    t->rexPriority = h->cpuFactor > 2 ? 10 : 0;
+    t->hostType = h->type;
+    t->hostModel = h->model;
+    t->fromHostType = "LINUX";
+    t->fromHostModel = "M1";
+    t->cpuFactor = h->cpuFactor;
+    t->resBitMaps = calloc(1, sizeof(int));
+    t->resBitMaps[0] = h->bools;
+
+    t->resPairs = calloc(3, sizeof(struct resPair));
+    if (h->nlic) {
+        t->resPairs[t->numResPairs].name = "nlic";
+        t->resPairs[t->numResPairs++].value = h->nlic;
+    }
+    if (h->osver) {
+        t->resPairs[t->numResPairs].name = "osver";
+        t->resPairs[t->numResPairs++].value = h->osver;
+    }
+    if (h->gpu) {
+        t->resPairs[t->numResPairs].name = "gpu";
+        t->resPairs[t->numResPairs++].value = h->gpu;
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    struct tclHostData thosts[sizeof(hosts) / sizeof(hosts[0])];
+    struct resVal rv;
+    int numHosts;
+    int numBad;
+    int numEvals;
+    int i;
+    int j;
+    int flag;
+    int fromType;
+
+    if (argc > 1 && strcmp(argv[1], "-v") == 0)
+        verbose = 1;
+
+    makeLsInfo();
+    initParse(&lsInfo);
+    if (initTcl(&tclLsInfo) < 0) {
+        fprintf(stderr, "initTcl() failed\n");
+        return 1;
+    }
+
+    for (numHosts = 0; hosts[numHosts].name; numHosts++)
+        makeHost(&hosts[numHosts], &thosts[numHosts]);
+
+    numBad = numEvals = 0;
+    for (i = 0; selects[i]; i++) {
+        int bad;
+
+        memset(&rv, 0, sizeof(struct resVal));
+        if (parseResReq(selects[i], &rv, &lsInfo, PR_SELECT) != PARSE_OK) {
+            printf("%-50s parse error\n", selects[i]);
+            numBad++;
+            continue;
+        }
+        if (rv.selectCode == NULL) {
+            printf("%-50s not compiled: %s\n", selects[i], rv.selectStr);
+            numBad++;
+            freeResVal(&rv);
+            continue;
+        }
+
+        bad = 0;
+        for (j = 0; j < numHosts; j++) {
+            struct tclHostData *t = &thosts[j];
+
+            for (flag = TCL_CHECK_SYNTAX;
+                 flag <= TCL_CHECK_EXPRESSION; flag++) {
+                for (fromType = FALSE; fromType <= TRUE; fromType++) {
+                    int cc1, cc2;
+                    int o1, o2;
+
+                    t->flag = flag;
+                    cc1 = evalSelectCode(rv.selectCode, rv.selectStr,
+                                         t, fromType);
+                    o1 = t->overRideFromType;
+                    cc2 = evalResReq(rv.selectStr, t, fromType);
+                    o2 = t->overRideFromType;
+                    numEvals++;
+
+                    if (cc1 != cc2 || (cc1 >= 0 && o1 != o2)) {
+                        printf("\
+%-50s %s flag %d fromType %d: compiled %d/%d tcl %d/%d\n",
+                               selects[i], t->hostName, flag, fromType,
+                               cc1, o1, cc2, o2);
+                        bad++;
+                    } else if (verbose && flag == TCL_CHECK_EXPRESSION
+                               && !fromType) {
+                        printf("%-50s %s %d\n", selects[i], t->hostName, cc1);
+                    }
+                }
+            }
+        }
+
+        if (bad) {
+            printf("%-50s %s\n", "", rv.selectStr);
+            numBad++;
+        } else {
+            printf("%-50s same\n", selects[i]);
+        }
+        freeResVal(&rv);
+    }
+
+    printf("%d select strings %d evaluations %d differ\n",
+           i, numEvals, numBad);
+
+    return numBad != 0;
+}
+
+#endif /* _SELECT_TEST_ */
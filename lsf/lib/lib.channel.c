@@ -19,6 +19,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <syslog.h>
+#include <sys/epoll.h>
 #include "lib.h"
 #include "lproto.h"
 #include "lib.osal.h"
@@ -30,6 +31,25 @@
 
 #define NL_SETN   23
 
+#define CHAN_MAX_EVENTS 4096
+
+/* Outcome of doread() and dowrite()
+ */
+#define IO_ERR    -1
+#define IO_AGAIN   0
+#define IO_MORE    1
+#define IO_DONE    2
+
+#define DIRTY_WATCH  0x01
+#define DIRTY_REARM  0x02
+
+#define CHAN_SLAB_MIN      256
+#define CHAN_SLAB_CLASSES  5      /* 256 bytes to 64KB by 4 */
+#define CHAN_SLAB_KEEP     256    /* free slabs kept per class */
+#define CHAN_MAX_IOV       64
+
+#define SLAB_SIZE(c)  (CHAN_SLAB_MIN << (2 * (c)))
+
 #define CLOSEIT(i) {                            \
         CLOSESOCKET(channels[i].handle);        \
         channels[i].state = CH_DISC;            \
@@ -41,10 +61,46 @@ extern int errno;
 int chanIndex;
 static int chanMaxSize;
 
+/* The epoll set of chanPoll_(), created by its first call.
+ * A channel whose interest may have changed is put on the
+ * dirty list and the set is brought up to date before
+ * waiting, so a wakeup costs in the number of ready and
+ * changed channels, not in the number of channels.
+ */
+static int epfd = -1;
+static pid_t epPid;
+static int *dirtyList;
+static int numDirty;
+static int maxEvents;
+static struct epoll_event *epEvents;
+static struct chanEvent *readyList;
+static int numReady;
+
+/* Pool of message buffers. The data of a buffer is a slab
+ * of one of the fixed size classes and a freed buffer is
+ * kept with its slab on the free list of the class, so
+ * a message costs no malloc() once the daemon is warm.
+ * Data larger than the biggest class is malloc()ed.
+ */
+static struct Buffer *slabFree[CHAN_SLAB_CLASSES];
+static int numSlabFree[CHAN_SLAB_CLASSES];
+static struct chanBufStats bufStats;
+
 extern int CreateSock_(int);
 
-static void doread(int , struct Masks *);
-static void dowrite(int, struct Masks *);
+static int doread(int);
+static int dowrite(int);
+static int chanFill(int);
+static int chanFlush(int);
+static int chanPollInit(void);
+static int chanInterest(int);
+static void chanWatch(void);
+static void chanUnwatch(int);
+static void chanDirty(int, int);
+static struct Buffer *bufGet(int);
+static void bufPut(struct Buffer *);
+static int bufGrow(struct Buffer *, int);
+static int bufIov(struct Buffer *, int, struct iovec *, int);
 static struct Buffer *newBuf(void);
 static void enqueueTail_(struct Buffer *, struct Buffer *);
 static void dequeue_(struct Buffer *);
@@ -121,6 +177,7 @@ chanServSocket_(int type, u_short port, int backlog, int options)
         channels[ch].type  = CH_TYPE_UDP;
     else
         channels[ch].type  = CH_TYPE_PASSIVE;
+    chanDirty(ch, DIRTY_WATCH);
     return(ch);
 }
 
@@ -267,6 +324,7 @@ chanInactivate_(int chfd)
     if (channels[chfd].state != CH_INACTIVE) {
         channels[chfd].prestate = channels[chfd].state;
         channels[chfd].state = CH_INACTIVE;
+        chanDirty(chfd, DIRTY_WATCH);
     }
 }
 
@@ -278,6 +336,7 @@ chanActivate_(int chfd)
 
     if (channels[chfd].state == CH_INACTIVE) {
         channels[chfd].state = channels[chfd].prestate;
+        chanDirty(chfd, DIRTY_WATCH);
     }
 }
 
@@ -503,6 +562,7 @@ chanOpen: connect() failed, laddr=%s, addr=%s"),/*catgets 5003*/
             return (-1);
         }
         channels[i].state = CH_PRECONN;
+        chanDirty(i, DIRTY_WATCH);
         return(i);
     }
 
@@ -518,6 +578,7 @@ chanOpen: connect() failed, laddr=%s, addr=%s"),/*catgets 5003*/
         return(-1);
     }
 
+    chanDirty(i, DIRTY_WATCH);
     return(i);
 
 } /* chanOpen_() */
@@ -554,6 +615,7 @@ chanOpenSock_(int s, int options)
         lserrno = LSE_MALLOC;
         return(-1);
     }
+    chanDirty(i, DIRTY_WATCH);
     return(i);
 }
 
@@ -575,6 +637,16 @@ chanClose_(int chfd)
         cherrno = CHANE_BADCHFD;
         return(-1);
     }
+
+    /* Leave the epoll set before the close as a copy
+     * of the socket in a child would keep it there,
+     * and drop the events not yet seen by the caller.
+     */
+    chanUnwatch(chfd);
+    if (channels[chfd].ready > 0) {
+        readyList[channels[chfd].ready - 1].events = 0;
+        channels[chfd].ready = 0;
+    }
     close(channels[chfd].handle);
 
     if (channels[chfd].send
@@ -582,8 +654,7 @@ chanClose_(int chfd)
         for (buf = channels[chfd].send->forw;
              buf != channels[chfd].send; buf = nextbuf) {
             nextbuf = buf->forw;
-            FREEUP(buf->data);
-            FREEUP(buf);
+            chanFreeBuf_(buf);
         }
     }
     if (channels[chfd].recv
@@ -591,8 +662,7 @@ chanClose_(int chfd)
         for (buf = channels[chfd].recv->forw;
              buf != channels[chfd].recv; buf = nextbuf) {
             nextbuf = buf->forw;
-            FREEUP(buf->data);
-            FREEUP(buf);
+            chanFreeBuf_(buf);
         }
     }
     FREEUP(channels[chfd].recv);
@@ -632,6 +702,7 @@ chanSelect_(struct Masks *sockmask,
             struct timeval *timeout)
 {
     int i;
+    int cc;
     int nReady;
     int maxfds;
 
@@ -729,21 +800,26 @@ chanSelect_(struct Masks *sockmask,
                 channels[i].state = CH_CONN;
                 channels[i].send  = newBuf();
                 channels[i].recv  = newBuf();
+                chanDirty(i, DIRTY_WATCH);
                 FD_SET(i, &(chanmask->wmask));
             }
 
         } else {
 
             if (FD_ISSET(channels[i].handle, &(sockmask->rmask))) {
-                doread(i, chanmask);
-                if (!FD_ISSET(i, &(chanmask->rmask))
-                    && !FD_ISSET(i, &(chanmask->emask)) )
+                cc = doread(i);
+                if (cc == IO_DONE)
+                    FD_SET(i, &(chanmask->rmask));
+                else if (cc == IO_ERR)
+                    FD_SET(i, &(chanmask->emask));
+                else
                     nReady--;
             }
 
             if ((channels[i].send->forw != channels[i].send)
                 && FD_ISSET(channels[i].handle, &(sockmask->wmask))) {
-                dowrite(i, chanmask);
+                if (dowrite(i) == IO_ERR)
+                    FD_SET(i, &(chanmask->emask));
             }
             FD_SET(i, &(chanmask->wmask));
         }
@@ -776,6 +852,7 @@ chanEnqueue_(int chfd, struct Buffer *msg)
     }
 
     enqueueTail_(msg, channels[chfd].send);
+    chanDirty(chfd, DIRTY_WATCH);
     return(0);
 }
 
@@ -801,9 +878,39 @@ chanDequeue_(int chfd, struct Buffer **buf)
     }
     *buf = channels[chfd].recv->forw;
     dequeue_(channels[chfd].recv->forw);
+
+    /* An edge triggered channel gets no event for the
+     * bytes of the next message already in the socket.
+     */
+    if (channels[chfd].trigger == CHAN_TRIG_EDGE)
+        chanDirty(chfd, DIRTY_REARM);
     return(0);
 }
 
+/* chanSendQueued_()
+ * Number of messages not yet written from
+ * the send queue of chfd.
+ */
+int
+chanSendQueued_(int chfd)
+{
+    struct Buffer *buf;
+    int num;
+
+    if (chfd < 0 || chfd >= chanMaxSize
+        || channels[chfd].send == NULL) {
+        cherrno = CHANE_BADCHAN;
+        return -1;
+    }
+
+    num = 0;
+    for (buf = channels[chfd].send->forw;
+         buf != channels[chfd].send; buf = buf->forw)
+        num++;
+
+    return num;
+}
+
 int
 chanReadNonBlock_(int chfd, char *buf, int len, int timeout)
 {
@@ -833,6 +940,50 @@ chanWrite_(int chfd, char *buf, int len)
 
 }
 
+/* chanWritev_()
+ * Write all the iovcnt buffers in as few system
+ * calls as possible, iov is consumed by partial
+ * writes. Return the number of bytes written or -1.
+ */
+int
+chanWritev_(int chfd, struct iovec *iov, int iovcnt)
+{
+    int cc;
+    int len;
+    int loop;
+
+    for (len = 0, cc = 0; cc < iovcnt; cc++)
+        len += iov[cc].iov_len;
+
+    for (loop = 0; iovcnt > 0 && loop < MAXLOOP; loop++) {
+
+        cc = writev(channels[chfd].handle, iov, iovcnt);
+        if (cc < 0) {
+            if (errno == EINTR)
+                continue;
+            lserrno = LSE_SOCK_SYS;
+            return -1;
+        }
+
+        while (iovcnt > 0 && cc >= iov->iov_len) {
+            cc -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + cc;
+            iov->iov_len -= cc;
+        }
+    }
+
+    if (iovcnt > 0) {
+        lserrno = LSE_SOCK_SYS;
+        return -1;
+    }
+
+    return len;
+}
+
 int
 chanRpc_(int chfd, struct Buffer *in, struct Buffer *out,
          struct LSFHeader *outhdr, int timeout)
@@ -847,24 +998,10 @@ chanRpc_(int chfd, struct Buffer *in, struct Buffer *out,
         ls_syslog(LOG_DEBUG1, "%s: Entering ... chfd=%d", fname, chfd);
 
     if (in) {
-        if (logclass & LC_COMM)
-            ls_syslog(LOG_DEBUG1,"%s: sending %d bytes", fname, in->len);
-        if (chanWrite_(chfd, in->data, in->len ) != in->len)
+        if ((cc = chanWriteBuf_(chfd, in)) < 0)
             return(-1);
-
-        if (in->forw != NULL) {
-            struct Buffer *buf=in->forw;
-            int nlen = htonl(buf->len);
-
-            if (logclass & LC_COMM)
-                ls_syslog(LOG_DEBUG1,"%s: sending %d extra bytes", fname, nlen);
-            if (chanWrite_(chfd, NET_INTADDR_(&nlen), NET_INTSIZE_)
-                != NET_INTSIZE_)
-                return (-1);
-
-            if (chanWrite_(chfd, buf->data, buf->len ) != buf->len)
-                return(-1);
-        }
+        if (logclass & LC_COMM)
+            ls_syslog(LOG_DEBUG1,"%s: sent %d bytes", fname, cc);
     }
 
 
@@ -969,6 +1106,7 @@ chanSetMode_(int chfd, int mode)
             return(-1);
         }
 
+        chanDirty(chfd, DIRTY_WATCH);
         return 0;
     }
 
@@ -980,38 +1118,32 @@ chanSetMode_(int chfd, int mode)
     return 0;
 }
 
-static void
-doread(int chfd, struct Masks *chanmask)
+/* doread()
+ * Read what the socket has of the message being received
+ * on the channel. Returns IO_DONE once the message is
+ * complete, IO_MORE if bytes were read but the message
+ * is not complete, IO_AGAIN if nothing could be read
+ * and IO_ERR with chanerr set.
+ */
+static int
+doread(int chfd)
 {
     struct Buffer *rcvbuf;
     int cc;
 
     if (channels[chfd].recv->forw == channels[chfd].recv) {
-        rcvbuf = newBuf();
+        rcvbuf = bufGet(LSF_HEADER_LEN);
         if (!rcvbuf) {
-            FD_SET(chfd, &(chanmask->emask));
             channels[chfd].chanerr = LSE_MALLOC;
-            return;
+            return IO_ERR;
         }
+        rcvbuf->len = LSF_HEADER_LEN;
         enqueueTail_(rcvbuf, channels[chfd].recv);
     } else
         rcvbuf = channels[chfd].recv->forw;
 
-    if (!rcvbuf->len) {
-        rcvbuf->data =  malloc(LSF_HEADER_LEN);
-        if (!rcvbuf->data) {
-            FD_SET(chfd, &(chanmask->emask));
-            channels[chfd].chanerr = LSE_MALLOC;
-            return;
-        }
-        rcvbuf->len = LSF_HEADER_LEN;
-        rcvbuf->pos = 0;
-    }
-
-    if (rcvbuf->pos == rcvbuf->len) {
-        FD_SET(chfd, &(chanmask->rmask));
-        return;
-    }
+    if (rcvbuf->pos == rcvbuf->len)
+        return IO_DONE;
 
     errno = 0;
 
@@ -1021,15 +1153,15 @@ doread(int chfd, struct Masks *chanmask)
         ls_syslog(LOG_ERR, "\
 %s: looks like read() has returned EOF when interrupted by a signal",
                   __func__);
-        return;
+        return IO_AGAIN;
     }
 
     if (cc <= 0) {
         if (cc == 0 || BAD_IO_ERR(errno)) {
-            FD_SET(chfd, &(chanmask->emask));
             channels[chfd].chanerr = CHANE_CONNRESET;
+            return IO_ERR;
         }
-        return;
+        return IO_AGAIN;
     }
 
     rcvbuf->pos += cc;
@@ -1038,66 +1170,417 @@ doread(int chfd, struct Masks *chanmask)
         && (rcvbuf->pos == rcvbuf->len )) {
         XDR xdrs;
         struct LSFHeader hdr;
-        char *newdata;
 
         xdrmem_create(&xdrs,
                       rcvbuf->data,
                       sizeof(struct LSFHeader),
                       XDR_DECODE);
         if (!xdr_LSFHeader(&xdrs, &hdr)) {
-            FD_SET(chfd, &(chanmask->emask));
             channels[chfd].chanerr = CHANE_BADHDR;
             xdr_destroy(&xdrs);
-            return;
+            return IO_ERR;
         }
 
         if (hdr.length) {
-            rcvbuf->len = hdr.length + LSF_HEADER_LEN;
-            newdata = realloc(rcvbuf->data, rcvbuf->len);
-            if (!newdata) {
-                FD_SET(chfd, &(chanmask->emask));
+            if (bufGrow(rcvbuf, hdr.length + LSF_HEADER_LEN) < 0) {
                 channels[chfd].chanerr = LSE_MALLOC;
                 xdr_destroy(&xdrs);
-                return;
+                return IO_ERR;
             }
-            rcvbuf->data = newdata;
+            rcvbuf->len = hdr.length + LSF_HEADER_LEN;
         }
         xdr_destroy(&xdrs);
     }
 
-    if (rcvbuf->pos == rcvbuf->len) {
-        FD_SET(chfd, &(chanmask->rmask));
+    if (rcvbuf->pos == rcvbuf->len)
+        return IO_DONE;
+
+    return IO_MORE;
+}
+
+/* dowrite()
+ * Write what the socket takes of the send queue, the
+ * segments of as many messages as fit in one writev().
+ * Returns IO_MORE if bytes were written, IO_AGAIN if
+ * the socket is full or the queue is empty and IO_ERR
+ * with chanerr set.
+ */
+static int
+dowrite(int chfd)
+{
+    struct iovec iov[CHAN_MAX_IOV];
+    struct Buffer *head;
+    struct Buffer *msg;
+    struct Buffer *seg;
+    int niov;
+    int len;
+    int cc;
+
+    head = channels[chfd].send;
+    if (head->forw == head)
+        return IO_AGAIN;
+
+    niov = 0;
+    for (msg = head->forw;
+         msg != head && niov < CHAN_MAX_IOV;
+         msg = msg->forw)
+        niov += bufIov(msg, msg->pos, iov + niov, CHAN_MAX_IOV - niov);
+
+    cc = writev(channels[chfd].handle, iov, niov);
+    if (cc < 0) {
+        if (BAD_IO_ERR(errno)) {
+            channels[chfd].chanerr = LSE_MSG_SYS;
+            return IO_ERR;
+        }
+        return IO_AGAIN;
+    }
+    bufStats.writevs++;
+    bufStats.iovecs += niov;
+
+    while (cc > 0) {
+        msg = head->forw;
+        for (len = 0, seg = msg; seg; seg = seg->next)
+            len += seg->len;
+
+        if (cc < len - msg->pos) {
+            msg->pos += cc;
+            break;
+        }
+        cc -= len - msg->pos;
+        dequeue_(msg);
+        chanFreeBuf_(msg);
     }
 
-    return;
+    if (head->forw == head)
+        chanDirty(chfd, DIRTY_WATCH);
+
+    return IO_MORE;
 }
 
-static void
-dowrite(int chfd, struct Masks *chanmask)
+/* chanFill()
+ * Read the message of a channel the poller found readable
+ * until it is complete or read() would block, the header
+ * and the body usually come in one wakeup.
+ */
+static int
+chanFill(int chfd)
 {
-    struct Buffer *sendbuf;
     int cc;
 
-    if (channels[chfd].send->forw == channels[chfd].send)
-        return;
-    else
-        sendbuf = channels[chfd].send->forw;
-
-    cc = write(channels[chfd].handle,
-               sendbuf->data + sendbuf->pos,
-               sendbuf->len - sendbuf->pos);
-    if (cc < 0 && BAD_IO_ERR(errno)){
-        FD_SET(chfd, &(chanmask->emask));
-        channels[chfd].chanerr = LSE_MSG_SYS;
-        return;
+    do {
+        cc = doread(chfd);
+    } while (cc == IO_MORE);
+
+    if (cc == IO_DONE)
+        return CHAN_EV_READ;
+    if (cc == IO_ERR)
+        return CHAN_EV_EXCEPT;
+
+    return 0;
+}
+
+/* chanFlush()
+ * Write the send queue of a channel the poller found
+ * writable, an edge triggered channel until write()
+ * would block as there is no other event before then.
+ */
+static int
+chanFlush(int chfd)
+{
+    int cc;
+
+    do {
+        cc = dowrite(chfd);
+    } while (cc == IO_MORE && channels[chfd].trigger == CHAN_TRIG_EDGE);
+
+    if (cc == IO_ERR)
+        return CHAN_EV_EXCEPT;
+
+    return 0;
+}
+
+/* chanPoll_()
+ * Wait at most timeout, forever if NULL, for channels to
+ * become ready and set *ready to the list of them. This
+ * is chanSelect_() without the FD_SETSIZE limit and the
+ * walk of all channels: CHAN_EV_READ is a complete message
+ * to chanDequeue_() or a readable raw or passive channel,
+ * CHAN_EV_EXCEPT an error, the caller closes the channel,
+ * and CHAN_EV_WRITE a connected or writable raw channel.
+ * The list is valid until the next call, an entry whose
+ * channel is closed meanwhile has its events cleared.
+ * Returns the number of entries, 0 on timeout and -1
+ * with errno set.
+ */
+int
+chanPoll_(struct chanEvent **ready, struct timeval *timeout)
+{
+    int nEvents;
+    int revents;
+    int events;
+    int chfd;
+    int ms;
+    int i;
+
+    if (epfd < 0 || epPid != getpid()) {
+        if (chanPollInit() < 0)
+            return -1;
+    }
+
+    for (i = 0; i < numReady; i++)
+        channels[readyList[i].chfd].ready = 0;
+    numReady = 0;
+    *ready = readyList;
+
+    chanWatch();
+
+    ms = -1;
+    if (timeout)
+        ms = timeout->tv_sec * 1000 + (timeout->tv_usec + 999) / 1000;
+
+    nEvents = epoll_wait(epfd, epEvents, maxEvents, ms);
+    if (nEvents <= 0)
+        return nEvents;
+
+    for (i = 0; i < nEvents; i++) {
+
+        chfd = epEvents[i].data.fd;
+        revents = epEvents[i].events;
+
+        if (channels[chfd].handle == INVALID_HANDLE)
+            continue;
+
+        /* As select() does, report errors and
+         * hangups as the socket being readable
+         * and writable for the IO to tell why.
+         */
+        if (revents & (EPOLLERR | EPOLLHUP))
+            revents |= EPOLLIN | EPOLLOUT;
+
+        events = 0;
+
+        if (revents & EPOLLPRI) {
+            events = CHAN_EV_EXCEPT;
+        } else if (channels[chfd].state == CH_PRECONN) {
+            if (revents & EPOLLOUT) {
+                channels[chfd].state = CH_CONN;
+                channels[chfd].send  = newBuf();
+                channels[chfd].recv  = newBuf();
+                chanDirty(chfd, DIRTY_WATCH);
+                events = CHAN_EV_WRITE;
+                if (!channels[chfd].send || !channels[chfd].recv) {
+                    channels[chfd].chanerr = LSE_MALLOC;
+                    events = CHAN_EV_EXCEPT;
+                }
+            }
+        } else if (!channels[chfd].send || !channels[chfd].recv) {
+            if (revents & EPOLLIN)
+                events |= CHAN_EV_READ;
+            if (revents & EPOLLOUT)
+                events |= CHAN_EV_WRITE;
+        } else {
+            if (revents & EPOLLIN)
+                events = chanFill(chfd);
+            if (events != CHAN_EV_EXCEPT && (revents & EPOLLOUT))
+                events |= chanFlush(chfd);
+            if (events & CHAN_EV_EXCEPT)
+                events = CHAN_EV_EXCEPT;
+        }
+
+        if (events == 0)
+            continue;
+
+        readyList[numReady].chfd = chfd;
+        readyList[numReady].events = events;
+        channels[chfd].ready = ++numReady;
+    }
+
+    return numReady;
+}
+
+/* chanSetTrigger_()
+ * Have chanPoll_() report the channel with level
+ * or edge triggering, channels start level triggered.
+ * An edge triggered channel is read and written until
+ * the socket would block, a passive channel must stay
+ * level triggered as it is accepted once per event.
+ */
+int
+chanSetTrigger_(int chfd, int trigger)
+{
+    if (chfd < 0 || chfd >= chanMaxSize) {
+        cherrno = CHANE_BADCHAN;
+        return -1;
+    }
+
+    if (channels[chfd].handle == INVALID_HANDLE) {
+        cherrno = CHANE_BADCHFD;
+        return -1;
+    }
+
+    if (channels[chfd].trigger != trigger) {
+        channels[chfd].trigger = trigger;
+        chanDirty(chfd, DIRTY_WATCH);
+    }
+
+    return 0;
+}
+
+/* chanPollInit()
+ * Create the epoll set, again in a child that inherited
+ * the one of its parent as the registrations made or
+ * removed on it would be those of the parent.
+ */
+static int
+chanPollInit(void)
+{
+    int i;
+
+    if (epfd >= 0)
+        close(epfd);
+
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        cherrno = CHANE_SYSCALL;
+        return -1;
     }
-    sendbuf->pos += cc;
-    if (sendbuf->pos == sendbuf->len) {
-        dequeue_(sendbuf);
-        free(sendbuf->data);
-        free(sendbuf);
+    epPid = getpid();
+
+    if (dirtyList == NULL) {
+        maxEvents = chanMaxSize < CHAN_MAX_EVENTS ?
+            chanMaxSize : CHAN_MAX_EVENTS;
+        dirtyList = calloc(chanMaxSize, sizeof(int));
+        epEvents = calloc(maxEvents, sizeof(struct epoll_event));
+        readyList = calloc(maxEvents, sizeof(struct chanEvent));
+        if (!dirtyList || !epEvents || !readyList) {
+            FREEUP(dirtyList);
+            FREEUP(epEvents);
+            FREEUP(readyList);
+            close(epfd);
+            epfd = -1;
+            cherrno = CHANE_MALLOC;
+            return -1;
+        }
+    }
+
+    numDirty = 0;
+    numReady = 0;
+    for (i = 0; i < chanIndex; i++) {
+        channels[i].watched = 0;
+        channels[i].dirty = 0;
+        channels[i].ready = 0;
+        chanDirty(i, DIRTY_WATCH);
+    }
+
+    return 0;
+}
+
+/* chanInterest()
+ * The epoll events the channel is waited for, the
+ * same rules chanSelect_() uses to build its masks.
+ */
+static int
+chanInterest(int chfd)
+{
+    struct chanData *ch;
+    int events;
+
+    ch = &channels[chfd];
+
+    if (ch->handle == INVALID_HANDLE
+        || ch->state == CH_FREE
+        || ch->state == CH_INACTIVE)
+        return 0;
+
+    if (ch->type == CH_TYPE_UDP && ch->state != CH_WAIT)
+        return 0;
+
+    if (ch->state == CH_PRECONN)
+        return EPOLLOUT;
+
+    if (ch->type == CH_TYPE_TCP && !ch->recv && !ch->send)
+        return 0;
+
+    events = EPOLLIN;
+    if (ch->type != CH_TYPE_UDP)
+        events |= EPOLLPRI;
+    if (ch->send && ch->send->forw != ch->send)
+        events |= EPOLLOUT;
+    if (ch->trigger == CHAN_TRIG_EDGE)
+        events |= EPOLLET;
+
+    return events;
+}
+
+/* chanWatch()
+ * Bring the epoll set up to date with the dirty channels.
+ */
+static void
+chanWatch(void)
+{
+    struct epoll_event ev;
+    int events;
+    int dirty;
+    int chfd;
+    int op;
+
+    while (numDirty > 0) {
+
+        chfd = dirtyList[--numDirty];
+        dirty = channels[chfd].dirty;
+        channels[chfd].dirty = 0;
+
+        events = chanInterest(chfd);
+        if (events == channels[chfd].watched
+            && !(events && (dirty & DIRTY_REARM)))
+            continue;
+
+        if (events == 0) {
+            chanUnwatch(chfd);
+            continue;
+        }
+
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.fd = chfd;
+        op = channels[chfd].watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+        if (epoll_ctl(epfd, op, channels[chfd].handle, &ev) < 0) {
+            ls_syslog(LOG_ERR, "\
+%s: epoll_ctl() failed for channel %d socket %d: %m", __func__,
+                      chfd, channels[chfd].handle);
+            continue;
+        }
+        channels[chfd].watched = events;
     }
-    return;
+}
+
+/* chanUnwatch()
+ */
+static void
+chanUnwatch(int chfd)
+{
+    struct epoll_event ev;
+
+    if (channels[chfd].watched == 0)
+        return;
+
+    if (epfd >= 0 && epPid == getpid())
+        epoll_ctl(epfd, EPOLL_CTL_DEL, channels[chfd].handle, &ev);
+    channels[chfd].watched = 0;
+}
+
+/* chanDirty()
+ */
+static void
+chanDirty(int chfd, int dirty)
+{
+    if (epfd < 0)
+        return;
+
+    if (channels[chfd].dirty == 0)
+        dirtyList[numDirty++] = chfd;
+    channels[chfd].dirty |= dirty;
 }
 
 static struct Buffer *
@@ -1119,29 +1602,77 @@ newBuf(void)
 int
 chanAllocBuf_(struct Buffer **buf, int size)
 {
-    *buf = newBuf();
+    *buf = bufGet(size);
     if (!*buf)
         return -1;
 
-    (*buf)->data = calloc(size, sizeof(char));
-    if ((*buf)->data == NULL) {
-        free(*buf);
+    memset((*buf)->data, 0, size);
+
+    return 0;
+}
+
+/* chanAttachBuf_()
+ * Make a buffer of len bytes of malloc()ed data without
+ * copying them, the data is freed with the buffer.
+ */
+int
+chanAttachBuf_(struct Buffer **buf, char *data, int len)
+{
+    *buf = newBuf();
+    if (!*buf)
         return -1;
-    }
+
+    (*buf)->data = data;
+    (*buf)->len = len;
+    bufStats.allocs++;
+    bufStats.inUse++;
 
     return 0;
 }
 
+/* chanChainBuf_()
+ * Append seg to the message buf, the segments go out
+ * with one writev() and are freed with the message.
+ */
+int
+chanChainBuf_(struct Buffer *buf, struct Buffer *seg)
+{
+    while (buf->next)
+        buf = buf->next;
+    buf->next = seg;
+
+    return 0;
+}
+
+/* chanRefBuf_()
+ * Take one more reference on buf so it can end the
+ * chain of several messages, each chanFreeBuf_()
+ * drops one and the last frees it.
+ */
+struct Buffer *
+chanRefBuf_(struct Buffer *buf)
+{
+    buf->ref++;
+    return buf;
+}
+
 int
 chanFreeBuf_(struct Buffer *buf)
 {
+    struct Buffer *next;
+
     if (buf) {
         if (buf->stashed) return 0;
 
-        if (buf->data)
-            free(buf->data);
-
-        free(buf);
+        /* A shared segment ends the part of
+         * the chain this message owns.
+         */
+        for (; buf && buf->ref == 0; buf = next) {
+            next = buf->next;
+            bufPut(buf);
+        }
+        if (buf)
+            buf->ref--;
     }
     return(0);
 }
@@ -1156,6 +1687,162 @@ chanFreeStashedBuf_(struct Buffer *buf)
     return -1 ;
 }
 
+/* chanWriteBuf_()
+ * Write the message buf with its chained segments in
+ * as few system calls as possible. Returns the number
+ * of bytes written or -1.
+ */
+int
+chanWriteBuf_(int chfd, struct Buffer *buf)
+{
+    struct iovec iov[CHAN_MAX_IOV];
+    struct Buffer *seg;
+    int niov;
+    int len;
+    int cc;
+    int n;
+
+    for (len = 0, cc = 0, seg = buf; seg; seg = seg->next)
+        len += seg->len;
+
+    while (cc < len) {
+        niov = bufIov(buf, cc, iov, CHAN_MAX_IOV);
+        if ((n = chanWritev_(chfd, iov, niov)) < 0)
+            return -1;
+        cc += n;
+    }
+
+    return len;
+}
+
+void
+chanBufStats_(struct chanBufStats *stats)
+{
+    *stats = bufStats;
+}
+
+/* bufGet()
+ * A buffer with room for size bytes, from the
+ * pool if size fits one of the slab classes.
+ */
+static struct Buffer *
+bufGet(int size)
+{
+    struct Buffer *buf;
+    int c;
+
+    for (c = 0; c < CHAN_SLAB_CLASSES; c++)
+        if (size <= SLAB_SIZE(c))
+            break;
+
+    if (c < CHAN_SLAB_CLASSES && slabFree[c] != NULL) {
+        buf = slabFree[c];
+        slabFree[c] = buf->next;
+        numSlabFree[c]--;
+        bufStats.pooled--;
+        bufStats.poolHits++;
+    } else {
+        buf = calloc(1, sizeof(struct Buffer));
+        if (!buf)
+            return NULL;
+        if (c < CHAN_SLAB_CLASSES) {
+            buf->data = malloc(SLAB_SIZE(c));
+            buf->slab = c + 1;
+        } else
+            buf->data = malloc(size);
+        if (!buf->data) {
+            free(buf);
+            return NULL;
+        }
+        bufStats.mallocs++;
+    }
+
+    buf->forw = buf->back = buf;
+    buf->pos = buf->len = 0;
+    buf->stashed = FALSE;
+    buf->next = NULL;
+    buf->ref = 0;
+    bufStats.allocs++;
+    bufStats.inUse++;
+
+    return buf;
+}
+
+/* bufPut()
+ */
+static void
+bufPut(struct Buffer *buf)
+{
+    int c;
+
+    bufStats.frees++;
+    bufStats.inUse--;
+
+    c = buf->slab - 1;
+    if (c >= 0 && numSlabFree[c] < CHAN_SLAB_KEEP) {
+        buf->next = slabFree[c];
+        slabFree[c] = buf;
+        numSlabFree[c]++;
+        bufStats.pooled++;
+        return;
+    }
+
+    FREEUP(buf->data);
+    free(buf);
+}
+
+/* bufGrow()
+ * Make room for size bytes in buf keeping the pos
+ * bytes it has, its slab goes back to the pool.
+ */
+static int
+bufGrow(struct Buffer *buf, int size)
+{
+    struct Buffer *big;
+    char *data;
+    int slab;
+
+    if (buf->slab > 0 && size <= SLAB_SIZE(buf->slab - 1))
+        return 0;
+
+    if ((big = bufGet(size)) == NULL)
+        return -1;
+    memcpy(big->data, buf->data, buf->pos);
+
+    data = buf->data;
+    slab = buf->slab;
+    buf->data = big->data;
+    buf->slab = big->slab;
+    big->data = data;
+    big->slab = slab;
+    bufPut(big);
+
+    return 0;
+}
+
+/* bufIov()
+ * Fill at most max iovecs with the segments of the
+ * message buf past its first skip bytes.
+ */
+static int
+bufIov(struct Buffer *buf, int skip, struct iovec *iov, int max)
+{
+    int niov;
+
+    for (niov = 0; buf && niov < max; buf = buf->next) {
+        if (skip >= buf->len) {
+            skip -= buf->len;
+            continue;
+        }
+        iov[niov].iov_base = buf->data + skip;
+        iov[niov].iov_len = buf->len - skip;
+        skip = 0;
+        niov++;
+    }
+
+    return niov;
+}
+
 static void
 dequeue_(struct Buffer *entry)
 {
@@ -1196,6 +1883,8 @@ findAFreeChannel(void)
     channels[i].send  = NULL;
     channels[i].recv = NULL;
     channels[i].chanerr = CHANE_NOERR;
+    channels[i].trigger = CHAN_TRIG_LEVEL;
+    channels[i].ready = 0;
 
     return i;
 }
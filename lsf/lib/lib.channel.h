@@ -18,6 +18,7 @@
 #ifndef CHANNEL_H
 #define CHANNEL_H
 #include <sys/types.h>
+#include <sys/uio.h>
 #include "lib.hdr.h"
 
 
@@ -47,6 +48,11 @@ enum chanType {CH_TYPE_UDP, CH_TYPE_TCP, CH_TYPE_LOCAL, CH_TYPE_PASSIVE,
 
 #define CHAN_INIT_BUF(b)  memset((b), 0, sizeof(struct Buffer));
 
+/* A message is a chain of buffers linked by next, on a
+ * send queue pos is the number of bytes of the whole
+ * chain written so the segments are only read and can
+ * be shared, ref counting their extra owners.
+ */
 struct Buffer {
     struct Buffer  *forw;
     struct Buffer  *back;
@@ -54,6 +60,20 @@ struct Buffer {
     int    pos;
     int    len;
     int stashed;
+    struct Buffer *next;
+    int ref;
+    int slab;
+};
+
+struct chanBufStats {
+    long allocs;
+    long poolHits;
+    long mallocs;
+    long frees;
+    long inUse;
+    long pooled;
+    long writevs;
+    long iovecs;
 };
 
 struct Masks {
@@ -71,7 +91,24 @@ struct chanData {
     int chanerr; 
     struct Buffer *send;
     struct Buffer *recv;
-    
+    int trigger;
+    int watched;
+    int dirty;
+    int ready;
+};
+
+/* Events of a channel in the ready list of chanPoll_()
+ */
+#define CHAN_EV_READ    0x01
+#define CHAN_EV_WRITE   0x02
+#define CHAN_EV_EXCEPT  0x04
+
+#define CHAN_TRIG_LEVEL 0
+#define CHAN_TRIG_EDGE  1
+
+struct chanEvent {
+    int chfd;
+    int events;
 };
 
 #define  CHANE_NOERR      0
@@ -96,8 +133,11 @@ int chanInit_(void);
 int chanOpen_(u_int, u_short, int);
 int chanEnqueue_(int chfd, struct Buffer *buf);
 int chanDequeue_(int chfd, struct Buffer **buf);
+int chanSendQueued_(int);
 
 int chanSelect_(struct Masks *, struct Masks *, struct timeval *timeout);
+int chanPoll_(struct chanEvent **, struct timeval *);
+int chanSetTrigger_(int, int);
 int chanClose_(int chfd);
 void chanCloseAll_(void);
 int chanSock_(int chfd);
@@ -114,10 +154,16 @@ int chanRpc_(int , struct Buffer *, struct Buffer *, struct LSFHeader *, int tim
 int chanRead_(int, char *, int);
 int chanReadNonBlock_(int, char *, int, int);
 int chanWrite_(int, char *, int);
+int chanWritev_(int, struct iovec *, int);
 
 int chanAllocBuf_(struct Buffer **buf, int size);
 int chanFreeBuf_(struct Buffer *buf);
 int chanFreeStashedBuf_(struct Buffer *buf);
+int chanAttachBuf_(struct Buffer **, char *, int);
+int chanChainBuf_(struct Buffer *, struct Buffer *);
+struct Buffer *chanRefBuf_(struct Buffer *);
+int chanWriteBuf_(int, struct Buffer *);
+void chanBufStats_(struct chanBufStats *);
 int chanOpenSock_(int , int);
 int chanSetMode_(int, int);
 
@@ -454,7 +454,7 @@ listtask_(char ***taskList, hTab *tasktb, int sortflag)
 {
     static char **tlist;
     hEnt *hEntPtr;
-    struct hLinks *hashLinks;
+    sTab hashSearchPtr;
     int  nEntry;
     int  index;
     int  listindex;
@@ -475,25 +475,23 @@ listtask_(char ***taskList, hTab *tasktb, int sortflag)
 
     tlist = (char **) malloc((nEntry+1) * sizeof(char *));
 
-    for (index = 0, listindex = 0; index < tasktb->size; index++) {
-        hashLinks = &(tasktb->slotPtr[index]);
-        for ( hEntPtr = (hEnt *) hashLinks->bwPtr;
-              hEntPtr != (hEnt *) hashLinks;
-              hEntPtr = (hEnt *) ((struct hLinks *) hEntPtr)->bwPtr) {
-            strcpy(buf, hEntPtr->keyname);
-            if (hEntPtr->hData != (int *)NULL) {
-                tasklen = strlen(buf);
-
-		if ((p=getenv("LSF_TRS")) != NULL)
-		    buf[tasklen] = *p;
-		else
-		    buf[tasklen] = '/';
-                strcpy(buf + tasklen + 1, (char *)hEntPtr->hData);
-            }
-
-            tlist[listindex] = putstr_(buf);
-            listindex++;
+    listindex = 0;
+    for (hEntPtr = h_firstEnt_(tasktb, &hashSearchPtr);
+         hEntPtr != NULL;
+         hEntPtr = h_nextEnt_(&hashSearchPtr)) {
+        strcpy(buf, hEntPtr->keyname);
+        if (hEntPtr->hData != (int *)NULL) {
+            tasklen = strlen(buf);
+
+            if ((p=getenv("LSF_TRS")) != NULL)
+                buf[tasklen] = *p;
+            else
+                buf[tasklen] = '/';
+            strcpy(buf + tasklen + 1, (char *)hEntPtr->hData);
         }
+
+        tlist[listindex] = putstr_(buf);
+        listindex++;
     }
 
     tlist[listindex] = NULL;
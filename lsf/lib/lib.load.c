@@ -20,6 +20,7 @@
 #include "lib.xdr.h"
 #include "lproto.h"
 #define LOAD_INFO_THRESHOLD 75
+#define LOAD_SUB_TIMEOUT    10
 
 struct hostLoad *loadinfo_(char *resReq, struct decisionReq *loadReqPtr, char *fromhost, int *numHosts, char ***outnlist);
 
@@ -320,3 +321,134 @@ ls_loadadj(char *resreq, struct placeInfo *placeinfo, int listsize)
 
 }
 
+
+/* ls_loadsubscribe()
+ * Subscribe to the load of the server hosts on a connection
+ * to the master LIM. The master replies with the hosts that
+ * changed since seqNo, or with all of them if it does not
+ * have the epoch, then it pushes the changes as they happen.
+ * Returns the channel with the first delta in delta, the
+ * channel is non blocking and the caller reads the pushed
+ * deltas with ls_loaddelta() when it is readable.
+ */
+int
+ls_loadsubscribe(unsigned int epoch, unsigned int seqNo,
+                 struct loadDelta *delta)
+{
+    struct loadSubReq req;
+    struct LSFHeader hdr;
+    struct Buffer sndbuf;
+    struct Buffer rcvbuf;
+    char buf[MSGSIZE];
+    XDR xdrs;
+    int chfd;
+
+    if (ls_getmastername() == NULL)
+        return -1;
+
+    chfd = chanClientSocket_(AF_INET, SOCK_STREAM, 0);
+    if (chfd < 0)
+        return -1;
+
+    if (chanConnect_(chfd, &sockIds_[TCP], LOAD_SUB_TIMEOUT * 1000, 0) < 0) {
+        if (errno == ECONNREFUSED)
+            lserrno = LSE_LIM_DOWN;
+        chanClose_(chfd);
+        return -1;
+    }
+
+    initLSFHeader_(&hdr);
+    hdr.opCode = LIM_LOAD_SUBSCRIBE;
+    hdr.refCode = getRefNum_();
+    hdr.version = OPENLAVA_VERSION;
+    req.epoch = epoch;
+    req.seqNo = seqNo;
+
+    xdrmem_create(&xdrs, buf, sizeof(buf), XDR_ENCODE);
+    if (!xdr_encodeMsg(&xdrs, (char *)&req, &hdr, xdr_loadSubReq, 0, NULL)) {
+        xdr_destroy(&xdrs);
+        chanClose_(chfd);
+        lserrno = LSE_BAD_XDR;
+        return -1;
+    }
+
+    CHAN_INIT_BUF(&sndbuf);
+    sndbuf.data = buf;
+    sndbuf.len = XDR_GETPOS(&xdrs);
+    xdr_destroy(&xdrs);
+    CHAN_INIT_BUF(&rcvbuf);
+
+    if (chanRpc_(chfd, &sndbuf, &rcvbuf, &hdr, LOAD_SUB_TIMEOUT * 1000) < 0) {
+        chanClose_(chfd);
+        return -1;
+    }
+
+    if (hdr.opCode != LIME_NO_ERR) {
+        FREEUP(rcvbuf.data);
+        chanClose_(chfd);
+        err_return_(hdr.opCode);
+        return -1;
+    }
+
+    xdrmem_create(&xdrs, rcvbuf.data, XDR_DECODE_SIZE_(hdr.length),
+                  XDR_DECODE);
+    if (!xdr_loadDelta(&xdrs, delta, &hdr)) {
+        xdr_destroy(&xdrs);
+        FREEUP(rcvbuf.data);
+        chanClose_(chfd);
+        lserrno = LSE_BAD_XDR;
+        return -1;
+    }
+    xdr_destroy(&xdrs);
+    FREEUP(rcvbuf.data);
+
+    if (chanSetMode_(chfd, CHAN_MODE_NONBLOCK) < 0) {
+        ls_freeloaddelta(delta);
+        chanClose_(chfd);
+        return -1;
+    }
+
+    return chfd;
+}
+
+/* ls_loaddelta()
+ * Take the next delta pushed on the subscription
+ * channel chfd. Returns 1 if there was one, 0 if
+ * none is queued and -1 if the channel is broken.
+ */
+int
+ls_loaddelta(int chfd, struct loadDelta *delta)
+{
+    struct LSFHeader hdr;
+    struct Buffer *buf;
+    XDR xdrs;
+
+    if (chanDequeue_(chfd, &buf) < 0) {
+        if (cherrno == CHANE_NOMSG)
+            return 0;
+        lserrno = LSE_MSG_SYS;
+        return -1;
+    }
+
+    xdrmem_create(&xdrs, buf->data, XDR_DECODE_SIZE_(buf->len), XDR_DECODE);
+    if (!xdr_LSFHeader(&xdrs, &hdr)
+        || hdr.opCode != LIME_NO_ERR
+        || !xdr_loadDelta(&xdrs, delta, &hdr)) {
+        xdr_destroy(&xdrs);
+        chanFreeBuf_(buf);
+        lserrno = LSE_BAD_XDR;
+        return -1;
+    }
+
+    xdr_destroy(&xdrs);
+    chanFreeBuf_(buf);
+
+    return 1;
+}
+
+void
+ls_freeloaddelta(struct loadDelta *delta)
+{
+    FREEUP(delta->loadMatrix);
+    delta->nEntry = 0;
+}
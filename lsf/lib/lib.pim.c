@@ -56,6 +56,19 @@ static int hitPGid = 0;
 static char *pimInfoBuf = NULL;
 static long pimInfoLen;
 
+/* The process table published by pim, mapped
+ * read only, and the buffers used to walk it.
+ */
+#define PIM_TABLE_TRIES 100
+
+static struct pimTable *pimTable;
+static size_t pimTableSize;
+static ino_t pimTableIno;
+static int pimBufProcs;
+static char *pimMark;
+static int *pimQueue;
+static struct pimProc *pimProcBuf;
+
 static int pimPort(struct sockaddr_in *, char *);
 static struct jRusage *readPIMInfo(int, int *);
 static int inAddPList(struct lsPidInfo *pinfo);
@@ -64,24 +77,108 @@ static FILE *openPIMFile(char *pfile);
 static int readPIMFile(char *);
 static char *getNextString(char *,char *);
 static char *readPIMBuf(char *);
+static int initPIM(void);
+static int pimRequest(struct sockaddr_in *, int, int, time_t,
+                      char *, bool_t (*)());
+static int mapPIMTable(char *);
+static int readPIMTable(int, int *);
+static int walkPIMTable(int, int, int *, int *);
 
 static int argOptions;
+static char pfile[MAXFILENAMELEN];
+static char tfile[MAXFILENAMELEN];
+static struct sockaddr_in pimAddr;
+static time_t pimSleepTime = PIM_SLEEP_TIME;
+static bool_t periodicUpdateOnly = FALSE;
+
+/* initPIM()
+ * Read the pim parameters and find the
+ * files pim writes on this host.
+ */
+static int
+initPIM(void)
+{
+    struct hostent *hp;
+    struct config_param *plp;
+    char *myHost;
+
+    for (plp = pimParams; plp->paramName != NULL; plp++) {
+         if (plp->paramValue != NULL) {
+             FREEUP (plp->paramValue);
+         }
+    }
+
+    if (initenv_(pimParams, NULL) < 0) {
+        if (logclass & LC_PIM)
+            ls_syslog(LOG_DEBUG, "%s: initenv_() failed: %M", __func__);
+        return -1;
+    }
+
+    if ((myHost = ls_getmyhostname()) == NULL) {
+        if (logclass & LC_PIM)
+            ls_syslog(LOG_DEBUG,
+                      "%s: ls_getmyhostname() failed: %m", __func__);
+        return -1;
+    }
+
+    if (pimParams[LSF_PIM_INFODIR].paramValue) {
+        sprintf(pfile, "%s/pim.info.%s",
+                pimParams[LSF_PIM_INFODIR].paramValue, myHost);
+        sprintf(tfile, "%s/pim.table.%s",
+                pimParams[LSF_PIM_INFODIR].paramValue, myHost);
+    } else {
+        if (pimParams[LSF_LIM_DEBUG].paramValue) {
+            if (pimParams[LSF_LOGDIR].paramValue) {
+                sprintf(pfile, "%s/pim.info.%s",
+                        pimParams[LSF_LOGDIR].paramValue, myHost);
+                sprintf(tfile, "%s/pim.table.%s",
+                        pimParams[LSF_LOGDIR].paramValue, myHost);
+            } else {
+                sprintf(pfile, "/tmp/pim.info.%s.%d", myHost, (int)getuid());
+                sprintf(tfile, "/tmp/pim.table.%s.%d", myHost, (int)getuid());
+            }
+        } else {
+            sprintf(pfile, "/tmp/pim.info.%s", myHost);
+            sprintf(tfile, "/tmp/pim.table.%s", myHost);
+        }
+    }
+
+    if (pimParams[LSF_PIM_SLEEPTIME].paramValue) {
+        if ((pimSleepTime =
+             atoi(pimParams[LSF_PIM_SLEEPTIME].paramValue)) < 0) {
+            if (logclass & LC_PIM)
+                ls_syslog(LOG_DEBUG, "LSF_PIM_SLEEPTIME value <%s> must be a positive integer, defaulting to %d", pimParams[LSF_PIM_SLEEPTIME].paramValue, PIM_SLEEP_TIME);
+            pimSleepTime = PIM_SLEEP_TIME;
+        }
+    }
+
+    if (pimParams[LSF_PIM_SLEEPTIME_UPDATE].paramValue != NULL
+        && strcasecmp(pimParams[LSF_PIM_SLEEPTIME_UPDATE].paramValue, "y") == 0) {
+        periodicUpdateOnly = TRUE;
+        if (logclass & LC_PIM)
+            ls_syslog(LOG_DEBUG, "%s: Only to call pim each PIM_SLEEP_TIME interval", __func__);
+    }
+
+    if ((hp = Gethostbyname_(myHost)) == NULL) {
+        return -1;
+    }
+
+    memset((char *) &pimAddr, 0, sizeof(pimAddr));
+    memcpy((char *) &pimAddr.sin_addr, (char *) hp->h_addr,
+           (int)hp->h_length);
+    pimAddr.sin_family = AF_INET;
+
+    return 0;
+}
+
 
 struct jRusage *getJInfo_(int npgid, int *pgid, int options, int cpgid)
 {
     static char fname[] = "lib.pim.c/getJInfo_()";
     struct jRusage *jru;
 
-    static char pfile[MAXFILENAMELEN];
-    char *myHost;
-    static struct sockaddr_in pimAddr;
-    struct LSFHeader sendHdr, recvHdr, hdrBuf;
-    int s, cc;
-    struct timeval timeOut;
     static time_t lastTime = 0, lastUpdateNow = 0;
     time_t now;
-    static time_t pimSleepTime = PIM_SLEEP_TIME;
-    static bool_t periodicUpdateOnly = FALSE;
 
     now = time(0);
 
@@ -90,139 +187,41 @@ struct jRusage *getJInfo_(int npgid, int *pgid, int options, int cpgid)
                  now, lastUpdateNow, pimSleepTime);
     argOptions = options;
 
-    if (lastTime == 0) {
-	struct hostent *hp;
-        struct config_param *plp;
+    if (lastTime == 0 && initPIM() < 0)
+	return NULL;
 
-        for (plp = pimParams; plp->paramName != NULL; plp++) {
-             if (plp->paramValue != NULL) {
-                 FREEUP (plp->paramValue);
-             }
-        }
 
-	if (initenv_(pimParams, NULL) < 0) {
-	    if (logclass & LC_PIM)
-		ls_syslog(LOG_DEBUG, "%s: initenv_() failed: %M", fname);
-	    return NULL;
-	}
+    if (mapPIMTable(tfile) == 0) {
 
-	if ((myHost = ls_getmyhostname()) == NULL) {
+	/* The table is shared by all the readers on the
+	 * host, ask pim to refresh it only if it is older
+	 * than our sleep time.
+	 */
+	if (now - pimTable->updTime >= pimSleepTime
+	    || (options & PIM_API_UPDATE_NOW)) {
 	    if (logclass & LC_PIM)
-		ls_syslog(LOG_DEBUG,
-			  "%s: ls_getmyhostname() failed: %m", fname);
-	    return (NULL);
+		ls_syslog(LOG_DEBUG,"%s: update now", fname);
+	    lastUpdateNow = now;
+	    pimAddr.sin_port = htons(pimTable->port);
+	    if (pimRequest(&pimAddr, options, cpgid, now, NULL, NULL) < 0)
+		return NULL;
 	}
 
-	if (pimParams[LSF_PIM_INFODIR].paramValue)
-	    sprintf(pfile, "%s/pim.info.%s",
-		    pimParams[LSF_PIM_INFODIR].paramValue, myHost);
-	else {
-	    if (pimParams[LSF_LIM_DEBUG].paramValue) {
-		if (pimParams[LSF_LOGDIR].paramValue)
-		    sprintf(pfile, "%s/pim.info.%s",
-			    pimParams[LSF_LOGDIR].paramValue, myHost);
-		else
-		    sprintf(pfile, "/tmp/pim.info.%s.%d", myHost, (int)getuid());
-	    } else {
-		sprintf(pfile, "/tmp/pim.info.%s", myHost);
-	    }
-	}
-
-	if (pimParams[LSF_PIM_SLEEPTIME].paramValue) {
-	    if ((pimSleepTime =
-		 atoi(pimParams[LSF_PIM_SLEEPTIME].paramValue)) < 0) {
-		if (logclass & LC_PIM)
-		    ls_syslog(LOG_DEBUG, "LSF_PIM_SLEEPTIME value <%s> must be a positive integer, defaulting to %d", pimParams[LSF_PIM_SLEEPTIME].paramValue, PIM_SLEEP_TIME);
-		pimSleepTime = PIM_SLEEP_TIME;
-	    }
-	}
-
-        if (pimParams[LSF_PIM_SLEEPTIME_UPDATE].paramValue != NULL
-            && strcasecmp(pimParams[LSF_PIM_SLEEPTIME_UPDATE].paramValue, "y") == 0) {
-            periodicUpdateOnly = TRUE;
-            if (logclass & LC_PIM)
-                ls_syslog(LOG_DEBUG, "%s: Only to call pim each PIM_SLEEP_TIME interval", fname);
-        }
-
-	if ((hp = Gethostbyname_(myHost)) == NULL) {
+	if (!readPIMTable(npgid, pgid))
 	    return NULL;
-	}
-
-	memset((char *) &pimAddr, 0, sizeof(pimAddr));
-	memcpy((char *) &pimAddr.sin_addr, (char *) hp->h_addr,
-	       (int)hp->h_length);
-	pimAddr.sin_family = AF_INET;
-    }
 
-
-    if (now - lastUpdateNow >= pimSleepTime || (options & PIM_API_UPDATE_NOW)) {
+    } else if (now - lastUpdateNow >= pimSleepTime
+	       || (options & PIM_API_UPDATE_NOW)) {
         if (logclass & LC_PIM)
 	    ls_syslog(LOG_DEBUG,"%s: update now", fname);
 	lastUpdateNow = now;
 
-	if ((s = TcpCreate_(FALSE, 0)) < 0) {
-	    if (logclass & LC_PIM)
-		ls_syslog(LOG_DEBUG, "%s: tcpCreate failed: %m", fname);
-	    return (NULL);
-	}
-
-	if (pimPort(&pimAddr, pfile) == -1) {
-	    close(s);
+	if (pimPort(&pimAddr, pfile) == -1)
 	    return (NULL);
-	}
 
-	if (b_connect_(s, (struct sockaddr *) &pimAddr, sizeof(pimAddr), 0)
-	    == -1) {
-	    if (logclass & LC_PIM)
-		ls_syslog(LOG_DEBUG, "%s: b_connect() failed: %m", fname);
-	    lserrno = LSE_CONN_SYS;
-	    close(s);
-	    return (NULL);
-	}
-
-	initLSFHeader_(&sendHdr);
-	initLSFHeader_(&recvHdr);
-
-	sendHdr.opCode = options;
-	sendHdr.refCode = (short) now & 0xffff;
-	sendHdr.reserved = cpgid;
-
-	if ((cc = writeEncodeHdr_(s, &sendHdr, b_write_fix)) < 0) {
-	    if (logclass & LC_PIM)
-		ls_syslog(LOG_DEBUG,
-			  "%s: writeEncodeHdr failed cc=%d: %M", fname, cc);
-	    close(s);
-	    return (NULL);
-	}
-
-	timeOut.tv_sec = 10;
-	timeOut.tv_usec = 0;
-	if ((cc = rd_select_(s, &timeOut)) < 0) {
-	    if (logclass & LC_PIM)
-		ls_syslog(LOG_DEBUG, "%s: rd_select_ cc=%d: %m", fname, cc);
-	    close(s);
-	    return (NULL);
-	}
-
-	if ((cc = lsRecvMsg_(s, (char *) &hdrBuf, sizeof(hdrBuf), &recvHdr,
-			     NULL, NULL, b_read_fix)) < 0) {
-	    if (logclass & LC_PIM)
-		ls_syslog(LOG_DEBUG, "%s: lsRecvMsg_ failed cc=%d: %M",
-			  fname, cc);
-	    close(s);
-	    return (NULL);
-	}
-	close(s);
+	if (pimRequest(&pimAddr, options, cpgid, now, NULL, NULL) < 0)
+	    return NULL;
 
-	if (recvHdr.refCode != sendHdr.refCode) {
-	    if (logclass & LC_PIM)
-		ls_syslog(LOG_DEBUG,
-			  "%s: recv refCode=%d not equal to send refCode=%d, server is not PIM",
-			  fname, (int) recvHdr.refCode, (int) sendHdr.refCode);
-	    return (NULL);
-	}
-        if (logclass & LC_PIM)
-	    ls_syslog(LOG_DEBUG,"%s updated now",fname);
 	if (!readPIMFile(pfile)) {
 		ls_syslog(LOG_ERR, I18N_FUNC_FAIL,  fname, "readPIMFile");
 		return(NULL);
@@ -250,6 +249,361 @@ struct jRusage *getJInfo_(int npgid, int *pgid, int options, int cpgid)
 
 }
 
+/* getPIMStats_()
+ * The statistics of the pim scans on this host.
+ */
+struct pimStats *
+getPIMStats_(void)
+{
+    static struct pimStats stats;
+    static int inited;
+
+    if (!inited) {
+        if (initPIM() < 0)
+            return NULL;
+        inited = TRUE;
+    }
+
+    if (mapPIMTable(tfile) == 0)
+        pimAddr.sin_port = htons(pimTable->port);
+    else if (pimPort(&pimAddr, pfile) < 0)
+        return NULL;
+
+    if (pimRequest(&pimAddr, PIM_API_STATS, 0, time(NULL),
+                   (char *)&stats, xdr_pimStats) < 0)
+        return NULL;
+
+    return &stats;
+}
+
+bool_t
+xdr_pimStats(XDR *xdrs, struct pimStats *stats, struct LSFHeader *hdr)
+{
+    if (!(xdr_int(xdrs, &stats->numProcs)
+          && xdr_int(xdrs, &stats->numJobProcs)
+          && xdr_int(xdrs, &stats->numNew)
+          && xdr_int(xdrs, &stats->numGone)
+          && xdr_int(xdrs, &stats->numOpen)
+          && xdr_int(xdrs, &stats->numScans)
+          && xdr_int(xdrs, &stats->scanTime)
+          && xdr_int(xdrs, &stats->maxScanTime)))
+        return FALSE;
+
+    return TRUE;
+}
+
+/* pimRequest()
+ * Send the request opCode to pim and wait for its
+ * reply, decoded in data by xdrFunc if there is one.
+ * The default request makes pim scan the processes.
+ */
+static int
+pimRequest(struct sockaddr_in *pimAddr, int opCode, int cpgid, time_t now,
+           char *data, bool_t (*xdrFunc)())
+{
+    static char fname[] = "pimRequest";
+    struct LSFHeader sendHdr, recvHdr;
+    struct timeval timeOut;
+    char buf[MSGSIZE];
+    int s, cc;
+
+    if ((s = TcpCreate_(FALSE, 0)) < 0) {
+	if (logclass & LC_PIM)
+	    ls_syslog(LOG_DEBUG, "%s: tcpCreate failed: %m", fname);
+	return -1;
+    }
+
+    if (b_connect_(s, (struct sockaddr *) pimAddr, sizeof(*pimAddr), 0)
+	== -1) {
+	if (logclass & LC_PIM)
+	    ls_syslog(LOG_DEBUG, "%s: b_connect() failed: %m", fname);
+	lserrno = LSE_CONN_SYS;
+	close(s);
+	return -1;
+    }
+
+    initLSFHeader_(&sendHdr);
+    initLSFHeader_(&recvHdr);
+
+    sendHdr.opCode = opCode;
+    sendHdr.refCode = (short) now & 0xffff;
+    sendHdr.reserved = cpgid;
+
+    if ((cc = writeEncodeHdr_(s, &sendHdr, b_write_fix)) < 0) {
+	if (logclass & LC_PIM)
+	    ls_syslog(LOG_DEBUG,
+		      "%s: writeEncodeHdr failed cc=%d: %M", fname, cc);
+	close(s);
+	return -1;
+    }
+
+    timeOut.tv_sec = 10;
+    timeOut.tv_usec = 0;
+    if ((cc = rd_select_(s, &timeOut)) < 0) {
+	if (logclass & LC_PIM)
+	    ls_syslog(LOG_DEBUG, "%s: rd_select_ cc=%d: %m", fname, cc);
+	close(s);
+	return -1;
+    }
+
+    if ((cc = lsRecvMsg_(s, buf, sizeof(buf), &recvHdr,
+			 data, xdrFunc, b_read_fix)) < 0) {
+	if (logclass & LC_PIM)
+	    ls_syslog(LOG_DEBUG, "%s: lsRecvMsg_ failed cc=%d: %M",
+		      fname, cc);
+	close(s);
+	return -1;
+    }
+    close(s);
+
+    if (recvHdr.refCode != sendHdr.refCode) {
+	if (logclass & LC_PIM)
+	    ls_syslog(LOG_DEBUG,
+		      "%s: recv refCode=%d not equal to send refCode=%d, server is not PIM",
+		      fname, (int) recvHdr.refCode, (int) sendHdr.refCode);
+	return -1;
+    }
+    if (logclass & LC_PIM)
+	ls_syslog(LOG_DEBUG,"%s updated now",fname);
+
+    return 0;
+}
+
+/* mapPIMTable()
+ * Map the process table pim publishes, mapping it
+ * again if pim created a new file. Returns -1 if
+ * there is no valid table, an older pim or one on
+ * a platform that writes the text file.
+ */
+static int
+mapPIMTable(char *tfile)
+{
+    struct pimTable *t;
+    struct stat st;
+    int fd;
+
+    if (stat(tfile, &st) < 0) {
+	if (pimTable) {
+	    munmap(pimTable, pimTableSize);
+	    pimTable = NULL;
+	}
+	return -1;
+    }
+
+    if (pimTable && st.st_ino == pimTableIno)
+	return 0;
+
+    if (pimTable) {
+	munmap(pimTable, pimTableSize);
+	pimTable = NULL;
+    }
+
+    if (st.st_size < sizeof(struct pimTable))
+	return -1;
+
+    if ((fd = open(tfile, O_RDONLY)) < 0)
+	return -1;
+
+    t = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (t == MAP_FAILED) {
+	if (logclass & LC_PIM)
+	    ls_syslog(LOG_DEBUG, "%s: mmap(%s) failed: %m", __func__, tfile);
+	return -1;
+    }
+
+    if (t->magic != PIM_TABLE_MAGIC
+	|| t->version != PIM_TABLE_VERSION
+	|| t->maxProcs < 0
+	|| t->hashSize <= 0
+	|| (t->hashSize & (t->hashSize - 1)) != 0
+	|| PIM_TABLE_SIZE(t->maxProcs, t->hashSize) > st.st_size) {
+	if (logclass & LC_PIM)
+	    ls_syslog(LOG_DEBUG, "\
+%s: %s is not a valid process table version %d", __func__,
+		      tfile, PIM_TABLE_VERSION);
+	munmap(t, st.st_size);
+	return -1;
+    }
+
+    if (t->maxProcs > pimBufProcs) {
+	FREEUP(pimMark);
+	FREEUP(pimQueue);
+	FREEUP(pimProcBuf);
+	pimBufProcs = 0;
+	pimMark = malloc(t->maxProcs + 1);
+	pimQueue = malloc((t->maxProcs + 1) * sizeof(int));
+	pimProcBuf = malloc((t->maxProcs + 1) * sizeof(struct pimProc));
+	if (pimMark == NULL || pimQueue == NULL || pimProcBuf == NULL) {
+	    ls_syslog(LOG_ERR, I18N_FUNC_FAIL_M, __func__, "malloc");
+	    munmap(t, st.st_size);
+	    return -1;
+	}
+	pimBufProcs = t->maxProcs;
+    }
+
+    pimTable = t;
+    pimTableSize = st.st_size;
+    pimTableIno = st.st_ino;
+
+    return 0;
+}
+
+/* readPIMTable()
+ * Copy the processes of the given process groups, and of
+ * the groups their children created, from the shared table
+ * into pinfoList so readPIMInfo() sees only those. The copy
+ * is retried if pim updated the table meanwhile.
+ */
+static int
+readPIMTable(int npgid, int *pgid)
+{
+    static char fname[] = "readPIMTable";
+    struct pimTable *t;
+    unsigned int seqNo;
+    int numProcs;
+    int tries;
+    int num;
+    int ok;
+    int i;
+
+    t = pimTable;
+    num = 0;
+
+    for (tries = 0; tries < PIM_TABLE_TRIES; tries++) {
+
+	if ((seqNo = t->seqNo) & 1) {
+	    millisleep_(1);
+	    continue;
+	}
+	__sync_synchronize();
+
+	numProcs = t->numProcs;
+	ok = numProcs >= 0 && numProcs <= t->maxProcs
+	    && walkPIMTable(numProcs, npgid, pgid, &num);
+
+	__sync_synchronize();
+	if (ok && t->seqNo == seqNo)
+	    break;
+    }
+
+    if (tries == PIM_TABLE_TRIES) {
+	ls_syslog(LOG_ERR, "\
+%s: process table is being updated, gave up after %d tries",
+		  fname, PIM_TABLE_TRIES);
+	return FALSE;
+    }
+
+    FREEUP(pinfoList);
+    npinfoList = 0;
+    pinfoList = calloc(num + 1, sizeof(struct lsPidInfo));
+    if (pinfoList == NULL) {
+	ls_syslog(LOG_ERR, I18N_FUNC_D_FAIL_M, fname,  "calloc",
+		  (num + 1) * sizeof(struct lsPidInfo));
+	return FALSE;
+    }
+
+    for (i = 0; i < num; i++) {
+	pinfoList[i].pid = pimProcBuf[i].pid;
+	pinfoList[i].ppid = pimProcBuf[i].ppid;
+	pinfoList[i].pgid = pimProcBuf[i].pgid;
+	pinfoList[i].jobid = pimProcBuf[i].jobid;
+	pinfoList[i].utime = pimProcBuf[i].utime;
+	pinfoList[i].stime = pimProcBuf[i].stime;
+	pinfoList[i].cutime = pimProcBuf[i].cutime;
+	pinfoList[i].cstime = pimProcBuf[i].cstime;
+	pinfoList[i].proc_size = pimProcBuf[i].proc_size;
+	pinfoList[i].resident_size = pimProcBuf[i].resident_size;
+	pinfoList[i].stack_size = pimProcBuf[i].stack_size;
+	pinfoList[i].status = pimProcBuf[i].status;
+    }
+    npinfoList = num;
+
+    return TRUE;
+}
+
+/* walkPIMTable()
+ * Mark the processes of the process groups in the queue
+ * following the pgid chains, a child found on the ppid
+ * chain in another group queues its group. The marked
+ * processes are copied in table order, the order
+ * readPIMInfo() expects. Returns FALSE if a chain is
+ * broken, the writer was updating it.
+ */
+static int
+walkPIMTable(int numProcs, int npgid, int *pgid, int *num)
+{
+    struct pimTable *t;
+    struct pimProc *p;
+    int *pgidHash;
+    int *ppidHash;
+    int nqueue;
+    int q, i, c, k;
+    int len;
+    int clen;
+
+    t = pimTable;
+    p = PIM_PROCS(t);
+    pgidHash = PIM_PGID_HASH(t);
+    ppidHash = PIM_PPID_HASH(t);
+
+    if (argOptions & PIM_API_TREAT_JID_AS_PGID) {
+	memset(pimMark, 1, numProcs);
+	goto copy;
+    }
+
+    memset(pimMark, 0, numProcs);
+    nqueue = 0;
+
+    for (q = 0; q < npgid + nqueue; q++) {
+	int g;
+
+	g = q < npgid ? pgid[q] : pimQueue[q - npgid];
+
+	for (i = pgidHash[PIM_HASH(t, g)], len = 0;
+	     i != -1;
+	     i = p[i].nextPgid) {
+
+	    if (i < 0 || i >= numProcs || ++len > numProcs)
+		return FALSE;
+	    if (p[i].pgid != g || pimMark[i])
+		continue;
+	    pimMark[i] = 1;
+
+	    for (c = ppidHash[PIM_HASH(t, p[i].pid)], clen = 0;
+		 c != -1;
+		 c = p[c].nextPpid) {
+
+		if (c < 0 || c >= numProcs || ++clen > numProcs)
+		    return FALSE;
+		if (p[c].ppid != p[i].pid || p[c].pgid == g)
+		    continue;
+
+		for (k = 0; k < npgid && pgid[k] != p[c].pgid; k++)
+		    ;
+		if (k < npgid)
+		    continue;
+		for (k = 0; k < nqueue && pimQueue[k] != p[c].pgid; k++)
+		    ;
+		if (k < nqueue)
+		    continue;
+		if (nqueue == numProcs)
+		    return FALSE;
+		pimQueue[nqueue++] = p[c].pgid;
+	    }
+	}
+    }
+
+copy:
+    for (i = 0, k = 0; i < numProcs; i++) {
+	if (pimMark[i])
+	    pimProcBuf[k++] = p[i];
+    }
+    *num = k;
+
+    return TRUE;
+}
+
 static char *
 readPIMBuf(char *pfile)
 {
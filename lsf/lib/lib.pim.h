@@ -50,10 +50,75 @@ struct lsPidInfo {
 
 #define PIM_API_TREAT_JID_AS_PGID 0x1
 #define PIM_API_UPDATE_NOW        0x2
+#define PIM_API_STATS             0x4
+
+/* Statistics of the pim scans, the reply to
+ * a PIM_API_STATS request.
+ */
+struct pimStats {
+    int numProcs;       /* processes on the host */
+    int numJobProcs;    /* processes in the table */
+    int numNew;         /* pids new in the last scan */
+    int numGone;        /* pids gone in the last scan */
+    int numOpen;        /* stat files kept open */
+    int numScans;
+    int scanTime;       /* last scan in microseconds */
+    int maxScanTime;
+};
+
+/* Process table PIM publishes in the file pim.table.<host>,
+ * sbd and RES map it read only. The processes of a process
+ * group are chained from the pgid hash and the children of
+ * a process from the ppid hash, -1 ends a chain. The writer
+ * makes seqNo odd while it updates the table and even again
+ * when done, a reader retries if it saw an odd value or if
+ * seqNo moved while it was reading.
+ */
+#define PIM_TABLE_MAGIC    0x50494d54
+#define PIM_TABLE_VERSION  1
+
+struct pimTable {
+    unsigned int magic;
+    unsigned int version;
+    volatile unsigned int seqNo;
+    int   port;
+    int   maxProcs;
+    int   numProcs;
+    int   hashSize;
+    int   reserved;
+    int64_t updTime;
+};
+
+struct pimProc {
+    int pid;
+    int ppid;
+    int pgid;
+    int jobid;
+    int utime;
+    int stime;
+    int cutime;
+    int cstime;
+    int proc_size;
+    int resident_size;
+    int stack_size;
+    int status;
+    int nextPgid;
+    int nextPpid;
+};
+
+#define PIM_TABLE_SIZE(maxProcs, hashSize)                      \
+    (sizeof(struct pimTable) + 2 * (hashSize) * sizeof(int)     \
+     + (maxProcs) * sizeof(struct pimProc))
+#define PIM_PGID_HASH(t)  ((int *)((struct pimTable *)(t) + 1))
+#define PIM_PPID_HASH(t)  (PIM_PGID_HASH(t) + (t)->hashSize)
+#define PIM_PROCS(t)      ((struct pimProc *)(PIM_PPID_HASH(t) + (t)->hashSize))
+#define PIM_HASH(t, id)   ((unsigned int)(id) & ((t)->hashSize - 1))
 
 #define PIM_SLEEP_TIME 3
 #define PIM_UPDATE_INTERVAL 30
 
 extern struct jRusage *getJInfo_(int, int *, int, int);
+extern struct pimStats *getPIMStats_(void);
+extern bool_t xdr_pimStats(XDR *, struct pimStats *, struct LSFHeader *);
 
 #endif
@@ -22,16 +22,13 @@
 #include "lproto.h"
 #include "lib.table.h"
 
-static hEnt           *h_findEnt(const char *, struct hLinks *);
-static unsigned int   getAddr(hTab *, const char *);
-static void           resetTab(hTab *);
-static int            getClosestPrime(int);
+#define MINBITS   4
 
-static int   primes[] =
-{
-    101, 1009, 5009, 10007, 20011, 50021, 100003,
-    200003, 500009, 1030637
-};
+static hEnt           *h_findEnt(const char *, unsigned int, struct hLinks *);
+static unsigned int   hashKey(const char *);
+static unsigned int   getAddr(hTab *, unsigned int);
+static struct hLinks  *getSlot(hTab *, unsigned int);
+static void           splitSlot(hTab *);
 
 /* insList_()
  * Add the elemPtr in the list at destPtr address.
@@ -70,35 +67,42 @@ initList_(struct hLinks *headPtr)
 void
 h_initTab_(hTab *tabPtr, int numSlots)
 {
-    int             i;
-    struct hLinks   *slotPtr;
+    unsigned int    i;
 
     tabPtr->numEnts = 0;
 
-    /* Our hash table works best if we have its size
-     * as prime number.
+    /* The slots are addressed by the low bits
+     * of the hash so the base size is a power of 2.
      */
-    tabPtr->size = getClosestPrime(numSlots);
+    tabPtr->segBits = MINBITS;
+    while ((1 << tabPtr->segBits) < numSlots && tabPtr->segBits < 20)
+        tabPtr->segBits++;
 
-    tabPtr->slotPtr = malloc(sizeof(struct hLinks) * tabPtr->size);
+    tabPtr->base = 1 << tabPtr->segBits;
+    tabPtr->split = 0;
+    tabPtr->size = tabPtr->base;
 
-    for (i = 0, slotPtr = tabPtr->slotPtr; i < tabPtr->size; i++, slotPtr++)
-        initList_(slotPtr);
+    tabPtr->slotPtr = calloc(HTAB_MAXSEGS, sizeof(struct hLinks *));
+    tabPtr->slotPtr[0] = malloc(sizeof(struct hLinks) * tabPtr->base);
+
+    for (i = 0; i < tabPtr->base; i++)
+        initList_(&tabPtr->slotPtr[0][i]);
 
 }
 
 void
 h_freeTab_(hTab *tabPtr, void (*freeFunc)(void *))
 {
-    struct hLinks   *hTabEnd;
     struct hLinks   *slotPtr;
     hEnt            *hEntPtr;
+    int             i;
 
-    slotPtr = tabPtr->slotPtr;
-    hTabEnd = &(slotPtr[tabPtr->size]);
+    if (tabPtr->slotPtr == NULL)
+        return;
 
-    for ( ;slotPtr < hTabEnd; slotPtr++) {
+    for (i = 0; i < tabPtr->size; i++) {
 
+        slotPtr = getSlot(tabPtr, i);
         while ( slotPtr != slotPtr->bwPtr ) {
 
             hEntPtr = (hEnt *) slotPtr->bwPtr;
@@ -118,8 +122,10 @@ h_freeTab_(hTab *tabPtr, void (*freeFunc)(void *))
         }
     }
 
-    free((char *) tabPtr->slotPtr);
-    tabPtr->slotPtr = (struct hLinks *) NULL;
+    for (i = 0; i < HTAB_MAXSEGS; i++)
+        FREEUP(tabPtr->slotPtr[i]);
+    free(tabPtr->slotPtr);
+    tabPtr->slotPtr = NULL;
     tabPtr->numEnts = 0;
 }
 
@@ -142,10 +148,14 @@ h_delTab_(hTab *tabPtr)
 hEnt *
 h_getEnt_(hTab *tabPtr, const char *key)
 {
+    unsigned int   hash;
+
     if (tabPtr->numEnts == 0)
         return NULL;
 
-    return(h_findEnt(key, &(tabPtr->slotPtr[getAddr(tabPtr, key)])));
+    hash = hashKey(key);
+
+    return(h_findEnt(key, hash, getSlot(tabPtr, getAddr(tabPtr, hash))));
 
 }
 
@@ -156,12 +166,15 @@ hEnt *
 h_addEnt_(hTab *tabPtr, const char *key, int *newPtr)
 {
     hEnt            *hEntPtr;
-    int             *keyPtr;
+    unsigned int    hash;
     struct hLinks   *hList;
 
-    keyPtr = (int *) key;
-    hList = &(tabPtr->slotPtr[getAddr(tabPtr, (char *) keyPtr)]);
-    hEntPtr = h_findEnt((char *) keyPtr, hList);
+    if (tabPtr->slotPtr == NULL)
+        h_initTab_(tabPtr, DEFAULT_SLOTS);
+
+    hash = hashKey(key);
+    hList = getSlot(tabPtr, getAddr(tabPtr, hash));
+    hEntPtr = h_findEnt(key, hash, hList);
 
     if (hEntPtr != NULL) {
         if (newPtr != NULL)
@@ -169,17 +182,21 @@ h_addEnt_(hTab *tabPtr, const char *key, int *newPtr)
         return hEntPtr;
     }
 
+    /* Split one slot, the entry may have to go
+     * to the new one.
+     */
     if (tabPtr->numEnts >= RESETLIMIT * tabPtr->size) {
-        resetTab(tabPtr);
-        hList = &(tabPtr->slotPtr[getAddr(tabPtr, (char *) keyPtr)]);
+        splitSlot(tabPtr);
+        hList = getSlot(tabPtr, getAddr(tabPtr, hash));
     }
 
     /* Create a new entry and increase the counter
      * of entries.
      */
     hEntPtr = malloc(sizeof(hEnt));
-    hEntPtr->keyname = putstr_((char *) keyPtr);
+    hEntPtr->keyname = putstr_(key);
     hEntPtr->hData = NULL;
+    hEntPtr->hash = hash;
     insList_((struct hLinks *) hEntPtr, hList);
     if (newPtr != NULL)
         *newPtr = TRUE;
@@ -260,7 +277,7 @@ h_nextEnt_(sTab *sPtr)
 
         if (sPtr->nIndex >= sPtr->tabPtr->size)
             return((hEnt *) NULL);
-        hList = &(sPtr->tabPtr->slotPtr[sPtr->nIndex]);
+        hList = getSlot(sPtr->tabPtr, sPtr->nIndex);
         sPtr->nIndex++;
         if ( hList != hList->bwPtr ) {
             hEntPtr = (hEnt *) hList->bwPtr;
@@ -276,30 +293,77 @@ h_nextEnt_(sTab *sPtr)
 
 }
 
-/* getAddr()
- * Compute a hash index, almost right from K&R
+/* hashKey()
+ * FNV-1a followed by the murmur3 finalizer as the
+ * table uses the low bits of the hash.
  */
 static unsigned int
-getAddr(hTab *tabPtr, const char *key)
+hashKey(const char *key)
 {
-    unsigned int   ha = 0;
+    unsigned int   ha = 2166136261U;
+
+    while (*key) {
+        ha ^= (unsigned char)*key++;
+        ha *= 16777619U;
+    }
 
-    while (*key)
-        ha = (ha * 128 + *key++) % tabPtr->size;
+    ha ^= ha >> 16;
+    ha *= 0x85ebca6bU;
+    ha ^= ha >> 13;
+    ha *= 0xc2b2ae35U;
+    ha ^= ha >> 16;
 
     return ha;
 
 }
 
+/* getAddr()
+ * Slots below split have already been divided
+ * and are addressed with one more bit.
+ */
+static unsigned int
+getAddr(hTab *tabPtr, unsigned int hash)
+{
+    unsigned int   addr;
+
+    addr = hash & (tabPtr->base - 1);
+    if (addr < tabPtr->split)
+        addr = hash & (2 * tabPtr->base - 1);
+
+    return addr;
+
+}
+
+/* getSlot()
+ * Segment 0 holds the first 2^segBits slots,
+ * segment n > 0 the 2^(segBits + n - 1) following.
+ */
+static struct hLinks *
+getSlot(hTab *tabPtr, unsigned int addr)
+{
+    unsigned int   q;
+    int            seg;
+
+    q = addr >> tabPtr->segBits;
+    if (q == 0)
+        return &tabPtr->slotPtr[0][addr];
+
+    seg = 32 - __builtin_clz(q);
+
+    return &tabPtr->slotPtr[seg][addr - ((1U << (seg - 1)) << tabPtr->segBits)];
+
+}
+
 static hEnt *
-h_findEnt(const char *key, struct hLinks *hList)
+h_findEnt(const char *key, unsigned int hash, struct hLinks *hList)
 {
     hEnt   *hEntPtr;
 
     for (hEntPtr = (hEnt *) hList->bwPtr;
          hEntPtr != (hEnt *) hList;
          hEntPtr = (hEnt *) ((struct hLinks *) hEntPtr)->bwPtr) {
-        if (strcmp(hEntPtr->keyname, key) == 0)
+        if (hEntPtr->hash == hash
+            && strcmp(hEntPtr->keyname, key) == 0)
             return hEntPtr;
     }
 
@@ -307,34 +371,55 @@ h_findEnt(const char *key, struct hLinks *hList)
 
 }
 
-/* resetTab()
+/* splitSlot()
+ * Move the entries of slot split having the base
+ * bit set in the new slot split + base. Slots are
+ * initialized only when they come into use.
  */
 static void
-resetTab(hTab *tabPtr)
+splitSlot(hTab *tabPtr)
 {
-    int      lastSize;
-    int      slot;
-    struct hLinks   *lastSlotPtr;
-    struct hLinks   *lastList;
-    hEnt     *hEntPtr;
+    unsigned int    addr;
+    unsigned int    q;
+    int             seg;
+    struct hLinks   *oldList;
+    struct hLinks   *newList;
+    struct hLinks   *hLink;
+    struct hLinks   *next;
+
+    addr = tabPtr->split + tabPtr->base;
+    q = addr >> tabPtr->segBits;
+    seg = 32 - __builtin_clz(q);
+
+    if (seg >= HTAB_MAXSEGS)
+        return;
 
-    lastSlotPtr = tabPtr->slotPtr;
-    lastSize = tabPtr->size;
+    if (tabPtr->slotPtr[seg] == NULL) {
+        tabPtr->slotPtr[seg] = malloc(sizeof(struct hLinks)
+                                      * ((1U << (seg - 1))
+                                         << tabPtr->segBits));
+        if (tabPtr->slotPtr[seg] == NULL)
+            return;
+    }
 
-    h_initTab_(tabPtr, tabPtr->size * RESETFACTOR);
+    oldList = getSlot(tabPtr, tabPtr->split);
+    newList = getSlot(tabPtr, addr);
+    initList_(newList);
 
-    for (lastList = lastSlotPtr; lastSize > 0; lastSize--, lastList++) {
-        while (lastList != lastList->bwPtr) {
-            hEntPtr = (hEnt *) lastList->bwPtr;
-            remList_((struct hLinks *) hEntPtr);
-            slot = getAddr(tabPtr, (char *) hEntPtr->keyname);
-            insList_((struct hLinks *) hEntPtr,
-                     (struct hLinks *) (&(tabPtr->slotPtr[slot])));
-            tabPtr->numEnts++;
+    for (hLink = oldList->bwPtr; hLink != oldList; hLink = next) {
+        next = hLink->bwPtr;
+        if (((hEnt *) hLink)->hash & tabPtr->base) {
+            remList_(hLink);
+            insList_(hLink, newList);
         }
     }
 
-    free(lastSlotPtr);
+    tabPtr->size++;
+    tabPtr->split++;
+    if (tabPtr->split == tabPtr->base) {
+        tabPtr->base *= 2;
+        tabPtr->split = 0;
+    }
 
 }
 
@@ -353,14 +438,16 @@ h_delRef_(hTab *tabPtr, hEnt *hEntPtr)
 void
 h_freeRefTab_(hTab *tabPtr)
 {
-    struct hLinks *hTabEnd, *slotPtr;
+    struct hLinks *slotPtr;
     hEnt    *hEntPtr;
+    int     i;
 
-    slotPtr = tabPtr->slotPtr;
-    hTabEnd = &(slotPtr[tabPtr->size]);
+    if (tabPtr->slotPtr == NULL)
+        return;
 
-    for ( ;slotPtr < hTabEnd; slotPtr++) {
+    for (i = 0; i < tabPtr->size; i++) {
 
+        slotPtr = getSlot(tabPtr, i);
         while (slotPtr != slotPtr->bwPtr) {
 
             hEntPtr = (hEnt *) slotPtr->bwPtr;
@@ -370,27 +457,9 @@ h_freeRefTab_(hTab *tabPtr)
         }
     }
 
+    for (i = 0; i < HTAB_MAXSEGS; i++)
+        FREEUP(tabPtr->slotPtr[i]);
     free(tabPtr->slotPtr);
     tabPtr->slotPtr = NULL;
     tabPtr->numEnts = 0;
 }
-
-/* getClosestPrime()
- * Get the nearest prime >= x.
- */
-static int
-getClosestPrime(int x)
-{
-    int   cc;
-    int   n;
-
-    n = sizeof(primes)/sizeof(primes[0]);
-
-    for (cc = 0; cc < n; cc++) {
-
-        if (x < primes[cc])
-            return primes[cc];
-    }
-
-    return primes[n - 1];
-}
@@ -20,9 +20,16 @@
 #ifndef _LIB_TABLE_H_
 #define _LIB_TABLE_H_
 
-#define RESETFACTOR     2
-#define RESETLIMIT      1.5
+/* Average number of entries per slot above
+ * which the table splits one more slot.
+ */
+#define RESETLIMIT      1
 #define DEFAULT_SLOTS   11
+/* Maximum number of slot segments, segment 0 and 1
+ * have the initial table size then every segment
+ * doubles the slots of the table.
+ */
+#define HTAB_MAXSEGS    24
 
 /* Double linked list addressed by each
  * hash table slot.
@@ -39,14 +46,23 @@ typedef struct hEnt {
     struct hLinks   *bwPtr;
     void            *hData;
     char            *keyname;
+    unsigned int    hash;
 } hEnt;
 
-/* This si the hash table itself.
+/* This is the hash table itself. The table grows
+ * by linear hashing: when the load exceeds RESETLIMIT
+ * the slot split is divided in split and split + base
+ * so the table never rehashes all its entries at once.
+ * The slots are in segments that never move, slotPtr
+ * is the segment directory.
  */
 typedef struct hTab {
-    struct hLinks   *slotPtr;
+    struct hLinks   **slotPtr;
     int             numEnts;
     int             size;
+    int             segBits;
+    unsigned int    base;
+    unsigned int    split;
 } hTab;
 
 
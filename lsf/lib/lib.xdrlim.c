@@ -229,6 +229,70 @@ xdr_loadReply(XDR *xdrs, struct loadReply *loadReplyPtr, struct LSFHeader *hdr)
     return(TRUE);
 }
 
+bool_t
+xdr_loadSubReq(XDR *xdrs, struct loadSubReq *req, struct LSFHeader *hdr)
+{
+    if (!(xdr_u_int(xdrs, &req->epoch)
+          && xdr_u_int(xdrs, &req->seqNo)))
+        return FALSE;
+
+    return TRUE;
+}
+
+/* xdr_loadDelta()
+ * On decode the matrix is one block the caller
+ * releases with ls_freeloaddelta().
+ */
+bool_t
+xdr_loadDelta(XDR *xdrs, struct loadDelta *delta, struct LSFHeader *hdr)
+{
+    int i;
+
+    if (!(xdr_u_int(xdrs, &delta->epoch)
+          && xdr_u_int(xdrs, &delta->baseSeqNo)
+          && xdr_u_int(xdrs, &delta->seqNo)
+          && xdr_int(xdrs, &delta->flags)
+          && xdr_int(xdrs, &delta->nIndex)
+          && xdr_int(xdrs, &delta->nEntry)))
+        return FALSE;
+
+    if (xdrs->x_op == XDR_DECODE) {
+        int hlSize, vecSize, staSize;
+        char *currp;
+
+        if (delta->nIndex < 0 || delta->nEntry < 0)
+            return FALSE;
+
+        hlSize  = ALIGNWORD_(delta->nEntry * sizeof(struct hostLoad));
+        vecSize = ALIGNWORD_(delta->nIndex * sizeof(float));
+        staSize = ALIGNWORD_((1 + GET_INTNUM(delta->nIndex)) * sizeof(int));
+        delta->loadMatrix = malloc(hlSize
+                                   + delta->nEntry * (vecSize + staSize) + 1);
+        if (delta->loadMatrix == NULL)
+            return FALSE;
+
+        currp = (char *)delta->loadMatrix + hlSize;
+        for (i = 0; i < delta->nEntry; i++, currp += vecSize)
+            delta->loadMatrix[i].li = (float *)currp;
+        for (i = 0; i < delta->nEntry; i++, currp += staSize)
+            delta->loadMatrix[i].status = (int *)currp;
+    }
+
+    for (i = 0; i < delta->nEntry; i++) {
+        if (!xdr_arrayElement(xdrs,
+                              (char *)&delta->loadMatrix[i],
+                              hdr,
+                              xdr_hostLoad,
+                              (char *)&delta->nIndex)) {
+            if (xdrs->x_op == XDR_DECODE)
+                FREEUP(delta->loadMatrix);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 bool_t
 xdr_jobXfer(XDR *xdrs, struct jobXfer *jobXferPtr, struct LSFHeader *hdr)
 {
@@ -32,6 +32,12 @@ extern bool_t xdr_placeReply(XDR *,
 extern bool_t xdr_loadReply(XDR *,
                             struct loadReply *,
                             struct LSFHeader *);
+extern bool_t xdr_loadSubReq(XDR *,
+                             struct loadSubReq *,
+                             struct LSFHeader *);
+extern bool_t xdr_loadDelta(XDR *,
+                            struct loadDelta *,
+                            struct LSFHeader *);
 extern bool_t xdr_jobXfer(XDR *,
                           struct jobXfer *,
                           struct LSFHeader *);
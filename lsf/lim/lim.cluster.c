@@ -33,6 +33,7 @@ extern int chanIndex;
 
 static void processMsg(int);
 static void clientReq(XDR *, struct LSFHeader *, int );
+static int loadSubscribe(XDR *, struct LSFHeader *, int);
 
 static void shutDownChan(int);
 
@@ -158,6 +159,12 @@ processMsg(int chanfd)
             clientMap[chanfd]->reqbuf = buf;
             clientReq(&xdrs, &hdr, chanfd);
             break;
+        case LIM_LOAD_SUBSCRIBE:
+            if (loadSubscribe(&xdrs, &hdr, chanfd) < 0)
+                shutDownChan(chanfd);
+            xdr_destroy(&xdrs);
+            chanFreeBuf_(buf);
+            break;
         case LIM_LOAD_ADJ:
             loadadjReq(&xdrs, &clientMap[chanfd]->from, &hdr, chanfd);
             xdr_destroy(&xdrs);
@@ -282,6 +289,89 @@ Reply1:
     }
 }
 
+/* loadSubscribe()
+ * Keep the connection of the client to push it the
+ * load of the server hosts, starting with the changes
+ * it missed since its last subscription.
+ */
+static int
+loadSubscribe(XDR *xdrs, struct LSFHeader *hdr, int chfd)
+{
+    struct loadSubReq req;
+    struct LSFHeader replyHdr;
+    char buf[LSF_HEADER_LEN];
+    XDR xdrs2;
+
+    if (!xdr_loadSubReq(xdrs, &req, hdr)) {
+        ls_syslog(LOG_ERR, "\
+%s: xdr_loadSubReq() failed from %s", __func__,
+                  sockAdd2Str_(&clientMap[chfd]->from));
+        return -1;
+    }
+
+    if (!masterMe) {
+        initLSFHeader_(&replyHdr);
+        replyHdr.opCode = LIME_WRONG_MASTER;
+        replyHdr.refCode = hdr->refCode;
+        xdrmem_create(&xdrs2, buf, sizeof(buf), XDR_ENCODE);
+        if (xdr_LSFHeader(&xdrs2, &replyHdr))
+            chanWrite_(chfd, buf, XDR_GETPOS(&xdrs2));
+        xdr_destroy(&xdrs2);
+        return -1;
+    }
+
+    clientMap[chfd]->subscriber = TRUE;
+    clientMap[chfd]->subEpoch = req.epoch;
+    clientMap[chfd]->subSeqNo = req.seqNo;
+
+    ls_syslog(LOG_INFO, "\
+%s: load subscription from %s epoch %u seqNo %u", __func__,
+              sockAdd2Str_(&clientMap[chfd]->from), req.epoch, req.seqNo);
+
+    pubLoad();
+
+    return sendLoadDelta(clientMap[chfd], TRUE);
+}
+
+/* pushLoad()
+ * Send the subscribers the hosts whose load changed,
+ * a subscriber still reading the previous push gets
+ * the changes in the next. The subscribers of a LIM
+ * that is no longer master are dropped, they will
+ * subscribe to the new master. A subscriber that got
+ * nothing for LOAD_DELTA_KEEPALIVE gets an empty delta.
+ */
+void
+pushLoad(void)
+{
+    time_t t;
+    int i;
+
+    t = time(NULL);
+
+    if (masterMe)
+        pubLoad();
+
+    for (i = 0; i < chanIndex && i < MAXCLIENTS; i++) {
+
+        if (clientMap[i] == NULL || !clientMap[i]->subscriber)
+            continue;
+
+        if (!masterMe) {
+            shutDownChan(i);
+            continue;
+        }
+
+        if (chanSendQueued_(i) > 0)
+            continue;
+
+        if (sendLoadDelta(clientMap[i],
+                          t - clientMap[i]->subTime >= LOAD_DELTA_KEEPALIVE)
+            < 0)
+            shutDownChan(i);
+    }
+}
+
 static void
 shutDownChan(int chanfd)
 {
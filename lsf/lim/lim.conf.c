@@ -3085,6 +3085,7 @@ addHost_(struct clusterNode *clPtr,
     }
 
     numofhosts++;
+    hostListChanged();
 
     return hPtr;
 }
@@ -3147,6 +3148,10 @@ freeHostNodes(struct hostNode *hPtr, int allList)
         FREEUP(hPtr->DResBitMaps);
         FREEUP(hPtr->status);
         FREEUP(hPtr->instances);
+        FREEUP(hPtr->pubLoad);
+        FREEUP(hPtr->pubStatus);
+        loadWheelRm(hPtr);
+        hostListChanged();
 
         next = hPtr->nextPtr;
         FREEUP(hPtr);
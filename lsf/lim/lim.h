@@ -128,6 +128,13 @@ struct hostNode {
     struct  hostNode *nextPtr;
     time_t  expireTime;
     uint8_t migrant;
+    float   *pubLoad;      /* load last pushed to subscribers */
+    int     *pubStatus;
+    u_int   pubSeqNo;
+    u_int   loadTick;      /* exchange interval of the last load */
+    u_int   wheelTick;     /* inactivity timer, 0 if not armed */
+    struct  hostNode *wheelForw;
+    struct  hostNode *wheelBack;
 };
 
 #define CLUST_ACTIVE		0x00010000
@@ -190,6 +197,10 @@ struct clientNode {
     struct hostNode *fromHost;
     struct sockaddr_in from;
     struct Buffer *reqbuf;
+    char   subscriber;
+    u_int  subEpoch;
+    u_int  subSeqNo;
+    time_t subTime;
 };
 
 struct liStruct {
@@ -321,7 +332,9 @@ typedef enum {
     LIM_COMPUTE_ONLY,
     LSB_SHAREDIR,
     LIM_NO_MIGRANT_HOSTS,
-    LIM_NO_FORK
+    LIM_NO_FORK,
+    LIM_LOAD_DELTA,
+    LIM_LOAD_RELAYS
 } limParams_t;
 
 #define LOOP_ADDR       0x7F000001
@@ -462,6 +475,13 @@ extern void loadIndex(void);
 extern void initReadLoad(int);
 extern void initConfInfo(void);
 extern void readLoad(int);
+extern void loadPubReset(void);
+extern void rcvLoadRelay(XDR *, struct sockaddr_in *, struct LSFHeader *);
+extern void loadWheelTouch(struct hostNode *);
+extern void loadWheelRm(struct hostNode *);
+extern void loadRelayBypass(void);
+extern void pubLoad(void);
+extern int sendLoadDelta(struct clientNode *, int);
 extern char *getHostModel(void);
 
 extern void lim_Exit(const char *);
@@ -471,6 +491,8 @@ extern struct hostNode *findHostbyAddr(struct sockaddr_in *,
                                        char *);
 extern struct hostNode *findHostByAddr(in_addr_t);
 extern struct hostNode *rmHost(struct hostNode *);
+extern void hostListChanged(void);
+extern u_int hostListGen;
 extern struct hostNode *findHostbyList(struct hostNode *, char *);
 extern struct hostNode *findHostbyNo(struct hostNode *, int);
 extern bool_t findHostInCluster(char *);
@@ -486,6 +508,7 @@ extern void loadadjReq(XDR *, struct sockaddr_in *, struct LSFHeader *, int);
 extern void updExtraLoad(struct hostNode **, char *, int);
 extern void loadReq(XDR *, struct sockaddr_in *, struct LSFHeader *,
                     int);
+extern void effectiveLoad(struct hostNode *, float *, int *);
 extern int getEligibleSites(register struct resVal*, struct decisionReq *,
                             char, char *);
 extern int validHosts(char **, int, char *, int);
@@ -502,6 +525,7 @@ extern int xdr_loadmatrix(XDR *, int, struct loadVectorStruct *,
 extern int xdr_masterReg(XDR *, struct masterReg *, struct LSFHeader *);
 extern int xdr_statInfo(XDR *, struct statInfo *, struct LSFHeader *);
 extern void clientIO(struct Masks *);
+extern void pushLoad(void);
 
 /* openlava floating host management
  */
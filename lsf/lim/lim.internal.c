@@ -97,6 +97,7 @@ Run lim -C on this host to find more information",
 
         if (masterReg.flags & SEND_LOAD_INFO) {
             mustSendLoad = TRUE;
+            loadRelayBypass();
             ls_syslog(LOG_DEBUG, "\
 %s: Master lim is probing me. Send my load in next interval", __func__);
         }
@@ -517,7 +518,7 @@ initNewMaster(void)
             hPtr->status[0] |= LIM_UNAVAIL;
             for (j = 0; j < GET_INTNUM(allInfo.numIndx); j++)
                 hPtr->status[j + 1] = 0;
-            hPtr->hostInactivityCount = 0;
+            loadWheelTouch(hPtr);
             hPtr->infoValid = FALSE;
             hPtr->lastSeqNo = 0;
         }
@@ -41,6 +41,32 @@ extern int maxnLbHost;
 
 static void rcvLoadVector (XDR *, struct sockaddr_in *, struct LSFHeader *);
 static void copyResValues (struct loadVectorStruct, struct hostNode *);
+static struct loadVectorStruct *getLoadVector(void);
+static void applyLoadVector(struct loadVectorStruct *, struct sockaddr_in *);
+static struct hostNode *loadRelay(struct hostNode *);
+static int isLoadRelay(void);
+static void relayLoadVector(struct loadVectorStruct *,
+                            struct sockaddr_in *, struct LSFHeader *);
+static void relayFlush(void);
+static void loadWheelTick(void);
+static void loadWheelAdd(struct hostNode *, u_int);
+
+/* Load vectors a relay LIM collected since its last
+ * exchange interval, forwarded to the master in
+ * LIM_LOAD_RELAY datagrams.
+ */
+static char relayBuf[MSGSIZE];
+static XDR relayXdrs;
+static int relayNum;
+static int relayBypass;
+
+/* Inactivity timers of the server hosts, in exchange
+ * intervals. A host is looked at by the master only
+ * when its timer expires instead of at every interval.
+ */
+#define LOAD_WHEEL_SIZE 256
+static struct hostNode *loadWheel[LOAD_WHEEL_SIZE];
+static u_int loadTick = 1;
 
 void
 sendLoad(void)
@@ -70,53 +96,12 @@ sendLoad(void)
     if (logclass & LC_TRACE)
        ls_syslog(LOG_DEBUG, "%s: Entering ..", __func__);
 
-    if (masterMe) {
+    if (relayNum > 0)
+        relayFlush();
 
-        for (hPtr = myClusterPtr->hostList; hPtr; hPtr = hPtr->nextPtr) {
-
-            if (hPtr == myHostPtr)
-                continue;
-
-                hPtr->hostInactivityCount++;
-                if (hPtr->hostInactivityCount > 10000)
-                    hPtr->hostInactivityCount = 100;
+    if (masterMe) {
 
-                if (! LS_ISUNAVAIL(hPtr->status)) {
-                    if (hPtr->hostInactivityCount > (hostInactivityLimit + retryLimit)) {
-                        ls_syslog(LOG_DEBUG, "\
-%s: Declaring %s unavailable inactivity Count=%d", __func__,
-                                  hPtr->hostName, hPtr->hostInactivityCount);
-
-                        hPtr->status[0] |= LIM_UNAVAIL;
-                        hPtr->infoValid = FALSE;
-                        if (hPtr->numInstances > 0) {
-                            int resNo;
-                            for (i = 0; i < hPtr->numInstances; i++) {
-                                if (hPtr->instances[i]->updHost == NULL
-                                      || hPtr->instances[i]->updHost != hPtr)
-                                    continue;
-                                resNo = resNameDefined(hPtr->instances[i]->resName);
-                                if (allInfo.resTable[resNo].flags & RESF_DYNAMIC) {
-                                    strcpy (hPtr->instances[i]->value, "-");
-                                    hPtr->instances[i]->updHost = NULL;
-                                }
-                            }
-                        }
-                        hPtr->loadMask  = 0;
-                        hPtr->infoMask  = 0;
-                    }
-                    if ( (hPtr->hostInactivityCount > hostInactivityLimit) &&
-                         (hPtr->hostInactivityCount <= (hostInactivityLimit + retryLimit))) {
-                        if (logclass & LC_COMM) {
-                            ls_syslog(LOG_DEBUG3,
-                              "%s: Asking %s to send load info %d %d", __func__,
-                              hPtr->hostName, hPtr->hostInactivityCount,
-                              hostInactivityLimit + retryLimit);
-                        }
-                        announceMasterToHost(hPtr, SEND_LOAD_INFO);
-                    }
-                }
-        }
+        loadWheelTick();
 
     } else {
 
@@ -259,10 +244,22 @@ sendLoad(void)
             return;
         }
 
+        /* Send to the relay of the host if it has one,
+         * unless the master asked for the load which it
+         * does when the relay does not forward it.
+         */
+        hPtr = NULL;
+        if (relayBypass > 0)
+            relayBypass--;
+        else
+            hPtr = loadRelay(myHostPtr);
+        if (hPtr == NULL)
+            hPtr = myClusterPtr->masterPtr;
+
         toAddr.sin_family = AF_INET;
         toAddr.sin_port   = lim_port;
         memcpy(&toAddr.sin_addr.s_addr,
-               &myClusterPtr->masterPtr->addr[0],
+               &hPtr->addr[0],
                sizeof(in_addr_t));
 
         if (logclass & LC_COMM)
@@ -344,18 +341,9 @@ rcvLoad(XDR *xdrs, struct sockaddr_in *from, struct LSFHeader *hdr)
 static void
 rcvLoadVector(XDR *xdrs, struct sockaddr_in *from, struct LSFHeader *hdr)
 {
-    static int checkSumMismatch;
-    static struct loadVectorStruct *loadVector;
-    struct hostNode *hPtr;
-    int i;
-    int masterLock = FALSE;
+    struct loadVectorStruct *loadVector;
 
-    if (loadVector == NULL) {
-        loadVector = calloc(1, sizeof(struct loadVectorStruct));
-        loadVector->li = calloc(allInfo.numIndx, sizeof(float));
-        loadVector->status = calloc((1 + GET_INTNUM(allInfo.numIndx)),
-                                    sizeof(int));
-    }
+    loadVector = getLoadVector();
 
     if (!xdr_loadvector(xdrs, loadVector, hdr)) {
         ls_syslog(LOG_ERR, "\
@@ -364,12 +352,113 @@ rcvLoadVector(XDR *xdrs, struct sockaddr_in *from, struct LSFHeader *hdr)
     }
 
     if (!masterMe) {
+        if (isLoadRelay()) {
+            relayLoadVector(loadVector, from, hdr);
+            return;
+        }
         ls_syslog(LOG_DEBUG, "\
 %s: %s thinks I am the master, but I'm not",
                   __func__, sockAdd2Str_(from));
         return;
     }
 
+    applyLoadVector(loadVector, from);
+}
+
+/* rcvLoadRelay()
+ * Apply the load vectors a relay LIM forwarded,
+ * each one as if it came from its host.
+ */
+void
+rcvLoadRelay(XDR *xdrs, struct sockaddr_in *from, struct LSFHeader *hdr)
+{
+    struct loadVectorStruct *loadVector;
+    struct sockaddr_in hostAddr;
+    struct hostNode *hPtr;
+    u_int addr;
+    int num;
+    int i;
+
+    if (from->sin_port != lim_port) {
+        ls_syslog(LOG_ERR, "\
+%s: Update not from LIM: %s, expected %d",
+                  __func__, sockAdd2Str_(from), ntohs(lim_port));
+        return;
+    }
+
+    if (!masterMe) {
+        ls_syslog(LOG_DEBUG, "\
+%s: relay %s thinks I am the master, but I'm not",
+                  __func__, sockAdd2Str_(from));
+        return;
+    }
+
+    hPtr = findHostbyAddr(from, (char *)__func__);
+    if (hPtr == NULL || hPtr->hostInactivityCount == -1) {
+        ls_syslog(LOG_ERR, "\
+%s: Received relayed load from unknown or client host %s",
+                  __func__, sockAdd2Str_(from));
+        return;
+    }
+
+    if (!xdr_int(xdrs, &num)) {
+        ls_syslog(LOG_ERR, "\
+%s: Error in xdr_int from relay %s", __func__, sockAdd2Str_(from));
+        return;
+    }
+
+    if (logclass & LC_COMM)
+        ls_syslog(LOG_DEBUG, "\
+%s: %d load vectors from relay %s", __func__, num, hPtr->hostName);
+
+    loadVector = getLoadVector();
+    memset(&hostAddr, 0, sizeof(hostAddr));
+    hostAddr.sin_family = AF_INET;
+    hostAddr.sin_port = lim_port;
+
+    for (i = 0; i < num; i++) {
+
+        if (!xdr_u_int(xdrs, &addr)
+            || !xdr_loadvector(xdrs, loadVector, hdr)) {
+            ls_syslog(LOG_ERR, "\
+%s: Error in xdr_loadvector %d of %d from relay %s", __func__,
+                      i, num, sockAdd2Str_(from));
+            return;
+        }
+
+        hostAddr.sin_addr.s_addr = addr;
+        applyLoadVector(loadVector, &hostAddr);
+    }
+}
+
+/* getLoadVector()
+ */
+static struct loadVectorStruct *
+getLoadVector(void)
+{
+    static struct loadVectorStruct *loadVector;
+
+    if (loadVector == NULL) {
+        loadVector = calloc(1, sizeof(struct loadVectorStruct));
+        loadVector->li = calloc(allInfo.numIndx, sizeof(float));
+        loadVector->status = calloc((1 + GET_INTNUM(allInfo.numIndx)),
+                                    sizeof(int));
+    }
+
+    return loadVector;
+}
+
+/* applyLoadVector()
+ * Update the host with the load vector it sent from.
+ */
+static void
+applyLoadVector(struct loadVectorStruct *loadVector, struct sockaddr_in *from)
+{
+    static int checkSumMismatch;
+    struct hostNode *hPtr;
+    int i;
+    int masterLock = FALSE;
+
     if (myClusterPtr->checkSum != loadVector->checkSum
         && checkSumMismatch < 5
         && (limParams[LSF_LIM_IGNORE_CHECKSUM].paramValue == NULL)) {
@@ -387,7 +476,7 @@ rcvLoadVector(XDR *xdrs, struct sockaddr_in *from, struct LSFHeader *hdr)
         return ;
     }
 
-    if (findHostbyList(myClusterPtr->hostList, hPtr->hostName) == NULL) {
+    if (hPtr->hostInactivityCount == -1) {
         ls_syslog(LOG_ERR, "\
 %s: Got load from client-only host %s.  Kill LIM on %s",
                   __func__, sockAdd2Str_(from), sockAdd2Str_(from));
@@ -401,7 +490,7 @@ rcvLoadVector(XDR *xdrs, struct sockaddr_in *from, struct LSFHeader *hdr)
     ls_syslog(LOG_DEBUG,"\
 %s: Received load update from host %s", __func__, hPtr->hostName);
 
-    hPtr->hostInactivityCount = 0;
+    loadWheelTouch(hPtr);
 
     if (hPtr->status[0] & LIM_LOCKEDM) {
         masterLock = TRUE;
@@ -442,6 +531,213 @@ rcvLoadVector(XDR *xdrs, struct sockaddr_in *from, struct LSFHeader *hdr)
     }
 }
 
+/* loadRelays()
+ * The hosts of LIM_LOAD_RELAYS, looked up
+ * again only when the host list changed.
+ */
+static int
+loadRelays(struct hostNode ***relays)
+{
+    static struct hostNode **list;
+    static int num = -1;
+    static u_int gen;
+    struct hostNode *hPtr;
+    char *sp;
+    char *word;
+    int n;
+
+    if (num >= 0 && gen == hostListGen) {
+        *relays = list;
+        return num;
+    }
+
+    FREEUP(list);
+    num = 0;
+    gen = hostListGen;
+    *relays = NULL;
+
+    if (limParams[LIM_LOAD_RELAYS].paramValue == NULL)
+        return 0;
+
+    n = 0;
+    sp = limParams[LIM_LOAD_RELAYS].paramValue;
+    while (getNextWord_(&sp) != NULL)
+        n++;
+    if (n == 0)
+        return 0;
+
+    if ((list = calloc(n, sizeof(struct hostNode *))) == NULL) {
+        ls_syslog(LOG_ERR, "%s: calloc() failed %m", __func__);
+        return 0;
+    }
+
+    sp = limParams[LIM_LOAD_RELAYS].paramValue;
+    while ((word = getNextWord_(&sp)) != NULL) {
+        hPtr = findHostbyList(myClusterPtr->hostList, word);
+        if (hPtr == NULL) {
+            ls_syslog(LOG_WARNING, "\
+%s: LIM_LOAD_RELAYS host %s is not a server host, ignored",
+                      __func__, word);
+            continue;
+        }
+        list[num++] = hPtr;
+    }
+
+    *relays = list;
+    return num;
+}
+
+/* loadRelay()
+ * The relay LIM the host sends its load to, the hosts
+ * are spread over the relays by their position in the
+ * cluster file. Returns NULL if the host sends to the
+ * master, as the relays themselves do.
+ */
+static struct hostNode *
+loadRelay(struct hostNode *hPtr)
+{
+    struct hostNode **relays;
+    struct hostNode *relay;
+    int num;
+    int i;
+
+    if ((num = loadRelays(&relays)) == 0)
+        return NULL;
+
+    for (i = 0; i < num; i++) {
+        if (relays[i] == hPtr)
+            return NULL;
+    }
+
+    relay = relays[abs(hPtr->hostNo) % num];
+    if (relay == myClusterPtr->masterPtr)
+        return NULL;
+
+    return relay;
+}
+
+/* isLoadRelay()
+ */
+static int
+isLoadRelay(void)
+{
+    struct hostNode **relays;
+    int num;
+    int i;
+
+    num = loadRelays(&relays);
+    for (i = 0; i < num; i++) {
+        if (relays[i] == myHostPtr)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* loadRelayBypass()
+ * The master asked for the load, it did not get it
+ * from the relay, send it directly for a while.
+ */
+void
+loadRelayBypass(void)
+{
+    relayBypass = hostInactivityLimit;
+}
+
+/* relayLoadVector()
+ * Add the load vector of a host to the batch the
+ * relay forwards at its next exchange interval,
+ * a full batch is forwarded right away.
+ */
+static void
+relayLoadVector(struct loadVectorStruct *loadVector,
+                struct sockaddr_in *from,
+                struct LSFHeader *hdr)
+{
+    struct LSFHeader relayHdr;
+    u_int addr;
+    u_int pos;
+
+    if (!myClusterPtr->masterKnown)
+        return;
+
+    /* Room for the header and the number of
+     * vectors, written when the batch is sent.
+     */
+    if (relayNum == 0) {
+        xdrmem_create(&relayXdrs, relayBuf, MSGSIZE, XDR_ENCODE);
+        initLSFHeader_(&relayHdr);
+        relayHdr.opCode = LIM_LOAD_RELAY;
+        xdr_LSFHeader(&relayXdrs, &relayHdr);
+        xdr_int(&relayXdrs, &relayNum);
+    }
+
+    addr = from->sin_addr.s_addr;
+    pos = XDR_GETPOS(&relayXdrs);
+
+    if (!xdr_u_int(&relayXdrs, &addr)
+        || !xdr_loadvector(&relayXdrs, loadVector, hdr)) {
+
+        XDR_SETPOS(&relayXdrs, pos);
+        if (relayNum == 0) {
+            ls_syslog(LOG_ERR, "\
+%s: load vector of %s does not fit a datagram", __func__,
+                      sockAdd2Str_(from));
+            xdr_destroy(&relayXdrs);
+            return;
+        }
+
+        relayFlush();
+        relayLoadVector(loadVector, from, hdr);
+        return;
+    }
+
+    relayNum++;
+}
+
+/* relayFlush()
+ * Forward the batch of load vectors to the master.
+ */
+static void
+relayFlush(void)
+{
+    struct LSFHeader relayHdr;
+    struct sockaddr_in toAddr;
+    int len;
+
+    if (relayNum == 0)
+        return;
+
+    len = XDR_GETPOS(&relayXdrs);
+    XDR_SETPOS(&relayXdrs, 0);
+    initLSFHeader_(&relayHdr);
+    relayHdr.opCode = LIM_LOAD_RELAY;
+    xdr_LSFHeader(&relayXdrs, &relayHdr);
+    xdr_int(&relayXdrs, &relayNum);
+
+    if (myClusterPtr->masterKnown) {
+
+        memset(&toAddr, 0, sizeof(toAddr));
+        toAddr.sin_family = AF_INET;
+        toAddr.sin_port = lim_port;
+        memcpy(&toAddr.sin_addr.s_addr,
+               &myClusterPtr->masterPtr->addr[0],
+               sizeof(in_addr_t));
+
+        if (logclass & LC_COMM)
+            ls_syslog(LOG_DEBUG, "\
+%s: forwarding %d load vectors to %s (len=%d)", __func__,
+                      relayNum, sockAdd2Str_(&toAddr), len);
+
+        if (chanSendDgram_(limSock, relayBuf, len, &toAddr) < 0)
+            ls_syslog(LOG_ERR, I18N_FUNC_S_FAIL_M, __func__, "chanSendDgram_",
+                      sockAdd2Str_(&toAddr));
+    }
+
+    xdr_destroy(&relayXdrs);
+    relayNum = 0;
+}
+
 static void
 copyResValues(struct loadVectorStruct loadVector, struct hostNode *hPtr)
 {
@@ -582,3 +878,347 @@ normalizeRq(float rawql, float cpuFactor, int nprocs)
 
     return (nrq);
 }
+
+/* The master pushes the load of the server hosts to the
+ * subscribers, mbatchd, on their connection. Every host
+ * keeps the vector last pushed and the sequence number of
+ * when it changed, a subscriber that has seen seqNo gets
+ * the hosts whose pubSeqNo is greater. A host leaving the
+ * cluster starts a new epoch in which the subscribers get
+ * all the hosts again.
+ */
+static u_int loadPubEpoch;
+static u_int loadPubSeqNo;
+
+static int loadChanged(struct hostNode *, float *, int *, float);
+
+/* loadPubReset()
+ */
+void
+loadPubReset(void)
+{
+    if (loadPubEpoch == 0)
+        loadPubEpoch = time(NULL);
+    loadPubEpoch++;
+}
+
+/* pubLoad()
+ * Take a new sequence number for each host whose effective
+ * load moved by more than LIM_LOAD_DELTA percent, default 1,
+ * or whose status changed since it was last pushed.
+ */
+void
+pubLoad(void)
+{
+    static float *li;
+    static int *status;
+    static int numIndx;
+    struct hostNode *hPtr;
+    float delta;
+    int staSize;
+
+    if (loadPubEpoch == 0)
+        loadPubEpoch = time(NULL);
+
+    staSize = (1 + GET_INTNUM(allInfo.numIndx)) * sizeof(int);
+    if (numIndx != allInfo.numIndx) {
+        FREEUP(li);
+        FREEUP(status);
+        li = calloc(allInfo.numIndx, sizeof(float));
+        status = calloc(1, staSize);
+        if (li == NULL || status == NULL) {
+            ls_syslog(LOG_ERR, "%s: calloc() failed %m", __func__);
+            FREEUP(li);
+            FREEUP(status);
+            numIndx = 0;
+            return;
+        }
+        numIndx = allInfo.numIndx;
+    }
+
+    delta = 1.0;
+    if (limParams[LIM_LOAD_DELTA].paramValue)
+        delta = atof(limParams[LIM_LOAD_DELTA].paramValue);
+    if (delta < 0.0)
+        delta = 0.0;
+
+    for (hPtr = myClusterPtr->hostList; hPtr; hPtr = hPtr->nextPtr) {
+
+        if (hPtr->pubLoad == NULL) {
+            hPtr->pubLoad = calloc(numIndx, sizeof(float));
+            hPtr->pubStatus = calloc(1, staSize);
+            if (hPtr->pubLoad == NULL || hPtr->pubStatus == NULL) {
+                ls_syslog(LOG_ERR, "%s: calloc() failed %m", __func__);
+                FREEUP(hPtr->pubLoad);
+                FREEUP(hPtr->pubStatus);
+                continue;
+            }
+            hPtr->pubSeqNo = 0;
+        }
+
+        effectiveLoad(hPtr, li, status);
+
+        if (hPtr->pubSeqNo != 0
+            && !loadChanged(hPtr, li, status, delta / 100.0))
+            continue;
+
+        memcpy(hPtr->pubLoad, li, numIndx * sizeof(float));
+        memcpy(hPtr->pubStatus, status, staSize);
+        hPtr->pubSeqNo = ++loadPubSeqNo;
+    }
+}
+
+/* loadChanged()
+ */
+static int
+loadChanged(struct hostNode *hPtr, float *li, int *status, float delta)
+{
+    float old;
+    int i;
+
+    for (i = 0; i < 1 + GET_INTNUM(allInfo.numIndx); i++)
+        if (hPtr->pubStatus[i] != status[i])
+            return TRUE;
+
+    for (i = 0; i < allInfo.numIndx; i++) {
+        old = hPtr->pubLoad[i];
+        if (old == li[i])
+            continue;
+        if (old >= INFINIT_LOAD || li[i] >= INFINIT_LOAD)
+            return TRUE;
+        if (fabs(li[i] - old) > delta * fabs(old))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* sendLoadDelta()
+ * Queue to the subscriber client the hosts it has not seen,
+ * all of them if it is in another epoch. Nothing is queued
+ * if there are no changes unless force is set. Returns 0 or
+ * -1 if the client should be dropped.
+ */
+int
+sendLoadDelta(struct clientNode *client, int force)
+{
+    static struct hostLoad *matrix;
+    static int matrixSize;
+    struct loadDelta delta;
+    struct LSFHeader hdr;
+    struct hostNode *hPtr;
+    struct Buffer *buf;
+    XDR xdrs;
+    int size;
+    int n;
+
+    delta.epoch = loadPubEpoch;
+    delta.baseSeqNo = client->subSeqNo;
+    delta.seqNo = loadPubSeqNo;
+    delta.flags = 0;
+    delta.nIndex = allInfo.numIndx;
+    delta.nEntry = 0;
+
+    if (client->subEpoch != loadPubEpoch
+        || client->subSeqNo > loadPubSeqNo) {
+        delta.flags |= LOAD_DELTA_FULL;
+        delta.baseSeqNo = 0;
+    }
+
+    if (!force
+        && !(delta.flags & LOAD_DELTA_FULL)
+        && client->subSeqNo == loadPubSeqNo)
+        return 0;
+
+    n = 0;
+    for (hPtr = myClusterPtr->hostList; hPtr; hPtr = hPtr->nextPtr)
+        n++;
+    if (n > matrixSize) {
+        FREEUP(matrix);
+        matrix = calloc(n, sizeof(struct hostLoad));
+        if (matrix == NULL) {
+            ls_syslog(LOG_ERR, "%s: calloc() failed %m", __func__);
+            matrixSize = 0;
+            return -1;
+        }
+        matrixSize = n;
+    }
+
+    /* The vectors go out from the hosts, only
+     * the names are copied.
+     */
+    for (hPtr = myClusterPtr->hostList; hPtr; hPtr = hPtr->nextPtr) {
+        if (hPtr->pubLoad == NULL)
+            continue;
+        if (!(delta.flags & LOAD_DELTA_FULL)
+            && hPtr->pubSeqNo <= client->subSeqNo)
+            continue;
+        strcpy(matrix[delta.nEntry].hostName, hPtr->hostName);
+        matrix[delta.nEntry].li = hPtr->pubLoad;
+        matrix[delta.nEntry].status = hPtr->pubStatus;
+        delta.nEntry++;
+    }
+    delta.loadMatrix = matrix;
+
+    size = LSF_HEADER_LEN + 6 * NET_INTSIZE_
+        + delta.nEntry * (ALIGNWORD_(MAXHOSTNAMELEN) + 2 * NET_INTSIZE_
+                          + (1 + GET_INTNUM(delta.nIndex)) * NET_INTSIZE_
+                          + delta.nIndex * NET_INTSIZE_);
+    if (chanAllocBuf_(&buf, size) < 0) {
+        ls_syslog(LOG_ERR, "%s: chanAllocBuf_() failed %m", __func__);
+        return -1;
+    }
+
+    initLSFHeader_(&hdr);
+    hdr.opCode = LIME_NO_ERR;
+    hdr.version = OPENLAVA_VERSION;
+
+    xdrmem_create(&xdrs, buf->data, size, XDR_ENCODE);
+    if (!xdr_encodeMsg(&xdrs, (char *)&delta, &hdr, xdr_loadDelta, 0, NULL)) {
+        ls_syslog(LOG_ERR, "%s: xdr_encodeMsg() failed", __func__);
+        xdr_destroy(&xdrs);
+        chanFreeBuf_(buf);
+        return -1;
+    }
+    buf->len = size = XDR_GETPOS(&xdrs);
+    xdr_destroy(&xdrs);
+
+    if (chanEnqueue_(client->chanfd, buf) < 0) {
+        ls_syslog(LOG_ERR, "\
+%s: chanEnqueue_() failed to %s %M", __func__, sockAdd2Str_(&client->from));
+        chanFreeBuf_(buf);
+        return -1;
+    }
+
+    if (logclass & LC_COMM)
+        ls_syslog(LOG_DEBUG, "\
+%s: %d hosts seqNo %u-%u flags %x %d bytes to %s", __func__,
+                  delta.nEntry, delta.baseSeqNo, delta.seqNo, delta.flags,
+                  size, sockAdd2Str_(&client->from));
+
+    client->subEpoch = loadPubEpoch;
+    client->subSeqNo = loadPubSeqNo;
+    client->subTime = time(NULL);
+
+    return 0;
+}
+
+/* loadWheelTick()
+ * Advance the inactivity timers by one exchange interval.
+ * The hosts whose timer expired and that did not send their
+ * load for more than hostInactivityLimit intervals are asked
+ * for it, retryLimit times, then declared unavailable.
+ */
+static void
+loadWheelTick(void)
+{
+    struct hostNode *hPtr;
+    struct hostNode *next;
+    u_int count;
+    int resNo;
+    int i;
+
+    loadTick++;
+
+    for (hPtr = loadWheel[loadTick % LOAD_WHEEL_SIZE]; hPtr; hPtr = next) {
+
+        next = hPtr->wheelForw;
+        if (hPtr->wheelTick != loadTick)
+            continue;
+
+        loadWheelRm(hPtr);
+        if (hPtr == myHostPtr)
+            continue;
+
+        count = loadTick - hPtr->loadTick;
+        hPtr->hostInactivityCount = count > 10000 ? 100 : count;
+
+        if (count <= hostInactivityLimit) {
+            loadWheelAdd(hPtr, hPtr->loadTick + hostInactivityLimit + 1);
+            continue;
+        }
+
+        if (LS_ISUNAVAIL(hPtr->status))
+            continue;
+
+        if (count > hostInactivityLimit + retryLimit) {
+            ls_syslog(LOG_DEBUG, "\
+%s: Declaring %s unavailable inactivity Count=%d", __func__,
+                      hPtr->hostName, hPtr->hostInactivityCount);
+
+            hPtr->status[0] |= LIM_UNAVAIL;
+            hPtr->infoValid = FALSE;
+            for (i = 0; i < hPtr->numInstances; i++) {
+                if (hPtr->instances[i]->updHost == NULL
+                    || hPtr->instances[i]->updHost != hPtr)
+                    continue;
+                resNo = resNameDefined(hPtr->instances[i]->resName);
+                if (allInfo.resTable[resNo].flags & RESF_DYNAMIC) {
+                    strcpy (hPtr->instances[i]->value, "-");
+                    hPtr->instances[i]->updHost = NULL;
+                }
+            }
+            hPtr->loadMask  = 0;
+            hPtr->infoMask  = 0;
+            continue;
+        }
+
+        if (logclass & LC_COMM)
+            ls_syslog(LOG_DEBUG3, "\
+%s: Asking %s to send load info %d %d", __func__,
+                      hPtr->hostName, hPtr->hostInactivityCount,
+                      hostInactivityLimit + retryLimit);
+        announceMasterToHost(hPtr, SEND_LOAD_INFO);
+        loadWheelAdd(hPtr, loadTick + 1);
+    }
+}
+
+/* loadWheelTouch()
+ * The host sent its load in this interval.
+ */
+void
+loadWheelTouch(struct hostNode *hPtr)
+{
+    hPtr->hostInactivityCount = 0;
+    hPtr->loadTick = loadTick;
+
+    if (hPtr->wheelTick == 0 && hPtr != myHostPtr)
+        loadWheelAdd(hPtr, loadTick + hostInactivityLimit + 1);
+}
+
+/* loadWheelAdd()
+ */
+static void
+loadWheelAdd(struct hostNode *hPtr, u_int tick)
+{
+    struct hostNode **head;
+
+    loadWheelRm(hPtr);
+
+    head = &loadWheel[tick % LOAD_WHEEL_SIZE];
+    hPtr->wheelTick = tick;
+    hPtr->wheelBack = NULL;
+    hPtr->wheelForw = *head;
+    if (*head)
+        (*head)->wheelBack = hPtr;
+    *head = hPtr;
+}
+
+/* loadWheelRm()
+ */
+void
+loadWheelRm(struct hostNode *hPtr)
+{
+    if (hPtr->wheelTick == 0)
+        return;
+
+    if (hPtr->wheelBack)
+        hPtr->wheelBack->wheelForw = hPtr->wheelForw;
+    else
+        loadWheel[hPtr->wheelTick % LOAD_WHEEL_SIZE] = hPtr->wheelForw;
+    if (hPtr->wheelForw)
+        hPtr->wheelForw->wheelBack = hPtr->wheelBack;
+
+    hPtr->wheelForw = hPtr->wheelBack = NULL;
+    hPtr->wheelTick = 0;
+}
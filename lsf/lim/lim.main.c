@@ -80,6 +80,8 @@ struct config_param limParams[] =
     {"LSB_SHAREDIR", NULL},
     {"LIM_NO_MIGRANT_HOSTS", NULL},
     {"LIM_NO_FORK", NULL},
+    {"LIM_LOAD_DELTA", NULL},
+    {"LIM_LOAD_RELAYS", NULL},
     {NULL, NULL},
 };
 
@@ -513,6 +515,9 @@ processUDPMsg(void)
         case LIM_LOAD_UPD:
             rcvLoad(&xdrs, &from, &reqHdr);
             break;
+        case LIM_LOAD_RELAY:
+            rcvLoadRelay(&xdrs, &from, &reqHdr);
+            break;
         case LIM_JOB_XFER:
             jobxferReq(&xdrs, &from, &reqHdr);
             break;
@@ -742,6 +747,7 @@ periodic(int kernelPerm)
     ls_syslog(LOG_DEBUG, "%s: Entering this routine...", __func__);
 
     TIMEIT(0, readLoad(kernelPerm), "readLoad()");
+    pushLoad();
 
     if (masterMe)
         announceMaster(myClusterPtr, 1, FALSE);
@@ -20,8 +20,17 @@
 #include "lim.h"
 
 static struct hostNode *findHNbyAddr(in_addr_t);
+static void hostAddrAdd(struct hostNode *, in_addr_t);
 static int loadEvents(void);
 
+/* Index of the host addresses, every datagram is
+ * looked up by its source. It is rebuilt at the first
+ * lookup after hosts are added or removed.
+ */
+static hTab hostAddrTab;
+static int hostAddrValid;
+u_int hostListGen;
+
 void
 lim_Exit(const char *fname)
 {
@@ -134,6 +143,8 @@ findHostbyAddr(struct sockaddr_in *from,
     hPtr->addr = tPtr;
     hPtr->addr[hPtr->naddr] = from->sin_addr.s_addr;
     hPtr->naddr++;
+    if (hostAddrValid)
+        hostAddrAdd(hPtr, from->sin_addr.s_addr);
 
     return hPtr;
 }
@@ -142,21 +153,61 @@ findHostbyAddr(struct sockaddr_in *from,
 static struct hostNode *
 findHNbyAddr(in_addr_t from)
 {
-    struct clusterNode *clPtr;
     struct hostNode *hPtr;
+    char key[16];
+    hEnt *ent;
+    int i;
 
-    clPtr = myClusterPtr;
-    for (hPtr = clPtr->hostList; hPtr; hPtr = hPtr->nextPtr) {
-        if (equivHostAddr(hPtr, from))
-            return hPtr;
-    }
+    if (!hostAddrValid) {
 
-    for (hPtr = clPtr->clientList; hPtr; hPtr = hPtr->nextPtr) {
-        if (equivHostAddr(hPtr, from))
-            return hPtr;
+        h_freeRefTab_(&hostAddrTab);
+        h_initTab_(&hostAddrTab, 64);
+
+        /* Server hosts first, the first host
+         * having the address is the one found.
+         */
+        for (hPtr = myClusterPtr->hostList; hPtr; hPtr = hPtr->nextPtr)
+            for (i = 0; i < hPtr->naddr; i++)
+                hostAddrAdd(hPtr, hPtr->addr[i]);
+        for (hPtr = myClusterPtr->clientList; hPtr; hPtr = hPtr->nextPtr)
+            for (i = 0; i < hPtr->naddr; i++)
+                hostAddrAdd(hPtr, hPtr->addr[i]);
+
+        hostAddrValid = TRUE;
     }
 
-    return NULL;
+    sprintf(key, "%x", from);
+    if ((ent = h_getEnt_(&hostAddrTab, key)) == NULL)
+        return NULL;
+
+    return ent->hData;
+}
+
+/* hostAddrAdd()
+ */
+static void
+hostAddrAdd(struct hostNode *hPtr, in_addr_t addr)
+{
+    char key[16];
+    hEnt *ent;
+    int new;
+
+    sprintf(key, "%x", addr);
+    ent = h_addEnt_(&hostAddrTab, key, &new);
+    if (new)
+        ent->hData = hPtr;
+}
+
+/* hostListChanged()
+ * Hosts were added or removed, the index is rebuilt
+ * at the next lookup and hostListGen tells the other
+ * caches of host pointers.
+ */
+void
+hostListChanged(void)
+{
+    hostAddrValid = FALSE;
+    hostListGen++;
 }
 
 struct hostNode *
@@ -169,12 +220,18 @@ rmHost(struct hostNode *r)
     hPtr = myClusterPtr->hostList;
     if (hPtr == r) {
         myClusterPtr->hostList = hPtr->nextPtr;
+        loadPubReset();
+        loadWheelRm(r);
+        hostListChanged();
         return r;
     }
 
     while (hPtr) {
         if (hPtr == r) {
             hPtr0->nextPtr = hPtr->nextPtr;
+            loadPubReset();
+            loadWheelRm(r);
+            hostListChanged();
             return r;
         }
         hPtr0 = hPtr;
@@ -441,9 +441,10 @@ grabHosts(struct hostNode *hList,
         }
 
         getTclHostData (&tclHostData, hPtr, fromHostPtr, FALSE);
-        if (evalResReq(resValPtr->selectStr,
-                       &tclHostData,
-                       reqPtr->options & DFT_FROMTYPE) != 1)
+        if (evalSelectCode(resValPtr->selectCode,
+                           resValPtr->selectStr,
+                           &tclHostData,
+                           reqPtr->options & DFT_FROMTYPE) != 1)
             continue;
 
         if (equalHost_(hPtr->hostName, reqPtr->preferredHosts[0]))
@@ -1560,6 +1561,41 @@ Reply1:
 
 }
 
+/* effectiveLoad()
+ * The load vector of host as loadReq() replies it to an
+ * EFFECTIVE request of all the indices, into li and status.
+ */
+void
+effectiveLoad(struct hostNode *host, float *li, int *status)
+{
+    float factor;
+    int i;
+
+    status[0] = host->status[0];
+    for (i = 0; i < GET_INTNUM(allInfo.numIndx); i++)
+        status[i + 1] = 0;
+
+    if (LS_ISUNAVAIL(host->status)) {
+        for (i = 0; i < allInfo.numIndx; i++)
+            li[i] = INFINIT_LOAD;
+        return;
+    }
+
+    factor = (host->hModelNo >= 0) ?
+        shortInfo.cpuFactors[host->hModelNo] : 1.0;
+
+    for (i = 0; i < allInfo.numIndx; i++) {
+        if (LS_ISBUSYON(host->status, i))
+            SET_BIT(INTEGER_BITS + i, status);
+        if (i == R15S || i == R1M || i == R15M) {
+            li[i] = effectiveRq(host->loadIndex[i], factor);
+            if (li[i] < 0.0)
+                li[i] = 0.0;
+        } else
+            li[i] = host->loadIndex[i];
+    }
+}
+
 static int
 initCandList(void)
 {
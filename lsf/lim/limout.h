@@ -64,6 +64,7 @@ enum limReqCode {
     LIM_ADD_HOST      = 14,
     LIM_RM_HOST       = 15,
     LIM_GET_MASTINFO2 = 16,
+    LIM_LOAD_SUBSCRIBE = 17,
 
 #define FIRST_LIM_PRIV	LIM_REBOOT
     LIM_REBOOT        = 50,
@@ -76,6 +77,7 @@ enum limReqCode {
     LIM_JOB_XFER      = 101,
     LIM_MASTER_ANN    = 102,
     LIM_CONF_INFO     = 103,
+    LIM_LOAD_RELAY    = 104,
 
 #define FIRST_INTER_CLUS  LIM_CLUST_INFO
     LIM_CLUST_INFO   = 200,
@@ -121,6 +123,14 @@ struct loadReply {
     int  flags;
 };
 
+/* Subscription to the load of the server hosts, resumed
+ * from seqNo if the master LIM still has the same epoch.
+ */
+struct loadSubReq {
+    u_int epoch;
+    u_int seqNo;
+};
+
 struct shortHInfo {
     char    hostName[MAXHOSTNAMELEN];
     int     hTypeIndx;
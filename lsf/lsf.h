@@ -282,6 +282,27 @@ struct hostLoad {
     float *li;
 };
 
+/* Load vectors pushed by the master LIM to a subscriber,
+ * the effective load of all the server hosts whose load
+ * changed since baseSeqNo. With LOAD_DELTA_FULL the
+ * message has all the hosts and replaces what the
+ * subscriber knows. A subscriber gets a message, empty
+ * if nothing changed, at least every LOAD_DELTA_KEEPALIVE
+ * seconds so it can tell a quiet cluster from a dead LIM.
+ */
+#define LOAD_DELTA_KEEPALIVE  60
+
+struct loadDelta {
+    unsigned int epoch;
+    unsigned int baseSeqNo;
+    unsigned int seqNo;
+    int   flags;
+#define LOAD_DELTA_FULL  0x1
+    int   nIndex;
+    int   nEntry;
+    struct hostLoad *loadMatrix;
+};
+
 enum valueType {LS_BOOLEAN, LS_NUMERIC, LS_STRING, LS_EXTERNAL};
 #define BOOLEAN  LS_BOOLEAN
 #define NUMERIC  LS_NUMERIC
@@ -833,6 +854,10 @@ extern struct  hostLoad *ls_loadinfo(char *resreq, int *numhosts,
                                      int listsize, char ***indxnamelist);
 extern int     ls_loadadj(char *resreq, struct placeInfo *hostlist,
                           int listsize);
+extern int     ls_loadsubscribe(unsigned int epoch, unsigned int seqNo,
+                                struct loadDelta *);
+extern int     ls_loaddelta(int chfd, struct loadDelta *);
+extern void    ls_freeloaddelta(struct loadDelta *);
 extern int     ls_eligible(char *task, char *resreqstr, char mode);
 extern char *  ls_resreq(char *task);
 extern int     ls_insertrtask(char *task);
@@ -21,5 +21,8 @@
 #include "../intlib/intlibout.h"
 
 extern char infofile[];
+extern char tablefile[];
+extern int maxProcs;
+extern struct pimStats pimStats;
 extern int pimPort;
 extern int scan_procs(void);
@@ -19,18 +19,82 @@
 
 #include "pim.h"
 
-static struct lsPidInfo procs[MAX_PROC_ENT];
+/* A process pim knows about, indexed by pid in procTab.
+ * The job processes keep their /proc stat file open and
+ * it is read again with pread() every scan. The others
+ * are read once when they show up and then only tracked
+ * until their pid goes away.
+ */
+struct procEnt {
+    int pid;
+    int fd;
+    int scan;
+    int state;
+    int daemon;
+    ino_t ino;
+    struct pimProc proc;
+};
+
+enum {
+    PROC_NEW,       /* not classified yet */
+    PROC_DAEMON,    /* sbatchd or res */
+    PROC_JOB,       /* started by a daemon */
+    PROC_OTHER,     /* not read again */
+    PROC_CHECK      /* being classified */
+};
+
+#define PROC_MAX_DEPTH  256
+
+static hTab procTab;
+static int scanNo;
+static int numOpen;
+static int maxOpen;
+static struct pimProc *procs;
 static int numprocs;
-static int ls_pidinfo(int, struct lsPidInfo *);
+static int sizeprocs;
+static struct pimTable *table;
+static ino_t tableIno;
+struct pimStats pimStats;
+
+static void initProcs(void);
+static int readProc(struct procEnt *);
+static int procClass(struct procEnt *, int);
+static struct procEnt *findProc(int);
+static int jobEnviron(int);
+static void closeProc(struct procEnt *);
+static int addProc(struct procEnt *);
+static int cmpProc(const void *, const void *);
 static int parse_stat(char *, struct lsPidInfo *);
-static void logProcessInfo(void);
+static int openTable(void);
+static void publishTable(void);
 
+/* scan_procs()
+ * Bring the process table up to date. readdir() finds the
+ * pids that came and went since the last scan, only the
+ * new ones and the job ones are read.
+ */
 int
 scan_procs(void)
 {
+    struct timeval t0;
+    struct timeval t1;
     DIR *dir;
     struct dirent *process;
-    struct lsPidInfo rec;
+    struct procEnt *ent;
+    hEnt *e;
+    sTab st;
+    char key[32];
+    int numNew;
+    int numAll;
+    int numGone;
+    int isNew;
+    int pid;
+    int usec;
+
+    if (scanNo == 0)
+        initProcs();
+
+    gettimeofday(&t0, NULL);
 
     dir = opendir("/proc");
     if (dir == NULL) {
@@ -39,131 +103,474 @@ scan_procs(void)
         return -1;
     }
 
-    numprocs = 0;
+    ++scanNo;
+    numNew = numAll = numGone = 0;
+
     while ((process = readdir(dir))) {
 
         if (! isdigit(process->d_name[0]))
             continue;
 
-        if (ls_pidinfo(atoi(process->d_name), &rec) != 0)
-            continue;
+        pid = atoi(process->d_name);
+        sprintf(key, "%d", pid);
+        e = h_addEnt_(&procTab, key, &isNew);
+        if (isNew) {
+            ent = calloc(1, sizeof(struct procEnt));
+            if (ent == NULL) {
+                ls_syslog(LOG_ERR, "%s: calloc() failed %m.", __func__);
+                h_rmEnt_(&procTab, e);
+                continue;
+            }
+            ent->pid = pid;
+            ent->fd = -1;
+            ent->state = PROC_NEW;
+            ent->ino = process->d_ino;
+            e->hData = ent;
+            ++numNew;
+        }
+        ent = e->hData;
+
+        /* The pid was reused by another process.
+         */
+        if (ent->ino != process->d_ino) {
+            closeProc(ent);
+            ent->state = PROC_NEW;
+            ent->ino = process->d_ino;
+            ++numNew;
+        }
+
+        ++numAll;
+        ent->scan = scanNo;
 
-        if (rec.pgid == 1)
+        if (ent->state == PROC_OTHER)
             continue;
 
-        procs[numprocs].pid = rec.pid;
-        procs[numprocs].ppid = rec.ppid;
-        procs[numprocs].pgid = rec.pgid;
-
-        procs[numprocs].utime = rec.utime/100;
-        procs[numprocs].stime = rec.stime/100;
-        procs[numprocs].cutime = rec.cutime/100;
-        procs[numprocs].cstime = rec.cstime/100;
-
-        procs[numprocs].proc_size = rec.proc_size;
-        procs[numprocs].resident_size
-            = rec.resident_size * (sysconf(_SC_PAGESIZE)/1024);
-        procs[numprocs].stack_size = rec.stack_size;
-        if ( procs[numprocs].stack_size < 0 )
-            procs[numprocs].stack_size = 0;
-        procs[numprocs].status = rec.status;
-
-        ++numprocs;
-        if (numprocs == MAX_PROC_ENT - 1) {
-            ls_syslog(LOG_INFO, "\
-%s: maximum number of processes %d reached.", __func__, numprocs);
-            break;
-        }
+        if (readProc(ent) < 0)
+            ent->scan = 0;
     }
 
     closedir(dir);
 
-    logProcessInfo();
+    for (e = h_firstEnt_(&procTab, &st); e; e = h_nextEnt_(&st)) {
+        ent = e->hData;
+        if (ent->scan != scanNo) {
+            closeProc(ent);
+            h_delEnt_(&procTab, e);
+            ++numGone;
+        }
+    }
+
+    /* A daemon child that exec'ed the job is
+     * a job process now.
+     */
+    numprocs = 0;
+    for (e = h_firstEnt_(&procTab, &st); e; e = h_nextEnt_(&st)) {
+        ent = e->hData;
+        if (ent->state == PROC_DAEMON && !ent->daemon)
+            ent->state = PROC_NEW;
+        if (procClass(ent, 0) == PROC_OTHER) {
+            closeProc(ent);
+            continue;
+        }
+        if (ent->state == PROC_JOB
+            && ent->proc.pgid != 1
+            && addProc(ent) < 0)
+            break;
+    }
+
+    /* Parents before children as in /proc,
+     * readPIMInfo() relies on it.
+     */
+    qsort(procs, numprocs, sizeof(struct pimProc), cmpProc);
+
+    publishTable();
+
+    gettimeofday(&t1, NULL);
+    usec = (t1.tv_sec - t0.tv_sec) * 1000000 + (t1.tv_usec - t0.tv_usec);
+
+    pimStats.numProcs = numAll;
+    pimStats.numJobProcs = numprocs;
+    pimStats.numNew = numNew;
+    pimStats.numGone = numGone;
+    pimStats.numOpen = numOpen;
+    pimStats.numScans++;
+    pimStats.scanTime = usec;
+    if (usec > pimStats.maxScanTime)
+        pimStats.maxScanTime = usec;
+
+    ls_syslog(LOG_DEBUG, "\
+%s: %d processes %d job processes %d new %d gone %d open in %d usec",
+              __func__, numAll, numprocs, numNew, numGone, numOpen, usec);
 
     return 0;
 }
 
-/* logProcessInfo()
+/* initProcs()
+ * The job processes keep a file open each,
+ * take all the descriptors we are allowed.
  */
 static void
-logProcessInfo(void)
+initProcs(void)
 {
-    int i;
-    FILE *fp;
-    static char wfile[MAXFILENAMELEN];
+    struct rlimit rl;
 
-    sprintf(wfile, "%s.%d", infofile, getpid());
+    h_initTab_(&procTab, 1024);
 
-    fp = fopen(wfile, "w");
-    if (fp == NULL) {
-        ls_syslog(LOG_ERR, "%s: fopen() %s failed %m.", wfile);
-        return;
+    maxOpen = 0;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        if (rl.rlim_cur < rl.rlim_max) {
+            rl.rlim_cur = rl.rlim_max;
+            if (setrlimit(RLIMIT_NOFILE, &rl) < 0)
+                getrlimit(RLIMIT_NOFILE, &rl);
+        }
+        if (rl.rlim_cur > 64)
+            maxOpen = rl.rlim_cur - 64;
     }
+}
 
-    fprintf(fp, "%d\n", pimPort);
-    for (i = 0; i < numprocs; i++) {
+/* readProc()
+ * Read the process stat, through its open file if
+ * any. Returns -1 if the process is gone.
+ */
+static int
+readProc(struct procEnt *ent)
+{
+    char filename[PATH_MAX];
+    char buffer[BUFSIZ];
+    struct lsPidInfo rec;
+    int cc;
 
-        fprintf(fp, "\
-%d %d %d %d %d %d %d %d %d %d %d %d\n",
-                procs[i].pid, procs[i].ppid, procs[i].pgid, procs[i].jobid,
-                procs[i].utime, procs[i].stime, procs[i].cutime,
-                procs[i].cstime, procs[i].proc_size,
-                procs[i].resident_size, procs[i].stack_size,
-                (int) procs[i].status);
+    cc = -1;
+    if (ent->fd >= 0) {
+        cc = pread(ent->fd, buffer, sizeof(buffer) - 1, 0);
+        if (cc <= 0)
+            closeProc(ent);
     }
-    fclose(fp);
 
-    if (unlink(infofile) < 0 && errno != ENOENT) {
-        ls_syslog(LOG_DEBUG, "\
-%s: unlink(%s) failed: %m.", __func__, infofile);
+    if (ent->fd < 0) {
+
+        sprintf(filename, "/proc/%d/stat", ent->pid);
+        if ((ent->fd = open(filename, O_RDONLY, 0)) < 0)
+            return -1;
+        ++numOpen;
+
+        cc = read(ent->fd, buffer, sizeof(buffer) - 1);
+
+        if (numOpen > maxOpen)
+            closeProc(ent);
     }
 
-    if (rename(wfile, infofile) < 0) {
+    if (cc <= 0)
+        return -1;
+    buffer[cc] = 0;
+
+    if (parse_stat(buffer, &rec) < 0) {
         ls_syslog(LOG_ERR, "\
-%s: rename() %s to %s failed: %m.", __func__, wfile, infofile);
+%s: parse_stat() failed process %d.", __func__, ent->pid);
+        return -1;
     }
-    unlink(wfile);
 
-    ls_syslog(LOG_DEBUG, "\
-%s: process table updated.", __func__);
+    ent->daemon = strcmp(rec.command, "(sbatchd)") == 0
+        || strcmp(rec.command, "(res)") == 0;
+
+    ent->proc.pid = rec.pid;
+    ent->proc.ppid = rec.ppid;
+    ent->proc.pgid = rec.pgid;
 
+    ent->proc.utime = rec.utime/100;
+    ent->proc.stime = rec.stime/100;
+    ent->proc.cutime = rec.cutime/100;
+    ent->proc.cstime = rec.cstime/100;
+
+    ent->proc.proc_size = rec.proc_size;
+    ent->proc.resident_size
+        = rec.resident_size * (sysconf(_SC_PAGESIZE)/1024);
+    ent->proc.stack_size = rec.stack_size;
+    if ( ent->proc.stack_size < 0 )
+        ent->proc.stack_size = 0;
+    ent->proc.status = rec.status;
+
+    return 0;
 }
 
-/* ls_pidinfo()
+/* procClass()
+ * A process started by sbatchd or res, directly or
+ * not, is a job process. So is one whose parent is
+ * gone if its process group leader is a job process
+ * or if it has the job environment.
  */
 static int
-ls_pidinfo(int pid, struct lsPidInfo *rec)
+procClass(struct procEnt *ent, int depth)
+{
+    struct procEnt *p;
+
+    if (ent->state == PROC_CHECK)
+        return PROC_OTHER;
+    if (ent->state != PROC_NEW)
+        return ent->state;
+
+    ent->state = PROC_CHECK;
+
+    if (ent->daemon) {
+        ent->state = PROC_DAEMON;
+        return ent->state;
+    }
+
+    p = findProc(ent->proc.ppid);
+    if (p && p != ent && depth < PROC_MAX_DEPTH) {
+        if (procClass(p, depth + 1) != PROC_OTHER) {
+            ent->state = PROC_JOB;
+            return ent->state;
+        }
+    }
+
+    p = findProc(ent->proc.pgid);
+    if (p && p != ent && depth < PROC_MAX_DEPTH) {
+        if (procClass(p, depth + 1) == PROC_JOB) {
+            ent->state = PROC_JOB;
+            return ent->state;
+        }
+    }
+
+    if (jobEnviron(ent->pid))
+        ent->state = PROC_JOB;
+    else
+        ent->state = PROC_OTHER;
+
+    return ent->state;
+}
+
+static struct procEnt *
+findProc(int pid)
 {
+    char key[32];
+    hEnt *e;
+
+    sprintf(key, "%d", pid);
+    if ((e = h_getEnt_(&procTab, key)) == NULL)
+        return NULL;
+
+    return e->hData;
+}
+
+/* jobEnviron()
+ * Does the process have LSB_JOBID in its environment.
+ */
+static int
+jobEnviron(int pid)
+{
+    static char buf[64 * 1024];
+    char filename[PATH_MAX];
+    char *p;
     int fd;
-    static char filename[PATH_MAX];
-    static char buffer[BUFSIZ];
+    int cc;
 
-    sprintf(filename, "/proc/%d/stat", pid);
+    sprintf(filename, "/proc/%d/environ", pid);
+    if ((fd = open(filename, O_RDONLY, 0)) < 0)
+        return FALSE;
+    cc = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (cc <= 0)
+        return FALSE;
+    buf[cc] = 0;
 
-    fd = open(filename, O_RDONLY, 0);
-    if (fd == -1) {
-        ls_syslog(LOG_ERR, "\
-%s: open() failed %s %m.", __func__, filename );
+    for (p = buf; p < buf + cc; p += strlen(p) + 1) {
+        if (strncmp(p, "LSB_JOBID=", 10) == 0)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void
+closeProc(struct procEnt *ent)
+{
+    if (ent->fd < 0)
+        return;
+
+    close(ent->fd);
+    ent->fd = -1;
+    --numOpen;
+}
+
+/* addProc()
+ * Append the process to the table of the scan,
+ * the table grows as needed.
+ */
+static int
+addProc(struct procEnt *ent)
+{
+    struct pimProc *p;
+    int size;
+
+    if (numprocs == sizeprocs) {
+        size = sizeprocs ? 2 * sizeprocs : maxProcs;
+        p = realloc(procs, size * sizeof(struct pimProc));
+        if (p == NULL) {
+            ls_syslog(LOG_ERR, "\
+%s: realloc(%d) failed: %m.", __func__, size);
+            return -1;
+        }
+        procs = p;
+        sizeprocs = size;
+    }
+
+    procs[numprocs++] = ent->proc;
+
+    return 0;
+}
+
+static int
+cmpProc(const void *a, const void *b)
+{
+    return ((struct pimProc *)a)->pid - ((struct pimProc *)b)->pid;
+}
+
+/* openTable()
+ * Create the process table file, map it and
+ * rename it into place only once the header is
+ * valid so a reader never maps a partial table.
+ */
+static int
+openTable(void)
+{
+    static char wfile[PATH_MAX];
+    struct pimTable *t;
+    struct stat st;
+    size_t size;
+    int hashSize;
+    int fd;
+
+    hashSize = 1;
+    while (hashSize < maxProcs)
+        hashSize *= 2;
+    size = PIM_TABLE_SIZE(maxProcs, hashSize);
+
+    sprintf(wfile, "%s.%d", tablefile, getpid());
+    unlink(wfile);
+    fd = open(wfile, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        ls_syslog(LOG_ERR, "%s: open() %s failed %m.", __func__, wfile);
         return -1;
     }
 
-    if (read(fd, buffer, sizeof(buffer) - 1) <= 0) {
+    if (ftruncate(fd, size) < 0
+        || fstat(fd, &st) < 0) {
         ls_syslog(LOG_ERR, "\
-%s: read() failed %s %m.", __func__, filename);
+%s: ftruncate() %s to %zu failed %m.", __func__, wfile, size);
         close(fd);
+        unlink(wfile);
         return -1;
     }
+
+    t = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
     close(fd);
+    if (t == MAP_FAILED) {
+        ls_syslog(LOG_ERR, "%s: mmap() %s failed %m.", __func__, wfile);
+        unlink(wfile);
+        return -1;
+    }
 
-    if (parse_stat(buffer, rec) < 0) {
+    t->magic = PIM_TABLE_MAGIC;
+    t->version = PIM_TABLE_VERSION;
+    t->seqNo = 0;
+    t->port = pimPort;
+    t->maxProcs = maxProcs;
+    t->numProcs = 0;
+    t->hashSize = hashSize;
+    t->updTime = 0;
+    memset(PIM_PGID_HASH(t), 0xff, 2 * hashSize * sizeof(int));
+
+    if (rename(wfile, tablefile) < 0) {
         ls_syslog(LOG_ERR, "\
-%s: parse_stat() failed process %d.", __func__, pid);
+%s: rename() %s to %s failed: %m.", __func__, wfile, tablefile);
+        munmap(t, size);
+        unlink(wfile);
         return -1;
     }
 
+    if (table)
+        munmap(table, PIM_TABLE_SIZE(table->maxProcs, table->hashSize));
+    table = t;
+    tableIno = st.st_ino;
+
+    /* The text file of an older pim, if
+     * any, would only mislead the readers.
+     */
+    unlink(infofile);
+
     return 0;
 }
 
+/* publishTable()
+ * Copy the scanned processes into the shared table
+ * and rebuild the pgid and ppid chains, the odd seqNo
+ * tells readers the table is being written.
+ */
+static void
+publishTable(void)
+{
+    struct pimProc *p;
+    struct stat st;
+    int *pgidHash;
+    int *ppidHash;
+    int h;
+    int i;
+
+    /* Somebody removed or replaced the file,
+     * the readers can no longer find our mapping.
+     */
+    if (table
+        && (stat(tablefile, &st) < 0 || st.st_ino != tableIno)) {
+        ls_syslog(LOG_INFO, "\
+%s: process table %s was removed, recreating it.", __func__, tablefile);
+        munmap(table, PIM_TABLE_SIZE(table->maxProcs, table->hashSize));
+        table = NULL;
+    }
+
+    /* More job processes than the table holds,
+     * make a new one as large as our array.
+     */
+    if (table && numprocs > table->maxProcs) {
+        ls_syslog(LOG_INFO, "\
+%s: %d processes, growing the process table from %d to %d.",
+                  __func__, numprocs, table->maxProcs, sizeprocs);
+        munmap(table, PIM_TABLE_SIZE(table->maxProcs, table->hashSize));
+        table = NULL;
+    }
+    if (numprocs > maxProcs)
+        maxProcs = sizeprocs;
+
+    if (table == NULL && openTable() < 0)
+        return;
+
+    pgidHash = PIM_PGID_HASH(table);
+    ppidHash = PIM_PPID_HASH(table);
+    p = PIM_PROCS(table);
+
+    table->seqNo++;
+    __sync_synchronize();
+
+    memset(pgidHash, 0xff, 2 * table->hashSize * sizeof(int));
+    for (i = 0; i < numprocs; i++) {
+        p[i] = procs[i];
+        h = PIM_HASH(table, p[i].pgid);
+        p[i].nextPgid = pgidHash[h];
+        pgidHash[h] = i;
+        h = PIM_HASH(table, p[i].ppid);
+        p[i].nextPpid = ppidHash[h];
+        ppidHash[h] = i;
+    }
+    table->numProcs = numprocs;
+    table->updTime = time(NULL);
+
+    __sync_synchronize();
+    table->seqNo++;
+
+    ls_syslog(LOG_DEBUG, "\
+%s: process table updated %d processes.", __func__, numprocs);
+}
+
 /* parse_stat()
  */
 static int
@@ -53,6 +53,11 @@ enum {
  * this file is used by the arch dipendent modules.
  */
 char infofile[PATH_MAX];
+/* The process table shared with sbatchd and res
+ * and the number of processes it can hold.
+ */
+char tablefile[PATH_MAX];
+int maxProcs = MAX_PROC_ENT;
 int pimPort;
 static int pim_debug;
 static int sleepTime = PIM_SLEEP_TIME;
@@ -61,12 +66,13 @@ static int updInterval = PIM_UPDATE_INTERVAL;
 static int doServ(void);
 static void hup(int);
 static void updateProcs(void);
+static int printStats(void);
 
 static void
 usage (const char *cmd)
 {
     fprintf(stderr, "\
-%s: [-V] [-h] [-debug_level] [-d env_dir]\n", cmd);
+%s: [-V] [-h] [-s] [-debug_level] [-d env_dir]\n", cmd);
 }
 
 /* This is PIM process information manager.
@@ -85,7 +91,7 @@ main(int argc, char **argv)
     int cc;
 
     myHost = "localhost";
-    while ((cc = getopt(argc, argv, "12Vd:")) != EOF) {
+    while ((cc = getopt(argc, argv, "12Vsd:")) != EOF) {
 
         switch (cc) {
             case 'd':
@@ -100,6 +106,8 @@ main(int argc, char **argv)
             case 'V':
                 fputs(_LS_VERSION_, stderr);
                 return 0;
+            case 's':
+                return printStats();
             case '?':
             default:
                 usage(argv[0]);
@@ -163,6 +171,15 @@ main(int argc, char **argv)
         }
     }
 
+    if ((sp = pimParams[LSF_PIM_NPROC].paramValue)) {
+        if ((maxProcs = atoi(sp)) <= 0) {
+            ls_syslog(LOG_ERR, "\
+%s: LSF_PIM_NPROC value %s must be a positive integer, set to %d",
+                      __func__, sp, MAX_PROC_ENT);
+            maxProcs = MAX_PROC_ENT;
+        }
+    }
+
     myHost = ls_getmyhostname();
     /* Greet the world!
      */
@@ -170,9 +187,12 @@ main(int argc, char **argv)
 pim: Howdy this is Process Information Manager daemon on host %s.", myHost);
 
     sprintf(infofile, "/tmp/pim.info.%s", myHost);
+    sprintf(tablefile, "/tmp/pim.table.%s", myHost);
     if (pimParams[LSF_PIM_INFODIR].paramValue) {
         sprintf(infofile, "\
 %s/pim.info.%s", pimParams[LSF_PIM_INFODIR].paramValue, myHost);
+        sprintf(tablefile, "\
+%s/pim.table.%s", pimParams[LSF_PIM_INFODIR].paramValue, myHost);
     }
 
     /* Like a good old Unix deamon do something
@@ -278,6 +298,17 @@ doServ(void)
             continue;
         }
 
+        if (hdr.opCode & PIM_API_STATS) {
+            char buf[MSGSIZE];
+
+            if (writeEncodeMsg_(sock, buf, sizeof(buf), &hdr,
+                                (char *)&pimStats, nb_write_fix,
+                                xdr_pimStats, 0) < 0)
+                ls_syslog(LOG_ERR, "%s: write() failed %m.", __func__);
+            close(sock);
+            continue;
+        }
+
         ls_syslog(LOG_DEBUG, "\
 %s: got opCode %d PGID %d updating now.", __func__,
                   hdr.opCode, hdr.reserved);
@@ -312,6 +343,33 @@ updateProcs(void)
     scan_procs();
 }
 
+/* printStats()
+ * Ask the pim running on this host
+ * how its scans are doing.
+ */
+static int
+printStats(void)
+{
+    struct pimStats *s;
+
+    if ((s = getPIMStats_()) == NULL) {
+        fprintf(stderr, "pim: cannot get the statistics: %s\n",
+                ls_sysmsg());
+        return -1;
+    }
+
+    printf("processes       %d\n", s->numProcs);
+    printf("job processes   %d\n", s->numJobProcs);
+    printf("new             %d\n", s->numNew);
+    printf("gone            %d\n", s->numGone);
+    printf("open files      %d\n", s->numOpen);
+    printf("scans           %d\n", s->numScans);
+    printf("scan time       %d usec\n", s->scanTime);
+    printf("max scan time   %d usec\n", s->maxScanTime);
+
+    return 0;
+}
+
 static void
 hup(int sig)
 {